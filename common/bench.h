@@ -0,0 +1,267 @@
+#pragma once
+#include <cuda_runtime_api.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "cuda_utils.h"
+#include "latency_stats.h"
+
+// --bench: synthetic inputs generated in memory, warmup, then timed iterations with per-stage timings. Nothing is
+// read from or written to disk except the optional JSON report.
+struct BenchOptions {
+    bool enabled = false;
+    bool mock = false;  // only the CPU stages, on synthetic engine output, no GPU needed
+    int warmup = 20;
+    int iterations = 200;
+    std::string json_path;
+};
+
+// Consumes "--bench", "--bench_mock", "--bench_warmup=N", "--bench_iters=N" and "--bench_json=path" and compacts
+// argv. --bench_mock implies --bench.
+static inline bool parse_bench_args(int& argc, char** argv, BenchOptions& opts) {
+    int kept = 0;
+    for (int i = 0; i < argc; i++) {
+        std::string arg(argv[i]);
+        bool ok = true;
+        if (i == 0 || arg.compare(0, 7, "--bench") != 0) {
+            argv[kept++] = argv[i];
+        } else if (arg == "--bench") {
+            opts.enabled = true;
+        } else if (arg == "--bench_mock") {
+            opts.enabled = true;
+            opts.mock = true;
+        } else if (arg.compare(0, 15, "--bench_warmup=") == 0) {
+            opts.warmup = atoi(arg.substr(15).c_str());
+            ok = opts.warmup >= 0;
+        } else if (arg.compare(0, 14, "--bench_iters=") == 0) {
+            opts.iterations = atoi(arg.substr(14).c_str());
+            ok = opts.iterations > 0;
+        } else if (arg.compare(0, 13, "--bench_json=") == 0) {
+            opts.json_path = arg.substr(13);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "invalid argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    argc = kept;
+    return true;
+}
+
+// Samples of every stage over the timed iterations, kept in the order the stages were first recorded. The "total"
+// stage is the end-to-end time of an iteration and gives the throughput.
+class BenchStats {
+   public:
+    void add(const std::string& stage, double ms) {
+        auto it = samples_.find(stage);
+        if (it == samples_.end()) {
+            stages_.push_back(stage);
+            it = samples_.emplace(stage, std::vector<double>()).first;
+        }
+        it->second.push_back(ms);
+    }
+
+    struct Row {
+        std::string stage;
+        double mean, p50, p90, p99, max;
+    };
+
+    std::vector<Row> rows() const {
+        std::vector<Row> res;
+        for (const auto& stage : stages_) {
+            std::vector<double> s = samples_.at(stage);
+            double sum = 0.0;
+            for (double v : s) {
+                sum += v;
+            }
+            Row row;
+            row.stage = stage;
+            row.mean = sum / s.size();
+            row.p50 = latency_percentile(s, 50);
+            row.p90 = latency_percentile(s, 90);
+            row.p99 = latency_percentile(s, 99);
+            row.max = latency_percentile(s, 100);
+            res.push_back(row);
+        }
+        return res;
+    }
+
+    double images_per_second(int images_per_iteration) const {
+        auto it = samples_.find("total");
+        if (it == samples_.end() || it->second.empty()) {
+            return 0.0;
+        }
+        double ms = 0.0;
+        for (double v : it->second) {
+            ms += v;
+        }
+        return ms > 0.0 ? images_per_iteration * it->second.size() * 1000.0 / ms : 0.0;
+    }
+
+    void print(std::ostream& out, int images_per_iteration) const {
+        auto flags = out.flags();
+        auto precision = out.precision();
+        out << std::left << std::setw(16) << "stage (ms)" << std::right << std::setw(10) << "mean" << std::setw(10)
+            << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+        out << std::fixed << std::setprecision(3);
+        for (const auto& r : rows()) {
+            out << std::left << std::setw(16) << r.stage << std::right << std::setw(10) << r.mean << std::setw(10)
+                << r.p50 << std::setw(10) << r.p90 << std::setw(10) << r.p99 << std::setw(10) << r.max << std::endl;
+        }
+        out << std::setprecision(1) << "throughput: " << images_per_second(images_per_iteration) << " img/s"
+            << std::endl;
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    bool write_json(const std::string& path, const std::string& name, int images_per_iteration) const {
+        std::ofstream out(path);
+        if (!out.good()) {
+            std::cerr << "write " << path << " error!" << std::endl;
+            return false;
+        }
+        std::vector<Row> r = rows();
+        auto it = samples_.find("total");
+        out << "{\"name\": \"" << name << "\", \"batch\": " << images_per_iteration << ", \"iterations\": "
+            << (it == samples_.end() ? 0 : it->second.size())
+            << ", \"images_per_second\": " << images_per_second(images_per_iteration) << ", \"stages\": [";
+        for (size_t i = 0; i < r.size(); i++) {
+            out << (i ? ", " : "") << "{\"stage\": \"" << r[i].stage << "\", \"mean_ms\": " << r[i].mean
+                << ", \"p50_ms\": " << r[i].p50 << ", \"p90_ms\": " << r[i].p90 << ", \"p99_ms\": " << r[i].p99
+                << ", \"max_ms\": " << r[i].max << "}";
+        }
+        out << "]}" << std::endl;
+        return true;
+    }
+
+    // Prints the table and writes the JSON report if one was asked for.
+    bool report(const BenchOptions& opts, const std::string& name, int images_per_iteration) const {
+        std::cout << name << ": " << opts.iterations << " iterations of batch " << images_per_iteration << " after "
+                  << opts.warmup << " warmup" << std::endl;
+        print(std::cout, images_per_iteration);
+        return opts.json_path.empty() || write_json(opts.json_path, name, images_per_iteration);
+    }
+
+   private:
+    std::vector<std::string> stages_;
+    std::map<std::string, std::vector<double>> samples_;
+};
+
+// Runs step opts.warmup times untimed, then opts.iterations times. step records its own stages, the end-to-end time
+// of each iteration is added as "total".
+static inline BenchStats run_bench(const BenchOptions& opts, const std::function<void(BenchStats&)>& step) {
+    BenchStats warmup, stats;
+    for (int i = 0; i < opts.warmup; i++) {
+        step(warmup);
+    }
+    for (int i = 0; i < opts.iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        step(stats);
+        stats.add("total", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return stats;
+}
+
+// cudaEvent timing of the GPU stages of one iteration: start() before the first stage is enqueued, mark(stage) after
+// each one, collect() once the stream has been synchronized.
+class GpuStageTimer {
+   public:
+    explicit GpuStageTimer(cudaStream_t stream) : stream_(stream) {}
+    ~GpuStageTimer() {
+        for (auto& e : events_) {
+            cudaEventDestroy(e);
+        }
+    }
+    GpuStageTimer(const GpuStageTimer&) = delete;
+    GpuStageTimer& operator=(const GpuStageTimer&) = delete;
+
+    void start() {
+        stages_.clear();
+        next_ = 0;
+        record();
+    }
+
+    void mark(const std::string& stage) {
+        stages_.push_back(stage);
+        record();
+    }
+
+    void collect(BenchStats& stats) {
+        for (size_t i = 0; i < stages_.size(); i++) {
+            float ms = 0.f;
+            CUDA_CHECK(cudaEventElapsedTime(&ms, events_[i], events_[i + 1]));
+            stats.add(stages_[i], ms);
+        }
+    }
+
+   private:
+    void record() {
+        if (next_ == events_.size()) {
+            cudaEvent_t e;
+            CUDA_CHECK(cudaEventCreate(&e));
+            events_.push_back(e);
+        }
+        CUDA_CHECK(cudaEventRecord(events_[next_++], stream_));
+    }
+
+    cudaStream_t stream_;
+    std::vector<cudaEvent_t> events_;
+    std::vector<std::string> stages_;
+    size_t next_ = 0;
+};
+
+// Random BGR frames of one size, standing in for decoded camera or video input.
+static inline std::vector<cv::Mat> make_bench_images(int batch, int width, int height) {
+    std::vector<cv::Mat> imgs;
+    for (int i = 0; i < batch; i++) {
+        cv::Mat img(height, width, CV_8UC3);
+        cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(255));
+        imgs.push_back(img);
+    }
+    return imgs;
+}
+
+// Output of the yolo layer for one image as the engine writes it: a count followed by count Det entries, clustered
+// around a few objects so NMS has overlapping boxes to suppress. corners: the bbox is left, top, right, bottom
+// instead of center x, center y, w, h.
+template <typename Det>
+static inline void fill_mock_output(float* output, int output_size, int count, int input_w, int input_h,
+                                    int num_class, bool corners, std::mt19937& rng) {
+    count = std::min(count, (int)((output_size - 1) * sizeof(float) / sizeof(Det)));
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    std::normal_distribution<float> jitter(0.f, 4.f);
+    const int objects = std::max(1, count / 16);
+    std::vector<float> centers;
+    for (int i = 0; i < objects; i++) {
+        centers.push_back(uniform(rng) * input_w);
+        centers.push_back(uniform(rng) * input_h);
+        centers.push_back(16.f + uniform(rng) * input_w / 4);
+        centers.push_back(16.f + uniform(rng) * input_h / 4);
+    }
+    output[0] = count;
+    Det* dets = reinterpret_cast<Det*>(output + 1);
+    for (int i = 0; i < count; i++) {
+        const float* c = &centers[(i % objects) * 4];
+        Det det;
+        memset(&det, 0, sizeof(det));
+        float cx = c[0] + jitter(rng), cy = c[1] + jitter(rng), w = c[2] + jitter(rng), h = c[3] + jitter(rng);
+        det.bbox[0] = corners ? cx - w / 2 : cx;
+        det.bbox[1] = corners ? cy - h / 2 : cy;
+        det.bbox[2] = corners ? cx + w / 2 : w;
+        det.bbox[3] = corners ? cy + h / 2 : h;
+        det.conf = uniform(rng);
+        det.class_id = (i % objects) % num_class;
+        dets[i] = det;
+    }
+}
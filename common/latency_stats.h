@@ -0,0 +1,14 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Nearest-rank percentile, p in [0, 100]. Sorts samples in place.
+static inline double latency_percentile(std::vector<double>& samples, double p) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t rank = (size_t)std::ceil(p / 100.0 * samples.size());
+    return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include <NvInfer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Per-layer timings of an engine collected over several inferences. The layer names are the ones reported by
+// TensorRT, i.e. the names given to the layers when the network was built (fused layers are joined with " + ").
+struct LayerTiming {
+    std::string name;
+    int count;
+    float total_ms;
+    float mean_ms;
+    float p50_ms;
+    float p99_ms;
+    float max_ms;
+    float percent;  // share of the total time of all layers
+};
+
+class LayerTimingTable {
+   public:
+    void add(const std::string& layer, float ms) {
+        auto it = samples_.find(layer);
+        if (it == samples_.end()) {
+            names_.push_back(layer);
+            it = samples_.emplace(layer, std::vector<float>()).first;
+        }
+        it->second.push_back(ms);
+    }
+
+    void clear() {
+        names_.clear();
+        samples_.clear();
+    }
+
+    bool empty() const { return names_.empty(); }
+
+    // One entry per layer in execution order, percentiles are nearest rank.
+    std::vector<LayerTiming> summarize() const {
+        std::vector<LayerTiming> res;
+        float all = 0.f;
+        for (const auto& name : names_) {
+            std::vector<float> s = samples_.at(name);
+            std::sort(s.begin(), s.end());
+            LayerTiming t;
+            t.name = name;
+            t.count = (int)s.size();
+            t.total_ms = 0.f;
+            for (float v : s) {
+                t.total_ms += v;
+            }
+            t.mean_ms = t.total_ms / t.count;
+            t.p50_ms = percentile(s, 50.0);
+            t.p99_ms = percentile(s, 99.0);
+            t.max_ms = s.back();
+            t.percent = 0.f;
+            all += t.total_ms;
+            res.push_back(t);
+        }
+        for (auto& t : res) {
+            t.percent = all > 0.f ? t.total_ms * 100.f / all : 0.f;
+        }
+        return res;
+    }
+
+    void print(std::ostream& out) const {
+        std::vector<LayerTiming> rows = summarize();
+        size_t width = 10;
+        float total = 0.f;
+        int iterations = 0;
+        for (const auto& t : rows) {
+            width = std::max(width, std::min<size_t>(t.name.size(), 70));
+            total += t.total_ms;
+            iterations = std::max(iterations, t.count);
+        }
+        auto flags = out.flags();
+        auto precision = out.precision();
+        out << std::left << std::setw(width) << "layer" << std::right << std::setw(8) << "count" << std::setw(11)
+            << "mean ms" << std::setw(11) << "p50 ms" << std::setw(11) << "p99 ms" << std::setw(8) << "%" << std::endl;
+        out << std::fixed;
+        for (const auto& t : rows) {
+            std::string name = t.name.size() > width ? t.name.substr(0, width - 3) + "..." : t.name;
+            out << std::left << std::setw(width) << name << std::right << std::setw(8) << t.count << std::setprecision(4)
+                << std::setw(11) << t.mean_ms << std::setw(11) << t.p50_ms << std::setw(11) << t.p99_ms
+                << std::setprecision(1) << std::setw(8) << t.percent << std::endl;
+        }
+        out << std::setprecision(4) << "total " << (iterations > 0 ? total / iterations : 0.f) << " ms per inference over "
+            << iterations << " inferences" << std::endl;
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    bool write_csv(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out.good()) {
+            std::cerr << "write " << path << " error!" << std::endl;
+            return false;
+        }
+        out << "layer,count,total_ms,mean_ms,p50_ms,p99_ms,max_ms,percent" << std::endl;
+        for (const auto& t : summarize()) {
+            std::string name;
+            for (char c : t.name) {
+                name += c == '"' ? std::string("\"\"") : std::string(1, c);
+            }
+            out << '"' << name << "\"," << t.count << "," << t.total_ms << "," << t.mean_ms << "," << t.p50_ms << ","
+                << t.p99_ms << "," << t.max_ms << "," << t.percent << std::endl;
+        }
+        return true;
+    }
+
+    bool write_json(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out.good()) {
+            std::cerr << "write " << path << " error!" << std::endl;
+            return false;
+        }
+        std::vector<LayerTiming> rows = summarize();
+        out << "[" << std::endl;
+        for (size_t i = 0; i < rows.size(); i++) {
+            const auto& t = rows[i];
+            out << "  {\"layer\": \"" << json_escape(t.name) << "\", \"count\": " << t.count
+                << ", \"total_ms\": " << t.total_ms << ", \"mean_ms\": " << t.mean_ms << ", \"p50_ms\": " << t.p50_ms
+                << ", \"p99_ms\": " << t.p99_ms << ", \"max_ms\": " << t.max_ms << ", \"percent\": " << t.percent
+                << "}" << (i + 1 < rows.size() ? "," : "") << std::endl;
+        }
+        out << "]" << std::endl;
+        return true;
+    }
+
+    // Prints the table and writes <prefix>.csv and <prefix>.json.
+    bool report(const std::string& prefix) const {
+        print(std::cout);
+        bool ok = write_csv(prefix + ".csv") && write_json(prefix + ".json");
+        if (ok) {
+            std::cout << "layer timings written to " << prefix << ".csv and " << prefix << ".json" << std::endl;
+        }
+        return ok;
+    }
+
+   private:
+    static float percentile(const std::vector<float>& sorted, double p) {
+        size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+        return sorted[rank > 0 ? rank - 1 : 0];
+    }
+
+    static std::string json_escape(const std::string& s) {
+        std::string res;
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                res += '\\';
+                res += c;
+            } else if ((unsigned char)c < 0x20) {
+                res += ' ';
+            } else {
+                res += c;
+            }
+        }
+        return res;
+    }
+
+    std::vector<std::string> names_;
+    std::map<std::string, std::vector<float>> samples_;
+};
+
+// Attach with context->setProfiler(&profiler). TensorRT reports the layer times once the enqueued work has finished,
+// i.e. after the stream is synchronized.
+class LayerProfiler : public nvinfer1::IProfiler {
+   public:
+    void reportLayerTime(const char* layerName, float ms) noexcept override { table.add(layerName, ms); }
+
+    LayerTimingTable table;
+};
+
+// Consumes "--profile=<prefix>" and "--profile_iters=<n>" and compacts argv. An empty prefix means profiling is off,
+// n is the number of times every batch is run while profiling.
+static inline bool parse_profile_args(int& argc, char** argv, std::string& prefix, int& iters) {
+    int kept = 0;
+    for (int i = 0; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (i > 0 && arg.compare(0, 10, "--profile=") == 0) {
+            prefix = arg.substr(10);
+        } else if (i > 0 && arg.compare(0, 16, "--profile_iters=") == 0) {
+            iters = atoi(arg.substr(16).c_str());
+            if (iters <= 0) {
+                std::cerr << "invalid argument: " << arg << std::endl;
+                return false;
+            }
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    return true;
+}
@@ -0,0 +1,133 @@
+/**************************************************************************
+ * Fixed set of reusable objects (e.g. execution contexts) lent to
+ * threads with RAII leases, independent of TensorRT
+*************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trt {
+
+    template <typename T>
+    class LeasePool {
+    public:
+        // Borrowed item, handed back to the pool when the lease is destroyed. The pool must outlive its leases.
+        class Lease {
+        public:
+            Lease() = default;
+            Lease(LeasePool* pool, std::unique_ptr<T> item) : _pool(pool), _item(std::move(item)) {}
+            Lease(Lease &&other) noexcept : _pool(other._pool), _item(std::move(other._item)) { other._pool = nullptr; }
+            Lease& operator=(Lease &&other) noexcept {
+                if (this != &other) {
+                    release();
+                    _pool = other._pool;
+                    _item = std::move(other._item);
+                    other._pool = nullptr;
+                }
+                return *this;
+            }
+            Lease(const Lease &) = delete;
+            Lease& operator=(const Lease &) = delete;
+            ~Lease() { release(); }
+
+            T* operator->() { return _item.get(); }
+            T& operator*() { return *_item; }
+            explicit operator bool() const { return _item != nullptr; }
+
+            void release() {
+                if (_pool != nullptr && _item != nullptr) {
+                    _pool->giveBack(std::move(_item));
+                }
+                _pool = nullptr;
+            }
+
+        private:
+            LeasePool* _pool{nullptr};
+            std::unique_ptr<T> _item;
+        };
+
+        void add(std::unique_ptr<T> item) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _free.push_back(std::move(item));
+                _total++;
+            }
+            _cv.notify_one();
+        }
+
+        // Blocks until an item is free.
+        Lease acquire() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this] { return !_free.empty(); });
+            return take();
+        }
+
+        // Empty lease if nothing was free within timeout.
+        Lease tryAcquire(std::chrono::milliseconds timeout) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (!_cv.wait_for(lock, timeout, [this] { return !_free.empty(); })) {
+                return Lease();
+            }
+            return take();
+        }
+
+        size_t size() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _total;
+        }
+
+        size_t available() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _free.size();
+        }
+
+    private:
+        Lease take() {
+            std::unique_ptr<T> item = std::move(_free.back());
+            _free.pop_back();
+            return Lease(this, std::move(item));
+        }
+
+        void giveBack(std::unique_ptr<T> item) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _free.push_back(std::move(item));
+            }
+            _cv.notify_one();
+        }
+
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        std::vector<std::unique_ptr<T>> _free;
+        size_t _total{0};
+    };
+
+    // Number of contexts that fit in budget_bytes of device memory next to the shared weights, at least 1.
+    inline int poolSizeForBudget(size_t budget_bytes, size_t shared_bytes, size_t per_context_bytes, int max_contexts) {
+        if (per_context_bytes == 0 || budget_bytes <= shared_bytes + per_context_bytes) {
+            return 1;
+        }
+        size_t n = (budget_bytes - shared_bytes) / per_context_bytes;
+        return (int)std::min<size_t>(n, (size_t)max_contexts);
+    }
+
+    // Compares n threads sharing one engine with n threads each deserializing their own.
+    inline void printPoolMemoryReport(size_t shared_bytes, size_t per_context_bytes, int n) {
+        const double mb = 1024.0 * 1024.0;
+        double pooled = (shared_bytes + n * per_context_bytes) / mb;
+        double per_thread = n * (shared_bytes + per_context_bytes) / mb;
+        std::cout << "engine weights " << shared_bytes / mb << "MB, per context " << per_context_bytes / mb << "MB"
+                  << std::endl;
+        std::cout << n << " contexts on one engine: " << pooled << "MB, " << n << " engines: " << per_thread
+                  << "MB, saved " << shared_bytes / mb << "MB per extra thread" << std::endl;
+    }
+
+}
@@ -0,0 +1,150 @@
+#include "ReplicaScheduler.h"
+#include <assert.h>
+#include <iostream>
+
+namespace trt {
+
+    ReplicaScheduler::ReplicaScheduler(std::vector<std::unique_ptr<IReplica>> replicas, bool work_stealing)
+        : _replicas(std::move(replicas))
+        , _queues(_replicas.size())
+        , _broken(_replicas.size(), false)
+        , _live(_replicas.size())
+        , _workStealing(work_stealing)
+        , _start(std::chrono::steady_clock::now()) {
+
+        assert(!_replicas.empty());
+        for (size_t i = 0; i < _replicas.size(); ++i) {
+            _stats.push_back(ReplicaStats{_replicas[i]->getDeviceID(), 0, 0, 0, 0.0, 0.0});
+        }
+        for (size_t i = 0; i < _replicas.size(); ++i) {
+            _workers.emplace_back(&ReplicaScheduler::workerLoop, this, (int)i);
+        }
+    }
+
+    ReplicaScheduler::~ReplicaScheduler() {
+        shutdown();
+    }
+
+    std::future<std::vector<float>> ReplicaScheduler::submit(std::vector<cv::Mat> batch) {
+        auto task = std::make_shared<Task>();
+        task->batch = std::move(batch);
+        auto future = task->output.get_future();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_live == 0) {
+                task->output.set_value(std::vector<float>());
+                return future;
+            }
+            // shortest queue of a working replica, ties go round robin
+            size_t start = _next++ % _queues.size();
+            int best = -1;
+            for (size_t k = 0; k < _queues.size(); ++k) {
+                size_t i = (start + k) % _queues.size();
+                if (!_broken[i] && (best < 0 || _queues[i].size() < _queues[best].size())) {
+                    best = i;
+                }
+            }
+            _queues[best].push_back(task);
+        }
+        _cv.notify_all();
+        return future;
+    }
+
+    void ReplicaScheduler::shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _cv.notify_all();
+        for (auto &worker : _workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    std::vector<ReplicaStats> ReplicaScheduler::getStats() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+        std::vector<ReplicaStats> stats = _stats;
+        for (auto &s : stats) {
+            s.utilization = elapsed_ms > 0 ? s.busy_ms / elapsed_ms : 0.0;
+        }
+        return stats;
+    }
+
+    bool ReplicaScheduler::popTask(int idx, std::shared_ptr<Task> &task, bool &stolen) {
+        if (!_queues[idx].empty()) {
+            task = _queues[idx].front();
+            _queues[idx].pop_front();
+            stolen = false;
+            return true;
+        }
+        if (!_workStealing) {
+            return false;
+        }
+        // steal the newest batch of the longest queue, its owner is the furthest behind
+        int victim = -1;
+        for (size_t i = 0; i < _queues.size(); ++i) {
+            if (!_queues[i].empty() && (victim < 0 || _queues[i].size() > _queues[victim].size())) {
+                victim = i;
+            }
+        }
+        if (victim < 0) {
+            return false;
+        }
+        task = _queues[victim].back();
+        _queues[victim].pop_back();
+        stolen = true;
+        return true;
+    }
+
+    void ReplicaScheduler::failQueue(size_t idx) {
+        for (auto &t : _queues[idx]) {
+            t->output.set_value(std::vector<float>());
+        }
+        _queues[idx].clear();
+    }
+
+    void ReplicaScheduler::workerLoop(int idx) {
+        IReplica &replica = *_replicas[idx];
+        bool ready = replica.init();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (!ready) {
+            std::cerr << "replica " << idx << " on device " << replica.getDeviceID() << " failed to initialize"
+                      << std::endl;
+            _broken[idx] = true;
+            --_live;
+            // with stealing, the working replicas drain its queue. Without, or with none left, nobody ever will.
+            for (size_t i = 0; i < _queues.size(); ++i) {
+                if (_live == 0 || (!_workStealing && i == (size_t)idx)) {
+                    failQueue(i);
+                }
+            }
+            return;
+        }
+        while (true) {
+            std::shared_ptr<Task> task;
+            bool stolen = false;
+            _cv.wait(lock, [&] { return popTask(idx, task, stolen) || _stopping; });
+            if (!task) {
+                return;
+            }
+            lock.unlock();
+
+            auto t0 = std::chrono::steady_clock::now();
+            std::vector<float> output;
+            bool ok = replica.infer(task->batch, output);
+            auto t1 = std::chrono::steady_clock::now();
+            task->output.set_value(ok ? std::move(output) : std::vector<float>());
+
+            lock.lock();
+            _stats[idx].batches++;
+            _stats[idx].images += task->batch.size();
+            _stats[idx].stolen += stolen;
+            _stats[idx].busy_ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        }
+    }
+
+}
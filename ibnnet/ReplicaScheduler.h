@@ -0,0 +1,82 @@
+/**************************************************************************
+ * Spread batches over several engine replicas (one per GPU, or several
+ * per GPU) with work stealing, so a slow replica does not hold up the tail
+*************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace trt {
+
+    // One engine instance with its own device, stream and buffers. All calls come from the replica's worker thread.
+    class IReplica {
+    public:
+        virtual ~IReplica() {}
+        virtual int getDeviceID() const = 0;
+        // Called once on the worker thread before the first batch, e.g. to set the device and deserialize.
+        virtual bool init() = 0;
+        // Runs one batch synchronously and returns output_size floats per image.
+        virtual bool infer(const std::vector<cv::Mat> &batch, std::vector<float> &output) = 0;
+    };
+
+    struct ReplicaStats {
+        int device_id;
+        uint64_t batches;
+        uint64_t images;
+        uint64_t stolen;    /* batches taken from another replica's queue */
+        double busy_ms;
+        double utilization; /* busy time over the scheduler's lifetime */
+    };
+
+    class ReplicaScheduler {
+    public:
+        // work_stealing = false keeps each batch on the replica it was assigned to (static partitioning).
+        explicit ReplicaScheduler(std::vector<std::unique_ptr<IReplica>> replicas, bool work_stealing = true);
+        ~ReplicaScheduler();
+
+        ReplicaScheduler(const ReplicaScheduler &) = delete;
+        ReplicaScheduler& operator=(const ReplicaScheduler &) = delete;
+
+        // Queues a batch on the working replica with the fewest queued batches. The future holds the output, or is
+        // empty if the replica failed or every replica failed to initialize.
+        std::future<std::vector<float>> submit(std::vector<cv::Mat> batch);
+
+        // Finishes the queued batches and joins the workers.
+        void shutdown();
+
+        std::vector<ReplicaStats> getStats();
+
+    private:
+        struct Task {
+            std::vector<cv::Mat> batch;
+            std::promise<std::vector<float>> output;
+        };
+
+        void workerLoop(int idx);
+        bool popTask(int idx, std::shared_ptr<Task> &task, bool &stolen);
+        void failQueue(size_t idx);
+
+        std::vector<std::unique_ptr<IReplica>> _replicas;
+        std::vector<std::deque<std::shared_ptr<Task>>> _queues;
+        std::vector<ReplicaStats> _stats;
+        std::vector<bool> _broken;  /* failed to initialize, gets no more batches */
+        size_t _live;               /* replicas not broken, including those still initializing */
+        std::vector<std::thread> _workers;
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        bool _stopping{false};
+        bool _workStealing;
+        size_t _next{0};
+        std::chrono::steady_clock::time_point _start;
+    };
+
+}
@@ -0,0 +1,79 @@
+#include "SharedEngine.h"
+
+namespace trt {
+
+    ExecutionSlot::ExecutionSlot(nvinfer1::ICudaEngine &engine, const EngineConfig &enginecfg): _engineCfg(enginecfg) {
+
+        CHECK(cudaSetDevice(_engineCfg.device_id));
+
+        _context = make_holder(engine.createExecutionContext());
+        assert(_context);
+
+        CHECK(cudaStreamCreate(&_stream));
+
+        assert(engine.getNbBindings() == 2);
+        _inputIndex = engine.getBindingIndex(_engineCfg.input_name);
+        _outputIndex = engine.getBindingIndex(_engineCfg.output_name);
+
+        _inputSize = 3 * _engineCfg.input_h * _engineCfg.input_w * sizeof(float);
+        _outputSize = _engineCfg.output_size * sizeof(float);
+
+        CHECK(cudaMallocHost((void**)&_data, _engineCfg.max_batch_size * _inputSize));
+        CHECK(cudaMallocHost((void**)&_prob, _engineCfg.max_batch_size * _outputSize));
+        CHECK(cudaMalloc(&_buffers[_inputIndex], _engineCfg.max_batch_size * _inputSize));
+        CHECK(cudaMalloc(&_buffers[_outputIndex], _engineCfg.max_batch_size * _outputSize));
+    }
+
+    ExecutionSlot::~ExecutionSlot() {
+        CHECK(cudaStreamDestroy(_stream));
+        CHECK(cudaFreeHost(_data));
+        CHECK(cudaFreeHost(_prob));
+        CHECK(cudaFree(_buffers[_inputIndex]));
+        CHECK(cudaFree(_buffers[_outputIndex]));
+    }
+
+    bool ExecutionSlot::doInference(const int inference_batch_size, std::function<void(float*)> preprocessing) {
+        assert(inference_batch_size <= _engineCfg.max_batch_size);
+        preprocessing(_data);
+        CHECK(cudaSetDevice(_engineCfg.device_id));
+        CHECK(cudaMemcpyAsync(_buffers[_inputIndex], _data, inference_batch_size * _inputSize, cudaMemcpyHostToDevice, _stream));
+        auto status = _context->enqueue(inference_batch_size, _buffers, _stream, nullptr);
+        CHECK(cudaMemcpyAsync(_prob, _buffers[_outputIndex], inference_batch_size * _outputSize, cudaMemcpyDeviceToHost, _stream));
+        CHECK(cudaStreamSynchronize(_stream));
+        return status;
+    }
+
+    SharedEngine::SharedEngine(const EngineConfig &enginecfg): _engineCfg(enginecfg) {
+
+        assert(_engineCfg.max_batch_size > 0);
+
+        CHECK(cudaSetDevice(_engineCfg.device_id));
+
+        _runtime = make_holder(nvinfer1::createInferRuntime(gLogger));
+        assert(_runtime);
+
+        _engine = make_holder(_runtime->deserializeCudaEngine(_engineCfg.trtModelStream.get(), _engineCfg.stream_size));
+        assert(_engine);
+    }
+
+    size_t SharedEngine::contextMemoryBytes() {
+        size_t io = _engineCfg.max_batch_size * (3 * _engineCfg.input_h * _engineCfg.input_w + _engineCfg.output_size) * sizeof(float);
+        return _engine->getDeviceMemorySize() + io;
+    }
+
+    int SharedEngine::createContexts(size_t device_budget_bytes, int max_contexts) {
+        CHECK(cudaSetDevice(_engineCfg.device_id));
+        if (device_budget_bytes == 0) {
+            size_t free_bytes = 0, total_bytes = 0;
+            CHECK(cudaMemGetInfo(&free_bytes, &total_bytes));
+            // the weights are already resident, the whole budget goes to contexts
+            device_budget_bytes = free_bytes * 9 / 10 + sharedMemoryBytes();
+        }
+        int n = poolSizeForBudget(device_budget_bytes, sharedMemoryBytes(), contextMemoryBytes(), max_contexts);
+        for (int i = 0; i < n; ++i) {
+            _pool.add(std::unique_ptr<ExecutionSlot>(new ExecutionSlot(*_engine, _engineCfg)));
+        }
+        return n;
+    }
+
+}
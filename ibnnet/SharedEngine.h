@@ -0,0 +1,70 @@
+/**************************************************************************
+ * One deserialized engine shared by several threads: the weights are
+ * loaded once and every thread borrows an execution context with its own
+ * stream and buffers from a pool
+*************************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "InferenceEngine.h"
+#include "LeasePool.h"
+
+namespace trt {
+
+    // Execution context with its own stream, pinned host buffers and device buffers.
+    class ExecutionSlot {
+    public:
+        ExecutionSlot(nvinfer1::ICudaEngine &engine, const EngineConfig &enginecfg);
+        ~ExecutionSlot();
+
+        ExecutionSlot(const ExecutionSlot &) = delete;
+        ExecutionSlot& operator=(const ExecutionSlot &) = delete;
+
+        bool doInference(const int inference_batch_size, std::function<void(float*)> preprocessing);
+        float* getOutput() { return _prob; }
+
+    private:
+        EngineConfig _engineCfg;
+        TensorRTHolder<nvinfer1::IExecutionContext> _context{nullptr};
+        cudaStream_t _stream;
+        float* _data{nullptr};
+        float* _prob{nullptr};
+        void* _buffers[2];
+        int _inputIndex;
+        int _outputIndex;
+        int _inputSize;  /* bytes per image */
+        int _outputSize;
+    };
+
+    class SharedEngine {
+    public:
+        using Pool = LeasePool<ExecutionSlot>;
+
+        // Deserializes enginecfg.trtModelStream once on enginecfg.device_id.
+        explicit SharedEngine(const EngineConfig &enginecfg);
+
+        SharedEngine(const SharedEngine &) = delete;
+        SharedEngine& operator=(const SharedEngine &) = delete;
+
+        // Creates as many contexts as fit in device_budget_bytes (at most max_contexts, at least 1) and returns the
+        // count. A budget of 0 uses 90% of the currently free device memory.
+        int createContexts(size_t device_budget_bytes, int max_contexts);
+
+        Pool& pool() { return _pool; }
+
+        // Weights and other per-engine memory, estimated by the plan size.
+        size_t sharedMemoryBytes() const { return _engineCfg.stream_size; }
+        // Activations plus input/output buffers of one context.
+        size_t contextMemoryBytes();
+
+    private:
+        EngineConfig _engineCfg;
+        TensorRTHolder<nvinfer1::IRuntime> _runtime{nullptr};
+        TensorRTHolder<nvinfer1::ICudaEngine> _engine{nullptr};
+        Pool _pool;  /* declared last, the contexts go before the engine */
+    };
+
+}
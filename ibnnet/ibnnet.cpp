@@ -143,7 +143,7 @@ namespace trt {
         return true;
     }
 
-    bool IBNNet::deserializeEngine() {
+    bool IBNNet::readEngineFile() {
         std::ifstream file("./ibnnet.engine", std::ios::binary | std::ios::in);
         if (file.good()) {
             file.seekg(0, file.end);
@@ -153,13 +153,28 @@ namespace trt {
             assert(_engineCfg.trtModelStream.get());
             file.read(_engineCfg.trtModelStream.get(), _engineCfg.stream_size);
             file.close();
-    
+            return true;
+        }
+        return false;
+    }
+
+    bool IBNNet::deserializeEngine() {
+        if (readEngineFile()) {
             _inferEngine = make_unique<trt::InferenceEngine>(_engineCfg);
             return true;
         }
         return false;
     }
 
+    bool IBNNet::deserializeSharedEngine(size_t device_budget_bytes, int max_contexts) {
+        if (readEngineFile()) {
+            _sharedEngine = make_unique<trt::SharedEngine>(_engineCfg);
+            _sharedEngine->createContexts(device_budget_bytes, max_contexts);
+            return true;
+        }
+        return false;
+    }
+
     void IBNNet::preprocessing(const cv::Mat& img, float* const data, const std::size_t stride) {
         for (std::size_t i = 0; i < stride; ++i) { 
             data[i] = img.at<cv::Vec3b>(i)[2] / 255.0; 
@@ -184,6 +199,25 @@ namespace trt {
         }
     }
 
+    bool IBNNet::inferenceShared(const std::vector<cv::Mat> &input, std::vector<float> &output) {
+        if(_sharedEngine == nullptr) {
+            return false;
+        }
+        const std::size_t stride = _engineCfg.input_w * _engineCfg.input_h;
+        auto slot = _sharedEngine->pool().acquire();
+        bool status = slot->doInference(input.size(),
+            [&](float* data) {
+                for(const auto &img : input) {
+                    preprocessing(img, data, stride);
+                    data += 3 * stride;
+                }
+            }
+        );
+        float* prob = slot->getOutput();
+        output.assign(prob, prob + input.size() * _engineCfg.output_size);
+        return status;
+    }
+
     float* IBNNet::getOutput() { 
         if(_inferEngine != nullptr) 
             return _inferEngine.get()->getOutput(); 
@@ -4,6 +4,7 @@
 #include "holder.h"
 #include "layers.h"
 #include "InferenceEngine.h"
+#include "SharedEngine.h"
 #include <memory>
 #include <vector>
 #include <chrono>
@@ -28,16 +29,24 @@ namespace trt {
         bool deserializeEngine();
         bool inference(std::vector<cv::Mat> &input); /* support batch inference */
 
+        /* one engine, contexts pooled under a device memory budget (0: 90% of free memory) */
+        bool deserializeSharedEngine(size_t device_budget_bytes, int max_contexts);
+        /* thread safe, borrows a context from the shared engine and copies its output */
+        bool inferenceShared(const std::vector<cv::Mat> &input, std::vector<float> &output);
+        trt::SharedEngine* getSharedEngine() { return _sharedEngine.get(); }
+
         float* getOutput(); 
         int getDeviceID(); /* cuda deviceid */ 
 
     private:
         ICudaEngine *createEngine(IBuilder *builder, IBuilderConfig *config);
+        bool readEngineFile();
         void preprocessing(const cv::Mat& img, float* const data, const std::size_t stride);
 
     private:
         trt::EngineConfig _engineCfg;
         std::unique_ptr<trt::InferenceEngine> _inferEngine{nullptr};
+        std::unique_ptr<trt::SharedEngine> _sharedEngine{nullptr};
         std::string _ibn;
         DataType _dt{DataType::kFLOAT};
     };
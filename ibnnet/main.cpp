@@ -1,8 +1,11 @@
+#include <atomic>
 #include <thread>
 #include <vector>
 #include <memory>
 #include "ibnnet.h"
 #include "InferenceEngine.h"
+#include "ReplicaScheduler.h"
+#include "LeasePool.h"
 
 // stuff we know about the network and the input/output blobs
 static const int MAX_BATCH_SIZE = 4;
@@ -47,6 +50,143 @@ void run_infer(std::shared_ptr<trt::IBNNet> model) {
     }
 }
 
+/* ibnnet on one device, run by the replica scheduler */
+class IBNNetReplica : public trt::IReplica {
+public:
+    IBNNetReplica(trt::EngineConfig cfg, int device_id) : _cfg(cfg) { _cfg.device_id = device_id; }
+    int getDeviceID() const override { return _cfg.device_id; }
+    bool init() override {
+        CHECK(cudaSetDevice(_cfg.device_id));
+        _model = std::make_shared<trt::IBNNet>(_cfg, trt::IBN::A);
+        return _model->deserializeEngine();
+    }
+    bool infer(const std::vector<cv::Mat> &batch, std::vector<float> &output) override {
+        std::vector<cv::Mat> input(batch);
+        if (!_model->inference(input)) {
+            return false;
+        }
+        float* prob = _model->getOutput();
+        output.assign(prob, prob + batch.size() * OUTPUT_SIZE);
+        return true;
+    }
+private:
+    trt::EngineConfig _cfg;
+    std::shared_ptr<trt::IBNNet> _model;
+};
+
+/* simulated device, a batch takes batch size * ms_per_image * slowdown */
+class MockReplica : public trt::IReplica {
+public:
+    MockReplica(int device_id, double ms_per_image, double slowdown, bool init_ok = true)
+        : _deviceID(device_id), _msPerImage(ms_per_image), _slowdown(slowdown), _initOK(init_ok) {}
+    int getDeviceID() const override { return _deviceID; }
+    bool init() override { return _initOK; }
+    bool infer(const std::vector<cv::Mat> &batch, std::vector<float> &output) override {
+        std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(batch.size() * _msPerImage * _slowdown * 1000)));
+        output.assign(batch.size() * OUTPUT_SIZE, 0.f);
+        return true;
+    }
+private:
+    int _deviceID;
+    double _msPerImage;
+    double _slowdown;
+    bool _initOK;
+};
+
+void print_replica_stats(trt::ReplicaScheduler &scheduler) {
+    for (const auto &s : scheduler.getStats()) {
+        std::cout << "device " << s.device_id << ": " << s.batches << " batches, " << s.images << " images, "
+                  << s.stolen << " stolen, busy " << s.busy_ms << "ms, utilization " << s.utilization * 100 << "%"
+                  << std::endl;
+    }
+}
+
+/* 4 simulated devices, the last one throttled to 1/3 speed, with and without work stealing */
+void run_mock_replicas() {
+    const int num_batches = 200;
+    const double slowdown[] = {1.0, 1.0, 1.0, 3.0};
+    for (bool stealing : {false, true}) {
+        std::vector<std::unique_ptr<trt::IReplica>> replicas;
+        for (int i = 0; i < 4; ++i) {
+            replicas.emplace_back(new MockReplica(i, 0.5, slowdown[i]));
+        }
+        trt::ReplicaScheduler scheduler(std::move(replicas), stealing);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::future<std::vector<float>>> results;
+        for (int i = 0; i < num_batches; ++i) {
+            results.emplace_back(scheduler.submit(std::vector<cv::Mat>(MAX_BATCH_SIZE)));
+        }
+        for (auto &r : results) {
+            r.wait();
+        }
+        auto end = std::chrono::steady_clock::now();
+        std::cout << (stealing ? "work stealing: " : "static partitioning: ")
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms for "
+                  << num_batches << " batches" << std::endl;
+        print_replica_stats(scheduler);
+    }
+
+    /* no replica comes up: the batches must come back empty instead of waiting forever */
+    std::vector<std::unique_ptr<trt::IReplica>> broken;
+    for (int i = 0; i < 2; ++i) {
+        broken.emplace_back(new MockReplica(i, 0.5, 1.0, false));
+    }
+    trt::ReplicaScheduler scheduler(std::move(broken));
+    std::vector<std::future<std::vector<float>>> results;
+    for (int i = 0; i < 10; ++i) {
+        results.emplace_back(scheduler.submit(std::vector<cv::Mat>(MAX_BATCH_SIZE)));
+    }
+    int failed = 0;
+    for (auto &r : results) {
+        failed += r.get().empty();
+    }
+    std::cout << "no working replica: " << failed << " of " << results.size() << " batches failed" << std::endl;
+}
+
+/* fake context for the lease pool, counts how many leases overlap */
+struct MockContext {
+    int id;
+    std::atomic<int>* inUse;
+    std::atomic<int>* maxInUse;
+    void infer() {
+        int now = ++(*inUse);
+        int seen = maxInUse->load();
+        while (now > seen && !maxInUse->compare_exchange_weak(seen, now)) {}
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        --(*inUse);
+    }
+};
+
+/* 8 threads borrowing from a pool sized by a simulated memory budget, no GPU needed */
+void run_mock_pool() {
+    const size_t mb = 1024 * 1024;
+    const size_t weights = 100 * mb, per_context = 60 * mb, budget = 400 * mb;
+    const int mthreads = 8, iterations = 50;
+
+    int n = trt::poolSizeForBudget(budget, weights, per_context, mthreads);
+    std::atomic<int> in_use{0}, max_in_use{0};
+    trt::LeasePool<MockContext> pool;
+    for (int i = 0; i < n; ++i) {
+        pool.add(std::unique_ptr<MockContext>(new MockContext{i, &in_use, &max_in_use}));
+    }
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < mthreads; ++t) {
+        workers.emplace_back([&] {
+            for (int i = 0; i < iterations; ++i) {
+                auto ctx = pool.acquire();
+                ctx->infer();
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    std::cout << mthreads << " threads on " << n << " contexts, at most " << max_in_use << " leased at once, "
+              << pool.available() << "/" << pool.size() << " returned" << std::endl;
+    trt::printPoolMemoryReport(weights, per_context, n);
+}
+
 int main(int argc, char** argv) {
 
     trt::EngineConfig engineCfg { 
@@ -88,11 +228,73 @@ int main(int argc, char** argv) {
             worker.join();
         } 
 
+        return 0;
+    } else if (argc == 2 && std::string(argv[1]) == "-r") {
+
+        /* one replica per visible device, batches are balanced between them with work stealing */
+        int device_count = 0;
+        CHECK(cudaGetDeviceCount(&device_count));
+        std::vector<std::unique_ptr<trt::IReplica>> replicas;
+        for (int i = 0; i < device_count; ++i) {
+            replicas.emplace_back(new IBNNetReplica(engineCfg, i));
+        }
+        trt::ReplicaScheduler scheduler(std::move(replicas));
+        std::vector<std::future<std::vector<float>>> results;
+        for (int i = 0; i < 100; ++i) {
+            std::vector<cv::Mat> batch(MAX_BATCH_SIZE, cv::Mat(INPUT_H, INPUT_W, CV_8UC3, cv::Scalar(255,255,255)));
+            results.emplace_back(scheduler.submit(batch));
+        }
+        int failed = 0;
+        for (auto &r : results) {
+            failed += r.get().empty();
+        }
+        print_replica_stats(scheduler);
+        if (failed > 0) {
+            std::cerr << failed << " of " << results.size() << " batches failed" << std::endl;
+            return -1;
+        }
+        return 0;
+    } else if (argc == 2 && std::string(argv[1]) == "-mock") {
+        run_mock_replicas();
+        return 0;
+    } else if (argc == 2 && std::string(argv[1]) == "-p") {
+
+        /* one CudaEngine shared by mthreads, each inference borrows one of its execution contexts */
+        int mthreads = 4;
+        trt::IBNNet model(engineCfg, trt::IBN::A);
+        CHECK(cudaSetDevice(model.getDeviceID()));
+        if (!model.deserializeSharedEngine(0, mthreads)) {
+            std::cout << "DeserializeEngine Failed." << std::endl;
+            return -1;
+        }
+        std::vector<std::thread> workers;
+        for (int i = 0; i < mthreads; ++i) {
+            workers.emplace_back([&] {
+                CHECK(cudaSetDevice(model.getDeviceID()));
+                std::vector<cv::Mat> input(MAX_BATCH_SIZE, cv::Mat(INPUT_H, INPUT_W, CV_8UC3, cv::Scalar(255,255,255)));
+                std::vector<float> output;
+                for (int k = 0; k < 100; ++k) {
+                    model.inferenceShared(input, output);
+                }
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        trt::SharedEngine* shared = model.getSharedEngine();
+        trt::printPoolMemoryReport(shared->sharedMemoryBytes(), shared->contextMemoryBytes(), shared->pool().size());
+        return 0;
+    } else if (argc == 2 && std::string(argv[1]) == "-mockpool") {
+        run_mock_pool();
         return 0;
     } else {
         std::cerr << "arguments not right!" << std::endl;
         std::cerr << "./ibnnet -s  // serialize model to plan file" << std::endl;
         std::cerr << "./ibnnet -d  // deserialize plan file and run inference" << std::endl;
+        std::cerr << "./ibnnet -r  // run batches on every visible GPU through the replica scheduler" << std::endl;
+        std::cerr << "./ibnnet -mock  // replica scheduler on simulated devices, no GPU needed" << std::endl;
+        std::cerr << "./ibnnet -p  // threads share one engine and borrow pooled execution contexts" << std::endl;
+        std::cerr << "./ibnnet -mockpool  // context pool with fake contexts, no GPU needed" << std::endl;
         return -1;
     }
 }
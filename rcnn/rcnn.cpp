@@ -8,6 +8,7 @@
 #include "BatchedNmsPlugin.h"
 #include "MaskRcnnInferencePlugin.h"
 #include "calibrator.hpp"
+#include "profiler.h"
 
 #define DEVICE 0
 #define BATCH_SIZE 1
@@ -406,10 +407,15 @@ int main(int argc, char** argv) {
     std::string engineFile = "";
 
     std::string imgDir;
-    if (!parse_args(argc, argv, wtsFile, engineFile, imgDir)) {
+    std::string profilePrefix;
+    int profileIters = 1;
+    if (!parse_profile_args(argc, argv, profilePrefix, profileIters) ||
+        !parse_args(argc, argv, wtsFile, engineFile, imgDir)) {
         std::cerr << "arguments not right!" << std::endl;
         std::cerr << "./rcnn -s [.wts] [.engine] [m] // serialize model to plan file" << std::endl;
         std::cerr << "./rcnn -d [.engine] ../samples [m]  // deserialize plan file and run inference" << std::endl;
+        std::cerr << "optional with -d: --profile=[output prefix] --profile_iters=10  // per-layer timings as csv/json"
+        << std::endl;
         return -1;
     }
 
@@ -488,6 +494,11 @@ int main(int argc, char** argv) {
         outputs.push_back(masks_h.data());
     }
 
+    LayerProfiler profiler;
+    if (!profilePrefix.empty()) {
+        context->setProfiler(&profiler);
+    }
+
     int fcount = 0;
     int fileLen = fileList.size();
     for (int f = 0; f < fileLen; f++) {
@@ -512,6 +523,10 @@ int main(int argc, char** argv) {
 
         auto end = std::chrono::system_clock::now();
         std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms" << std::endl;
+        // rerun the same input so every layer has profileIters samples per batch
+        for (int k = 1; !profilePrefix.empty() && k < profileIters; k++) {
+            doInference(*context, stream, buffers, data, outputs);
+        }
 
         float h_ratio = static_cast<float>(h_ori) / (INPUT_H - (Y_TOP_PAD + Y_BOTTOM_PAD));  // ratio of original image size to model input size
         float w_ratio = static_cast<float>(w_ori) / (INPUT_W - (X_LEFT_PAD + X_RIGHT_PAD));
@@ -560,6 +575,10 @@ int main(int argc, char** argv) {
         fcount = 0;
     }
 
+    if (!profilePrefix.empty()) {
+        profiler.table.report(profilePrefix);
+    }
+
     cudaStreamDestroy(stream);
     CUDA_CHECK(cudaFree(data_d));
     CUDA_CHECK(cudaFree(scores_d));
@@ -4,7 +4,9 @@
 #include "postprocess.hpp"// postprocess plugin 
 #include "logging.h"
 #include "utils.h"
+#include "tiling.h"
 #include <unistd.h>//access()
+#include <memory>
 
 #define DEVICE 0 // GPU id
 #define BATCH_SIZE 1
@@ -16,6 +18,8 @@ static const int INPUT_H = 640;
 static const int INPUT_W = 448;
 static const int INPUT_C = 3;
 static const int OUT_SCALE = 4;
+static const int TILE_OVERLAP = 16; // input pixels shared by neighbouring tiles, blended in the output
+static const long long MAX_FRAME_PIXELS = 8192LL * 8192; // larger outputs are streamed to ../_<name>.ppm row by row
 static const int OUTPUT_SIZE = INPUT_C * INPUT_H * OUT_SCALE * INPUT_W * OUT_SCALE;
 const char* INPUT_BLOB_NAME = "data";
 const char* OUTPUT_BLOB_NAME = "prob";
@@ -248,30 +252,57 @@ int main(int argc, char** argv) {
     cudaStream_t stream;
     CUDA_CHECK(cudaStreamCreate(&stream));
 
-    std::vector<cv::Mat> imgs_buffer(BATCH_SIZE);
     for (int f = 0; f < (int)file_names.size(); f++) {
-
-        for (int b = 0; b < BATCH_SIZE; b++) {
-            cv::Mat img = cv::imread(img_dir + "/" + file_names[f]);
-            if (img.empty()) continue;
-            memcpy(input.data() + b * INPUT_H * INPUT_W * INPUT_C, img.data, INPUT_H * INPUT_W * INPUT_C);
+        cv::Mat img = cv::imread(img_dir + "/" + file_names[f]);
+        if (img.empty()) continue;
+
+        // the engine input is fixed, so the image goes through it in overlapping tiles
+        SrTilePlan plan(img.cols, img.rows, INPUT_W, INPUT_H, TILE_OVERLAP, OUT_SCALE);
+        cv::Size out_size = plan.output_size();
+        cv::Mat frame;
+        std::unique_ptr<SrPpmWriter> ppm;
+        if ((long long)out_size.width * out_size.height > MAX_FRAME_PIXELS) {
+            ppm.reset(new SrPpmWriter("../_" + file_names[f] + ".ppm", out_size.width, out_size.height));
+        } else {
+            frame.create(out_size, CV_8UC3);
         }
+        SrStitcher stitcher(plan, [&](int y, const uint8_t* row) {
+            if (ppm) {
+                ppm->write_row(row);
+            } else {
+                memcpy(frame.ptr<uint8_t>(y), row, out_size.width * INPUT_C);
+            }
+        });
 
-        CUDA_CHECK(cudaMemcpyAsync(buffers[inputIndex], input.data(), BATCH_SIZE * INPUT_C * INPUT_H * INPUT_W * sizeof(uint8_t), cudaMemcpyHostToDevice, stream));
-
-        // Run inference
         auto start = std::chrono::system_clock::now();
-        doInference(*context, stream, (void**)buffers, outputs.data(), BATCH_SIZE);
+        const int tiles = plan.rows() * plan.cols();
+        for (int t = 0; t < tiles; t += BATCH_SIZE) {
+            int batch = std::min(BATCH_SIZE, tiles - t);
+            for (int b = 0; b < batch; b++) {
+                plan.fill_tile(img, (t + b) / plan.cols(), (t + b) % plan.cols(), input.data() + b * INPUT_H * INPUT_W * INPUT_C);
+            }
+            CUDA_CHECK(cudaMemcpyAsync(buffers[inputIndex], input.data(), batch * INPUT_C * INPUT_H * INPUT_W * sizeof(uint8_t), cudaMemcpyHostToDevice, stream));
+            doInference(*context, stream, (void**)buffers, outputs.data(), batch);
+            for (int b = 0; b < batch; b++) {
+                stitcher.add_tile((t + b) / plan.cols(), (t + b) % plan.cols(), outputs.data() + b * OUTPUT_SIZE);
+            }
+        }
         auto end = std::chrono::system_clock::now();
-        std::cout << "inference time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms" << std::endl;
-    }
-
-    cv::Mat frame = cv::Mat(INPUT_H * OUT_SCALE, INPUT_W * OUT_SCALE, CV_8UC3, outputs.data());
-    cv::imwrite("../_" + file_names[0] + ".png", frame);
+        assert(stitcher.done());
+        std::cout << file_names[f] << ": " << img.cols << "x" << img.rows << " -> " << out_size.width << "x" << out_size.height << ", " << tiles << " tiles, inference time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms" << std::endl;
+
+        if (ppm) {
+            if (!ppm->good()) {
+                std::cerr << "write ../_" << file_names[f] << ".ppm error!" << std::endl;
+            }
+            continue;
+        }
+        cv::imwrite("../_" + file_names[f] + ".png", frame);
 
-    if (VISUALIZATION) {
-        cv::imshow("result : " + file_names[0], frame);
-        cv::waitKey(0);
+        if (VISUALIZATION) {
+            cv::imshow("result : " + file_names[f], frame);
+            cv::waitKey(0);
+        }
     }
 
     // Release stream and buffers
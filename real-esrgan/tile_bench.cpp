@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include "tiling.h"
+
+// CPU checks and benchmark of the tiling, blending and stitching of real-esrgan, with a mock engine that upscales
+// tiles by pixel repetition.
+//   ./real-esrgan_tile_bench [width] [height]
+// Checks that the tiles cover the image with the requested overlap, that the blend weights sum to 1, that stitching
+// mock output reproduces the upscaled image exactly whatever the tile order, that a brightness offset between
+// neighbouring tiles is feathered instead of showing a seam, that rows streamed to a PPM file give the same image, and
+// that memory for an 8K input stays at two tile rows.
+// Exits 1 on a failure. Then times the host work for an image of the given size with the real engine shape.
+
+static const int TILE_W = 448;
+static const int TILE_H = 640;
+static const int OVERLAP = 16;
+static const int SCALE = 4;
+
+static bool check(bool ok, const char* what) {
+    std::cout << (ok ? "ok    " : "FAIL  ") << what << std::endl;
+    return ok;
+}
+
+static void make_image(cv::Mat& img) {
+    for (int y = 0; y < img.rows; y++) {
+        uint8_t* p = img.ptr<uint8_t>(y);
+        for (int x = 0; x < img.cols; x++) {
+            p[x * 3] = (x * 7 + y * 3) & 255;
+            p[x * 3 + 1] = (x ^ y) & 255;
+            p[x * 3 + 2] = (x * y) & 255;
+        }
+    }
+}
+
+// The mock engine: each input pixel becomes a scale x scale block, plus bias.
+static void mock_engine(const uint8_t* in, int tile_w, int tile_h, int scale, int bias, uint8_t* out) {
+    const int out_w = tile_w * scale;
+    for (int y = 0; y < tile_h * scale; y++) {
+        for (int x = 0; x < out_w; x++) {
+            for (int c = 0; c < 3; c++) {
+                int v = in[((y / scale) * tile_w + x / scale) * 3 + c] + bias;
+                out[(y * out_w + x) * 3 + c] = (uint8_t)std::max(0, std::min(255, v));
+            }
+        }
+    }
+}
+
+// Stitches img with the mock engine, tiles in row-major order or reversed. bias(row, col) offsets a tile.
+static void stitch(const cv::Mat& img, const SrTilePlan& plan, bool reverse, int (*bias)(int, int), cv::Mat* out,
+                   size_t* peak, SrPpmWriter* ppm = nullptr) {
+    const int s = plan.scale();
+    std::vector<uint8_t> in(plan.tile_w() * plan.tile_h() * 3);
+    std::vector<uint8_t> res((size_t)plan.tile_w() * s * plan.tile_h() * s * 3);
+    const int out_w = plan.output_size().width;
+    SrStitcher stitcher(plan, [&](int y, const uint8_t* row) {
+        if (out != nullptr) {
+            memcpy(out->ptr<uint8_t>(y), row, out_w * 3);
+        }
+        if (ppm != nullptr) {
+            ppm->write_row(row);
+        }
+    });
+    const int n = plan.rows() * plan.cols();
+    for (int k = 0; k < n; k++) {
+        int t = reverse ? n - 1 - k : k;
+        int row = t / plan.cols(), col = t % plan.cols();
+        plan.fill_tile(img, row, col, in.data());
+        mock_engine(in.data(), plan.tile_w(), plan.tile_h(), s, bias(row, col), res.data());
+        stitcher.add_tile(row, col, res.data());
+    }
+    if (peak != nullptr) {
+        *peak = stitcher.peak_bytes();
+    }
+}
+
+static int no_bias(int, int) { return 0; }
+static int checker_bias(int row, int col) { return (row + col) % 2 ? 20 : 0; }
+
+static bool run_checks() {
+    bool ok = true;
+    const int w = 1000, h = 1500;
+    cv::Mat img(h, w, CV_8UC3);
+    make_image(img);
+    SrTilePlan plan(w, h, TILE_W, TILE_H, OVERLAP, SCALE);
+    bool inside = true;
+    int min_overlap = TILE_W;
+    std::vector<int> cover(w * h, 0);
+    for (int r = 0; r < plan.rows(); r++) {
+        for (int c = 0; c < plan.cols(); c++) {
+            cv::Rect t = plan.tile_rect(r, c);
+            inside &= t.x >= 0 && t.y >= 0 && t.x + t.width <= w && t.y + t.height <= h;
+            for (int y = t.y; y < t.y + t.height; y++) {
+                for (int x = t.x; x < t.x + t.width; x++) {
+                    cover[y * w + x]++;
+                }
+            }
+            if (c > 0) {
+                min_overlap = std::min(min_overlap, plan.tile_rect(r, c - 1).x + TILE_W - t.x);
+            }
+        }
+    }
+    printf("      %dx%d: %d x %d tiles of %dx%d, min overlap %d px\n", w, h, plan.cols(), plan.rows(), TILE_W, TILE_H,
+           min_overlap);
+    ok &= check(inside && *std::min_element(cover.begin(), cover.end()) > 0 && min_overlap >= OVERLAP,
+                "tiles cover the image with the requested overlap");
+    float err = 0.f;
+    for (const SrTileAxis* axis : {&plan.x_axis(), &plan.y_axis()}) {
+        int total = (axis == &plan.x_axis() ? w : h) * SCALE;
+        std::vector<float> sum(total, 0.f);
+        for (size_t i = 0; i < axis->offsets.size(); i++) {
+            for (size_t k = 0; k < axis->weights[i].size(); k++) {
+                sum[axis->offsets[i] * SCALE + k] += axis->weights[i][k];
+            }
+        }
+        for (float v : sum) {
+            err = std::max(err, std::abs(v - 1.f));
+        }
+    }
+    ok &= check(err < 1e-5f, "blend weights sum to 1 over every output pixel");
+
+    cv::Mat expected(h * SCALE, w * SCALE, CV_8UC3);
+    for (int y = 0; y < h * SCALE; y++) {
+        for (int x = 0; x < w * SCALE; x++) {
+            memcpy(expected.ptr<uint8_t>(y) + x * 3, img.ptr<uint8_t>(y / SCALE) + (x / SCALE) * 3, 3);
+        }
+    }
+    cv::Mat out(h * SCALE, w * SCALE, CV_8UC3), out_reversed(h * SCALE, w * SCALE, CV_8UC3);
+    stitch(img, plan, false, no_bias, &out, nullptr);
+    stitch(img, plan, true, no_bias, &out_reversed, nullptr);
+    size_t bytes = (size_t)w * SCALE * h * SCALE * 3;
+    ok &= check(memcmp(out.data, expected.data, bytes) == 0, "stitched output equals the upscaled image");
+    ok &= check(memcmp(out_reversed.data, out.data, bytes) == 0, "tile order does not change the output");
+
+    std::string path = "/tmp/real-esrgan_tile_bench.ppm";
+    {
+        SrPpmWriter ppm(path, w * SCALE, h * SCALE);
+        stitch(img, plan, false, no_bias, nullptr, nullptr, &ppm);
+    }
+    std::ifstream in(path, std::ios::binary);
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::string header = "P6\n" + std::to_string(w * SCALE) + " " + std::to_string(h * SCALE) + "\n255\n";
+    bool ppm_ok = file.size() == header.size() + bytes && memcmp(file.data(), header.data(), header.size()) == 0;
+    for (size_t i = 0; ppm_ok && i < bytes; i += 3) {
+        const uint8_t* rgb = &file[header.size() + i];
+        ppm_ok = rgb[0] == out.data[i + 2] && rgb[1] == out.data[i + 1] && rgb[2] == out.data[i];
+    }
+    remove(path.c_str());
+    ok &= check(ppm_ok, "rows streamed to a PPM file give the stitched image");
+
+    // flat image, every other tile 20 brighter
+    cv::Mat flat(h, w, CV_8UC3);
+    memset(flat.data, 100, (size_t)flat.rows * flat.step);
+    stitch(flat, plan, false, checker_bias, &out, nullptr);
+    int max_step = 0;
+    for (int y = 0; y < h * SCALE; y++) {
+        const uint8_t* p = out.ptr<uint8_t>(y);
+        const uint8_t* q = out.ptr<uint8_t>(std::min(y + 1, h * SCALE - 1));
+        for (int x = 0; x + 1 < w * SCALE; x++) {
+            max_step = std::max(max_step, std::abs(p[x * 3] - p[x * 3 + 3]));
+            max_step = std::max(max_step, std::abs(p[x * 3] - q[x * 3]));
+        }
+    }
+    printf("      tiles 20 levels apart: largest step between neighbouring output pixels %d\n", max_step);
+    ok &= check(max_step <= 1, "overlaps are feathered, no seams");
+
+    cv::Mat small(200, 300, CV_8UC3);
+    make_image(small);
+    SrTilePlan small_plan(300, 200, TILE_W, TILE_H, OVERLAP, SCALE);
+    std::vector<uint8_t> tile(TILE_W * TILE_H * 3);
+    small_plan.fill_tile(small, 0, 0, tile.data());
+    bool padded = memcmp(&tile[(TILE_H - 1) * TILE_W * 3 + (TILE_W - 1) * 3], small.ptr<uint8_t>(199) + 299 * 3, 3) == 0;
+    cv::Mat small_out(200 * SCALE, 300 * SCALE, CV_8UC3);
+    stitch(small, small_plan, false, no_bias, &small_out, nullptr);
+    bool small_ok = memcmp(small_out.ptr<uint8_t>(799) + 1199 * 3, small.ptr<uint8_t>(199) + 299 * 3, 3) == 0;
+    ok &= check(small_plan.rows() == 1 && small_plan.cols() == 1 && padded && small_ok,
+                "an image smaller than the engine is padded, and cropped after upscaling");
+
+    // 8K input with a 2x mock, rows go to a sink that drops them
+    const int scale = 2;
+    cv::Mat big(4320, 7680, CV_8UC3);
+    SrTilePlan big_plan(7680, 4320, TILE_W, TILE_H, OVERLAP, scale);
+    size_t peak = 0;
+    stitch(big, big_plan, false, no_bias, nullptr, &peak);
+    size_t tile_row = (size_t)big_plan.cols() * TILE_W * scale * TILE_H * scale * 3;
+    printf("      7680x4320 at %dx: %d tile rows, peak %.0f MB of tiles, output %.0f MB\n", scale, big_plan.rows(),
+           peak / 1e6, 7680.0 * scale * 4320 * scale * 3 / 1e6);
+    ok &= check(peak <= 2 * tile_row, "at most two tile rows are held");
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    int w = argc > 1 ? atoi(argv[1]) : 1920;
+    int h = argc > 2 ? atoi(argv[2]) : 1080;
+    if (!run_checks()) {
+        return 1;
+    }
+    cv::Mat img(h, w, CV_8UC3);
+    make_image(img);
+    SrTilePlan plan(w, h, TILE_W, TILE_H, OVERLAP, SCALE);
+    cv::Size size = plan.output_size();
+    cv::Mat out(size.height, size.width, CV_8UC3);
+    memset(out.data, 0, (size_t)size.area() * 3);
+    std::vector<uint8_t> in(TILE_W * TILE_H * 3);
+    std::vector<uint8_t> res((size_t)TILE_W * SCALE * TILE_H * SCALE * 3);
+    mock_engine(in.data(), TILE_W, TILE_H, SCALE, 0, res.data());
+    double fill_ms = 0, stitch_ms = 0;
+    SrStitcher stitcher(plan, [&](int y, const uint8_t* row) { memcpy(out.ptr<uint8_t>(y), row, size.width * 3); });
+    for (int r = 0; r < plan.rows(); r++) {
+        for (int c = 0; c < plan.cols(); c++) {
+            auto t0 = std::chrono::steady_clock::now();
+            plan.fill_tile(img, r, c, in.data());
+            auto t1 = std::chrono::steady_clock::now();
+            // the engine output is not recomputed, only the host side is timed
+            stitcher.add_tile(r, c, res.data());
+            auto t2 = std::chrono::steady_clock::now();
+            fill_ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+            stitch_ms += std::chrono::duration<double, std::milli>(t2 - t1).count();
+        }
+    }
+    printf("%dx%d -> %dx%d, %d tiles: fill %.2f ms, stitch %.1f ms (%.2f ms per output megapixel), peak %.0f MB\n", w,
+           h, size.width, size.height, plan.rows() * plan.cols(), fill_ms, stitch_ms,
+           stitch_ms / (size.area() / 1e6), stitcher.peak_bytes() / 1e6);
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include "tiling.h"
+#include <algorithm>
+#include <cstring>
+
+static SrTileAxis make_axis(int total, int tile, int overlap, int scale) {
+    SrTileAxis axis;
+    axis.valid = std::min(tile, total);
+    overlap = std::max(0, std::min(overlap, tile / 2));
+    if (total <= tile) {
+        axis.offsets.push_back(0);
+    } else {
+        // the last tile ends at the image border, overlapping its neighbour by at least overlap
+        int step = tile - overlap;
+        int n = (total - tile + step - 1) / step + 1;
+        for (int i = 0; i < n - 1; i++) {
+            axis.offsets.push_back(i * step);
+        }
+        axis.offsets.push_back(total - tile);
+    }
+    // Each tile ramps up from its edges over the overlap where it has a neighbour, and the ramps of all tiles over an
+    // output pixel are normalized to sum to 1.
+    const int n = axis.offsets.size();
+    const int len = axis.valid * scale;
+    const float inv_ramp = 1.f / std::max(1, overlap * scale);
+    std::vector<float> sum(total * scale, 0.f);
+    axis.weights.assign(n, std::vector<float>(len));
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < len; k++) {
+            float r = 1.f;
+            if (i > 0) {
+                r = std::min(r, (k + 0.5f) * inv_ramp);
+            }
+            if (i < n - 1) {
+                r = std::min(r, (len - k - 0.5f) * inv_ramp);
+            }
+            axis.weights[i][k] = r;
+            sum[axis.offsets[i] * scale + k] += r;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < len; k++) {
+            axis.weights[i][k] /= sum[axis.offsets[i] * scale + k];
+        }
+    }
+    return axis;
+}
+
+SrTilePlan::SrTilePlan(int img_w, int img_h, int tile_w, int tile_h, int overlap, int scale)
+    : img_w_(img_w), img_h_(img_h), tile_w_(tile_w), tile_h_(tile_h), scale_(scale) {
+    x_ = make_axis(img_w, tile_w, overlap, scale);
+    y_ = make_axis(img_h, tile_h, overlap, scale);
+}
+
+cv::Rect SrTilePlan::tile_rect(int row, int col) const {
+    return cv::Rect(x_.offsets[col], y_.offsets[row], x_.valid, y_.valid);
+}
+
+void SrTilePlan::fill_tile(const cv::Mat& img, int row, int col, uint8_t* dst) const {
+    cv::Rect r = tile_rect(row, col);
+    const size_t line = (size_t)tile_w_ * 3;
+    for (int y = 0; y < tile_h_; y++) {
+        const uint8_t* src = img.ptr<uint8_t>(r.y + std::min(y, r.height - 1)) + r.x * 3;
+        uint8_t* out = dst + y * line;
+        memcpy(out, src, r.width * 3);
+        for (int x = r.width; x < tile_w_; x++) {
+            memcpy(out + x * 3, src + (r.width - 1) * 3, 3);
+        }
+    }
+}
+
+SrStitcher::SrStitcher(const SrTilePlan& plan, RowSink sink) : plan_(plan), sink_(sink) {
+    tiles_.assign(plan.rows(), std::vector<std::vector<uint8_t>>(plan.cols()));
+    arrived_.assign(plan.rows(), 0);
+    const SrTileAxis& xa = plan.x_axis();
+    const int s = plan.scale();
+    for (int x : xa.offsets) {
+        segments_.push_back(x * s);
+        segments_.push_back((x + xa.valid) * s);
+    }
+    std::sort(segments_.begin(), segments_.end());
+    segments_.erase(std::unique(segments_.begin(), segments_.end()), segments_.end());
+    for (size_t k = 0; k + 1 < segments_.size(); k++) {
+        std::vector<int> cols;
+        for (int i = 0; i < plan.cols(); i++) {
+            if (xa.offsets[i] * s <= segments_[k] && segments_[k + 1] <= (xa.offsets[i] + xa.valid) * s) {
+                cols.push_back(i);
+            }
+        }
+        segment_cols_.push_back(cols);
+    }
+    line_.resize((size_t)plan.output_size().width * 3);
+    acc_.resize(line_.size());
+}
+
+void SrStitcher::add_tile(int row, int col, const uint8_t* data) {
+    if (!tiles_[row][col].empty() || row < released_rows_) {
+        return;
+    }
+    const int s = plan_.scale();
+    const int h = plan_.y_axis().valid * s;
+    const size_t line = (size_t)plan_.x_axis().valid * s * 3;
+    const size_t stride = (size_t)plan_.tile_w() * s * 3;
+    std::vector<uint8_t>& tile = tiles_[row][col];
+    if (!free_.empty()) {
+        // reuse the buffer of a released tile, fresh pages cost more than the copy
+        tile.swap(free_.back());
+        free_.pop_back();
+    }
+    tile.resize(h * line);
+    for (int y = 0; y < h; y++) {
+        memcpy(&tile[y * line], data + y * stride, line);
+    }
+    bytes_ += tile.size();
+    peak_bytes_ = std::max(peak_bytes_, bytes_);
+    arrived_[row]++;
+    while (complete_rows_ < plan_.rows() && arrived_[complete_rows_] == plan_.cols()) {
+        complete_rows_++;
+    }
+    // output rows above the first incomplete tile row are covered by complete tile rows only
+    int y_end = complete_rows_ == plan_.rows() ? plan_.output_size().height
+                                               : plan_.y_axis().offsets[complete_rows_] * s;
+    if (y_end > next_y_) {
+        emit_rows(y_end);
+    }
+}
+
+void SrStitcher::emit_rows(int y_end) {
+    const SrTileAxis& xa = plan_.x_axis();
+    const SrTileAxis& ya = plan_.y_axis();
+    const int s = plan_.scale();
+    const int tile_h = ya.valid * s;
+    const size_t tile_line = (size_t)xa.valid * s * 3;
+    std::vector<int> rows;
+    std::vector<float> wy;
+    for (int y = next_y_; y < y_end; y++) {
+        rows.clear();
+        wy.clear();
+        for (int j = released_rows_; j < complete_rows_; j++) {
+            int k = y - ya.offsets[j] * s;
+            if (k >= 0 && k < tile_h) {
+                rows.push_back(j);
+                wy.push_back(ya.weights[j][k]);
+            }
+        }
+        for (size_t seg = 0; seg < segment_cols_.size(); seg++) {
+            const std::vector<int>& cols = segment_cols_[seg];
+            const int a = segments_[seg], b = segments_[seg + 1];
+            if (rows.size() == 1 && cols.size() == 1) {
+                // inside a single tile, nothing to blend
+                int j = rows[0], i = cols[0];
+                const uint8_t* src = &tiles_[j][i][(y - ya.offsets[j] * s) * tile_line + (a - xa.offsets[i] * s) * 3];
+                memcpy(&line_[a * 3], src, (b - a) * 3);
+                continue;
+            }
+            const int n = (b - a) * 3;
+            std::fill(acc_.begin(), acc_.begin() + n, 0.f);
+            for (size_t r = 0; r < rows.size(); r++) {
+                int j = rows[r];
+                for (int i : cols) {
+                    int kx = a - xa.offsets[i] * s;
+                    const uint8_t* p = &tiles_[j][i][(y - ya.offsets[j] * s) * tile_line + kx * 3];
+                    const float* wx = &xa.weights[i][kx];
+                    for (int x = 0; x < b - a; x++) {
+                        float w = wy[r] * wx[x];
+                        acc_[x * 3] += w * p[x * 3];
+                        acc_[x * 3 + 1] += w * p[x * 3 + 1];
+                        acc_[x * 3 + 2] += w * p[x * 3 + 2];
+                    }
+                }
+            }
+            uint8_t* out = &line_[a * 3];
+            for (int k = 0; k < n; k++) {
+                int v = (int)(acc_[k] + 0.5f);
+                out[k] = (uint8_t)(v < 255 ? v : 255);
+            }
+        }
+        sink_(y, line_.data());
+    }
+    next_y_ = y_end;
+    // tile rows that end above the next output row are not needed any more
+    while (released_rows_ < complete_rows_ && (ya.offsets[released_rows_] + ya.valid) * s <= next_y_) {
+        for (auto& tile : tiles_[released_rows_]) {
+            bytes_ -= tile.size();
+            free_.push_back(std::vector<uint8_t>());
+            free_.back().swap(tile);
+        }
+        released_rows_++;
+    }
+}
+
+SrPpmWriter::SrPpmWriter(const std::string& path, int width, int height)
+    : out_(path, std::ios::binary), rgb_((size_t)width * 3) {
+    out_ << "P6\n" << width << " " << height << "\n255\n";
+}
+
+void SrPpmWriter::write_row(const uint8_t* row) {
+    for (size_t x = 0; x < rgb_.size(); x += 3) {
+        rgb_[x] = row[x + 2];
+        rgb_[x + 1] = row[x + 1];
+        rgb_[x + 2] = row[x];
+    }
+    out_.write(reinterpret_cast<const char*>(rgb_.data()), rgb_.size());
+}
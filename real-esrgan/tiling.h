@@ -0,0 +1,103 @@
+#ifndef TRTX_REAL_ESRGAN_TILING_H_
+#define TRTX_REAL_ESRGAN_TILING_H_
+
+#include <stdint.h>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Super-resolution of images of any size with an engine of fixed input shape. The image is cut into overlapping tiles
+// of the engine shape, the upscaled tiles are blended with weights that ramp down over the overlap (feathering) so no
+// seams show, and the output is produced row by row. Only the tile rows that still cover unfinished output rows are
+// kept, so memory grows with the image width and the tile height, not with the image size.
+
+// Placement of the tiles along one side of the image.
+struct SrTileAxis {
+    std::vector<int> offsets;  // tile starts in input pixels
+    int valid = 0;             // pixels of the image in each tile, the tile size unless the image is smaller
+    // weights[i][k]: share of tile i in output pixel offsets[i] * scale + k; the shares of all tiles covering an output
+    // pixel sum to 1
+    std::vector<std::vector<float>> weights;
+};
+
+class SrTilePlan {
+   public:
+    // tile_w x tile_h is the engine input, overlap is in input pixels (at most half a tile), scale the upscale factor
+    SrTilePlan(int img_w, int img_h, int tile_w, int tile_h, int overlap, int scale);
+
+    int rows() const { return y_.offsets.size(); }
+    int cols() const { return x_.offsets.size(); }
+    int scale() const { return scale_; }
+    int tile_w() const { return tile_w_; }
+    int tile_h() const { return tile_h_; }
+    cv::Size output_size() const { return cv::Size(img_w_ * scale_, img_h_ * scale_); }
+    const SrTileAxis& x_axis() const { return x_; }
+    const SrTileAxis& y_axis() const { return y_; }
+
+    // The part of the image in tile (row, col).
+    cv::Rect tile_rect(int row, int col) const;
+
+    // Copies tile (row, col) of a BGR image into dst, tile_h x tile_w x 3 as the engine input; a tile larger than the
+    // image is filled by repeating the last column and row.
+    void fill_tile(const cv::Mat& img, int row, int col, uint8_t* dst) const;
+
+   private:
+    int img_w_, img_h_, tile_w_, tile_h_, scale_;
+    SrTileAxis x_, y_;
+};
+
+class SrStitcher {
+   public:
+    // Receives output row y, output_size().width x 3 bytes, once all tiles covering it have been added.
+    using RowSink = std::function<void(int y, const uint8_t* row)>;
+
+    SrStitcher(const SrTilePlan& plan, RowSink sink);
+
+    // Adds the engine output of tile (row, col), (tile_h * scale) x (tile_w * scale) x 3. Tiles may come in any order;
+    // in row-major order only two tile rows are held at a time.
+    void add_tile(int row, int col, const uint8_t* data);
+
+    bool done() const { return next_y_ == plan_.output_size().height; }
+    // Most bytes of tiles held at once; released tiles keep their buffers for the next ones.
+    size_t peak_bytes() const { return peak_bytes_; }
+
+   private:
+    void emit_rows(int y_end);
+
+    const SrTilePlan& plan_;
+    RowSink sink_;
+    // tiles_[row][col]: the valid part of the upscaled tile, empty until added or once released
+    std::vector<std::vector<std::vector<uint8_t>>> tiles_;
+    std::vector<int> arrived_;
+    std::vector<std::vector<uint8_t>> free_;  // buffers of released tiles
+    // output columns [segments_[s], segments_[s + 1]) are covered by the same tile columns, segment_cols_[s]
+    std::vector<int> segments_;
+    std::vector<std::vector<int>> segment_cols_;
+    int complete_rows_ = 0;
+    int released_rows_ = 0;
+    int next_y_ = 0;
+    size_t bytes_ = 0;
+    size_t peak_bytes_ = 0;
+    std::vector<float> acc_;
+    std::vector<uint8_t> line_;
+};
+
+// Writes the rows of an SrStitcher to a binary PPM (P6) file as they arrive, for outputs too large to assemble in a
+// cv::Mat for cv::imwrite: a 4x upscale of an 8K image is 1.6 GB. PPM has no row-wise encoder to wait for, and most
+// tools, OpenCV included, read it.
+class SrPpmWriter {
+   public:
+    SrPpmWriter(const std::string& path, int width, int height);
+
+    bool good() const { return out_.good(); }
+    // Writes the next row, width x 3 bytes of BGR.
+    void write_row(const uint8_t* row);
+
+   private:
+    std::ofstream out_;
+    std::vector<uint8_t> rgb_;
+};
+
+#endif  // TRTX_REAL_ESRGAN_TILING_H_
@@ -0,0 +1,98 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "NvInfer.h"
+#include "macros.h"
+namespace nvinfer1 {
+// First layer of an engine built with USE_UINT8_INPUT: reads the {H, W, 3} input binding as uint8 BGR and writes the
+// float RGB CHW / 255 tensor the backbone takes, so the host uploads bytes. The binding is declared float because
+// TensorRT 8.4 has no uint8 inputs; the plugin only takes float so no reformat ever reads it as floats.
+class API Uint8InputPlugin : public IPluginV2IOExt {
+public:
+  Uint8InputPlugin(int netHeight, int netWidth);
+
+  Uint8InputPlugin(const void* data, size_t length);
+  ~Uint8InputPlugin() override = default;
+
+  int getNbOutputs() const TRT_NOEXCEPT override { return 1; }
+
+  nvinfer1::Dims getOutputDimensions(int index, const nvinfer1::Dims* inputs, int nbInputDims) TRT_NOEXCEPT override;
+
+  int initialize() TRT_NOEXCEPT override { return 0; }
+
+  void terminate() TRT_NOEXCEPT override {}
+
+  size_t getWorkspaceSize(int maxBatchSize) const TRT_NOEXCEPT override { return 0; }
+
+  int enqueue(int batchSize, const void* const* inputs, void* TRT_CONST_ENQUEUE* outputs, void* workspace,
+        cudaStream_t stream) TRT_NOEXCEPT override;
+
+  size_t getSerializationSize() const TRT_NOEXCEPT override;
+
+  void serialize(void* buffer) const TRT_NOEXCEPT override;
+
+  bool supportsFormatCombination(int pos, const PluginTensorDesc* inOut, int nbInputs,
+                                   int nbOutputs) const TRT_NOEXCEPT override {
+    return inOut[pos].format == TensorFormat::kLINEAR && inOut[pos].type == DataType::kFLOAT;
+  }
+
+  const char* getPluginType() const TRT_NOEXCEPT override;
+
+  const char* getPluginVersion() const TRT_NOEXCEPT override;
+
+  void destroy() TRT_NOEXCEPT override;
+
+  IPluginV2IOExt* clone() const TRT_NOEXCEPT override;
+
+  void setPluginNamespace(const char* pluginNamespace) TRT_NOEXCEPT override;
+
+  const char* getPluginNamespace() const TRT_NOEXCEPT override;
+
+  nvinfer1::DataType getOutputDataType(int32_t index, nvinfer1::DataType const* inputTypes,
+                                         int32_t nbInputs) const TRT_NOEXCEPT override;
+
+  bool isOutputBroadcastAcrossBatch(int outputIndex, const bool* inputIsBroadcasted,
+                                      int nbInputs) const TRT_NOEXCEPT override {
+    return false;
+  }
+
+  bool canBroadcastInputAcrossBatch(int inputIndex) const TRT_NOEXCEPT override { return false; }
+
+  void configurePlugin(PluginTensorDesc const* in, int32_t nbInput, PluginTensorDesc const* out,
+                         int32_t nbOutput) TRT_NOEXCEPT override {}
+
+private:
+  int mThreadCount = 256;
+  std::string mPluginNamespace;
+  int mNetHeight;
+  int mNetWidth;
+};
+
+class API Uint8InputPluginCreator : public IPluginCreator {
+public:
+  Uint8InputPluginCreator();
+  ~Uint8InputPluginCreator() override = default;
+
+  const char* getPluginName() const TRT_NOEXCEPT override;
+
+  const char* getPluginVersion() const TRT_NOEXCEPT override;
+
+  const nvinfer1::PluginFieldCollection* getFieldNames() TRT_NOEXCEPT override;
+
+  nvinfer1::IPluginV2IOExt* createPlugin(const char* name,
+                                           const nvinfer1::PluginFieldCollection* fc) TRT_NOEXCEPT override;
+
+  nvinfer1::IPluginV2IOExt* deserializePlugin(const char* name, const void* serialData,
+                        size_t serialLength) TRT_NOEXCEPT override;
+
+  void setPluginNamespace(const char* libNamespace) TRT_NOEXCEPT override { mNamespace = libNamespace; }
+
+  const char* getPluginNamespace() const TRT_NOEXCEPT override { return mNamespace.c_str(); }
+
+private:
+  std::string mNamespace;
+  static PluginFieldCollection mFC;
+  static std::vector<PluginField> mPluginAttributes;
+};
+REGISTER_TENSORRT_PLUGIN(Uint8InputPluginCreator);
+}  // namespace nvinfer1
@@ -63,54 +63,52 @@ static int get_depth(int x, float gd) {
   return std::max<int>(r, 1);
 }
 
-static IScaleLayer* addBatchNorm2d(INetworkDefinition *network, std::map<std::string, Weights>& weightMap, ITensor& input, std::string lname, float eps) {
-  float* gamma = (float*)weightMap[lname + ".weight"].values;
-  float* beta = (float*)weightMap[lname + ".bias"].values;
-  float* mean = (float*)weightMap[lname + ".running_mean"].values;
-  float* var = (float*)weightMap[lname + ".running_var"].values;
-  int len = weightMap[lname + ".running_var"].count;
-
-  float* scval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-  for (int i = 0; i < len; i++) {
-    scval[i] = gamma[i] / sqrt(var[i] + eps);
-  }
-  Weights scale{ DataType::kFLOAT, scval, len };
-
-  float* shval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-  for (int i = 0; i < len; i++) {
-    shval[i] = beta[i] - mean[i] * gamma[i] / sqrt(var[i] + eps);
-  }
-  Weights shift{ DataType::kFLOAT, shval, len };
-
-  float* pval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-  for (int i = 0; i < len; i++) {
-    pval[i] = 1.0;
+// Folds a BatchNorm2d into the bias-free conv in front of it: convBlock's own, or the channels [first_channel,
+// first_channel + channels) of the one bottleneckCSP runs over the concat of cv3 and cv2. The conv weights are scaled
+// in place, and the bias is kept in weightMap so the free loop at the end of each build releases it.
+static void foldBatchNorm2d(std::map<std::string, Weights>& weightMap, std::string conv_name, std::string bn_name, float eps, Weights& weight, Weights& bias, int first_channel = 0, int channels = 0) {
+  std::string bias_name = conv_name + ".fused_bias";
+  Weights& w = weightMap[conv_name + ".weight"];
+  if (weightMap.count(bias_name) == 0) {
+    const float* gamma = (const float*)weightMap[bn_name + ".weight"].values + first_channel;
+    const float* beta = (const float*)weightMap[bn_name + ".bias"].values + first_channel;
+    const float* mean = (const float*)weightMap[bn_name + ".running_mean"].values + first_channel;
+    const float* var = (const float*)weightMap[bn_name + ".running_var"].values + first_channel;
+    int len = channels > 0 ? channels : weightMap[bn_name + ".running_var"].count;
+    assert(len > 0 && w.count % len == 0);
+    int per_channel = w.count / len;
+
+    float* wval = (float*)w.values;
+    float* bval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
+    for (int c = 0; c < len; c++) {
+      float scale = gamma[c] / sqrt(var[c] + eps);
+      float* row = wval + c * per_channel;
+      for (int i = 0; i < per_channel; i++) {
+        row[i] *= scale;
+      }
+      bval[c] = beta[c] - mean[c] * scale;
+    }
+    weightMap[bias_name] = Weights{ DataType::kFLOAT, bval, len };
   }
-  Weights power{ DataType::kFLOAT, pval, len };
-
-  weightMap[lname + ".scale"] = scale;
-  weightMap[lname + ".shift"] = shift;
-  weightMap[lname + ".power"] = power;
-  IScaleLayer* scale_1 = network->addScale(input, ScaleMode::kCHANNEL, shift, scale, power);
-  assert(scale_1);
-  return scale_1;
+  weight = w;
+  bias = weightMap[bias_name];
 }
 
 static ILayer* convBlock(INetworkDefinition *network, std::map<std::string, Weights>& weightMap, ITensor& input, int outch, int ksize, int s, int g, std::string lname) {
-  Weights emptywts{ DataType::kFLOAT, nullptr, 0 };
+  Weights weight, bias;
+  foldBatchNorm2d(weightMap, lname + ".conv", lname + ".bn", 1e-3, weight, bias);
   int p = ksize / 3;
-  IConvolutionLayer* conv1 = network->addConvolutionNd(input, outch, DimsHW{ ksize, ksize }, weightMap[lname + ".conv.weight"], emptywts);
+  IConvolutionLayer* conv1 = network->addConvolutionNd(input, outch, DimsHW{ ksize, ksize }, weight, bias);
   assert(conv1);
   conv1->setStrideNd(DimsHW{ s, s });
   conv1->setPaddingNd(DimsHW{ p, p });
   conv1->setNbGroups(g);
   conv1->setName((lname + ".conv").c_str());
-  IScaleLayer* bn1 = addBatchNorm2d(network, weightMap, *conv1->getOutput(0), lname + ".bn", 1e-3);
 
   // silu = x * sigmoid
-  auto sig = network->addActivation(*bn1->getOutput(0), ActivationType::kSIGMOID);
+  auto sig = network->addActivation(*conv1->getOutput(0), ActivationType::kSIGMOID);
   assert(sig);
-  auto ew = network->addElementWise(*bn1->getOutput(0), *sig->getOutput(0), ElementWiseOperation::kPROD);
+  auto ew = network->addElementWise(*conv1->getOutput(0), *sig->getOutput(0), ElementWiseOperation::kPROD);
   assert(ew);
   return ew;
 }
@@ -137,22 +135,24 @@ static ILayer* bottleneck(INetworkDefinition *network, std::map<std::string, Wei
 }
 
 static ILayer* bottleneckCSP(INetworkDefinition *network, std::map<std::string, Weights>& weightMap, ITensor& input, int c1, int c2, int n, bool shortcut, int g, float e, std::string lname) {
-  Weights emptywts{ DataType::kFLOAT, nullptr, 0 };
   int c_ = (int)((float)c2 * e);
   auto cv1 = convBlock(network, weightMap, input, c_, 1, 1, 1, lname + ".cv1");
-  auto cv2 = network->addConvolutionNd(input, c_, DimsHW{ 1, 1 }, weightMap[lname + ".cv2.weight"], emptywts);
+  // bn runs over cat(cv3, cv2), each conv takes its half
+  Weights cv2_weight, cv2_bias, cv3_weight, cv3_bias;
+  foldBatchNorm2d(weightMap, lname + ".cv2", lname + ".bn", 1e-4, cv2_weight, cv2_bias, c_, c_);
+  foldBatchNorm2d(weightMap, lname + ".cv3", lname + ".bn", 1e-4, cv3_weight, cv3_bias, 0, c_);
+  auto cv2 = network->addConvolutionNd(input, c_, DimsHW{ 1, 1 }, cv2_weight, cv2_bias);
   ITensor* y1 = cv1->getOutput(0);
   for (int i = 0; i < n; i++) {
     auto b = bottleneck(network, weightMap, *y1, c_, c_, shortcut, g, 1.0, lname + ".m." + std::to_string(i));
     y1 = b->getOutput(0);
   }
-  auto cv3 = network->addConvolutionNd(*y1, c_, DimsHW{ 1, 1 }, weightMap[lname + ".cv3.weight"], emptywts);
+  auto cv3 = network->addConvolutionNd(*y1, c_, DimsHW{ 1, 1 }, cv3_weight, cv3_bias);
 
   ITensor* inputTensors[] = { cv3->getOutput(0), cv2->getOutput(0) };
   auto cat = network->addConcatenation(inputTensors, 2);
 
-  IScaleLayer* bn = addBatchNorm2d(network, weightMap, *cat->getOutput(0), lname + ".bn", 1e-4);
-  auto lr = network->addActivation(*bn->getOutput(0), ActivationType::kLEAKY_RELU);
+  auto lr = network->addActivation(*cat->getOutput(0), ActivationType::kLEAKY_RELU);
   lr->setAlpha(0.1);
 
   auto cv4 = convBlock(network, weightMap, *lr->getOutput(0), c2, 1, 1, 1, lname + ".cv4");
@@ -283,11 +283,41 @@ static IPluginV2Layer* addYoLoLayer(INetworkDefinition *network, std::map<std::s
   return yolo;
 }
 
+#if defined(USE_UINT8_INPUT) && defined(USE_INT8)
+#error "USE_UINT8_INPUT engines cannot be calibrated, the int8 calibrator feeds float input"
+#endif
+
+// The network input, {3, kInputH, kInputW} float, or with USE_UINT8_INPUT a {kInputH, kInputW, 3} binding that the
+// Uint8Input_TRT plugin reads as uint8 BGR and turns into the same float tensor. The binding is declared float because
+// TensorRT 8 has no uint8 inputs.
+static ITensor* addInput(INetworkDefinition* network, DataType dt) {
+#ifdef USE_UINT8_INPUT
+  ITensor* data = network->addInput(kInputTensorName, DataType::kFLOAT, Dims3{ kInputH, kInputW, 3 });
+  assert(data);
+  auto creator = getPluginRegistry()->getPluginCreator("Uint8Input_TRT", "1");
+  int shape[2] = {kInputH, kInputW};
+  PluginField plugin_field;
+  plugin_field.data = shape;
+  plugin_field.length = 2;
+  plugin_field.name = "inputShape";
+  plugin_field.type = PluginFieldType::kINT32;
+  PluginFieldCollection plugin_data;
+  plugin_data.nbFields = 1;
+  plugin_data.fields = &plugin_field;
+  IPluginV2 *plugin_obj = creator->createPlugin("uint8_input", &plugin_data);
+  auto layer = network->addPluginV2(&data, 1, *plugin_obj);
+  layer->setName("uint8_input");
+  return layer->getOutput(0);
+#else
+  return network->addInput(kInputTensorName, dt, Dims3{ 3, kInputH, kInputW });
+#endif
+}
+
 ICudaEngine* build_det_engine(unsigned int maxBatchSize, IBuilder* builder, IBuilderConfig* config, DataType dt, float& gd, float& gw, std::string& wts_name) {
   INetworkDefinition* network = builder->createNetworkV2(0U);
 
-  // Create input tensor of shape {3, kInputH, kInputW}
-  ITensor* data = network->addInput(kInputTensorName, dt, Dims3{ 3, kInputH, kInputW });
+  // Create the input tensor, {3, kInputH, kInputW} as seen by the backbone
+  ITensor* data = addInput(network, dt);
   assert(data);
   std::map<std::string, Weights> weightMap = loadWeights(wts_name);
 
@@ -375,8 +405,8 @@ ICudaEngine* build_det_engine(unsigned int maxBatchSize, IBuilder* builder, IBui
 ICudaEngine* build_det_p6_engine(unsigned int maxBatchSize, IBuilder* builder, IBuilderConfig* config, DataType dt, float& gd, float& gw, std::string& wts_name) {
   INetworkDefinition* network = builder->createNetworkV2(0U);
 
-  // Create input tensor of shape {3, kInputH, kInputW}
-  ITensor* data = network->addInput(kInputTensorName, dt, Dims3{ 3, kInputH, kInputW });
+  // Create the input tensor, {3, kInputH, kInputW} as seen by the backbone
+  ITensor* data = addInput(network, dt);
   assert(data);
 
   std::map<std::string, Weights> weightMap = loadWeights(wts_name);
@@ -538,7 +568,7 @@ ICudaEngine* build_cls_engine(unsigned int maxBatchSize, IBuilder* builder, IBui
 
 ICudaEngine* build_seg_engine(unsigned int maxBatchSize, IBuilder* builder, IBuilderConfig* config, DataType dt, float& gd, float& gw, std::string& wts_name) {
   INetworkDefinition* network = builder->createNetworkV2(0U);
-  ITensor* data = network->addInput(kInputTensorName, dt, Dims3{ 3, kInputH, kInputW });
+  ITensor* data = addInput(network, dt);
   assert(data);
   std::map<std::string, Weights> weightMap = loadWeights(wts_name);
 
@@ -0,0 +1,182 @@
+#include "motion_gate.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+bool parse_motion_gate_args(int& argc, char** argv, MotionGateOptions& opts) {
+    int kept = 0;
+    for (int i = 0; i < argc; i++) {
+        std::string arg(argv[i]);
+        bool ok = true;
+        if (i == 0 || (arg.compare(0, 8, "--motion") != 0 && arg.compare(0, 12, "--max_stale=") != 0)) {
+            argv[kept++] = argv[i];
+        } else if (arg == "--motion_gate") {
+            opts.enabled = true;
+        } else if (arg.compare(0, 15, "--motion_block=") == 0) {
+            opts.block = atoi(arg.substr(15).c_str());
+            ok = opts.block > 0 && opts.block <= 85;  // the bytes of a cell row are summed in 16 bits
+        } else if (arg.compare(0, 14, "--motion_step=") == 0) {
+            opts.sample_step = atoi(arg.substr(14).c_str());
+            ok = opts.sample_step > 0;
+        } else if (arg.compare(0, 16, "--motion_thresh=") == 0) {
+            opts.cell_thresh = atof(arg.substr(16).c_str());
+            ok = opts.cell_thresh > 0.f;
+        } else if (arg.compare(0, 14, "--motion_area=") == 0) {
+            opts.area_thresh = atof(arg.substr(14).c_str());
+            ok = opts.area_thresh >= 0.f && opts.area_thresh < 1.f;
+        } else if (arg.compare(0, 12, "--max_stale=") == 0) {
+            opts.max_stale = atoi(arg.substr(12).c_str());
+            ok = opts.max_stale >= 0;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "invalid argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    argc = kept;
+    return true;
+}
+
+MotionGate::MotionGate(const MotionGateOptions& opts) : opts_(opts) {}
+
+void MotionGate::reset() {
+    has_reference_ = false;
+    decision_ = MotionDecision();
+}
+
+void MotionGate::resize_grid(int width, int height) {
+    const int b = opts_.block, s = opts_.sample_step;
+    width_ = width;
+    height_ = height;
+    grid_w_ = (width + b - 1) / b;
+    grid_h_ = (height + b - 1) / b;
+    int cells = grid_w_ * grid_h_;
+    reference_.assign(cells, 0.f);
+    current_.assign(cells, 0.f);
+    sums_.assign(cells, 0);
+    changed_.assign(cells, 0);
+    stack_.reserve(cells);
+    inv_count_.resize(cells);
+    for (int cy = 0; cy < grid_h_; cy++) {
+        // sampled rows of the cell, y = 0, s, 2s, ...
+        int rows = (std::min(height, (cy + 1) * b) - cy * b + s - 1) / s;
+        for (int cx = 0; cx < grid_w_; cx++) {
+            int cols = std::min(width, (cx + 1) * b) - cx * b;
+            inv_count_[cy * grid_w_ + cx] = 1.f / (3.f * rows * cols);
+        }
+    }
+}
+
+void MotionGate::reduce(const cv::Mat& img, std::vector<float>& cells) {
+    const int b = opts_.block;
+    std::fill(sums_.begin(), sums_.end(), 0);
+    for (int y = 0; y < height_; y += opts_.sample_step) {
+        const uint8_t* row = img.data + (size_t)y * img.step;
+        uint32_t* cell = &sums_[(y / b) * grid_w_];
+        // the B, G and R bytes of a cell are contiguous in a row, summing them is one vectorized loop per cell; 16-bit
+        // lanes hold the sum of up to 257 bytes
+        for (int cx = 0; cx < grid_w_; cx++) {
+            const int begin = cx * b * 3, end = std::min(width_, (cx + 1) * b) * 3;
+            uint16_t acc = 0;
+            for (int i = begin; i < end; i++) {
+                acc += row[i];
+            }
+            cell[cx] += acc;
+        }
+    }
+    for (size_t k = 0; k < cells.size(); k++) {
+        cells[k] = sums_[k] * inv_count_[k];
+    }
+}
+
+// 8-connected groups of changed cells, each reported as its bounding box grown by one cell. Boxes that touch or
+// overlap after growing are merged, so the leading and trailing edge of a moving object give one region.
+void MotionGate::find_regions() {
+    const int b = opts_.block;
+    std::vector<cv::Rect>& regions = decision_.regions;
+    for (int start = 0; start < grid_w_ * grid_h_; start++) {
+        if (changed_[start] != 1) {
+            continue;
+        }
+        int x0 = grid_w_, y0 = grid_h_, x1 = -1, y1 = -1;
+        stack_.clear();
+        stack_.push_back(start);
+        changed_[start] = 2;
+        while (!stack_.empty()) {
+            int k = stack_.back();
+            stack_.pop_back();
+            int cx = k % grid_w_, cy = k / grid_w_;
+            x0 = std::min(x0, cx);
+            y0 = std::min(y0, cy);
+            x1 = std::max(x1, cx);
+            y1 = std::max(y1, cy);
+            for (int ny = std::max(0, cy - 1); ny <= std::min(grid_h_ - 1, cy + 1); ny++) {
+                for (int nx = std::max(0, cx - 1); nx <= std::min(grid_w_ - 1, cx + 1); nx++) {
+                    int nk = ny * grid_w_ + nx;
+                    if (changed_[nk] == 1) {
+                        changed_[nk] = 2;
+                        stack_.push_back(nk);
+                    }
+                }
+            }
+        }
+        x0 = std::max(0, x0 - 1) * b;
+        y0 = std::max(0, y0 - 1) * b;
+        x1 = std::min(width_, (x1 + 2) * b);
+        y1 = std::min(height_, (y1 + 2) * b);
+        regions.push_back(cv::Rect(x0, y0, x1 - x0, y1 - y0));
+    }
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t i = 0; i < regions.size() && !merged; i++) {
+            for (size_t j = i + 1; j < regions.size() && !merged; j++) {
+                const cv::Rect& a = regions[i];
+                const cv::Rect& r = regions[j];
+                if (a.x <= r.x + r.width && r.x <= a.x + a.width && a.y <= r.y + r.height && r.y <= a.y + a.height) {
+                    regions[i] |= regions[j];
+                    regions.erase(regions.begin() + j);
+                    merged = true;
+                }
+            }
+        }
+    }
+}
+
+const MotionDecision& MotionGate::check(const cv::Mat& img) {
+    bool resized = img.cols != width_ || img.rows != height_;
+    if (resized) {
+        resize_grid(img.cols, img.rows);
+    }
+    reduce(img, current_);
+    decision_.regions.clear();
+    const int cells = grid_w_ * grid_h_;
+    if (resized || !has_reference_) {
+        decision_.changed_cells = cells;
+        decision_.regions.push_back(cv::Rect(0, 0, width_, height_));
+    } else {
+        int changed = 0;
+        for (int k = 0; k < cells; k++) {
+            changed_[k] = std::fabs(current_[k] - reference_[k]) > opts_.cell_thresh;
+            changed += changed_[k];
+        }
+        decision_.changed_cells = changed;
+        if (changed > 0) {
+            find_regions();
+        }
+    }
+    decision_.changed_fraction = (float)decision_.changed_cells / cells;
+    bool stale = opts_.max_stale > 0 && decision_.stale >= opts_.max_stale;
+    decision_.run_detector = resized || !has_reference_ || decision_.changed_fraction > opts_.area_thresh || stale;
+    if (decision_.run_detector) {
+        reference_.swap(current_);
+        has_reference_ = true;
+        decision_.stale = 0;
+    } else {
+        decision_.stale++;
+    }
+    return decision_;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Skips the detector on frames of a fixed camera that did not change. Every frame is reduced to the mean intensity
+// (B + G + R) / 3 of its block x block pixel cells, which averages out sensor noise, and compared with the cells of
+// the last frame the detector ran on. The detector runs when more than area_thresh of the cells changed by more than
+// cell_thresh, when the frame size changed, or after max_stale skipped frames; otherwise the caller reuses the
+// previous detections. Only every sample_step-th row is read, so a 1080p frame costs a fraction of a millisecond.
+
+struct MotionGateOptions {
+    bool enabled = false;
+    int block = 16;               // cell size in pixels, at most 85
+    int sample_step = 2;          // read every n-th row
+    float cell_thresh = 8.f;      // change of a cell's mean intensity (0-255) that counts as motion
+    float area_thresh = 0.0005f;  // fraction of changed cells above which the detector runs
+    int max_stale = 30;           // skipped frames after which the detector runs anyway, 0 never forces a run
+};
+
+struct MotionDecision {
+    bool run_detector = true;
+    int changed_cells = 0;
+    float changed_fraction = 0.f;
+    int stale = 0;                   // frames skipped since the detector last ran, this one included
+    std::vector<cv::Rect> regions;  // changed areas grown by one cell, in image pixels, for crop inference
+};
+
+// Consumes "--motion_gate", "--motion_block=", "--motion_step=", "--motion_thresh=", "--motion_area=" and
+// "--max_stale=" and compacts argv like parse_runtime_config_args. Returns false on an invalid value.
+bool parse_motion_gate_args(int& argc, char** argv, MotionGateOptions& opts);
+
+class MotionGate {
+   public:
+    explicit MotionGate(const MotionGateOptions& opts = MotionGateOptions());
+
+    // Decides whether the detector has to run on img (8-bit BGR). If so, img becomes the new reference, so the
+    // caller must run the detector on it. Buffers are only reallocated when the frame size changes.
+    const MotionDecision& check(const cv::Mat& img);
+
+    void reset();
+
+   private:
+    void resize_grid(int width, int height);
+    void reduce(const cv::Mat& img, std::vector<float>& cells);
+    void find_regions();
+
+    MotionGateOptions opts_;
+    MotionDecision decision_;
+    bool has_reference_ = false;
+    int width_ = 0, height_ = 0;
+    int grid_w_ = 0, grid_h_ = 0;
+    std::vector<float> reference_, current_;  // mean intensity per cell, row-major
+    std::vector<float> inv_count_;            // 1 / sampled bytes of each cell, edge cells are smaller
+    std::vector<uint32_t> sums_;
+    std::vector<uint8_t> changed_;
+    std::vector<int> stack_;
+};
@@ -1,5 +1,6 @@
 #include "preprocess.h"
 #include "cuda_utils.h"
+#include "uint8_input.h"
 
 static uint8_t* img_buffer_host = nullptr;
 static uint8_t* img_buffer_device = nullptr;
@@ -103,21 +104,8 @@ void cuda_preprocess(
   // copy data to device memory
   CUDA_CHECK(cudaMemcpyAsync(img_buffer_device, img_buffer_host, img_size, cudaMemcpyHostToDevice, stream));
 
-  AffineMatrix s2d, d2s;
-  float scale = std::min(dst_height / (float)src_height, dst_width / (float)src_width);
-
-  s2d.value[0] = scale;
-  s2d.value[1] = 0;
-  s2d.value[2] = -scale * src_width  * 0.5  + dst_width * 0.5;
-  s2d.value[3] = 0;
-  s2d.value[4] = scale;
-  s2d.value[5] = -scale * src_height * 0.5 + dst_height * 0.5;
-
-  cv::Mat m2x3_s2d(2, 3, CV_32F, s2d.value);
-  cv::Mat m2x3_d2s(2, 3, CV_32F, d2s.value);
-  cv::invertAffineTransform(m2x3_s2d, m2x3_d2s);
-
-  memcpy(d2s.value, m2x3_d2s.ptr<float>(0), sizeof(d2s.value));
+  AffineMatrix d2s;
+  letterbox_d2s(src_width, src_height, dst_width, dst_height, d2s.value);
 
   int jobs = dst_height * dst_width;
   int threads = 256;
@@ -139,6 +127,18 @@ void cuda_batch_preprocess(std::vector<cv::Mat>& img_batch,
   }
 }
 
+void cuda_batch_preprocess_uint8(std::vector<cv::Mat>& img_batch,
+                                 uint8_t* dst, int dst_width, int dst_height,
+                                 cudaStream_t stream) {
+  size_t dst_size = (size_t)dst_width * dst_height * 3;
+  // the last upload from the pinned buffer must be done before it is overwritten
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+  for (size_t i = 0; i < img_batch.size(); i++) {
+    letterbox_uint8(img_batch[i], img_buffer_host + dst_size * i, dst_width, dst_height);
+  }
+  CUDA_CHECK(cudaMemcpyAsync(dst, img_buffer_host, dst_size * img_batch.size(), cudaMemcpyHostToDevice, stream));
+}
+
 void cuda_preprocess_init(int max_image_size) {
   // prepare input data in pinned memory
   CUDA_CHECK(cudaMallocHost((void**)&img_buffer_host, max_image_size * 3));
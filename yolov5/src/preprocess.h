@@ -13,3 +13,8 @@ void cuda_batch_preprocess(std::vector<cv::Mat>& img_batch,
                            float* dst, int dst_width, int dst_height,
                            cudaStream_t stream);
 
+// For engines built with USE_UINT8_INPUT: letterboxes each image on the CPU into the pinned buffer as uint8 HWC BGR
+// (see letterbox_uint8) and uploads the batch in one copy, 3 bytes per input pixel whatever the image size.
+void cuda_batch_preprocess_uint8(std::vector<cv::Mat>& img_batch,
+                                 uint8_t* dst, int dst_width, int dst_height,
+                                 cudaStream_t stream);
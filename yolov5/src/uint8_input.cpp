@@ -0,0 +1,84 @@
+#include "uint8_input.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void letterbox_d2s(int src_width, int src_height, int dst_width, int dst_height, float d2s[6]) {
+  float scale = std::min(dst_height / (float)src_height, dst_width / (float)src_width);
+  float s2d[6] = {scale, 0, 0, 0, scale, 0};
+  s2d[2] = -scale * src_width * 0.5 + dst_width * 0.5;
+  s2d[5] = -scale * src_height * 0.5 + dst_height * 0.5;
+  // the determinant is a float product, the rest double, as in cv::invertAffineTransform for CV_32F
+  float det = s2d[0] * s2d[4] - s2d[1] * s2d[3];
+  double d = det != 0 ? 1. / det : 0.;
+  double a11 = s2d[4] * d, a22 = s2d[0] * d, a12 = -s2d[1] * d, a21 = -s2d[3] * d;
+  d2s[0] = a11;
+  d2s[1] = a12;
+  d2s[2] = -a11 * s2d[2] - a12 * s2d[5];
+  d2s[3] = a21;
+  d2s[4] = a22;
+  d2s[5] = -a21 * s2d[2] - a22 * s2d[5];
+}
+
+void letterbox_uint8(const cv::Mat& img, uint8_t* dst, int dst_width, int dst_height) {
+  const uint8_t border = 128;
+  const uint8_t pad[3] = {border, border, border};
+  float d2s[6];
+  letterbox_d2s(img.cols, img.rows, dst_width, dst_height, d2s);
+  // The letterbox only scales and shifts, d2s[1] and d2s[3] are zero, so a column samples the same image columns
+  // in every row: byte offsets of its two taps in a row (-1 past the border) and the weight of the right one
+  std::vector<int> left(dst_width), right(dst_width);
+  std::vector<float> lx(dst_width);
+  std::vector<uint8_t> inside(dst_width);
+  for (int dx = 0; dx < dst_width; dx++) {
+    float src_x = d2s[0] * dx + d2s[2] + 0.5f;
+    inside[dx] = src_x > -1 && src_x < img.cols;
+    int x_low = floorf(src_x);
+    lx[dx] = src_x - x_low;
+    left[dx] = x_low >= 0 ? x_low * 3 : -1;
+    right[dx] = x_low + 1 < img.cols ? (x_low + 1) * 3 : -1;
+  }
+  for (int dy = 0; dy < dst_height; dy++) {
+    uint8_t* out = dst + (size_t)dy * dst_width * 3;
+    float src_y = d2s[4] * dy + d2s[5] + 0.5f;
+    if (src_y <= -1 || src_y >= img.rows) {
+      memset(out, border, (size_t)dst_width * 3);
+      continue;
+    }
+    int y_low = floorf(src_y);
+    float ly = src_y - y_low;
+    float hy = 1 - ly;
+    const uint8_t* top = y_low >= 0 ? img.ptr<uint8_t>(y_low) : nullptr;
+    const uint8_t* bottom = y_low + 1 < img.rows ? img.ptr<uint8_t>(y_low + 1) : nullptr;
+    for (int dx = 0; dx < dst_width; dx++, out += 3) {
+      if (!inside[dx]) {
+        out[0] = out[1] = out[2] = border;
+        continue;
+      }
+      // the weights and the sum in the order of warpaffine_kernel
+      float hx = 1 - lx[dx];
+      float w1 = hy * hx, w2 = hy * lx[dx], w3 = ly * hx, w4 = ly * lx[dx];
+      const uint8_t* v1 = top && left[dx] >= 0 ? top + left[dx] : pad;
+      const uint8_t* v2 = top && right[dx] >= 0 ? top + right[dx] : pad;
+      const uint8_t* v3 = bottom && left[dx] >= 0 ? bottom + left[dx] : pad;
+      const uint8_t* v4 = bottom && right[dx] >= 0 ? bottom + right[dx] : pad;
+      for (int c = 0; c < 3; c++) {
+        float v = w1 * v1[c] + w2 * v2[c] + w3 * v3[c] + w4 * v4[c];
+        out[c] = (uint8_t)std::min(v + 0.5f, 255.f);
+      }
+    }
+  }
+}
+
+void uint8_input_reference(const uint8_t* src, float* dst, int batch, int height, int width) {
+  const int plane = height * width;
+  for (int b = 0; b < batch; b++) {
+    const uint8_t* s = src + (size_t)b * plane * 3;
+    float* d = dst + (size_t)b * plane * 3;
+    for (int p = 0; p < plane; p++) {
+      for (int c = 0; c < 3; c++) {
+        d[c * plane + p] = s[p * 3 + 2 - c] / 255.f;
+      }
+    }
+  }
+}
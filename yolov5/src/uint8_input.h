@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// uint8 input mode (USE_UINT8_INPUT in config.h). The engine input is the letterboxed image as uint8
+// HWC BGR and the Uint8Input_TRT plugin, the first layer, turns it into the float RGB CHW / 255 tensor the backbone
+// takes. The host letterboxes into bytes and uploads 3 bytes per input pixel instead of the whole frame, and nothing
+// is normalized outside the engine. TensorRT 8.4 has no uint8 network inputs, so like the preprocess plugin of
+// real-esrgan the binding is declared float of shape {H, W, 3} and the plugin reads it as bytes; only a quarter of
+// the binding size is used.
+
+// The input to image transform of the letterbox warpaffine_kernel samples with: image = d2s * (x, y, 1). Computed as
+// cv::invertAffineTransform does, so the CPU and GPU paths use the very same floats.
+void letterbox_d2s(int src_width, int src_height, int dst_width, int dst_height, float d2s[6]);
+
+// Letterboxes a BGR image into dst_width x dst_height uint8 HWC BGR. Each pixel is the bilinear sample
+// warpaffine_kernel computes, rounded to the nearest byte, with the same 128 border, so the engine sees the input of
+// the float path to within half a level.
+void letterbox_uint8(const cv::Mat& img, uint8_t* dst, int dst_width, int dst_height);
+
+// CPU reference of Uint8Input_TRT: batch uint8 HWC BGR images to float RGB CHW / 255.
+void uint8_input_reference(const uint8_t* src, float* dst, int batch, int height, int width);
@@ -4,8 +4,12 @@
 #include "preprocess.h"
 #include "postprocess.h"
 #include "model.h"
+#include "profiler.h"
+#include "bench.h"
+#include "motion_gate.h"
 
 #include <iostream>
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 
@@ -131,19 +135,89 @@ void deserialize_engine(std::string& engine_name, IRuntime** runtime, ICudaEngin
   delete[] serialized_engine;
 }
 
+// --bench: the -d pipeline on synthetic 1280x720 frames, without disk I/O. GPU stages are timed with cudaEvents, the
+// CPU postprocess with steady_clock. Preprocessing stages each image through pinned memory, so its stage includes
+// the H2D copy.
+int run_detect_bench(const BenchOptions& opts, IExecutionContext& context, cudaStream_t& stream, float** gpu_buffers, float* cpu_output_buffer) {
+  std::vector<cv::Mat> img_batch = make_bench_images(kBatchSize, 1280, 720);
+  GpuStageTimer timer(stream);
+  BenchStats stats = run_bench(opts, [&](BenchStats& s) {
+    timer.start();
+#ifdef USE_UINT8_INPUT
+    cuda_batch_preprocess_uint8(img_batch, (uint8_t*)gpu_buffers[0], kInputW, kInputH, stream);
+#else
+    cuda_batch_preprocess(img_batch, gpu_buffers[0], kInputW, kInputH, stream);
+#endif
+    timer.mark("preprocess");
+    context.enqueue(kBatchSize, (void**)gpu_buffers, stream, nullptr);
+    timer.mark("inference");
+    CUDA_CHECK(cudaMemcpyAsync(cpu_output_buffer, gpu_buffers[1], kBatchSize * kOutputSize * sizeof(float), cudaMemcpyDeviceToHost, stream));
+    timer.mark("d2h");
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    timer.collect(s);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<Detection>> res_batch;
+    batch_nms(res_batch, cpu_output_buffer, kBatchSize, kOutputSize, kConfThresh, kNmsThresh);
+    s.add("decode+nms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+  });
+  return stats.report(opts, "yolov5_det", kBatchSize) ? 0 : -1;
+}
+
+// --bench_mock: the CPU stages of -d, decode + NMS of the yolo layer output and mapping the boxes back to the image,
+// on synthetic engine output. Needs no GPU, so pre/post regressions can be tracked in CI.
+int run_mock_bench(const BenchOptions& opts) {
+  std::mt19937 rng(0);
+  std::vector<float> output(kBatchSize * kOutputSize);
+  for (int b = 0; b < kBatchSize; b++) {
+    fill_mock_output<Detection>(&output[b * kOutputSize], kOutputSize, kMaxNumOutputBbox, kInputW, kInputH, kNumClass, false, rng);
+  }
+  std::vector<cv::Mat> img_batch = make_bench_images(kBatchSize, 1280, 720);
+  BenchStats stats = run_bench(opts, [&](BenchStats& s) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::vector<Detection>> res_batch;
+    batch_nms(res_batch, output.data(), kBatchSize, kOutputSize, kConfThresh, kNmsThresh);
+    auto t1 = std::chrono::steady_clock::now();
+    for (int b = 0; b < kBatchSize; b++) {
+      for (auto& det : res_batch[b]) {
+        get_rect(img_batch[b], det.bbox);
+      }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    s.add("decode+nms", std::chrono::duration<double, std::milli>(t1 - t0).count());
+    s.add("get_rect", std::chrono::duration<double, std::milli>(t2 - t1).count());
+  });
+  return stats.report(opts, "yolov5_det mock", kBatchSize) ? 0 : -1;
+}
+
 int main(int argc, char** argv) {
+  BenchOptions bench;
+  MotionGateOptions motion;
+  if (!parse_bench_args(argc, argv, bench) || !parse_motion_gate_args(argc, argv, motion)) return -1;
+  if (bench.mock) return run_mock_bench(bench);
+
   cudaSetDevice(kGpuId);
 
+  std::string profile_prefix;
+  int profile_iters = 1;
+  if (!parse_profile_args(argc, argv, profile_prefix, profile_iters)) return -1;
+
   std::string wts_name = "";
   std::string engine_name = "";
   bool is_p6 = false;
   float gd = 0.0f, gw = 0.0f;
   std::string img_dir;
 
-  if (!parse_args(argc, argv, wts_name, engine_name, is_p6, gd, gw, img_dir)) {
+  if (bench.enabled && argc == 3 && std::string(argv[1]) == "-d") {
+    // the images are generated in memory, no image folder
+    engine_name = std::string(argv[2]);
+  } else if (!parse_args(argc, argv, wts_name, engine_name, is_p6, gd, gw, img_dir)) {
     std::cerr << "arguments not right!" << std::endl;
     std::cerr << "./yolov5_det -s [.wts] [.engine] [n/s/m/l/x/n6/s6/m6/l6/x6 or c/c6 gd gw]  // serialize model to plan file" << std::endl;
     std::cerr << "./yolov5_det -d [.engine] ../images  // deserialize plan file and run inference" << std::endl;
+    std::cerr << "optional with -d: --profile=[output prefix] --profile_iters=10  // per-layer timings as csv/json" << std::endl;
+    std::cerr << "optional with -d: --motion_gate [--motion_thresh=8 --motion_area=0.0005 --max_stale=30 --motion_block=16 --motion_step=2]  // reuse detections on static frames" << std::endl;
+    std::cerr << "./yolov5_det -d [.engine] --bench [--bench_iters=200 --bench_warmup=20 --bench_json=file]  // stage latency on synthetic frames" << std::endl;
+    std::cerr << "./yolov5_det --bench_mock  // CPU postprocess stages on synthetic engine output, no GPU" << std::endl;
     return -1;
   }
 
@@ -169,12 +243,28 @@ int main(int argc, char** argv) {
   float* cpu_output_buffer = nullptr;
   prepare_buffers(engine, &gpu_buffers[0], &gpu_buffers[1], &cpu_output_buffer);
 
+  if (bench.enabled) {
+    return run_detect_bench(bench, *context, stream, gpu_buffers, cpu_output_buffer);
+  }
+
   // Read images from directory
   std::vector<std::string> file_names;
   if (read_files_in_dir(img_dir.c_str(), file_names) < 0) {
     std::cerr << "read_files_in_dir failed." << std::endl;
     return -1;
   }
+  if (motion.enabled) {
+    // the gate compares consecutive frames, so the images are taken in name order (frame_0001.jpg, ...)
+    std::sort(file_names.begin(), file_names.end());
+  }
+  MotionGate gate(motion);
+  std::vector<Detection> last_dets;
+  int reused_frames = 0;
+
+  LayerProfiler profiler;
+  if (!profile_prefix.empty()) {
+    context->setProfiler(&profiler);
+  }
 
   // batch predict
   for (size_t i = 0; i < file_names.size(); i += kBatchSize) {
@@ -187,18 +277,47 @@ int main(int argc, char** argv) {
       img_name_batch.push_back(file_names[j]);
     }
 
-    // Preprocess
-    cuda_batch_preprocess(img_batch, gpu_buffers[0], kInputW, kInputH, stream);
-
-    // Run inference
-    auto start = std::chrono::system_clock::now();
-    infer(*context, stream, (void**)gpu_buffers, cpu_output_buffer, kBatchSize);
-    auto end = std::chrono::system_clock::now();
-    std::cout << "inference time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms" << std::endl;
-
-    // NMS
-    std::vector<std::vector<Detection>> res_batch;
-    batch_nms(res_batch, cpu_output_buffer, img_batch.size(), kOutputSize, kConfThresh, kNmsThresh);
+    // Frames without motion reuse the boxes of the last frame the detector ran on, the gate forces a run when the
+    // frame size changes so the boxes still fit get_rect
+    std::vector<cv::Mat> run_batch;
+    std::vector<size_t> run_index;
+    for (size_t j = 0; j < img_batch.size(); j++) {
+      if (!motion.enabled || gate.check(img_batch[j]).run_detector) {
+        run_batch.push_back(img_batch[j]);
+        run_index.push_back(j);
+      }
+    }
+    std::vector<std::vector<Detection>> run_res;
+    if (!run_batch.empty()) {
+      // Preprocess
+#ifdef USE_UINT8_INPUT
+      cuda_batch_preprocess_uint8(run_batch, (uint8_t*)gpu_buffers[0], kInputW, kInputH, stream);
+#else
+      cuda_batch_preprocess(run_batch, gpu_buffers[0], kInputW, kInputH, stream);
+#endif
+
+      // Run inference
+      auto start = std::chrono::system_clock::now();
+      infer(*context, stream, (void**)gpu_buffers, cpu_output_buffer, kBatchSize);
+      auto end = std::chrono::system_clock::now();
+      std::cout << "inference time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms" << std::endl;
+      // Rerun the preprocessed batch so every layer has profile_iters samples per batch
+      for (int k = 1; !profile_prefix.empty() && k < profile_iters; k++) {
+        infer(*context, stream, (void**)gpu_buffers, cpu_output_buffer, kBatchSize);
+      }
+
+      // NMS
+      batch_nms(run_res, cpu_output_buffer, run_batch.size(), kOutputSize, kConfThresh, kNmsThresh);
+    }
+    std::vector<std::vector<Detection>> res_batch(img_batch.size());
+    for (size_t j = 0, k = 0; j < img_batch.size(); j++) {
+      if (k < run_index.size() && run_index[k] == j) {
+        last_dets = run_res[k++];
+      } else {
+        reused_frames++;
+      }
+      res_batch[j] = last_dets;
+    }
 
     // Draw bounding boxes
     draw_bbox(img_batch, res_batch);
@@ -209,6 +328,13 @@ int main(int argc, char** argv) {
     }
   }
 
+  if (!profile_prefix.empty()) {
+    profiler.table.report(profile_prefix);
+  }
+  if (motion.enabled) {
+    std::cout << "motion gate: " << reused_frames << " of " << file_names.size() << " frames reused the previous detections" << std::endl;
+  }
+
   // Release stream and buffers
   cudaStreamDestroy(stream);
   CUDA_CHECK(cudaFree(gpu_buffers[0]));
@@ -204,7 +204,11 @@ int main(int argc, char** argv) {
     }
 
     // Preprocess
+#ifdef USE_UINT8_INPUT
+    cuda_batch_preprocess_uint8(img_batch, (uint8_t*)gpu_buffers[0], kInputW, kInputH, stream);
+#else
     cuda_batch_preprocess(img_batch, gpu_buffers[0], kInputW, kInputH, stream);
+#endif
 
     // Run inference
     auto start = std::chrono::system_clock::now();
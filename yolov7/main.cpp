@@ -5,6 +5,7 @@
 #include "utils.h"
 #include "preprocess.h"
 #include "postprocess.h"
+#include "bench.h"
 #include <chrono>
 #include <fstream>
 
@@ -110,7 +111,61 @@ bool parse_args(int argc, char** argv, std::string& wts, std::string& engine, st
   return true;
 }
 
+// --bench: the -d pipeline on synthetic 1280x720 frames, without disk I/O. GPU stages are timed with cudaEvents, the
+// CPU postprocess with steady_clock. Preprocessing stages each image through pinned memory, so its stage includes
+// the H2D copy.
+int run_detect_bench(const BenchOptions& opts, IExecutionContext& context, cudaStream_t& stream, float** device_buffers, float* output_buffer_host) {
+  std::vector<cv::Mat> img_batch = make_bench_images(kBatchSize, 1280, 720);
+  GpuStageTimer timer(stream);
+  BenchStats stats = run_bench(opts, [&](BenchStats& s) {
+    timer.start();
+    cuda_batch_preprocess(img_batch, device_buffers[0], kInputW, kInputH, stream);
+    timer.mark("preprocess");
+    context.enqueue(kBatchSize, (void**)device_buffers, stream, nullptr);
+    timer.mark("inference");
+    CUDA_CHECK(cudaMemcpyAsync(output_buffer_host, device_buffers[1], kBatchSize * kOutputSize * sizeof(float), cudaMemcpyDeviceToHost, stream));
+    timer.mark("d2h");
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    timer.collect(s);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<Detection>> res_batch;
+    batch_nms(res_batch, output_buffer_host, kBatchSize, kOutputSize, kConfThresh, kNmsThresh);
+    s.add("decode+nms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+  });
+  return stats.report(opts, "yolov7", kBatchSize) ? 0 : -1;
+}
+
+// --bench_mock: the CPU stages of -d, decode + NMS of the yolo layer output and mapping the boxes back to the image,
+// on synthetic engine output. Needs no GPU, so pre/post regressions can be tracked in CI.
+int run_mock_bench(const BenchOptions& opts) {
+  std::mt19937 rng(0);
+  std::vector<float> output(kBatchSize * kOutputSize);
+  for (int b = 0; b < kBatchSize; b++) {
+    fill_mock_output<Detection>(&output[b * kOutputSize], kOutputSize, kMaxNumOutputBbox, kInputW, kInputH, kNumClass, false, rng);
+  }
+  std::vector<cv::Mat> img_batch = make_bench_images(kBatchSize, 1280, 720);
+  BenchStats stats = run_bench(opts, [&](BenchStats& s) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::vector<Detection>> res_batch;
+    batch_nms(res_batch, output.data(), kBatchSize, kOutputSize, kConfThresh, kNmsThresh);
+    auto t1 = std::chrono::steady_clock::now();
+    for (int b = 0; b < kBatchSize; b++) {
+      for (auto& det : res_batch[b]) {
+        get_rect(img_batch[b], det.bbox);
+      }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    s.add("decode+nms", std::chrono::duration<double, std::milli>(t1 - t0).count());
+    s.add("get_rect", std::chrono::duration<double, std::milli>(t2 - t1).count());
+  });
+  return stats.report(opts, "yolov7 mock", kBatchSize) ? 0 : -1;
+}
+
 int main(int argc, char** argv) {
+  BenchOptions bench;
+  if (!parse_bench_args(argc, argv, bench)) return -1;
+  if (bench.mock) return run_mock_bench(bench);
+
   cudaSetDevice(kGpuId);
 
   std::string wts_name = "";
@@ -118,10 +173,15 @@ int main(int argc, char** argv) {
   std::string img_dir;
   std::string sub_type = "";
 
-  if (!parse_args(argc, argv, wts_name, engine_name, img_dir, sub_type)) {
+  if (bench.enabled && argc == 3 && std::string(argv[1]) == "-d") {
+    // the images are generated in memory, no image folder
+    engine_name = std::string(argv[2]);
+  } else if (!parse_args(argc, argv, wts_name, engine_name, img_dir, sub_type)) {
     std::cerr << "Arguments not right!" << std::endl;
     std::cerr << "./yolov7 -s [.wts] [.engine] [t/v7/x/w6/e6/d6/e6e]  // serialize model to plan file" << std::endl;
     std::cerr << "./yolov7 -d [.engine] ../samples  // deserialize plan file and run inference" << std::endl;
+    std::cerr << "./yolov7 -d [.engine] --bench [--bench_iters=200 --bench_warmup=20 --bench_json=file]  // stage latency on synthetic frames" << std::endl;
+    std::cerr << "./yolov7 --bench_mock  // CPU postprocess stages on synthetic engine output, no GPU" << std::endl;
     return -1;
   }
 
@@ -146,6 +206,10 @@ int main(int argc, char** argv) {
   float* output_buffer_host = nullptr;
   prepare_buffer(engine, &device_buffers[0], &device_buffers[1], &output_buffer_host);
 
+  if (bench.enabled) {
+    return run_detect_bench(bench, *context, stream, device_buffers, output_buffer_host);
+  }
+
   // Read images from directory
   std::vector<std::string> file_names;
   if (read_files_in_dir(img_dir.c_str(), file_names) < 0) {
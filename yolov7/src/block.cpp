@@ -49,56 +49,51 @@ std::map<std::string, Weights> loadWeights(const std::string file) {
     return weightMap;
 }
 
-static IScaleLayer* addBatchNorm2d(INetworkDefinition* network, std::map<std::string, Weights>& weightMap, ITensor& input, std::string lname, float eps) {
-    float* gamma = (float*)weightMap[lname + ".weight"].values;
-    float* beta = (float*)weightMap[lname + ".bias"].values;
-    float* mean = (float*)weightMap[lname + ".running_mean"].values;
-    float* var = (float*)weightMap[lname + ".running_var"].values;
-    int len = weightMap[lname + ".running_var"].count;
-
-    float* scval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-    for (int i = 0; i < len; i++) {
-        scval[i] = gamma[i] / sqrt(var[i] + eps);
-    }
-    Weights scale{ DataType::kFLOAT, scval, len };
-
-    float* shval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-    for (int i = 0; i < len; i++) {
-        shval[i] = beta[i] - mean[i] * gamma[i] / sqrt(var[i] + eps);
-    }
-    Weights shift{ DataType::kFLOAT, shval, len };
-
-    float* pval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-    for (int i = 0; i < len; i++) {
-        pval[i] = 1.0;
+// Folds the BatchNorm2d behind a bias-free conv into its weights and a bias: the .bn of convBnSilu and
+// convBlockLeakRelu, and the .1 of both RepConv branches. The weights are scaled in place, and the bias goes into
+// weightMap so each build's free loop in model.cpp releases it.
+static void foldBatchNorm2d(std::map<std::string, Weights>& weightMap, std::string conv_name, std::string bn_name, float eps, Weights& weight, Weights& bias) {
+    std::string bias_name = conv_name + ".fused_bias";
+    Weights& w = weightMap[conv_name + ".weight"];
+    if (weightMap.count(bias_name) == 0) {
+        const float* gamma = (const float*)weightMap[bn_name + ".weight"].values;
+        const float* beta = (const float*)weightMap[bn_name + ".bias"].values;
+        const float* mean = (const float*)weightMap[bn_name + ".running_mean"].values;
+        const float* var = (const float*)weightMap[bn_name + ".running_var"].values;
+        int len = weightMap[bn_name + ".running_var"].count;
+        assert(len > 0 && w.count % len == 0);
+        int per_channel = w.count / len;
+
+        float* wval = (float*)w.values;
+        float* bval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
+        for (int c = 0; c < len; c++) {
+            float scale = gamma[c] / sqrt(var[c] + eps);
+            float* row = wval + c * per_channel;
+            for (int i = 0; i < per_channel; i++) {
+                row[i] *= scale;
+            }
+            bval[c] = beta[c] - mean[c] * scale;
+        }
+        weightMap[bias_name] = Weights{ DataType::kFLOAT, bval, len };
     }
-    Weights power{ DataType::kFLOAT, pval, len };
-
-    weightMap[lname + ".scale"] = scale;
-    weightMap[lname + ".shift"] = shift;
-    weightMap[lname + ".power"] = power;
-    IScaleLayer* scale_1 = network->addScale(input, ScaleMode::kCHANNEL, shift, scale, power);
-    assert(scale_1);
-    return scale_1;
+    weight = w;
+    bias = weightMap[bias_name];
 }
 
 IElementWiseLayer* convBnSilu(INetworkDefinition* network, std::map<std::string, Weights>& weightMap, ITensor& input, int c2, int k, int s, int p, std::string lname) {
-    Weights emptywts{ DataType::kFLOAT, nullptr, 0 };
+    Weights weight, bias;
+    foldBatchNorm2d(weightMap, lname + ".conv", lname + ".bn", 1e-3, weight, bias);
 
-    IConvolutionLayer* conv1 = network->addConvolutionNd(input, c2, DimsHW{ k, k }, weightMap[lname + ".conv.weight"], emptywts);
+    IConvolutionLayer* conv1 = network->addConvolutionNd(input, c2, DimsHW{ k, k }, weight, bias);
     assert(conv1);
     conv1->setName((lname + ".conv").c_str());
     conv1->setStrideNd(DimsHW{ s, s });
     conv1->setPaddingNd(DimsHW{ p, p });
 
-
-    IScaleLayer* bn1 = addBatchNorm2d(network, weightMap, *conv1->getOutput(0), lname + ".bn", 1e-3);
-
-
     // silu = x * sigmoid(x)
-    IActivationLayer* sig1 = network->addActivation(*bn1->getOutput(0), ActivationType::kSIGMOID);
+    IActivationLayer* sig1 = network->addActivation(*conv1->getOutput(0), ActivationType::kSIGMOID);
     assert(sig1);
-    IElementWiseLayer* ew1 = network->addElementWise(*bn1->getOutput(0), *sig1->getOutput(0), ElementWiseOperation::kPROD);
+    IElementWiseLayer* ew1 = network->addElementWise(*conv1->getOutput(0), *sig1->getOutput(0), ElementWiseOperation::kPROD);
     assert(ew1);
     return ew1;
 }
@@ -166,22 +161,23 @@ IElementWiseLayer* SPPCSPC(INetworkDefinition* network, std::map<std::string, We
 }
 
 IElementWiseLayer* RepConv(INetworkDefinition* network, std::map<std::string, Weights>& weightMap, ITensor& input, int c2, int k, int s, const std::string& lname) {
-    Weights emptywts{ DataType::kFLOAT, nullptr, 0 };
     // 256 * 128 * 3 *3
-    IConvolutionLayer* rbr_dense_conv = network->addConvolutionNd(input, c2, DimsHW{ k, k }, weightMap[lname + ".rbr_dense.0.weight"], emptywts);
+    Weights dense_weight, dense_bias;
+    foldBatchNorm2d(weightMap, lname + ".rbr_dense.0", lname + ".rbr_dense.1", 1e-3, dense_weight, dense_bias);
+    IConvolutionLayer* rbr_dense_conv = network->addConvolutionNd(input, c2, DimsHW{ k, k }, dense_weight, dense_bias);
     assert(rbr_dense_conv);
     rbr_dense_conv->setPaddingNd(DimsHW{ k / 2, k / 2 });
     rbr_dense_conv->setStrideNd(DimsHW{ s, s });
     rbr_dense_conv->setName((lname + ".rbr_dense.0").c_str());
-    IScaleLayer* rbr_dense_bn = addBatchNorm2d(network, weightMap, *rbr_dense_conv->getOutput(0), lname + ".rbr_dense.1", 1e-3);
 
-    IConvolutionLayer* rbr_1x1_conv = network->addConvolutionNd(input, c2, DimsHW{ 1, 1 }, weightMap[lname + ".rbr_1x1.0.weight"], emptywts);
+    Weights weight_1x1, bias_1x1;
+    foldBatchNorm2d(weightMap, lname + ".rbr_1x1.0", lname + ".rbr_1x1.1", 1e-3, weight_1x1, bias_1x1);
+    IConvolutionLayer* rbr_1x1_conv = network->addConvolutionNd(input, c2, DimsHW{ 1, 1 }, weight_1x1, bias_1x1);
     assert(rbr_1x1_conv);
     rbr_1x1_conv->setStrideNd(DimsHW{ s, s });
     rbr_1x1_conv->setName((lname + ".rbr_1x1.0").c_str());
-    IScaleLayer* rbr_1x1_bn = addBatchNorm2d(network, weightMap, *rbr_1x1_conv->getOutput(0), lname + ".rbr_1x1.1", 1e-3);
 
-    IElementWiseLayer* ew1 = network->addElementWise(*rbr_dense_bn->getOutput(0), *rbr_1x1_bn->getOutput(0), ElementWiseOperation::kSUM);
+    IElementWiseLayer* ew1 = network->addElementWise(*rbr_dense_conv->getOutput(0), *rbr_1x1_conv->getOutput(0), ElementWiseOperation::kSUM);
     assert(ew1);
     // silu
     IActivationLayer* sigmoid = network->addActivation(*ew1->getOutput(0), ActivationType::kSIGMOID);
@@ -190,17 +186,17 @@ IElementWiseLayer* RepConv(INetworkDefinition* network, std::map<std::string, We
 }
 
 IActivationLayer* convBlockLeakRelu(INetworkDefinition* network, std::map<std::string, Weights>& weightMap, ITensor& input, int outch, int ksize, int s, int p, std::string lname) {
-    Weights emptywts{ DataType::kFLOAT, nullptr, 0 };
+    Weights weight, bias;
+    foldBatchNorm2d(weightMap, lname + ".conv", lname + ".bn", 1e-5, weight, bias);
 
-    IConvolutionLayer* conv1 = network->addConvolutionNd(input, outch, DimsHW{ ksize, ksize }, weightMap[lname + ".conv.weight"], emptywts);
+    IConvolutionLayer* conv1 = network->addConvolutionNd(input, outch, DimsHW{ ksize, ksize }, weight, bias);
     assert(conv1);
     conv1->setName((lname + ".conv").c_str());
     conv1->setStrideNd(DimsHW{ s, s });
     conv1->setPaddingNd(DimsHW{ p, p });
     //conv1->setNbGroups(g);
-    IScaleLayer* bn1 = addBatchNorm2d(network, weightMap, *conv1->getOutput(0), lname + ".bn", 1e-5);
 
-    auto ew1 = network->addActivation(*bn1->getOutput(0), ActivationType::kLEAKY_RELU);
+    auto ew1 = network->addActivation(*conv1->getOutput(0), ActivationType::kLEAKY_RELU);
     ew1->setAlpha(0.1);
     return ew1;
 }
@@ -14,6 +14,9 @@ def parse_args():
     parser.add_argument(
         '-t', '--type', type=str, default='detect', choices=['detect', 'cls', 'seg', 'pose'],
         help='determines the model is detection/classification')
+    parser.add_argument(
+        '-p', '--precision', type=str, default='fp32', choices=['fp32', 'fp16', 'int8'],
+        help='storage precision of the weights, int8 applies per-channel to conv weights except DFL (optional)')
     args = parser.parse_args()
     if not os.path.isfile(args.weights):
         raise SystemExit('Invalid input file')
@@ -23,10 +26,10 @@ def parse_args():
         args.output = os.path.join(
             args.output,
             os.path.splitext(os.path.basename(args.weights))[0] + '.wts')
-    return args.weights, args.output, args.type
+    return args.weights, args.output, args.type, args.precision
 
 
-pt_file, wts_file, m_type = parse_args()
+pt_file, wts_file, m_type, precision = parse_args()
 
 print(f'Generating .wts for {m_type} model')
 
@@ -50,8 +53,31 @@ with open(wts_file, 'w') as f:
     f.write('{}\n'.format(len(model.state_dict().keys())))
     for k, v in model.state_dict().items():
         vr = v.reshape(-1).cpu().numpy()
-        f.write('{} {} '.format(k, len(vr)))
-        for vv in vr:
-            f.write(' ')
-            f.write(struct.pack('>f', float(vv)).hex())
+        # conv weights carry their shape, so that tools like yolov8_sparsify know the kernel size
+        f.write(k + ' ')
+        if v.dim() == 4:
+            f.write('shape {} '.format('x'.join(str(d) for d in v.shape)))
+        # the DFL conv holds the fixed projection 0..15, which int8 can not represent exactly
+        if precision == 'int8' and v.dim() == 4 and k.endswith('.weight') and '.dfl.' not in k:
+            # per output channel symmetric quantization: w = q * scale
+            w = v.reshape(v.shape[0], -1).float()
+            scales = (w.abs().max(dim=1).values / 127.0).clamp(min=1e-12)
+            q = torch.round(w / scales[:, None]).clamp(-127, 127).to(torch.int8).reshape(-1).numpy()
+            f.write('int8 {} {} '.format(len(vr), len(scales)))
+            for s in scales.numpy():
+                f.write(' ')
+                f.write(struct.pack('>f', float(s)).hex())
+            for qq in q:
+                f.write(' ')
+                f.write(struct.pack('>b', int(qq)).hex())
+        elif precision == 'fp16' and v.is_floating_point():
+            f.write('fp16 {} '.format(len(vr)))
+            for vv in vr:
+                f.write(' ')
+                f.write(struct.pack('>e', float(vv)).hex())
+        else:
+            f.write('{} '.format(len(vr)))
+            for vv in vr:
+                f.write(' ')
+                f.write(struct.pack('>f', float(vv)).hex())
         f.write('\n')
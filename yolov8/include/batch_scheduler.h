@@ -0,0 +1,78 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <thread>
+#include <vector>
+#include "types.h"
+
+// One image submitted to the server. The batch function fills result, with bbox as [x, y, w, h] in pixels of img.
+struct InferJob {
+    cv::Mat img;
+    std::vector<Detection> result;
+    std::chrono::steady_clock::time_point arrival;
+    std::chrono::steady_clock::time_point deadline;
+    std::chrono::steady_clock::time_point finish;
+    std::promise<void> done;
+};
+
+struct BatchSchedulerOptions {
+    int max_batch = 1;
+    // bounds and start value of the coalescing window, measured from the arrival of the oldest queued job
+    int min_window_us = 100;
+    int max_window_us = 10000;
+    int initial_window_us = 1000;
+    // Runs first on the scheduler thread, before any batch; per-thread state such as the CUDA device goes here.
+    std::function<void()> thread_init;
+};
+
+struct BatchSchedulerStats {
+    uint64_t batches = 0;
+    uint64_t jobs = 0;
+    uint64_t deadline_misses = 0;
+    int window_us = 0;
+    float exec_us = 0.f;
+};
+
+// Coalesces single-image jobs into batches of up to max_batch for one engine. A batch is dispatched when it is full,
+// when the coalescing window of its oldest job has passed, or when waiting longer would make the earliest deadline
+// miss given the observed batch execution time. The window adapts to the queue depth seen at dispatch: it halves
+// while batches fill up on their own or deadlines are missed, shrinks when nothing coalesced, and grows while partial
+// batches are being formed.
+class BatchScheduler {
+   public:
+    // Runs on the scheduler thread with 1..max_batch jobs, must fill InferJob::result.
+    using BatchFn = std::function<void(std::vector<std::shared_ptr<InferJob>>&)>;
+
+    BatchScheduler(const BatchSchedulerOptions& opts, BatchFn fn);
+    ~BatchScheduler();
+
+    // Sets job->arrival and returns a future that is ready once job->result is filled. job->deadline must be set.
+    std::future<void> submit(std::shared_ptr<InferJob> job);
+
+    // Runs the jobs still queued and joins the scheduler thread.
+    void stop();
+
+    BatchSchedulerStats stats();
+
+   private:
+    void run();
+    void adapt(size_t batch_size, size_t queue_depth, bool missed);
+
+    BatchSchedulerOptions opts_;
+    BatchFn fn_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<InferJob>> queue_;
+    bool stopping_ = false;
+    int window_us_;
+    float exec_us_ = 0.f;  // moving average of the batch function duration
+    BatchSchedulerStats stats_;
+    std::thread thread_;
+};
@@ -3,15 +3,16 @@
 #include <string>
 #include <vector>
 #include "NvInfer.h"
+#include "config.h"
 
 std::map<std::string, nvinfer1::Weights> loadWeights(const std::string file);
 
 nvinfer1::IElementWiseLayer* convBnSiLU(nvinfer1::INetworkDefinition* network,
-                                        std::map<std::string, nvinfer1::Weights> weightMap, nvinfer1::ITensor& input,
+                                        std::map<std::string, nvinfer1::Weights>& weightMap, nvinfer1::ITensor& input,
                                         int ch, int k, int s, int p, std::string lname);
 
 nvinfer1::IElementWiseLayer* C2F(nvinfer1::INetworkDefinition* network,
-                                 std::map<std::string, nvinfer1::Weights> weightMap, nvinfer1::ITensor& input, int c1,
+                                 std::map<std::string, nvinfer1::Weights>& weightMap, nvinfer1::ITensor& input, int c1,
                                  int c2, int n, bool shortcut, float e, std::string lname);
 
 nvinfer1::IElementWiseLayer* C2(nvinfer1::INetworkDefinition* network,
@@ -19,12 +20,29 @@ nvinfer1::IElementWiseLayer* C2(nvinfer1::INetworkDefinition* network,
                                 int c2, int n, bool shortcut, float e, std::string lname);
 
 nvinfer1::IElementWiseLayer* SPPF(nvinfer1::INetworkDefinition* network,
-                                  std::map<std::string, nvinfer1::Weights> weightMap, nvinfer1::ITensor& input, int c1,
+                                  std::map<std::string, nvinfer1::Weights>& weightMap, nvinfer1::ITensor& input, int c1,
                                   int c2, int k, std::string lname);
 
-nvinfer1::IShuffleLayer* DFL(nvinfer1::INetworkDefinition* network, std::map<std::string, nvinfer1::Weights> weightMap,
+nvinfer1::IShuffleLayer* DFL(nvinfer1::INetworkDefinition* network, std::map<std::string, nvinfer1::Weights>& weightMap,
                              nvinfer1::ITensor& input, int ch, int grid, int k, int s, int p, std::string lname);
 
 nvinfer1::IPluginV2Layer* addYoLoLayer(nvinfer1::INetworkDefinition* network,
                                        std::vector<nvinfer1::IConcatenationLayer*> dets, const int* px_arry,
-                                       int px_arry_num, bool is_segmentation, bool is_pose);
+                                       int px_arry_num, bool is_segmentation, bool is_pose, int num_class = kNumClass,
+                                       int input_w = kInputW, int input_h = kInputH,
+                                       int max_num_output_bbox = kMaxNumOutputBbox);
+
+// Explicit-batch variant of DFL: takes the [N, 64, H, W] box branch and returns [N, 4, H, W].
+nvinfer1::IShuffleLayer* DFLDynamic(nvinfer1::INetworkDefinition* network,
+                                    std::map<std::string, nvinfer1::Weights>& weightMap, nvinfer1::ITensor& input,
+                                    std::string lname);
+
+// Decode plugin for explicit-batch engines, inputs are [N, 4 + num_class, H_i, W_i] per stride.
+nvinfer1::IPluginV2Layer* addYoLoLayerDynamic(nvinfer1::INetworkDefinition* network,
+                                              std::vector<nvinfer1::IConcatenationLayer*> dets, const int* strides,
+                                              int strides_num, int num_class, int max_num_output_bbox);
+
+// Network input of an engine built with uint8_input (see uint8_input.h): a {input_h, input_w, 3} binding that the
+// Uint8Input_TRT plugin reads as uint8 BGR. Returns the plugin's float RGB CHW / 255 output, used in place of the
+// input.
+nvinfer1::ITensor* addUint8Input(nvinfer1::INetworkDefinition* network, const char* name, int input_h, int input_w);
@@ -0,0 +1,8 @@
+#pragma once
+
+// Folds an inference-mode BatchNorm2d into the bias-free convolution in front of it:
+//   gamma * (conv(x, w) - mean) / sqrt(var + eps) + beta == conv(x, w * scale) + (beta - mean * scale)
+// with scale = gamma / sqrt(var + eps) per output channel. weight holds channels rows of weight_count / channels
+// values (out x in x kh x kw) and is scaled in place, bias gets channels values.
+void fold_batchnorm(float* weight, int weight_count, const float* gamma, const float* beta, const float* mean,
+                    const float* var, int channels, float eps, float* bias);
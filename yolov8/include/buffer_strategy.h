@@ -0,0 +1,83 @@
+#pragma once
+#include <cuda_runtime_api.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "NvInfer.h"
+
+// Where the engine's input and output tensors live and how they move between host and GPU.
+//   device:  cudaMalloc on the GPU plus pinned (cudaMallocHost) staging on the host, explicit async copies
+//   mapped:  cudaHostAllocMapped, one host allocation the GPU reads and writes over the bus, no copies; the best
+//            choice on integrated GPUs (Jetson) where host and device memory are the same DRAM
+//   managed: cudaMallocManaged, migrated on demand, with cudaMemPrefetchAsync hints where the device supports them
+//   host:    aligned host memory for both views and no CUDA calls, so the buffer handling runs on machines without a
+//            GPU (yolov8_buffer_bench)
+enum class BufferStrategy { kDevice, kMapped, kManaged, kHost };
+
+bool parse_buffer_strategy(const std::string& name, BufferStrategy& strategy);
+const char* buffer_strategy_name(BufferStrategy strategy);
+
+// Consumes "--buffers=device|mapped|managed|host" and compacts argv.
+bool parse_buffer_args(int& argc, char** argv, BufferStrategy& strategy);
+
+// Every allocation is aligned to and padded to a multiple of this.
+constexpr static size_t kBufferAlignment = 256;
+
+static inline size_t align_buffer_size(size_t bytes) {
+    return (bytes + kBufferAlignment - 1) / kBufferAlignment * kBufferAlignment;
+}
+
+// Host and device view of one buffer. They are the same address for every strategy but device; host is nullptr
+// for a device buffer allocated without staging.
+struct BufferPair {
+    void* host = nullptr;
+    void* device = nullptr;
+    size_t bytes = 0;
+};
+
+// Owns the buffers of one engine and frees each one with the API that allocated it.
+class BufferSet {
+   public:
+    explicit BufferSet(BufferStrategy strategy = BufferStrategy::kDevice);
+    ~BufferSet();
+    BufferSet(const BufferSet&) = delete;
+    BufferSet& operator=(const BufferSet&) = delete;
+
+    // with_host: the CPU reads or writes the buffer. Only device allocates anything extra for it, the pinned staging.
+    BufferPair allocate(size_t bytes, bool with_host);
+
+    // Frees all buffers.
+    void release();
+
+    BufferStrategy strategy() const { return strategy_; }
+
+    // Bytes allocated on the device and on the host, each buffer counted once per allocation.
+    size_t device_bytes() const;
+    size_t host_bytes() const;
+
+   private:
+    enum class Kind { kDeviceMemory, kPinned, kMapped, kManaged, kHost };
+    struct Allocation {
+        void* ptr;
+        size_t bytes;
+        Kind kind;
+    };
+
+    BufferStrategy strategy_;
+    std::vector<Allocation> allocations_;
+};
+
+// Makes bytes written at host visible at device to the work enqueued next on stream: a copy for device, a prefetch
+// to the GPU for managed, nothing for mapped and host.
+void buffer_to_device(BufferStrategy strategy, void* device, const void* host, size_t bytes, cudaStream_t stream);
+
+// Makes bytes written by the GPU at device readable at host once stream is synchronized: a copy for device, a
+// prefetch to the CPU for managed, nothing for mapped and host.
+void buffer_to_host(BufferStrategy strategy, void* host, const void* device, size_t bytes, cudaStream_t stream);
+
+size_t dims_volume(const nvinfer1::Dims& dims);
+size_t data_type_size(nvinfer1::DataType type);
+
+// Bytes of a binding at the largest batch the engine accepts: maxBatchSize times the binding dims for implicit
+// batch engines, the kMAX shape of optimization profile 0 for explicit batch engines.
+size_t binding_bytes(const nvinfer1::ICudaEngine& engine, int index);
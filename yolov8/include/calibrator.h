@@ -2,6 +2,7 @@
 #define ENTROPY_CALIBRATOR_H
 
 #include <NvInfer.h>
+#include <map>
 #include <string>
 #include <vector>
 #include "macros.h"
@@ -36,4 +37,9 @@ private:
     std::vector<char> calib_cache_;
 };
 
+//! Applies the scales in file as dynamic ranges (+-127 * scale) on the network tensors, so an int8 engine
+//! can be built without running the calibrator, see int8_scales.h for the file. Returns false if the file is missing,
+//! empty or malformed, after reporting the malformed line.
+bool setInt8DynamicRanges(nvinfer1::INetworkDefinition* network, const std::string& file);
+
 #endif // ENTROPY_CALIBRATOR_H
@@ -0,0 +1,101 @@
+#pragma once
+#include <deque>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include "types.h"
+
+// Cascade from detection to classification: the boxes found by the detector are cropped from their frame straight
+// into the input of a classifier engine, crops of many frames are packed into full classifier batches, and the top-k
+// classes are scattered back onto the detections they came from. A partial batch runs once its oldest crop has waited
+// max_wait_ms, so a slow stream of frames is not held back waiting for a full batch. The classifier is behind
+// CropClassifier so it can be replaced by a mock.
+
+struct CascadeOptions {
+    bool enabled = false;
+    std::string cls_engine;    // yolov8_cls engine of the second stage
+    std::vector<int> classes;  // detector classes that are classified, all when empty
+    int topk = 3;
+    float max_wait_ms = 20.f;  // longest a crop waits for its batch to fill
+    float context = 0.1f;      // the square crop is the longer box side grown by this fraction
+};
+
+// Consumes "--cls_engine=", "--cascade_classes=2,5,7", "--cascade_topk=", "--cascade_wait_ms=" and
+// "--cascade_context=" and compacts argv like parse_runtime_config_args. A classifier engine enables the cascade.
+// Returns false on an invalid value.
+bool parse_cascade_args(int& argc, char** argv, CascadeOptions& opts);
+
+// Crops the square of side max(w, h) * (1 + context) centered on bbox ([x, y, w, h] in pixels of the BGR image img),
+// resizes it bilinearly to dst_w x dst_h and writes it to dst as planar RGB in [0, 1], the input of yolov8_cls, in one
+// pass. Pixels outside the image repeat its border.
+void crop_to_planar(const cv::Mat& img, const float* bbox, float context, float* dst, int dst_w, int dst_h);
+
+// A classifier engine with a host input buffer of max_batch() crops.
+class CropClassifier {
+   public:
+    virtual ~CropClassifier() {}
+    virtual int max_batch() const = 0;
+    virtual cv::Size input_size() const = 0;
+    virtual int num_classes() const = 0;
+    // Planar RGB input of max_batch() crops, written by the batcher.
+    virtual float* input() = 0;
+    // Runs the first n crops of input() and returns their logits, n x num_classes().
+    virtual const float* classify(int n) = 0;
+};
+
+struct ClsLabel {
+    int class_id;
+    float prob;
+};
+
+// A frame handed to the batcher with its boxes, [x, y, w, h] in pixels of img. labels[i] holds the top-k classes of
+// dets[i], most probable first, and is empty for boxes of classes that are not classified.
+struct CascadeFrame {
+    long id = 0;
+    cv::Mat img;
+    std::vector<Detection> dets;
+    std::vector<std::vector<ClsLabel>> labels;
+    int pending = 0;  // crops not yet classified
+};
+
+struct CascadeStats {
+    long frames = 0;
+    long crops = 0;
+    long batches = 0;
+    long deadline_batches = 0;  // partial batches run because a crop waited max_wait_ms
+};
+
+// Single-threaded: crops are written into the classifier input as frames are added, and the classifier runs inside
+// add, poll and flush.
+class CropBatcher {
+   public:
+    CropBatcher(CropClassifier& classifier, const CascadeOptions& opts);
+
+    // Crops the boxes of img to classify into the batch, running the classifier each time the batch fills, then
+    // checks the deadline. now_ms is any monotonic clock in milliseconds.
+    void add(long id, const cv::Mat& img, const std::vector<Detection>& dets, double now_ms);
+
+    // Runs the partial batch if its oldest crop has waited max_wait_ms.
+    void poll(double now_ms);
+
+    // Runs the partial batch now.
+    void flush();
+
+    // Takes the oldest frame if all of its crops are classified; frames come out in the order they were added.
+    bool pop(CascadeFrame& frame);
+
+    const CascadeStats& stats() const { return stats_; }
+
+   private:
+    void run_batch();
+
+    CropClassifier& classifier_;
+    CascadeOptions opts_;
+    std::deque<CascadeFrame> frames_;
+    long first_seq_ = 0;  // sequence number of frames_.front()
+    // batch slot i holds the crop of detection slot_det_[i] of frame slot_seq_[i]
+    std::vector<long> slot_seq_;
+    std::vector<int> slot_det_;
+    double batch_start_ms_ = 0.0;  // when the first crop of the partial batch was added
+    CascadeStats stats_;
+};
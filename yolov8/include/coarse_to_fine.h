@@ -0,0 +1,73 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include "tiling.h"
+#include "types.h"
+
+// Coarse-to-fine detection: a low-resolution engine runs on the whole frame, and only where it reports small or
+// uncertain objects are a few regions re-run through a high-resolution engine. The regions are chosen to cover as many
+// of those candidates as a per-frame budget allows, and the two passes are fused into one set of boxes. Planning and
+// fusion run on the CPU; the engines are behind RoiDetector so they can be replaced by mocks.
+
+struct CoarseToFineOptions {
+    bool enabled = false;
+    std::string fine_engine;   // engine of the second pass, usually built with a larger input
+    float low_conf = 0.1f;     // the coarse pass keeps candidates down to this confidence
+    float conf_thresh = 0.5f;  // confidence of a final box, set from the runtime config
+    float small_side = 32.f;   // confident candidates whose longer side in frame pixels is below this are refined too
+    int max_rois = 4;          // fine-pass regions per frame
+    float roi_zoom = 1.f;      // frame pixels per fine input pixel, the region size is zoom * fine input size
+    TileMerge merge = TileMerge::kFusion;
+    float merge_thresh = 0.5f;
+};
+
+// Consumes "--fine_engine=", "--c2f_low_conf=", "--c2f_small=", "--c2f_max_rois=", "--c2f_zoom=" and
+// "--c2f_merge=nms|fusion" and compacts argv like parse_runtime_config_args. A fine engine enables the mode. Returns
+// false on an invalid value.
+bool parse_coarse_to_fine_args(int& argc, char** argv, CoarseToFineOptions& opts);
+
+// An engine that detects in regions of a frame, each letterboxed to its input.
+class RoiDetector {
+   public:
+    virtual ~RoiDetector() {}
+    virtual cv::Size input_size() const = 0;
+    // res[i] holds the boxes found in rois[i] as [x1, y1, x2, y2] in frame pixels, down to the detector's confidence
+    // threshold.
+    virtual void detect(const cv::Mat& frame, const std::vector<cv::Rect>& rois,
+                        std::vector<std::vector<Detection>>& res) = 0;
+};
+
+// Up to max_rois regions of roi_size (clamped to the frame) that together contain as many candidates, [x1, y1, x2, y2]
+// in frame pixels, as a greedy cover finds. Each region starts centered on the most confident candidate not yet
+// contained and is moved to the mean center of the candidates it contains. covered[i] tells whether candidate i is
+// contained by a region.
+std::vector<cv::Rect> plan_rois(const std::vector<Detection>& candidates, int frame_w, int frame_h, cv::Size roi_size,
+                                int max_rois, std::vector<char>& covered);
+
+// Final boxes of a frame: the confident coarse boxes not inside a region and the confident fine boxes, merged across
+// region borders. [x1, y1, x2, y2] in frame pixels.
+std::vector<Detection> fuse_coarse_fine(const std::vector<Detection>& coarse, const std::vector<cv::Rect>& rois,
+                                        const std::vector<std::vector<Detection>>& fine,
+                                        const CoarseToFineOptions& opts);
+
+struct CoarseToFineStats {
+    long frames = 0;
+    long rois = 0;
+    long candidates = 0;
+    long uncovered = 0;  // candidates beyond the region budget, which keep their coarse result
+};
+
+class CoarseToFine {
+   public:
+    explicit CoarseToFine(const CoarseToFineOptions& opts) : opts_(opts) {}
+
+    // Runs coarse on the whole frame and fine on the planned regions. coarse must report boxes down to low_conf.
+    void detect(const cv::Mat& frame, RoiDetector& coarse, RoiDetector& fine, std::vector<Detection>& dets);
+
+    const CoarseToFineStats& stats() const { return stats_; }
+
+   private:
+    CoarseToFineOptions opts_;
+    CoarseToFineStats stats_;
+};
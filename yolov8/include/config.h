@@ -1,6 +1,10 @@
+#pragma once
+
 #define USE_FP16
 //#define USE_FP32
 //#define USE_INT8
+// enable 2:4 sparse kernels (Ampere+), use with weights pruned by yolov8_sparsify
+//#define USE_SPARSE_WEIGHTS
 
 const static char* kInputTensorName = "images";
 const static char* kOutputTensorName = "output";
@@ -14,9 +18,12 @@ const static float kNmsThresh = 0.45f;
 const static float kConfThresh = 0.5f;
 const static float kConfThreshKeypoints = 0.5f;  // keypoints confidence
 const static int kMaxInputImageSize = 3000 * 3000;
+const static int kMaxTiledImageSize = 7680 * 4320;  // largest frame for sliced inference (--tile), 8K
 const static int kMaxNumOutputBbox = 1000;
 //Quantization input image folder path
 const static char* kInputQuantizationFolder = "./coco_calib";
+//Per-tensor int8 scales (QAT export or a previous int8calib.table), used instead of calibration when present
+const static char* kInputQuantizationScales = "./int8_scales.txt";
 
 // Classfication model's number of classes
 constexpr static int kClsNumClass = 1000;
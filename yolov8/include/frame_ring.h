@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Shared-memory frame transport between capture processes (producers) and the inference process (consumer).
+// A POSIX shm object holds a header and slot_count fixed-size slots. Producers claim slots lock-free (a bounded
+// MPSC queue with one sequence number per slot), write the frame in place and publish it; the consumer reads the
+// frame in place and releases the slot when it no longer needs the pixels. Waiting uses a futex in the shared header.
+
+enum class FrameFormat : uint32_t { kBGR = 0, kNV12 = 1 };
+
+struct FrameInfo {
+    FrameFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;  // bytes per row (of the Y plane for NV12)
+    uint32_t source_id;
+    uint64_t frame_id;
+    uint64_t timestamp_ns;  // CLOCK_MONOTONIC at capture
+    uint64_t size;          // bytes used in the slot
+};
+
+// Rows of a frame in its slot: height for BGR; for NV12 the height rows of the Y plane and below them the
+// (height + 1) / 2 rows of the interleaved UV plane, whose rows hold (width + 1) / 2 U, V pairs.
+uint32_t frame_rows(const FrameInfo& info);
+
+// Height of an NV12 frame of rows rows, the inverse of frame_rows, also for odd heights.
+uint32_t nv12_height(uint32_t rows);
+
+// Checks the info a producer published before the consumer touches the pixels: a known format, a non-empty frame of
+// at most max_pixels, stride at least a row of pixels (or of UV pairs), and stride * frame_rows and size within
+// slot_bytes. False, with error saying what is wrong, otherwise.
+bool check_frame_info(const FrameInfo& info, size_t slot_bytes, uint64_t max_pixels, std::string& error);
+
+// Frame data starts one page after the slot header, so slots can be used for DMA once the mapping is registered.
+const static size_t kFrameSlotHeaderSize = 4096;
+
+struct FrameSlot {
+    std::atomic<uint64_t> sequence;
+    FrameInfo info;
+
+    uint8_t* data() { return reinterpret_cast<uint8_t*>(this) + kFrameSlotHeaderSize; }
+};
+
+struct FrameRingHeader;
+
+class FrameRing {
+   public:
+    FrameRing() = default;
+    ~FrameRing();
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    // Consumer side, creates (or replaces) the shm object /name. The consumer owns it and unlinks it on destruction.
+    bool create(const std::string& name, int slot_count, size_t slot_bytes);
+
+    // Producer side, maps an existing ring.
+    bool open(const std::string& name);
+
+    // Producer: claims the next free slot, nullptr when the ring is full (the frame should be dropped).
+    FrameSlot* begin_write();
+
+    // Producer: makes a slot filled after begin_write visible to the consumer.
+    void end_write(FrameSlot* slot);
+
+    // Consumer: the next published frame in order, waiting up to timeout_ms, nullptr on timeout. Several slots may be
+    // held at once, e.g. for a batch.
+    FrameSlot* acquire(int timeout_ms);
+
+    // Consumer: returns the oldest held slot to the producers. Slots must be released in acquire order.
+    void release(FrameSlot* slot);
+
+    // Whole mapping, e.g. for cudaHostRegister.
+    void* mapping() const { return base_; }
+    size_t mapping_size() const { return size_; }
+
+    size_t slot_bytes() const;
+    uint64_t dropped() const;
+
+   private:
+    FrameSlot* slot_at(uint64_t pos) const;
+
+    std::string name_;
+    bool owner_ = false;
+    void* base_ = nullptr;
+    size_t size_ = 0;
+    FrameRingHeader* header_ = nullptr;
+    uint64_t read_cursor_ = 0;  // consumer: next position to acquire, read_pos in the header is the next to release
+};
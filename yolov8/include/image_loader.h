@@ -0,0 +1,36 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+// Decode-time downscaling (--decode_reduce=1). libjpeg can decode a JPEG at 1/2, 1/4 or 1/8 of its size by dropping
+// DCT coefficients, which skips most of the IDCT, color conversion and memory traffic of a full decode. A 24 MP photo
+// letterboxed to 640x640 keeps under 2% of its pixels, so it is decoded at the smallest of these sizes that is still
+// at least as large as the letterbox, through OpenCV's IMREAD_REDUCED_COLOR_*. That also keeps such photos under
+// kMaxInputImageSize. Other formats are decoded at full size.
+
+// An image as decoded, and where its pixels are in the file's image: pixel (x, y) covers
+// [x * scale, (x + 1) * scale) x [y * scale, (y + 1) * scale) of the original_size image.
+struct DecodedImage {
+    cv::Mat img;
+    cv::Size original_size;
+    int scale = 1;  // 1, 2, 4 or 8
+};
+
+// Width and height from the frame header of a JPEG, without decoding it. False if data is not a JPEG or ends before
+// its frame header.
+bool jpeg_size(const uint8_t* data, size_t size, int& width, int& height);
+
+// Largest of 1, 2, 4 and 8 at which a width x height image, in either orientation (EXIF may rotate it), is still
+// letterboxed down, not up, into input_w x input_h.
+int pick_reduce_factor(int width, int height, int input_w, int input_h);
+
+// Decodes encoded as BGR. JPEGs are reduced by pick_reduce_factor for input_w x input_h; input_w = 0 decodes at full
+// size. False if the image can not be decoded.
+bool decode_image(const std::vector<uint8_t>& encoded, int input_w, int input_h, DecodedImage& out);
+
+// Reads and decodes a file with decode_image.
+bool load_image(const std::string& path, int input_w, int input_h, DecodedImage& out);
+
+// Maps a box in pixels of image.img to pixels of the original image, clipped to it.
+cv::Rect to_original_rect(const cv::Rect& r, const DecodedImage& image);
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "batch_scheduler.h"
+#include "result_cache.h"
+
+// Unix domain socket protocol, native byte order, any number of requests per connection:
+//   request:  uint32 deadline_ms (0 for the server default, at most kMaxDeadlineMs), uint32 size, size bytes of an
+//             encoded image
+//   response: uint32 count, then count x ServerDetection (a count of 0xffffffff means the image could not be decoded
+//             or has more than kMaxInputImageSize pixels)
+// A request over kMaxRequestBytes is answered with 0xffffffff and the connection is closed without reading it.
+const static uint32_t kMaxRequestBytes = 64 << 20;
+const static int kMaxServerConnections = 64;
+const static uint32_t kMaxDeadlineMs = 60000;
+
+struct ServerDetection {
+    float bbox[4];  // x, y, w, h in pixels of the request image
+    float conf;
+    float class_id;
+};
+
+// Accepts clients on socket_path until the process exits, one thread per connection and at most max_connections at
+// a time, further clients wait in the listen backlog until one disconnects. Every request becomes an
+// InferJob submitted to scheduler, unless cache (optional) already holds the result for the image: with
+// CacheKeyMode::kEncoded such requests are answered without even decoding the image. Returns -1 if the socket can
+// not be created. A non-empty decode_size decodes JPEG requests reduced for a network input of that size (see
+// image_loader.h); their boxes are still returned in pixels of the request image.
+int run_inference_server(const std::string& socket_path, BatchScheduler& scheduler, int default_deadline_ms,
+                         ResultCache* cache = nullptr, cv::Size decode_size = cv::Size(),
+                         int max_connections = kMaxServerConnections);
+
+// Client side helpers, used by yolov8_server_bench.
+int connect_inference_server(const std::string& socket_path);
+
+bool send_inference_request(int fd, const std::vector<uint8_t>& image, uint32_t deadline_ms);
+
+bool read_inference_response(int fd, std::vector<ServerDetection>& dets);
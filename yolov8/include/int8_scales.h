@@ -0,0 +1,26 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+
+// Per-tensor int8 scales for building without calibration (kInputQuantizationScales). The file is either a TensorRT
+// calibration table, a "TRT-..." header followed by "name: hex-encoded-scale" lines, or plain "name scale" lines
+// exported from QAT. Names may contain spaces, as TensorRT's "(Unnamed Layer* 3) [Convolution]_output" do; the value
+// is the last field of the line.
+
+// Reads the scales of file. A missing file gives no scales, zero scales are left out. False, with error naming the
+// file and line, if a line is malformed: no value, a value that is not a number, or a negative or infinite scale.
+bool readInt8Scales(const std::string& file, std::map<std::string, float>& scales, std::string& error);
+
+// A tensor of the network as setInt8DynamicRanges walks it: the network inputs, then the outputs of every layer.
+// layer_name is the name of the layer for its first output, empty otherwise.
+struct Int8Target {
+    std::string tensor_name;
+    std::string layer_name;
+};
+
+// Dynamic range, +-range, for each target: 127 * the scale of its tensor name, else of its layer name, so a QAT
+// export can use the layer names of block.cpp (e.g. model.2.cv1.act). 0 for targets without a scale, which stay in
+// higher precision.
+std::vector<float> int8DynamicRanges(const std::map<std::string, float>& scales,
+                                     const std::vector<Int8Target>& targets);
@@ -0,0 +1,19 @@
+#pragma once
+#include <vector>
+
+// Input shape picked for a dynamic-shape engine. A square letterbox of a 16:9 frame is mostly padding, so instead
+// each image is scaled to fit max_w x max_h and only padded up to the next multiple of the stride.
+struct LetterboxShape {
+    int w;
+    int h;
+};
+
+// Smallest stride-aligned shape holding img_w x img_h scaled to fit max_w x max_h.
+LetterboxShape rect_letterbox_shape(int img_w, int img_h, int max_w, int max_h, int stride = 32);
+
+// Shape shared by a batch: the elementwise maximum of the per-image shapes.
+LetterboxShape rect_letterbox_batch_shape(const std::vector<LetterboxShape>& img_sizes, int max_w, int max_h,
+                                          int stride = 32);
+
+// Fraction of shape_w x shape_h that is padding after letterboxing img_w x img_h into it.
+float letterbox_padding_ratio(int img_w, int img_h, int shape_w, int shape_h);
@@ -2,10 +2,16 @@
 #include <assert.h>
 #include <string>
 #include "NvInfer.h"
+#include "runtime_config.h"
 
 nvinfer1::IHostMemory* buildEngineYolov8Det(nvinfer1::IBuilder* builder, nvinfer1::IBuilderConfig* config,
                                             nvinfer1::DataType dt, const std::string& wts_path, float& gd, float& gw,
-                                            int& max_channels);
+                                            int& max_channels, const RuntimeConfig& cfg = RuntimeConfig());
+
+// Explicit-batch detection engine, batch size and input resolution are set per inference up to the values in cfg.
+nvinfer1::IHostMemory* buildEngineYolov8DetDynamic(nvinfer1::IBuilder* builder, nvinfer1::IBuilderConfig* config,
+                                                   nvinfer1::DataType dt, const std::string& wts_path, float& gd,
+                                                   float& gw, int& max_channels, const RuntimeConfig& cfg);
 
 nvinfer1::IHostMemory* buildEngineYolov8DetP6(nvinfer1::IBuilder* builder, nvinfer1::IBuilderConfig* config,
                                               nvinfer1::DataType dt, const std::string& wts_path, float& gd, float& gw,
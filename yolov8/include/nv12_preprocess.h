@@ -0,0 +1,127 @@
+#pragma once
+#include <math.h>
+#include <stdint.h>
+
+// NV12 letterbox, for the FrameFormat::kNV12 frames of -shm. The float path converts a whole NV12 frame to BGR with
+// cvtColor and then letterboxes it. This one samples the Y plane and the interleaved half-resolution UV plane
+// directly at the taps warpaffine_kernel would use, and converts only the output pixels. It uses BT.601 video range
+// with the coefficients of cvtColor's COLOR_YUV2BGR_NV12. Each tap takes the chroma of its 2x2 block, as cvtColor
+// does. Taps are blended as Y, U and V before the conversion, which is affine, so the result only differs from
+// cvtColor + warpaffine_kernel by cvtColor's rounding to bytes.
+//
+// nv12_letterbox_pixel defines a pixel once. The CUDA kernel and the scalar CPU reference call it, and the SSE2 CPU
+// version repeats its float operations in the same order, so all three give the same bits. No multiply and add may
+// be fused: __fmul_rn and __fadd_rn on the GPU, -ffp-contract=off for the host code.
+
+#if defined(__CUDACC__)
+#define NV12_HOST_DEVICE __host__ __device__
+#else
+#define NV12_HOST_DEVICE
+#endif
+
+// cvtColor's fixed-point ITUR_BT_601_* coefficients / 2^20
+constexpr float kNv12Cy = 1.164f;
+constexpr float kNv12Cvr = 1.596f;
+constexpr float kNv12Cvg = -0.813f;
+constexpr float kNv12Cug = -0.391f;
+constexpr float kNv12Cub = 2.018f;
+// Y of the gray 128 border that warpaffine_kernel pads with, U and V are 128
+constexpr float kNv12BorderY = 16.f + 128.f / kNv12Cy;
+
+NV12_HOST_DEVICE inline float nv12_mul(float a, float b) {
+#if defined(__CUDA_ARCH__)
+    return __fmul_rn(a, b);
+#else
+    return a * b;
+#endif
+}
+
+NV12_HOST_DEVICE inline float nv12_add(float a, float b) {
+#if defined(__CUDA_ARCH__)
+    return __fadd_rn(a, b);
+#else
+    return a + b;
+#endif
+}
+
+NV12_HOST_DEVICE inline float nv12_sub(float a, float b) {
+#if defined(__CUDA_ARCH__)
+    return __fsub_rn(a, b);
+#else
+    return a - b;
+#endif
+}
+
+NV12_HOST_DEVICE inline float nv12_div(float a, float b) {
+#if defined(__CUDA_ARCH__)
+    return __fdiv_rn(a, b);
+#else
+    return a / b;
+#endif
+}
+
+// Y, U and V of pixel (x, y), those of the border outside the image. Both planes have rows of stride bytes.
+NV12_HOST_DEVICE inline void nv12_tap(const uint8_t* y_plane, const uint8_t* uv_plane, int width, int height,
+                                      int stride, int x, int y, float yuv[3]) {
+    if (x < 0 || x >= width || y < 0 || y >= height) {
+        yuv[0] = kNv12BorderY;
+        yuv[1] = 128.f;
+        yuv[2] = 128.f;
+        return;
+    }
+    const uint8_t* uv = uv_plane + (y >> 1) * stride + (x & ~1);
+    yuv[0] = y_plane[y * stride + x];
+    yuv[1] = uv[0];
+    yuv[2] = uv[1];
+}
+
+// RGB / 255 of a blended Y, U and V
+NV12_HOST_DEVICE inline void nv12_to_rgb(float y, float u, float v, float rgb[3]) {
+    float c = nv12_mul(fmaxf(nv12_sub(y, 16.f), 0.f), kNv12Cy);
+    u = nv12_sub(u, 128.f);
+    v = nv12_sub(v, 128.f);
+    float r = nv12_add(c, nv12_mul(kNv12Cvr, v));
+    float g = nv12_add(nv12_add(c, nv12_mul(kNv12Cvg, v)), nv12_mul(kNv12Cug, u));
+    float b = nv12_add(c, nv12_mul(kNv12Cub, u));
+    rgb[0] = nv12_div(fminf(fmaxf(r, 0.f), 255.f), 255.f);
+    rgb[1] = nv12_div(fminf(fmaxf(g, 0.f), 255.f), 255.f);
+    rgb[2] = nv12_div(fminf(fmaxf(b, 0.f), 255.f), 255.f);
+}
+
+// Output pixel (dx, dy) of the letterbox with the d2s of letterbox_d2s, which only scales and shifts, as RGB / 255.
+// Samples where warpaffine_kernel does, pixels that map outside the image are the border.
+NV12_HOST_DEVICE inline void nv12_letterbox_pixel(const uint8_t* y_plane, const uint8_t* uv_plane, int width,
+                                                  int height, int stride, const float d2s[6], int dx, int dy,
+                                                  float rgb[3]) {
+    float src_x = nv12_add(nv12_add(nv12_mul(d2s[0], (float)dx), d2s[2]), 0.5f);
+    float src_y = nv12_add(nv12_add(nv12_mul(d2s[4], (float)dy), d2s[5]), 0.5f);
+    if (src_x <= -1 || src_x >= width || src_y <= -1 || src_y >= height) {
+        rgb[0] = rgb[1] = rgb[2] = nv12_div(128.f, 255.f);
+        return;
+    }
+    int x_low = floorf(src_x);
+    int y_low = floorf(src_y);
+    float lx = nv12_sub(src_x, (float)x_low);
+    float ly = nv12_sub(src_y, (float)y_low);
+    float hx = nv12_sub(1.f, lx);
+    float hy = nv12_sub(1.f, ly);
+    float w[4] = {nv12_mul(hy, hx), nv12_mul(hy, lx), nv12_mul(ly, hx), nv12_mul(ly, lx)};
+    float yuv[3] = {0.f, 0.f, 0.f};
+    for (int i = 0; i < 4; i++) {
+        float tap[3];
+        nv12_tap(y_plane, uv_plane, width, height, stride, x_low + (i & 1), y_low + (i >> 1), tap);
+        for (int c = 0; c < 3; c++) {
+            yuv[c] = nv12_add(yuv[c], nv12_mul(w[i], tap[c]));
+        }
+    }
+    nv12_to_rgb(yuv[0], yuv[1], yuv[2], rgb);
+}
+
+// Letterboxes a width x height NV12 image into dst_width x dst_height float RGB CHW / 255, the engine input, on the
+// CPU with SSE2 where available. For hosts without the GPU path, and as its check.
+void nv12_letterbox(const uint8_t* y_plane, const uint8_t* uv_plane, int width, int height, int stride, float* dst,
+                    int dst_width, int dst_height);
+
+// nv12_letterbox_pixel for every output pixel, pixel for pixel what the CUDA kernel computes.
+void nv12_letterbox_reference(const uint8_t* y_plane, const uint8_t* uv_plane, int width, int height, int stride,
+                              float* dst, int dst_width, int dst_height);
@@ -4,14 +4,15 @@
 #include "NvInfer.h"
 #include "types.h"
 
-cv::Rect get_rect(cv::Mat& img, float bbox[4]);
+cv::Rect get_rect(cv::Mat& img, float bbox[4], int input_w = kInputW, int input_h = kInputH);
 
 void nms(std::vector<Detection>& res, float* output, float conf_thresh, float nms_thresh = 0.5);
 
 void batch_nms(std::vector<std::vector<Detection>>& batch_res, float* output, int batch_size, int output_size,
                float conf_thresh, float nms_thresh = 0.5);
 
-void draw_bbox(std::vector<cv::Mat>& img_batch, std::vector<std::vector<Detection>>& res_batch);
+void draw_bbox(std::vector<cv::Mat>& img_batch, std::vector<std::vector<Detection>>& res_batch, int input_w = kInputW,
+               int input_h = kInputH);
 
 void draw_bbox_keypoints_line(std::vector<cv::Mat>& img_batch, std::vector<std::vector<Detection>>& res_batch);
 
@@ -6,11 +6,40 @@
 #include <map>
 
 
+// Allocates the staging buffers for images of up to max_image_size pixels. Larger BGR images are downscaled on the CPU
+// to fit before they are letterboxed, larger NV12 frames are letterboxed on the CPU (nv12_letterbox) and only the
+// input tensor is uploaded.
 void cuda_preprocess_init(int max_image_size);
 
 void cuda_preprocess_destroy();
 
 void cuda_preprocess(uint8_t *src, int src_width, int src_height, float *dst, int dst_width, int dst_height, cudaStream_t stream);
 
+// Same as cuda_preprocess for a BGR image in memory registered with cudaHostRegister (e.g. a shared-memory frame
+// slot), src_line_size is the row stride in bytes. Skips the copy into the internal pinned buffer; the caller must
+// not reuse src until the stream has synchronized.
+void cuda_preprocess_registered(uint8_t *src, int src_width, int src_height, int src_line_size, float *dst,
+                                int dst_width, int dst_height, cudaStream_t stream);
+
+// Same as cuda_preprocess_registered for an NV12 frame: the Y plane followed by the interleaved UV plane, both with
+// rows of src_line_size bytes. The kernel samples the planes and converts only the letterboxed pixels to RGB (see
+// nv12_preprocess.h), so the frame is never converted to BGR.
+void cuda_preprocess_nv12_registered(uint8_t *src, int src_width, int src_height, int src_line_size, float *dst,
+                                     int dst_width, int dst_height, cudaStream_t stream);
+
+// Copies a whole BGR frame into the device image buffer once, so that several regions of it can be letterboxed with
+// cuda_roi_preprocess without uploading it again. False if the frame is larger than max_image_size.
+bool cuda_frame_upload(const cv::Mat &img, cudaStream_t stream);
+
+// Letterboxes the region roi of the frame last passed to cuda_frame_upload into dst, like cuda_preprocess does for a
+// whole image.
+void cuda_roi_preprocess(const cv::Mat &img, const cv::Rect &roi, float *dst, int dst_width, int dst_height,
+                         cudaStream_t stream);
+
 void cuda_batch_preprocess(std::vector<cv::Mat> &img_batch, float *dst, int dst_width, int dst_height, cudaStream_t stream);
 
+// For engines built with uint8_input: letterboxes each image on the CPU into the pinned buffer as uint8 HWC BGR (see
+// letterbox_uint8) and uploads the batch in one copy, 3 bytes per input pixel whatever the frame size.
+void cuda_batch_preprocess_uint8(std::vector<cv::Mat> &img_batch, uint8_t *dst, int dst_width, int dst_height,
+                                 cudaStream_t stream);
+
@@ -0,0 +1,99 @@
+#pragma once
+#include <stdint.h>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Preprocessing shared by several models that run on the same frame, e.g. yolop, a yolov8 detector and a classifier.
+// Each model declares the input it expects as an InputSpec; models with equal specs get the same tensor, computed once
+// per frame and shared read-only. Making a tensor has two stages, resizing a part of the frame and then padding,
+// reordering and normalizing it, and specs that resize the same part of the frame to the same size also share the
+// first stage: a 640x640 and a 640x384 letterbox of a 16:9 frame both scale it to 640x360 and only pad it differently.
+// Everything runs on the CPU, lazily when a model asks for its input.
+
+enum class ResizeMode {
+    kLetterbox,   // scaled to fit and centered on a pad border, as preprocess_img of yolop
+    kStretch,     // scaled to the input size, aspect ratio not kept
+    kCenterCrop,  // the centered square of the frame scaled to the input size, as batch_preprocess of yolov8_cls
+};
+
+enum class ChannelOrder { kBGR, kRGB };
+
+enum class InputDType {
+    kFloat32,  // planar CHW, (x / 255 - mean) / std
+    kUint8,    // interleaved HWC, for engines that normalize on the GPU; mean and std are unused
+};
+
+struct InputSpec {
+    int width = 640;
+    int height = 640;
+    ResizeMode resize = ResizeMode::kLetterbox;
+    ChannelOrder order = ChannelOrder::kRGB;
+    float mean[3] = {0.f, 0.f, 0.f};  // per tensor channel, in units of x / 255
+    float std[3] = {1.f, 1.f, 1.f};
+    InputDType dtype = InputDType::kFloat32;
+    uint8_t pad = 114;  // letterbox border, before normalization
+};
+
+bool operator==(const InputSpec& a, const InputSpec& b);
+
+// A tensor made for one or more models. data is valid and unchanged until the next set_frame.
+struct PreprocessedInput {
+    const void* data = nullptr;
+    size_t bytes = 0;
+    cv::Rect src;      // the part of the frame that was resized
+    cv::Rect content;  // where it lies in the tensor, the rest is pad
+};
+
+struct PreprocessCacheStats {
+    long frames = 0;
+    long requests = 0;  // input() calls
+    long tensors = 0;   // tensors computed
+    long resizes = 0;   // resizes computed
+};
+
+class PreprocessCache {
+   public:
+    // Registers the input of a model and returns its id for input(). Models with equal specs share one tensor.
+    int add_model(const InputSpec& spec);
+
+    // Distinct tensors, and distinct resizes for the frame size of the last set_frame.
+    int tensor_count() const { return tensors_.size(); }
+    int resize_count() const { return resizes_.size(); }
+
+    // Starts a frame, a BGR image that must stay valid while inputs are taken. Tensors of the previous frame are
+    // invalidated; a new frame size replans which tensors share a resize.
+    void set_frame(const cv::Mat& frame);
+
+    // The input of model for the current frame, computed on the first request.
+    const PreprocessedInput& input(int model);
+
+    const PreprocessCacheStats& stats() const { return stats_; }
+
+   private:
+    struct ResizeStage {
+        cv::Rect src;
+        cv::Size size;
+        cv::Mat image;  // BGR, size
+        long frame = -1;
+    };
+    struct TensorStage {
+        InputSpec spec;
+        int resize = -1;
+        std::vector<float> lut;  // 3 x 256, value of each byte per tensor channel
+        std::vector<float> storage;
+        PreprocessedInput out;
+        long frame = -1;
+    };
+
+    void plan(cv::Size frame_size);
+    const cv::Mat& resized(int index);
+    void fill(TensorStage& tensor, const cv::Mat& image);
+
+    std::vector<TensorStage> tensors_;
+    std::vector<int> model_tensor_;
+    std::vector<ResizeStage> resizes_;
+    cv::Mat frame_;
+    cv::Size planned_;
+    long frame_id_ = -1;
+    PreprocessCacheStats stats_;
+};
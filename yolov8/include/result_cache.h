@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "types.h"
+
+// Detection results keyed by image content, so duplicate images (re-uploads, static cameras) skip decode,
+// preprocessing, inference and NMS. Keys are a 64-bit hash of the image seeded with the identity of the engine and
+// the settings that change the result, so a cache never answers for another model or threshold. Stored boxes are
+// [x, y, w, h] in pixels of the image, as returned by the server.
+
+// XXH64 of data, seed selects an independent hash function.
+uint64_t xxh64(const void* data, size_t size, uint64_t seed = 0);
+
+enum class CacheKeyMode {
+    kEncoded,  // hash of the encoded file bytes, exact duplicates only, no decode needed
+    kPixels,   // difference hash of the downsampled decoded image, also matches re-encoded copies of the same size
+};
+
+bool parse_cache_key_mode(const std::string& name, CacheKeyMode& mode);
+
+struct ResultCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+// Thread-safe LRU of detection vectors bounded by budget_bytes, counting the boxes and the bookkeeping of each
+// entry. Optionally persisted to a file that is mapped on load.
+class ResultCache {
+   public:
+    ResultCache(size_t budget_bytes, uint64_t config_id, CacheKeyMode mode = CacheKeyMode::kEncoded);
+
+    // Keys of an image for this cache. pixel_key hashes the signs of the horizontal gradients of a 17x16 grayscale
+    // downsample (256 bits) and the image size, images must be 8-bit BGR.
+    uint64_t encoded_key(const void* data, size_t size) const;
+    uint64_t pixel_key(const cv::Mat& img) const;
+
+    // On a hit copies the stored result to dets and makes the entry the most recently used one.
+    bool lookup(uint64_t key, std::vector<Detection>& dets);
+
+    // Stores dets under key, evicting the least recently used entries until the cache fits its budget. Results
+    // larger than the whole budget are not stored.
+    void insert(uint64_t key, const std::vector<Detection>& dets);
+
+    // Saves to path after every save_every inserts, 0 saves only on explicit save() calls.
+    void set_persistence(const std::string& path, int save_every);
+
+    // Replaces the content with the entries of a file written by save() for the same config_id, most recently
+    // used first, as far as they fit. Returns false if the file is missing, invalid or for another config.
+    bool load(const std::string& path);
+
+    // Writes all entries, most recently used first, to path via a temporary file and rename.
+    bool save(const std::string& path);
+
+    CacheKeyMode mode() const { return mode_; }
+    uint64_t config_id() const { return config_id_; }
+    ResultCacheStats stats();
+
+   private:
+    // bbox, conf and class_id are all a cached result needs, masks and keypoints are not kept
+    struct CachedDetection {
+        float bbox[4];
+        float conf;
+        float class_id;
+    };
+    struct Entry {
+        uint64_t key;
+        std::vector<CachedDetection> dets;
+    };
+
+    static size_t entry_bytes(size_t num_dets);
+    void insert_locked(uint64_t key, std::vector<CachedDetection> dets);
+
+    const size_t budget_bytes_;
+    const uint64_t config_id_;
+    const CacheKeyMode mode_;
+
+    std::mutex mutex_;
+    std::mutex save_mutex_;  // one writer of the temporary file at a time
+    std::list<Entry> lru_;  // most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+    ResultCacheStats stats_;
+    std::string persist_path_;
+    int save_every_ = 0;
+    int unsaved_inserts_ = 0;
+};
+
+// Identity of an engine file and the runtime settings that change its detections.
+uint64_t result_cache_config_id(const std::string& engine_path, float conf_thresh, float nms_thresh,
+                                int max_num_output_bbox, CacheKeyMode mode);
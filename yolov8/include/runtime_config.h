@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+#include "buffer_strategy.h"
+#include "config.h"
+#include "result_cache.h"
+
+// Settings that used to be fixed in config.h. The defaults still come from config.h, and can be overridden at
+// runtime from a "key = value" file or "--key=value" command line arguments, so tuning batch size, input size or
+// thresholds does not require rebuilding the binaries.
+struct RuntimeConfig {
+    std::string precision;  // fp32, fp16 or int8, only used when building an engine
+    int batch_size;
+    int input_h;
+    int input_w;
+    // Only used when building: the decode plugin keeps it inside the engine and the detections carry their class ids,
+    // so running an engine does not depend on it.
+    int num_class;
+    float conf_thresh;
+    float nms_thresh;
+    int max_num_output_bbox;
+    int gpu_id;
+    // Build an explicit-batch engine whose batch size and input resolution can change per inference, up to
+    // batch_size x input_h x input_w. Detection only.
+    bool dynamic;
+    // Build an engine whose input is the letterboxed image as uint8 HWC BGR, normalized inside the engine (see
+    // uint8_input.h). Detection only, not with dynamic or int8.
+    bool uint8_input;
+    // Decode JPEGs at 1/2, 1/4 or 1/8 of their size when that still covers the network input (see image_loader.h).
+    bool decode_reduce;
+    // Print the inference time of every batch: 1 always, 0 never, -1 (the default) only where images are processed
+    // interactively, not in -serve, -shm or --bench, which run unattended or time the batches themselves.
+    int verbose;
+    // Write a Chrome trace of the host pipeline stages (see trace.h) to this file, empty for none.
+    std::string trace;
+    // How the engine's input and output buffers are allocated and moved, see buffer_strategy.h.
+    BufferStrategy buffers;
+    // Cache of detection results keyed by image content (see result_cache.h): budget in MB, 0 disables it; key mode
+    // (encoded or pixels); file the cache is loaded from and saved to, empty for none.
+    int cache_mb;
+    CacheKeyMode cache_key;
+    std::string cache_file;
+
+    RuntimeConfig();
+};
+
+// Sets a single key, returns false for unknown keys or invalid values.
+bool set_runtime_config_value(RuntimeConfig& cfg, const std::string& key, const std::string& value);
+
+// Reads "key = value" lines, '#' starts a comment.
+bool load_runtime_config_file(const std::string& path, RuntimeConfig& cfg);
+
+// Consumes all "--key=value" arguments ("--config=file.cfg" loads a file, later arguments win) and compacts argv so
+// the remaining positional arguments can be parsed as before. Returns false on the first invalid argument.
+bool parse_runtime_config_args(int& argc, char** argv, RuntimeConfig& cfg);
+
+// Input sizes must be multiples of the largest stride (32) and everything else positive.
+bool validate_runtime_config(const RuntimeConfig& cfg);
+
+// Replaces the settings baked into a deserialized engine, so buffers are sized from the engine and not from
+// constants. output_elements is the per-image size of the output binding.
+void update_runtime_config_from_engine(RuntimeConfig& cfg, int max_batch_size, int input_h, int input_w,
+                                       int output_elements);
+
+// Number of floats per image in the output binding: a count followed by max_num_output_bbox detections.
+int output_size_per_image(const RuntimeConfig& cfg);
+
+// Number of floats in the input binding for a full batch.
+size_t input_size_per_batch(const RuntimeConfig& cfg);
@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+
+// 2:4 structured sparsity of convolution weights laid out as [out][in][k*k]: in every group of 4 consecutive input
+// channels, per output channel and kernel position, at most 2 weights are non-zero. This is the pattern TensorRT's
+// sparse kernels expect. Trailing input channels that do not fill a group are left alone.
+
+// Zeros the 2 smallest magnitudes of every group, ties keep the lower channel.
+void prune_2to4(std::vector<float>& w, int out, int in, int kk);
+
+// True if every group has at most 2 non-zero weights.
+bool check_2to4(const std::vector<float>& w, int out, int in, int kk);
+
+struct PruneStats {
+    float sparsity;   // fraction of zero weights after pruning
+    float rel_error;  // ||w - pruned|| / ||w||
+    bool valid;       // check_2to4 of the pruned weights
+};
+
+// Prunes w in place and reports what it cost.
+PruneStats prune_conv_2to4(std::vector<float>& w, int out, int in, int kk);
+
+// Kernel size of a square conv with count weights and out output channels. From shape, the [out, in, k, k] shape tag
+// of the .wts entry, when there is one. Without it, 1 when count / out is not a multiple of 9; otherwise the layout
+// is ambiguous, a 1x1 conv over 9*n channels (576 for model.9.cv1 of yolov8m) or a 3x3 conv over n, and 0 is
+// returned. Also 0 if shape does not describe count weights over out channels.
+int conv_kernel_size(const std::vector<int>& shape, int count, int out);
@@ -0,0 +1,54 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "types.h"
+
+// Sliced inference for frames much larger than the network input, e.g. 4K and 8K aerial frames whose small objects
+// vanish when the whole frame is letterboxed to 640x640. The frame is cut into overlapping tiles of the input size,
+// every tile fills one slot of the engine batch at full resolution, the boxes are mapped back to frame pixels, and
+// the detections of objects seen by several tiles are merged. An optional full-frame pass keeps large objects that no
+// tile contains whole. Planning, mapping and merging run on the CPU.
+
+enum class TileMerge {
+    kNms,     // keep the most confident of same-class boxes whose IoU is above merge_thresh
+    kFusion,  // greedily fuse same-class boxes whose intersection over the smaller box is above merge_thresh into
+              // their union, so the parts of an object cut at a tile border become one box
+};
+
+struct TileOptions {
+    bool enabled = false;
+    int tile_w = 0;  // 0 uses the network input size
+    int tile_h = 0;
+    float overlap = 0.2f;    // fraction of a tile shared with its neighbour
+    bool full_frame = true;  // also run the whole frame, letterboxed
+    TileMerge merge = TileMerge::kFusion;
+    float merge_thresh = 0.5f;
+};
+
+// A region of the frame and the letterbox that maps it into the network input: input = (frame - roi.tl) * scale + pad,
+// as done by cuda_roi_preprocess.
+struct Tile {
+    cv::Rect roi;
+    float scale;
+    float pad_x;
+    float pad_y;
+};
+
+// Consumes "--tile", "--tile_size=WxH", "--tile_overlap=", "--tile_full=0|1", "--tile_merge=nms|fusion" and
+// "--tile_merge_thresh=" and compacts argv like parse_runtime_config_args. Returns false on an invalid value.
+bool parse_tile_args(int& argc, char** argv, TileOptions& opts);
+
+// The tile for an arbitrary region of a frame, letterboxed like a whole image.
+Tile make_tile(const cv::Rect& roi, int input_w, int input_h);
+
+// Tiles covering a frame row by row, all of the tile size: the last row and column are moved inwards to end at the
+// frame border instead of shrinking. A frame no larger than a tile gives a single tile. With full_frame the whole
+// frame comes first.
+std::vector<Tile> plan_tiles(int frame_w, int frame_h, int input_w, int input_h, const TileOptions& opts);
+
+// Maps NMS output of a tile, [x1, y1, x2, y2] in network input pixels, to frame pixels clipped to the tile.
+void tile_to_frame(const Tile& tile, std::vector<Detection>& dets);
+
+// Merges the detections of all tiles of a frame, [x1, y1, x2, y2] in frame pixels, in place. Only boxes of the same
+// class are merged; a uniform grid over the boxes limits the comparisons to neighbours.
+void merge_tile_detections(std::vector<Detection>& dets, TileMerge merge, float thresh);
@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Host-side tracing of the pipeline stages (decode, preprocess, inference, NMS, ...), exported as Chrome trace JSON
+// that chrome://tracing or ui.perfetto.dev open offline. Every thread records its spans into its own fixed-size
+// ring without locks; when a ring is full its oldest spans are overwritten. TRACE_SCOPE is compiled in with
+// ENABLE_TRACE (the YOLOV8_TRACE CMake option, off by default) and records only after trace_enable(true), otherwise
+// it costs one relaxed load.
+
+struct TraceSpan {
+    const char* name;  // string literal, only the pointer is stored
+    int64_t begin;  // trace_now_ticks()
+    int64_t end;
+};
+
+// Spans kept per thread, a power of two.
+constexpr static size_t kTraceRingSize = 1 << 16;
+
+extern std::atomic<bool> g_trace_enabled;
+
+static inline bool trace_enabled() {
+    return g_trace_enabled.load(std::memory_order_relaxed);
+}
+
+static inline int64_t trace_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+// Timestamp of a span. steady_clock costs about 50ns per read in a VM, most of a span, so on x86 spans read the TSC
+// instead and the exporter converts ticks to ns with a rate measured against steady_clock since trace_enable(true).
+static inline int64_t trace_now_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return (int64_t)__rdtsc();
+#else
+    return trace_now_ns();
+#endif
+}
+
+void trace_enable(bool enabled);
+
+// Name shown for the calling thread in the trace viewer.
+void trace_set_thread_name(const std::string& name);
+
+// Appends a span to the calling thread's ring, times from trace_now_ticks().
+void trace_record(const char* name, int64_t begin, int64_t end);
+
+// Writes the spans of all threads, call it once the traced threads are done or tracing is disabled.
+bool trace_write_chrome_json(const std::string& path);
+
+// Spans currently held by all rings.
+size_t trace_span_count();
+
+// Drops all recorded spans, same conditions as trace_write_chrome_json.
+void trace_clear();
+
+class TraceScope {
+   public:
+    explicit TraceScope(const char* name)
+        : name_(trace_enabled() ? name : nullptr), begin_(name_ != nullptr ? trace_now_ticks() : 0) {}
+    ~TraceScope() {
+        if (name_ != nullptr) {
+            trace_record(name_, begin_, trace_now_ticks());
+        }
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+   private:
+    const char* name_;
+    int64_t begin_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#if defined(ENABLE_TRACE)
+// Records the enclosing scope as a span named name, which must be a string literal.
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
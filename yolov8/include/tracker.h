@@ -0,0 +1,138 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "types.h"
+
+// ByteTrack-style multi-object tracker on the output of batch_nms, CPU only. Detections are associated with the
+// predicted tracks by IoU in two passes: high-score detections against all tracks, then low-score detections against
+// the tracks still unmatched, so occluded objects keep their ID through low-confidence frames. Each track has a
+// constant-velocity Kalman filter on its box center and size; the state of all tracks is kept in structure-of-arrays
+// form and the IoU matrix is computed with branch-free loops over it, which the compiler vectorizes. All buffers are
+// sized for max_tracks x max_detections at construction, so update() and predict() do not allocate.
+
+struct TrackerOptions {
+    float high_thresh = 0.5f;       // detections at or above are matched first and can start tracks
+    float low_thresh = 0.1f;        // detections below are ignored, between low and high only continue tracks
+    float new_track_thresh = 0.6f;  // unmatched detections at or above start a track
+    float match_iou = 0.2f;         // minimum IoU of the first pass
+    float low_match_iou = 0.5f;     // minimum IoU of the low-score pass
+    float unconfirmed_iou = 0.3f;   // minimum IoU for tracks seen once
+    int max_lost = 30;              // detection frames a track survives without a match
+    bool per_class = true;          // never match a detection to a track of another class
+    bool hungarian = false;         // optimal assignment per connected group of candidates instead of greedy
+    int max_tracks = 1024;
+    int max_detections = 1024;
+};
+
+// bbox is [x1, y1, x2, y2] in the coordinates of the detections.
+struct Track {
+    int id;
+    float bbox[4];
+    float conf;
+    int class_id;
+    int hits;                 // matched detections
+    int frames_since_update;  // frames since the last matched detection, detection frames or not
+};
+
+class ByteTracker {
+   public:
+    explicit ByteTracker(const TrackerOptions& opts = TrackerOptions());
+
+    // Detection frame: predicts all tracks one frame ahead, associates dets (bbox as [x1, y1, x2, y2], at most
+    // max_detections, in the order of batch_nms which is by confidence) and starts and drops tracks. Returns the
+    // confirmed tracks matched in this frame.
+    const std::vector<Track>& update(const std::vector<Detection>& dets);
+
+    // Frame without detection: advances all tracks with their motion model. Returns the confirmed tracks that were
+    // matched on the last detection frame, at their predicted position.
+    const std::vector<Track>& predict();
+
+    // Result of the last update() or predict().
+    const std::vector<Track>& tracks() const { return output_; }
+
+    // Largest standard deviation of a tracked box center, relative to the box height. Grows while tracks coast on
+    // predict(), KeyframeScheduler uses it to detect earlier.
+    float max_relative_uncertainty() const;
+
+    void reset();
+
+   private:
+    struct Candidate {
+        float iou;
+        int track;
+        int det;
+    };
+
+    void predict_states();
+    void compute_iou(const std::vector<int>& tracks, const std::vector<int>& dets);
+    void associate(std::vector<int>& tracks, std::vector<int>& dets, float min_iou);
+    void match_greedy(std::vector<int>& tracks, std::vector<int>& dets, float min_iou);
+    void match_hungarian(std::vector<int>& tracks, std::vector<int>& dets, float min_iou);
+    void solve_assignment(int rows, int cols);
+    int find_root(int node);
+    void update_state(int slot, int det);
+    void start_track(int det);
+    void remove_slot(int slot);
+    void write_output();
+    void box_of(int slot, float bbox[4]) const;
+
+    TrackerOptions opts_;
+    int next_id_ = 1;
+    int frame_ = 0;
+
+    // per track slot, slots [0, num_) are in use
+    int num_ = 0;
+    std::vector<float> mean_[4];  // cx, cy, w, h
+    std::vector<float> vel_[4];
+    std::vector<float> p00_[4];  // 2x2 covariance of each (position, velocity) pair
+    std::vector<float> p01_[4];
+    std::vector<float> p11_[4];
+    std::vector<int> id_, class_, hits_, lost_, since_update_;
+    std::vector<char> confirmed_;
+    std::vector<float> conf_;
+    std::vector<float> box_[4];  // predicted x1, y1, x2, y2 and area for the IoU matrix
+    std::vector<float> area_;
+
+    // per detection of the current frame
+    int num_dets_ = 0;
+    std::vector<float> det_box_[4];
+    std::vector<float> det_area_;
+    std::vector<float> det_conf_;
+    std::vector<int> det_class_;
+
+    // scratch, sized once
+    std::vector<float> pass_box_[4], pass_area_;  // detections of the current pass, contiguous
+    std::vector<int> pass_class_;
+    std::vector<float> iou_;                                    // tracks x detections of the current pass
+    std::vector<int> track_match_, det_match_;
+    std::vector<int> pass_tracks_, pass_dets_, rest_tracks_, rest_dets_, low_dets_, unconfirmed_;
+    std::vector<Candidate> candidates_;
+    std::vector<int> parent_, group_start_, group_order_, group_rows_, group_cols_;
+    std::vector<double> cost_, u_, v_, minv_;  // Hungarian, only allocated with opts.hungarian
+    std::vector<int> p_, way_;
+    std::vector<char> used_;
+    std::vector<Track> output_;
+};
+
+// Decides on which frames the detector runs: every interval-th frame, and earlier once a coasting track's center is
+// more uncertain than max_uncertainty box heights (0 disables that).
+class KeyframeScheduler {
+   public:
+    explicit KeyframeScheduler(int interval = 1, float max_uncertainty = 0.f)
+        : interval_(interval < 1 ? 1 : interval), max_uncertainty_(max_uncertainty) {}
+
+    // Call once per frame, in order.
+    bool is_keyframe(const ByteTracker& tracker) {
+        bool key = since_key_ + 1 >= interval_ ||
+                   (max_uncertainty_ > 0.f && tracker.max_relative_uncertainty() > max_uncertainty_) || frame_ == 0;
+        since_key_ = key ? 0 : since_key_ + 1;
+        frame_++;
+        return key;
+    }
+
+   private:
+    int interval_;
+    float max_uncertainty_;
+    int since_key_ = 0;
+    int64_t frame_ = 0;
+};
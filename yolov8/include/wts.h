@@ -0,0 +1,22 @@
+#pragma once
+#include <stdint.h>
+#include <istream>
+#include <string>
+#include <vector>
+
+// TensorRT weight files have a simple space delimited format:
+// [name] [size] <data x size in hex>
+// gen_wts.py can also emit compact entries, which are expanded to fp32 on load:
+// [name] fp16 [size] <fp16 data x size in hex>
+// [name] int8 [size] [channels] <fp32 scale x channels in hex> <int8 data x size in hex>
+// and tags 4-D tensors with their shape after the name, e.g. for a 3x3 conv from 16 to 32 channels:
+// [name] shape 32x16x3x3 [fp16|int8]? [size] ...
+
+// IEEE 754 binary16 -> binary32, including subnormals, inf and nan.
+float halfToFloat(uint16_t h);
+
+// Reads the next entry of a .wts file. values gets count fp32 values allocated with malloc, type is "fp32", "fp16" or
+// "int8", as stored, and shape the dimensions of the shape tag, empty without one. False if the entry is malformed
+// or the file ends inside it.
+bool readWtsEntry(std::istream& input, std::string& name, std::string& type, float*& values, uint32_t& count,
+                  std::vector<int>* shape = nullptr);
@@ -0,0 +1,125 @@
+#include <assert.h>
+#include <string.h>
+#include "cuda_utils.h"
+#include "uint8inputlayer.h"
+
+// One thread per pixel: BGR bytes to the R, G and B planes of its image, / 255. uint8_input_reference is the CPU
+// version.
+__global__ void uint8_input_kernel(const uint8_t* src, float* dst, int plane, int total) {
+    int idx = blockIdx.x * blockDim.x + threadIdx.x;
+    if (idx >= total)
+        return;
+    int b = idx / plane;
+    int p = idx - b * plane;
+    const uint8_t* s = src + (size_t)idx * 3;
+    float* d = dst + (size_t)b * 3 * plane + p;
+    d[0] = s[2] / 255.f;
+    d[plane] = s[1] / 255.f;
+    d[2 * plane] = s[0] / 255.f;
+}
+
+namespace nvinfer1 {
+Uint8InputPlugin::Uint8InputPlugin(int netHeight, int netWidth) : mNetHeight(netHeight), mNetWidth(netWidth) {}
+
+Uint8InputPlugin::Uint8InputPlugin(const void* data, size_t length) {
+    const char *d = reinterpret_cast<const char*>(data), *a = d;
+    memcpy(&mThreadCount, d, sizeof(int));
+    memcpy(&mNetHeight, d + sizeof(int), sizeof(int));
+    memcpy(&mNetWidth, d + 2 * sizeof(int), sizeof(int));
+    d += 3 * sizeof(int);
+    assert(d == a + length);
+}
+
+void Uint8InputPlugin::serialize(void* buffer) const TRT_NOEXCEPT {
+    char* d = static_cast<char*>(buffer);
+    memcpy(d, &mThreadCount, sizeof(int));
+    memcpy(d + sizeof(int), &mNetHeight, sizeof(int));
+    memcpy(d + 2 * sizeof(int), &mNetWidth, sizeof(int));
+}
+
+size_t Uint8InputPlugin::getSerializationSize() const TRT_NOEXCEPT {
+    return 3 * sizeof(int);
+}
+
+Dims Uint8InputPlugin::getOutputDimensions(int index, const Dims* inputs, int nbInputDims) TRT_NOEXCEPT {
+    return Dims3(3, mNetHeight, mNetWidth);
+}
+
+nvinfer1::DataType Uint8InputPlugin::getOutputDataType(int index, const nvinfer1::DataType* inputTypes,
+                                                       int nbInputs) const TRT_NOEXCEPT {
+    return nvinfer1::DataType::kFLOAT;
+}
+
+int Uint8InputPlugin::enqueue(int batchSize, const void* const* inputs, void* TRT_CONST_ENQUEUE* outputs,
+                              void* workspace, cudaStream_t stream) TRT_NOEXCEPT {
+    int plane = mNetHeight * mNetWidth;
+    int total = batchSize * plane;
+    uint8_input_kernel<<<(total + mThreadCount - 1) / mThreadCount, mThreadCount, 0, stream>>>(
+            (const uint8_t*)inputs[0], (float*)outputs[0], plane, total);
+    return cudaGetLastError() == cudaSuccess ? 0 : -1;
+}
+
+void Uint8InputPlugin::setPluginNamespace(const char* pluginNamespace) TRT_NOEXCEPT {
+    mPluginNamespace = pluginNamespace;
+}
+
+const char* Uint8InputPlugin::getPluginNamespace() const TRT_NOEXCEPT {
+    return mPluginNamespace.c_str();
+}
+
+const char* Uint8InputPlugin::getPluginType() const TRT_NOEXCEPT {
+    return "Uint8Input_TRT";
+}
+
+const char* Uint8InputPlugin::getPluginVersion() const TRT_NOEXCEPT {
+    return "1";
+}
+
+void Uint8InputPlugin::destroy() TRT_NOEXCEPT {
+    delete this;
+}
+
+IPluginV2IOExt* Uint8InputPlugin::clone() const TRT_NOEXCEPT {
+    Uint8InputPlugin* p = new Uint8InputPlugin(mNetHeight, mNetWidth);
+    p->setPluginNamespace(mPluginNamespace.c_str());
+    return p;
+}
+
+PluginFieldCollection Uint8InputPluginCreator::mFC{};
+std::vector<PluginField> Uint8InputPluginCreator::mPluginAttributes;
+
+Uint8InputPluginCreator::Uint8InputPluginCreator() {
+    mPluginAttributes.clear();
+    mFC.nbFields = mPluginAttributes.size();
+    mFC.fields = mPluginAttributes.data();
+}
+
+const char* Uint8InputPluginCreator::getPluginName() const TRT_NOEXCEPT {
+    return "Uint8Input_TRT";
+}
+
+const char* Uint8InputPluginCreator::getPluginVersion() const TRT_NOEXCEPT {
+    return "1";
+}
+
+const PluginFieldCollection* Uint8InputPluginCreator::getFieldNames() TRT_NOEXCEPT {
+    return &mFC;
+}
+
+IPluginV2IOExt* Uint8InputPluginCreator::createPlugin(const char* name, const PluginFieldCollection* fc) TRT_NOEXCEPT {
+    // "inputShape": {height, width} of the network input
+    assert(fc->nbFields == 1);
+    assert(strcmp(fc->fields[0].name, "inputShape") == 0 && fc->fields[0].length == 2);
+    const int* shape = static_cast<const int*>(fc->fields[0].data);
+    Uint8InputPlugin* obj = new Uint8InputPlugin(shape[0], shape[1]);
+    obj->setPluginNamespace(mNamespace.c_str());
+    return obj;
+}
+
+IPluginV2IOExt* Uint8InputPluginCreator::deserializePlugin(const char* name, const void* serialData,
+                                                           size_t serialLength) TRT_NOEXCEPT {
+    Uint8InputPlugin* obj = new Uint8InputPlugin(serialData, serialLength);
+    obj->setPluginNamespace(mNamespace.c_str());
+    return obj;
+}
+}  // namespace nvinfer1
@@ -344,4 +344,146 @@ IPluginV2IOExt* YoloPluginCreator::deserializePlugin(const char* name, const voi
     return obj;
 }
 
+YoloLayerPluginDynamic::YoloLayerPluginDynamic(int classCount, int maxOut, const int* strides, int stridesLength)
+    : mClassCount(classCount), mMaxOutObject(maxOut), mStrides(strides, strides + stridesLength) {}
+
+YoloLayerPluginDynamic::YoloLayerPluginDynamic(const void* data, size_t length) {
+    using namespace Tn;
+    const char *d = reinterpret_cast<const char*>(data), *a = d;
+    int stridesLength = 0;
+    read(d, mClassCount);
+    read(d, mThreadCount);
+    read(d, mMaxOutObject);
+    read(d, stridesLength);
+    mStrides.resize(stridesLength);
+    for (int i = 0; i < stridesLength; ++i) {
+        read(d, mStrides[i]);
+    }
+
+    assert(d == a + length);
+}
+
+void YoloLayerPluginDynamic::serialize(void* buffer) const TRT_NOEXCEPT {
+    using namespace Tn;
+    char *d = static_cast<char*>(buffer), *a = d;
+    write(d, mClassCount);
+    write(d, mThreadCount);
+    write(d, mMaxOutObject);
+    write(d, static_cast<int>(mStrides.size()));
+    for (int stride : mStrides) {
+        write(d, stride);
+    }
+
+    assert(d == a + getSerializationSize());
+}
+
+size_t YoloLayerPluginDynamic::getSerializationSize() const TRT_NOEXCEPT {
+    return sizeof(mClassCount) + sizeof(mThreadCount) + sizeof(mMaxOutObject) + sizeof(int) +
+           sizeof(int) * mStrides.size();
+}
+
+DimsExprs YoloLayerPluginDynamic::getOutputDimensions(int outputIndex, const DimsExprs* inputs, int nbInputs,
+                                                      IExprBuilder& exprBuilder) TRT_NOEXCEPT {
+    // [N, 1 + maxOut * sizeof(Detection) / sizeof(float)], same per-image layout as YoloLayerPlugin
+    DimsExprs output;
+    output.nbDims = 2;
+    output.d[0] = inputs[0].d[0];
+    output.d[1] = exprBuilder.constant(1 + mMaxOutObject * sizeof(Detection) / sizeof(float));
+    return output;
+}
+
+nvinfer1::DataType YoloLayerPluginDynamic::getOutputDataType(int index, const nvinfer1::DataType* inputTypes,
+                                                             int nbInputs) const TRT_NOEXCEPT {
+    return nvinfer1::DataType::kFLOAT;
+}
+
+void YoloLayerPluginDynamic::setPluginNamespace(const char* pluginNamespace) TRT_NOEXCEPT {
+    mPluginNamespace = pluginNamespace;
+}
+
+const char* YoloLayerPluginDynamic::getPluginNamespace() const TRT_NOEXCEPT {
+    return mPluginNamespace.c_str();
+}
+
+const char* YoloLayerPluginDynamic::getPluginType() const TRT_NOEXCEPT {
+    return "YoloLayerDynamic_TRT";
+}
+
+const char* YoloLayerPluginDynamic::getPluginVersion() const TRT_NOEXCEPT {
+    return "1";
+}
+
+void YoloLayerPluginDynamic::destroy() TRT_NOEXCEPT {
+    delete this;
+}
+
+IPluginV2DynamicExt* YoloLayerPluginDynamic::clone() const TRT_NOEXCEPT {
+    YoloLayerPluginDynamic* p =
+            new YoloLayerPluginDynamic(mClassCount, mMaxOutObject, mStrides.data(), mStrides.size());
+    p->setPluginNamespace(mPluginNamespace.c_str());
+    return p;
+}
+
+int YoloLayerPluginDynamic::enqueue(const PluginTensorDesc* inputDesc, const PluginTensorDesc* outputDesc,
+                                    const void* const* inputs, void* const* outputs, void* workspace,
+                                    cudaStream_t stream) TRT_NOEXCEPT {
+    int batchSize = inputDesc[0].dims.d[0];
+    int outputElem = 1 + mMaxOutObject * sizeof(Detection) / sizeof(float);
+    float* output = static_cast<float*>(outputs[0]);
+    for (int idx = 0; idx < batchSize; ++idx) {
+        CUDA_CHECK(cudaMemsetAsync(output + idx * outputElem, 0, sizeof(float), stream));
+    }
+
+    for (size_t i = 0; i < mStrides.size(); i++) {
+        int grid_h = inputDesc[i].dims.d[2];
+        int grid_w = inputDesc[i].dims.d[3];
+        int numElem = grid_h * grid_w * batchSize;
+        int threadCount = numElem < mThreadCount ? numElem : mThreadCount;
+        CalDetection<<<(numElem + threadCount - 1) / threadCount, threadCount, 0, stream>>>(
+                static_cast<const float*>(inputs[i]), output, numElem, mMaxOutObject, grid_h, grid_w, mStrides[i],
+                mClassCount, 0, 0.0f, outputElem, false, false);
+    }
+    return 0;
+}
+
+PluginFieldCollection YoloDynamicPluginCreator::mFC{};
+std::vector<PluginField> YoloDynamicPluginCreator::mPluginAttributes;
+
+YoloDynamicPluginCreator::YoloDynamicPluginCreator() {
+    mPluginAttributes.clear();
+    mFC.nbFields = mPluginAttributes.size();
+    mFC.fields = mPluginAttributes.data();
+}
+
+const char* YoloDynamicPluginCreator::getPluginName() const TRT_NOEXCEPT {
+    return "YoloLayerDynamic_TRT";
+}
+
+const char* YoloDynamicPluginCreator::getPluginVersion() const TRT_NOEXCEPT {
+    return "1";
+}
+
+const PluginFieldCollection* YoloDynamicPluginCreator::getFieldNames() TRT_NOEXCEPT {
+    return &mFC;
+}
+
+IPluginV2DynamicExt* YoloDynamicPluginCreator::createPlugin(const char* name,
+                                                            const PluginFieldCollection* fc) TRT_NOEXCEPT {
+    assert(fc->nbFields == 1);
+    assert(strcmp(fc->fields[0].name, "combinedInfo") == 0);
+    // combinedInfo: num_class, max_output_object_count, strides...
+    const int* combinedInfo = static_cast<const int*>(fc->fields[0].data);
+    YoloLayerPluginDynamic* obj = new YoloLayerPluginDynamic(combinedInfo[0], combinedInfo[1], combinedInfo + 2,
+                                                             fc->fields[0].length - 2);
+    obj->setPluginNamespace(mNamespace.c_str());
+    return obj;
+}
+
+IPluginV2DynamicExt* YoloDynamicPluginCreator::deserializePlugin(const char* name, const void* serialData,
+                                                                 size_t serialLength) TRT_NOEXCEPT {
+    YoloLayerPluginDynamic* obj = new YoloLayerPluginDynamic(serialData, serialLength);
+    obj->setPluginNamespace(mNamespace.c_str());
+    return obj;
+}
+
 }  // namespace nvinfer1
@@ -106,4 +106,93 @@ class API YoloPluginCreator : public IPluginCreator {
     static std::vector<PluginField> mPluginAttributes;
 };
 REGISTER_TENSORRT_PLUGIN(YoloPluginCreator);
+
+// Detection-only decode for explicit-batch engines built with dynamic batch and input resolution.
+// Grid sizes are read from the input descriptors at enqueue time instead of being fixed at build time.
+class API YoloLayerPluginDynamic : public IPluginV2DynamicExt {
+   public:
+    YoloLayerPluginDynamic(int classCount, int maxOut, const int* strides, int stridesLength);
+
+    YoloLayerPluginDynamic(const void* data, size_t length);
+    ~YoloLayerPluginDynamic() override = default;
+
+    int getNbOutputs() const TRT_NOEXCEPT override { return 1; }
+
+    DimsExprs getOutputDimensions(int outputIndex, const DimsExprs* inputs, int nbInputs,
+                                  IExprBuilder& exprBuilder) TRT_NOEXCEPT override;
+
+    int initialize() TRT_NOEXCEPT override { return 0; }
+
+    void terminate() TRT_NOEXCEPT override {}
+
+    size_t getWorkspaceSize(const PluginTensorDesc* inputs, int nbInputs, const PluginTensorDesc* outputs,
+                            int nbOutputs) const TRT_NOEXCEPT override {
+        return 0;
+    }
+
+    int enqueue(const PluginTensorDesc* inputDesc, const PluginTensorDesc* outputDesc, const void* const* inputs,
+                void* const* outputs, void* workspace, cudaStream_t stream) TRT_NOEXCEPT override;
+
+    size_t getSerializationSize() const TRT_NOEXCEPT override;
+
+    void serialize(void* buffer) const TRT_NOEXCEPT override;
+
+    bool supportsFormatCombination(int pos, const PluginTensorDesc* inOut, int nbInputs,
+                                   int nbOutputs) TRT_NOEXCEPT override {
+        return inOut[pos].format == TensorFormat::kLINEAR && inOut[pos].type == DataType::kFLOAT;
+    }
+
+    const char* getPluginType() const TRT_NOEXCEPT override;
+
+    const char* getPluginVersion() const TRT_NOEXCEPT override;
+
+    void destroy() TRT_NOEXCEPT override;
+
+    IPluginV2DynamicExt* clone() const TRT_NOEXCEPT override;
+
+    void setPluginNamespace(const char* pluginNamespace) TRT_NOEXCEPT override;
+
+    const char* getPluginNamespace() const TRT_NOEXCEPT override;
+
+    nvinfer1::DataType getOutputDataType(int32_t index, nvinfer1::DataType const* inputTypes,
+                                         int32_t nbInputs) const TRT_NOEXCEPT override;
+
+    void configurePlugin(const DynamicPluginTensorDesc* in, int nbInputs, const DynamicPluginTensorDesc* out,
+                         int nbOutputs) TRT_NOEXCEPT override {}
+
+   private:
+    int mThreadCount = 256;
+    std::string mPluginNamespace;
+    int mClassCount;
+    int mMaxOutObject;
+    std::vector<int> mStrides;
+};
+
+class API YoloDynamicPluginCreator : public IPluginCreator {
+   public:
+    YoloDynamicPluginCreator();
+    ~YoloDynamicPluginCreator() override = default;
+
+    const char* getPluginName() const TRT_NOEXCEPT override;
+
+    const char* getPluginVersion() const TRT_NOEXCEPT override;
+
+    const nvinfer1::PluginFieldCollection* getFieldNames() TRT_NOEXCEPT override;
+
+    nvinfer1::IPluginV2DynamicExt* createPlugin(const char* name,
+                                                const nvinfer1::PluginFieldCollection* fc) TRT_NOEXCEPT override;
+
+    nvinfer1::IPluginV2DynamicExt* deserializePlugin(const char* name, const void* serialData,
+                                                     size_t serialLength) TRT_NOEXCEPT override;
+
+    void setPluginNamespace(const char* libNamespace) TRT_NOEXCEPT override { mNamespace = libNamespace; }
+
+    const char* getPluginNamespace() const TRT_NOEXCEPT override { return mNamespace.c_str(); }
+
+   private:
+    std::string mNamespace;
+    static PluginFieldCollection mFC;
+    static std::vector<PluginField> mPluginAttributes;
+};
+REGISTER_TENSORRT_PLUGIN(YoloDynamicPluginCreator);
 }  // namespace nvinfer1
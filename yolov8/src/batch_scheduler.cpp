@@ -0,0 +1,109 @@
+#include "batch_scheduler.h"
+#include <algorithm>
+
+BatchScheduler::BatchScheduler(const BatchSchedulerOptions& opts, BatchFn fn)
+    : opts_(opts), fn_(fn), window_us_(opts.initial_window_us) {
+    opts_.max_batch = std::max(1, opts_.max_batch);
+    window_us_ = std::min(std::max(window_us_, opts_.min_window_us), opts_.max_window_us);
+    thread_ = std::thread(&BatchScheduler::run, this);
+}
+
+BatchScheduler::~BatchScheduler() {
+    stop();
+}
+
+std::future<void> BatchScheduler::submit(std::shared_ptr<InferJob> job) {
+    job->arrival = std::chrono::steady_clock::now();
+    std::future<void> future = job->done.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(job);
+    }
+    cv_.notify_one();
+    return future;
+}
+
+void BatchScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+BatchSchedulerStats BatchScheduler::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    BatchSchedulerStats stats = stats_;
+    stats.window_us = window_us_;
+    stats.exec_us = exec_us_;
+    return stats;
+}
+
+void BatchScheduler::adapt(size_t batch_size, size_t queue_depth, bool missed) {
+    if (missed || queue_depth >= (size_t)opts_.max_batch) {
+        // saturated, batches fill without waiting, or the window cost a deadline
+        window_us_ /= 2;
+    } else if (batch_size == 1) {
+        // nothing arrived within the window, waiting only added latency
+        window_us_ = window_us_ * 3 / 4;
+    } else {
+        // partial batches are forming, a slightly longer window should fill them further
+        window_us_ += std::max(opts_.min_window_us, window_us_ / 8);
+    }
+    window_us_ = std::min(std::max(window_us_, opts_.min_window_us), opts_.max_window_us);
+}
+
+void BatchScheduler::run() {
+    if (opts_.thread_init) {
+        opts_.thread_init();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;  // stopping and drained
+        }
+
+        // Wait for more jobs until the batch is full, the window of the oldest job passes or the earliest deadline
+        // minus the expected execution time is reached.
+        while (!stopping_ && queue_.size() < (size_t)opts_.max_batch) {
+            auto dispatch = queue_.front()->arrival + std::chrono::microseconds(window_us_);
+            auto exec = std::chrono::microseconds((int64_t)exec_us_);
+            for (size_t i = 0; i < queue_.size(); i++) {
+                dispatch = std::min(dispatch, queue_[i]->deadline - exec);
+            }
+            if (std::chrono::steady_clock::now() >= dispatch) {
+                break;
+            }
+            size_t queued = queue_.size();
+            cv_.wait_until(lock, dispatch, [this, queued] { return stopping_ || queue_.size() != queued; });
+        }
+
+        size_t queue_depth = queue_.size();
+        size_t n = std::min(queue_depth, (size_t)opts_.max_batch);
+        std::vector<std::shared_ptr<InferJob>> batch(queue_.begin(), queue_.begin() + n);
+        queue_.erase(queue_.begin(), queue_.begin() + n);
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        fn_(batch);
+        auto end = std::chrono::steady_clock::now();
+        int missed = 0;
+        for (auto& job : batch) {
+            job->finish = end;
+            missed += end > job->deadline;
+            job->done.set_value();
+        }
+
+        lock.lock();
+        float exec_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        exec_us_ = stats_.batches == 0 ? exec_us : 0.9f * exec_us_ + 0.1f * exec_us;
+        stats_.batches++;
+        stats_.jobs += n;
+        stats_.deadline_misses += missed;
+        adapt(n, queue_depth, missed > 0);
+    }
+}
@@ -1,11 +1,15 @@
 #include "block.h"
 #include <assert.h>
 #include <math.h>
+#include <string.h>
 #include <fstream>
 #include <iostream>
+#include "bn_fold.h"
 #include "config.h"
+#include "wts.h"
 #include "yololayer.h"
 
+// Loads a .wts file, see wts.h for the format.
 std::map<std::string, nvinfer1::Weights> loadWeights(const std::string file) {
     std::cout << "Loading weights: " << file << std::endl;
     std::map<std::string, nvinfer1::Weights> WeightMap;
@@ -18,78 +22,60 @@ std::map<std::string, nvinfer1::Weights> loadWeights(const std::string file) {
     assert(count > 0 && "Invalid weight map file.");
 
     while (count--) {
-        nvinfer1::Weights wt{nvinfer1::DataType::kFLOAT, nullptr, 0};
-        uint32_t size;
-
-        std::string name;
-        input >> name >> std::dec >> size;
-        wt.type = nvinfer1::DataType::kFLOAT;
-
-        uint32_t* val = reinterpret_cast<uint32_t*>(malloc(sizeof(val) * size));
-        for (uint32_t x = 0, y = size; x < y; x++) {
-            input >> std::hex >> val[x];
-        }
-        wt.values = val;
-        wt.count = size;
-        WeightMap[name] = wt;
+        std::string name, type;
+        float* values = nullptr;
+        uint32_t size = 0;
+        bool ok = readWtsEntry(input, name, type, values, size);
+        assert(ok && "Invalid weight map entry.");
+        (void)ok;
+        WeightMap[name] = nvinfer1::Weights{nvinfer1::DataType::kFLOAT, values, size};
     }
     return WeightMap;
 }
 
-static nvinfer1::IScaleLayer* addBatchNorm2d(nvinfer1::INetworkDefinition* network,
-                                             std::map<std::string, nvinfer1::Weights> weightMap,
-                                             nvinfer1::ITensor& input, std::string lname, float eps) {
-    float* gamma = (float*)weightMap[lname + ".weight"].values;
-    float* beta = (float*)weightMap[lname + ".bias"].values;
-    float* mean = (float*)weightMap[lname + ".running_mean"].values;
-    float* var = (float*)weightMap[lname + ".running_var"].values;
-    int len = weightMap[lname + ".running_var"].count;
-
-    float* scval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-    for (int i = 0; i < len; i++) {
-        scval[i] = gamma[i] / sqrt(var[i] + eps);
+// Fold the BatchNorm2d that follows a bias-free convolution into the conv weights and bias on the host, so the
+// network gets a single IConvolutionLayer instead of a convolution followed by an IScaleLayer.
+// The conv weights are scaled in place, nothing reads the unfolded ones, so the only extra host memory is the bias,
+// which is stored into weightMap and released together with the rest of the weights.
+static void foldBatchNorm2d(std::map<std::string, nvinfer1::Weights>& weightMap, std::string conv_name,
+                            std::string bn_name, float eps, nvinfer1::Weights& weight, nvinfer1::Weights& bias) {
+    std::string bias_name = conv_name + ".fused_bias";
+    nvinfer1::Weights& w = weightMap[conv_name + ".weight"];
+    if (weightMap.count(bias_name) == 0) {
+        int len = weightMap[bn_name + ".running_var"].count;
+        float* bval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
+        fold_batchnorm((float*)w.values, w.count, (const float*)weightMap[bn_name + ".weight"].values,
+                       (const float*)weightMap[bn_name + ".bias"].values,
+                       (const float*)weightMap[bn_name + ".running_mean"].values,
+                       (const float*)weightMap[bn_name + ".running_var"].values, len, eps, bval);
+        weightMap[bias_name] = nvinfer1::Weights{nvinfer1::DataType::kFLOAT, bval, len};
     }
-    nvinfer1::Weights scale{nvinfer1::DataType::kFLOAT, scval, len};
-
-    float* shval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-    for (int i = 0; i < len; i++) {
-        shval[i] = beta[i] - mean[i] * gamma[i] / sqrt(var[i] + eps);
-    }
-    nvinfer1::Weights shift{nvinfer1::DataType::kFLOAT, shval, len};
-
-    float* pval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-    for (int i = 0; i < len; i++) {
-        pval[i] = 1.0;
-    }
-    nvinfer1::Weights power{nvinfer1::DataType::kFLOAT, pval, len};
-    weightMap[lname + ".scale"] = scale;
-    weightMap[lname + ".shift"] = shift;
-    weightMap[lname + ".power"] = power;
-    nvinfer1::IScaleLayer* output = network->addScale(input, nvinfer1::ScaleMode::kCHANNEL, shift, scale, power);
-    assert(output);
-    return output;
+    weight = w;
+    bias = weightMap[bias_name];
 }
 
 nvinfer1::IElementWiseLayer* convBnSiLU(nvinfer1::INetworkDefinition* network,
-                                        std::map<std::string, nvinfer1::Weights> weightMap, nvinfer1::ITensor& input,
+                                        std::map<std::string, nvinfer1::Weights>& weightMap, nvinfer1::ITensor& input,
                                         int ch, int k, int s, int p, std::string lname) {
-    nvinfer1::Weights bias_empty{nvinfer1::DataType::kFLOAT, nullptr, 0};
-    nvinfer1::IConvolutionLayer* conv =
-            network->addConvolutionNd(input, ch, nvinfer1::DimsHW{k, k}, weightMap[lname + ".conv.weight"], bias_empty);
+    nvinfer1::Weights weight, bias;
+    foldBatchNorm2d(weightMap, lname + ".conv", lname + ".bn", 1e-3, weight, bias);
+    nvinfer1::IConvolutionLayer* conv = network->addConvolutionNd(input, ch, nvinfer1::DimsHW{k, k}, weight, bias);
     assert(conv);
     conv->setStrideNd(nvinfer1::DimsHW{s, s});
     conv->setPaddingNd(nvinfer1::DimsHW{p, p});
+    conv->setName((lname + ".conv").c_str());
 
-    nvinfer1::IScaleLayer* bn = addBatchNorm2d(network, weightMap, *conv->getOutput(0), lname + ".bn", 1e-3);
-
-    nvinfer1::IActivationLayer* sigmoid = network->addActivation(*bn->getOutput(0), nvinfer1::ActivationType::kSIGMOID);
+    nvinfer1::IActivationLayer* sigmoid =
+            network->addActivation(*conv->getOutput(0), nvinfer1::ActivationType::kSIGMOID);
+    sigmoid->setName((lname + ".sigmoid").c_str());
     nvinfer1::IElementWiseLayer* ew =
-            network->addElementWise(*bn->getOutput(0), *sigmoid->getOutput(0), nvinfer1::ElementWiseOperation::kPROD);
+            network->addElementWise(*conv->getOutput(0), *sigmoid->getOutput(0), nvinfer1::ElementWiseOperation::kPROD);
     assert(ew);
+    ew->setName((lname + ".act").c_str());
     return ew;
 }
 
-nvinfer1::ILayer* bottleneck(nvinfer1::INetworkDefinition* network, std::map<std::string, nvinfer1::Weights> weightMap,
+nvinfer1::ILayer* bottleneck(nvinfer1::INetworkDefinition* network, std::map<std::string, nvinfer1::Weights>& weightMap,
                              nvinfer1::ITensor& input, int c1, int c2, bool shortcut, float e, std::string lname) {
     nvinfer1::IElementWiseLayer* conv1 = convBnSiLU(network, weightMap, input, c2, 3, 1, 1, lname + ".cv1");
     nvinfer1::IElementWiseLayer* conv2 =
@@ -103,20 +89,62 @@ nvinfer1::ILayer* bottleneck(nvinfer1::INetworkDefinition* network, std::map<std
     return conv2;
 }
 
+// Shape of input with dimension index replaced by value, as an int32 shape tensor. Used to slice and reshape
+// explicit-batch tensors whose batch, height and width are only known at runtime.
+static nvinfer1::ITensor* shapeWithDim(nvinfer1::INetworkDefinition* network,
+                                       std::map<std::string, nvinfer1::Weights>& weightMap, nvinfer1::ITensor& input,
+                                       int index, int value, std::string lname) {
+    assert(weightMap.find(lname + ".shape_keep") == weightMap.end());
+    int nb = input.getDimensions().nbDims;
+    int32_t* keep = reinterpret_cast<int32_t*>(malloc(sizeof(int32_t) * nb));
+    int32_t* add = reinterpret_cast<int32_t*>(malloc(sizeof(int32_t) * nb));
+    for (int i = 0; i < nb; i++) {
+        keep[i] = i == index ? 0 : 1;
+        add[i] = i == index ? value : 0;
+    }
+    nvinfer1::Weights keep_wt{nvinfer1::DataType::kINT32, keep, nb};
+    nvinfer1::Weights add_wt{nvinfer1::DataType::kINT32, add, nb};
+    weightMap[lname + ".shape_keep"] = keep_wt;
+    weightMap[lname + ".shape_add"] = add_wt;
+
+    nvinfer1::Dims vec_dims;
+    vec_dims.nbDims = 1;
+    vec_dims.d[0] = nb;
+    nvinfer1::IShapeLayer* shape = network->addShape(input);
+    nvinfer1::IConstantLayer* keep_layer = network->addConstant(vec_dims, keep_wt);
+    nvinfer1::IConstantLayer* add_layer = network->addConstant(vec_dims, add_wt);
+    nvinfer1::IElementWiseLayer* masked = network->addElementWise(*shape->getOutput(0), *keep_layer->getOutput(0),
+                                                                  nvinfer1::ElementWiseOperation::kPROD);
+    nvinfer1::IElementWiseLayer* result = network->addElementWise(*masked->getOutput(0), *add_layer->getOutput(0),
+                                                                  nvinfer1::ElementWiseOperation::kSUM);
+    assert(result);
+    return result->getOutput(0);
+}
+
+// Channel slice [start, start + count) for both implicit-batch CHW and explicit-batch NCHW tensors.
+static nvinfer1::ISliceLayer* sliceChannels(nvinfer1::INetworkDefinition* network,
+                                            std::map<std::string, nvinfer1::Weights>& weightMap,
+                                            nvinfer1::ITensor& input, int start, int count, std::string lname) {
+    nvinfer1::Dims d = input.getDimensions();
+    if (d.nbDims == 3) {
+        return network->addSlice(input, nvinfer1::Dims3{start, 0, 0}, nvinfer1::Dims3{count, d.d[1], d.d[2]},
+                                 nvinfer1::Dims3{1, 1, 1});
+    }
+    nvinfer1::ISliceLayer* slice = network->addSlice(input, nvinfer1::Dims4{0, start, 0, 0},
+                                                     nvinfer1::Dims4{1, count, 1, 1}, nvinfer1::Dims4{1, 1, 1, 1});
+    slice->setInput(2, *shapeWithDim(network, weightMap, input, 1, count, lname));
+    return slice;
+}
+
 nvinfer1::IElementWiseLayer* C2F(nvinfer1::INetworkDefinition* network,
-                                 std::map<std::string, nvinfer1::Weights> weightMap, nvinfer1::ITensor& input, int c1,
+                                 std::map<std::string, nvinfer1::Weights>& weightMap, nvinfer1::ITensor& input, int c1,
                                  int c2, int n, bool shortcut, float e, std::string lname) {
     int c_ = (float)c2 * e;
 
     nvinfer1::IElementWiseLayer* conv1 = convBnSiLU(network, weightMap, input, 2 * c_, 1, 1, 0, lname + ".cv1");
-    nvinfer1::Dims d = conv1->getOutput(0)->getDimensions();
 
-    nvinfer1::ISliceLayer* split1 =
-            network->addSlice(*conv1->getOutput(0), nvinfer1::Dims3{0, 0, 0},
-                              nvinfer1::Dims3{d.d[0] / 2, d.d[1], d.d[2]}, nvinfer1::Dims3{1, 1, 1});
-    nvinfer1::ISliceLayer* split2 =
-            network->addSlice(*conv1->getOutput(0), nvinfer1::Dims3{d.d[0] / 2, 0, 0},
-                              nvinfer1::Dims3{d.d[0] / 2, d.d[1], d.d[2]}, nvinfer1::Dims3{1, 1, 1});
+    nvinfer1::ISliceLayer* split1 = sliceChannels(network, weightMap, *conv1->getOutput(0), 0, c_, lname + ".split1");
+    nvinfer1::ISliceLayer* split2 = sliceChannels(network, weightMap, *conv1->getOutput(0), c_, c_, lname + ".split2");
     nvinfer1::ITensor* inputTensor0[] = {split1->getOutput(0), split2->getOutput(0)};
     nvinfer1::IConcatenationLayer* cat = network->addConcatenation(inputTensor0, 2);
     nvinfer1::ITensor* y1 = split2->getOutput(0);
@@ -174,7 +202,7 @@ nvinfer1::IElementWiseLayer* C2(nvinfer1::INetworkDefinition* network,
 }
 
 nvinfer1::IElementWiseLayer* SPPF(nvinfer1::INetworkDefinition* network,
-                                  std::map<std::string, nvinfer1::Weights> weightMap, nvinfer1::ITensor& input, int c1,
+                                  std::map<std::string, nvinfer1::Weights>& weightMap, nvinfer1::ITensor& input, int c1,
                                   int c2, int k, std::string lname) {
     int c_ = c1 / 2;
     nvinfer1::IElementWiseLayer* conv1 = convBnSiLU(network, weightMap, input, c_, 1, 1, 0, lname + ".cv1");
@@ -198,7 +226,7 @@ nvinfer1::IElementWiseLayer* SPPF(nvinfer1::INetworkDefinition* network,
     return conv2;
 }
 
-nvinfer1::IShuffleLayer* DFL(nvinfer1::INetworkDefinition* network, std::map<std::string, nvinfer1::Weights> weightMap,
+nvinfer1::IShuffleLayer* DFL(nvinfer1::INetworkDefinition* network, std::map<std::string, nvinfer1::Weights>& weightMap,
                              nvinfer1::ITensor& input, int ch, int grid, int k, int s, int p, std::string lname) {
 
     nvinfer1::IShuffleLayer* shuffle1 = network->addShuffle(input);
@@ -218,21 +246,43 @@ nvinfer1::IShuffleLayer* DFL(nvinfer1::INetworkDefinition* network, std::map<std
     return shuffle2;
 }
 
+nvinfer1::IShuffleLayer* DFLDynamic(nvinfer1::INetworkDefinition* network,
+                                    std::map<std::string, nvinfer1::Weights>& weightMap, nvinfer1::ITensor& input,
+                                    std::string lname) {
+    // [N, 64, H, W] -> [N, 16, 4, H * W], softmax over the 16 bins
+    nvinfer1::IShuffleLayer* shuffle1 = network->addShuffle(input);
+    shuffle1->setReshapeDimensions(nvinfer1::Dims4{0, 4, 16, -1});
+    shuffle1->setSecondTranspose(nvinfer1::Permutation{0, 2, 1, 3});
+    nvinfer1::ISoftMaxLayer* softmax = network->addSoftMax(*shuffle1->getOutput(0));
+    softmax->setAxes(1 << 1);
+
+    nvinfer1::Weights bias_empty{nvinfer1::DataType::kFLOAT, nullptr, 0};
+    nvinfer1::IConvolutionLayer* conv =
+            network->addConvolutionNd(*softmax->getOutput(0), 1, nvinfer1::DimsHW{1, 1}, weightMap[lname], bias_empty);
+
+    // [N, 1, 4, H * W] -> [N, 4, H, W], keeping the grid shape for the yolo layer
+    nvinfer1::IShuffleLayer* shuffle2 = network->addShuffle(*conv->getOutput(0));
+    // lname is the shared dfl weight, so the shape constants are keyed by the (unique) input tensor name
+    shuffle2->setInput(1, *shapeWithDim(network, weightMap, input, 1, 4, std::string(input.getName()) + ".reshape"));
+    return shuffle2;
+}
+
 nvinfer1::IPluginV2Layer* addYoLoLayer(nvinfer1::INetworkDefinition* network,
                                        std::vector<nvinfer1::IConcatenationLayer*> dets, const int* px_arry,
-                                       int px_arry_num, bool is_segmentation, bool is_pose) {
+                                       int px_arry_num, bool is_segmentation, bool is_pose, int num_class,
+                                       int input_w, int input_h, int max_num_output_bbox) {
     auto creator = getPluginRegistry()->getPluginCreator("YoloLayer_TRT", "1");
     const int netinfo_count = 8;  // Assuming the first 5 elements are for netinfo as per existing code.
     const int total_count = netinfo_count + px_arry_num;  // Total number of elements for netinfo and px_arry combined.
 
     std::vector<int> combinedInfo(total_count);
     // Fill in the first 5 elements as per existing netinfo.
-    combinedInfo[0] = kNumClass;
+    combinedInfo[0] = num_class;
     combinedInfo[1] = kNumberOfPoints;
     combinedInfo[2] = kConfThreshKeypoints;
-    combinedInfo[3] = kInputW;
-    combinedInfo[4] = kInputH;
-    combinedInfo[5] = kMaxNumOutputBbox;
+    combinedInfo[3] = input_w;
+    combinedInfo[4] = input_h;
+    combinedInfo[5] = max_num_output_bbox;
     combinedInfo[6] = is_segmentation;
     combinedInfo[7] = is_pose;
 
@@ -266,3 +316,49 @@ nvinfer1::IPluginV2Layer* addYoLoLayer(nvinfer1::INetworkDefinition* network,
 
     return yoloLayer;  // Return the added YOLO layer.
 }
+
+nvinfer1::IPluginV2Layer* addYoLoLayerDynamic(nvinfer1::INetworkDefinition* network,
+                                              std::vector<nvinfer1::IConcatenationLayer*> dets, const int* strides,
+                                              int strides_num, int num_class, int max_num_output_bbox) {
+    auto creator = getPluginRegistry()->getPluginCreator("YoloLayerDynamic_TRT", "1");
+    std::vector<int> combinedInfo(2 + strides_num);
+    combinedInfo[0] = num_class;
+    combinedInfo[1] = max_num_output_bbox;
+    std::copy(strides, strides + strides_num, combinedInfo.begin() + 2);
+
+    nvinfer1::PluginField pluginField;
+    pluginField.name = "combinedInfo";
+    pluginField.data = combinedInfo.data();
+    pluginField.type = nvinfer1::PluginFieldType::kINT32;
+    pluginField.length = combinedInfo.size();
+    nvinfer1::PluginFieldCollection pluginFieldCollection;
+    pluginFieldCollection.nbFields = 1;
+    pluginFieldCollection.fields = &pluginField;
+    nvinfer1::IPluginV2* pluginObject = creator->createPlugin("yololayer_dynamic", &pluginFieldCollection);
+
+    std::vector<nvinfer1::ITensor*> inputTensors;
+    for (auto det : dets) {
+        inputTensors.push_back(det->getOutput(0));
+    }
+    return network->addPluginV2(inputTensors.data(), inputTensors.size(), *pluginObject);
+}
+
+nvinfer1::ITensor* addUint8Input(nvinfer1::INetworkDefinition* network, const char* name, int input_h, int input_w) {
+    // float because TensorRT 8.4 has no uint8 inputs, the plugin reads the bytes
+    nvinfer1::ITensor* data = network->addInput(name, nvinfer1::DataType::kFLOAT, nvinfer1::Dims3{input_h, input_w, 3});
+    assert(data);
+    auto creator = getPluginRegistry()->getPluginCreator("Uint8Input_TRT", "1");
+    int shape[2] = {input_h, input_w};
+    nvinfer1::PluginField pluginField;
+    pluginField.name = "inputShape";
+    pluginField.data = shape;
+    pluginField.type = nvinfer1::PluginFieldType::kINT32;
+    pluginField.length = 2;
+    nvinfer1::PluginFieldCollection pluginFieldCollection;
+    pluginFieldCollection.nbFields = 1;
+    pluginFieldCollection.fields = &pluginField;
+    nvinfer1::IPluginV2* pluginObject = creator->createPlugin("uint8_input", &pluginFieldCollection);
+    nvinfer1::IPluginV2Layer* layer = network->addPluginV2(&data, 1, *pluginObject);
+    layer->setName("uint8_input");
+    return layer->getOutput(0);
+}
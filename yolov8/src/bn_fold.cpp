@@ -0,0 +1,17 @@
+#include "bn_fold.h"
+#include <assert.h>
+#include <math.h>
+
+void fold_batchnorm(float* weight, int weight_count, const float* gamma, const float* beta, const float* mean,
+                    const float* var, int channels, float eps, float* bias) {
+    assert(channels > 0 && weight_count % channels == 0);
+    int per_channel = weight_count / channels;
+    for (int c = 0; c < channels; c++) {
+        float scale = gamma[c] / sqrtf(var[c] + eps);
+        float* row = weight + c * per_channel;
+        for (int i = 0; i < per_channel; i++) {
+            row[i] *= scale;
+        }
+        bias[c] = beta[c] - mean[c] * scale;
+    }
+}
@@ -0,0 +1,210 @@
+#include "buffer_strategy.h"
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "cuda_utils.h"
+
+bool parse_buffer_strategy(const std::string& name, BufferStrategy& strategy) {
+    if (name == "device") {
+        strategy = BufferStrategy::kDevice;
+    } else if (name == "mapped") {
+        strategy = BufferStrategy::kMapped;
+    } else if (name == "managed") {
+        strategy = BufferStrategy::kManaged;
+    } else if (name == "host") {
+        strategy = BufferStrategy::kHost;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* buffer_strategy_name(BufferStrategy strategy) {
+    switch (strategy) {
+        case BufferStrategy::kDevice:
+            return "device";
+        case BufferStrategy::kMapped:
+            return "mapped";
+        case BufferStrategy::kManaged:
+            return "managed";
+        case BufferStrategy::kHost:
+            return "host";
+    }
+    return "unknown";
+}
+
+bool parse_buffer_args(int& argc, char** argv, BufferStrategy& strategy) {
+    int kept = 0;
+    for (int i = 0; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (i == 0 || arg.compare(0, 10, "--buffers=") != 0) {
+            argv[kept++] = argv[i];
+        } else if (!parse_buffer_strategy(arg.substr(10), strategy)) {
+            std::cerr << "invalid argument: " << arg << ", expected device, mapped, managed or host" << std::endl;
+            return false;
+        }
+    }
+    argc = kept;
+    return true;
+}
+
+// Prefetching needs concurrent managed access (not on Windows or Jetson), without it the driver migrates the pages
+// when a kernel touches them and the hints are skipped.
+static bool managed_prefetch_supported(int& device) {
+    CUDA_CHECK(cudaGetDevice(&device));
+    int concurrent = 0;
+    CUDA_CHECK(cudaDeviceGetAttribute(&concurrent, cudaDevAttrConcurrentManagedAccess, device));
+    return concurrent != 0;
+}
+
+BufferSet::BufferSet(BufferStrategy strategy) : strategy_(strategy) {}
+
+BufferSet::~BufferSet() {
+    release();
+}
+
+BufferPair BufferSet::allocate(size_t bytes, bool with_host) {
+    BufferPair pair;
+    pair.bytes = align_buffer_size(bytes);
+    void* ptr = nullptr;
+    switch (strategy_) {
+        case BufferStrategy::kDevice:
+            CUDA_CHECK(cudaMalloc(&pair.device, pair.bytes));
+            allocations_.push_back({pair.device, pair.bytes, Kind::kDeviceMemory});
+            if (with_host) {
+                CUDA_CHECK(cudaMallocHost(&pair.host, pair.bytes));
+                allocations_.push_back({pair.host, pair.bytes, Kind::kPinned});
+            }
+            return pair;
+        case BufferStrategy::kMapped:
+            CUDA_CHECK(cudaHostAlloc(&ptr, pair.bytes, cudaHostAllocMapped));
+            allocations_.push_back({ptr, pair.bytes, Kind::kMapped});
+            pair.host = ptr;
+            CUDA_CHECK(cudaHostGetDevicePointer(&pair.device, ptr, 0));
+            return pair;
+        case BufferStrategy::kManaged: {
+            CUDA_CHECK(cudaMallocManaged(&ptr, pair.bytes));
+            allocations_.push_back({ptr, pair.bytes, Kind::kManaged});
+            int device = 0;
+            if (managed_prefetch_supported(device)) {
+                // the GPU writes most of it, the CPU only reads outputs back
+                CUDA_CHECK(cudaMemAdvise(ptr, pair.bytes, cudaMemAdviseSetPreferredLocation, device));
+                CUDA_CHECK(cudaMemPrefetchAsync(ptr, pair.bytes, device));
+            }
+            pair.host = ptr;
+            pair.device = ptr;
+            return pair;
+        }
+        case BufferStrategy::kHost:
+            if (posix_memalign(&ptr, kBufferAlignment, pair.bytes) != 0) {
+                std::cerr << "allocating " << pair.bytes << " bytes failed" << std::endl;
+                assert(false);
+            }
+            memset(ptr, 0, pair.bytes);
+            allocations_.push_back({ptr, pair.bytes, Kind::kHost});
+            pair.host = ptr;
+            pair.device = ptr;
+            return pair;
+    }
+    return pair;
+}
+
+void BufferSet::release() {
+    for (auto& a : allocations_) {
+        switch (a.kind) {
+            case Kind::kDeviceMemory:
+            case Kind::kManaged:
+                CUDA_CHECK(cudaFree(a.ptr));
+                break;
+            case Kind::kPinned:
+            case Kind::kMapped:
+                CUDA_CHECK(cudaFreeHost(a.ptr));
+                break;
+            case Kind::kHost:
+                free(a.ptr);
+                break;
+        }
+    }
+    allocations_.clear();
+}
+
+size_t BufferSet::device_bytes() const {
+    size_t total = 0;
+    for (auto& a : allocations_) {
+        total += a.kind == Kind::kDeviceMemory || a.kind == Kind::kManaged ? a.bytes : 0;
+    }
+    return total;
+}
+
+size_t BufferSet::host_bytes() const {
+    size_t total = 0;
+    for (auto& a : allocations_) {
+        total += a.kind == Kind::kPinned || a.kind == Kind::kMapped || a.kind == Kind::kHost ? a.bytes : 0;
+    }
+    return total;
+}
+
+void buffer_to_device(BufferStrategy strategy, void* device, const void* host, size_t bytes, cudaStream_t stream) {
+    int gpu = 0;
+    if (strategy == BufferStrategy::kDevice) {
+        CUDA_CHECK(cudaMemcpyAsync(device, host, bytes, cudaMemcpyHostToDevice, stream));
+    } else if (strategy == BufferStrategy::kManaged && managed_prefetch_supported(gpu)) {
+        CUDA_CHECK(cudaMemPrefetchAsync(device, bytes, gpu, stream));
+    }
+}
+
+void buffer_to_host(BufferStrategy strategy, void* host, const void* device, size_t bytes, cudaStream_t stream) {
+    int gpu = 0;
+    if (strategy == BufferStrategy::kDevice) {
+        CUDA_CHECK(cudaMemcpyAsync(host, device, bytes, cudaMemcpyDeviceToHost, stream));
+    } else if (strategy == BufferStrategy::kManaged && managed_prefetch_supported(gpu)) {
+        CUDA_CHECK(cudaMemPrefetchAsync(device, bytes, cudaCpuDeviceId, stream));
+    }
+}
+
+size_t dims_volume(const nvinfer1::Dims& dims) {
+    size_t volume = 1;
+    for (int i = 0; i < dims.nbDims; i++) {
+        assert(dims.d[i] >= 0);
+        volume *= dims.d[i];
+    }
+    return volume;
+}
+
+size_t data_type_size(nvinfer1::DataType type) {
+    switch (type) {
+        case nvinfer1::DataType::kFLOAT:
+        case nvinfer1::DataType::kINT32:
+            return 4;
+        case nvinfer1::DataType::kHALF:
+            return 2;
+        case nvinfer1::DataType::kINT8:
+        case nvinfer1::DataType::kBOOL:
+            return 1;
+        default:
+            break;
+    }
+    std::cerr << "unsupported binding data type " << (int)type << std::endl;
+    assert(false);
+    return 0;
+}
+
+size_t binding_bytes(const nvinfer1::ICudaEngine& engine, int index) {
+    size_t element_size = data_type_size(engine.getBindingDataType(index));
+    if (engine.hasImplicitBatchDimension()) {
+        return engine.getMaxBatchSize() * dims_volume(engine.getBindingDimensions(index)) * element_size;
+    }
+    nvinfer1::Dims dims = engine.getBindingDimensions(index);
+    if (engine.bindingIsInput(index)) {
+        dims = engine.getProfileDimensions(index, 0, nvinfer1::OptProfileSelector::kMAX);
+    } else {
+        // -1 in an output shape is the dynamic batch, the largest one is the input's
+        for (int i = 0; i < dims.nbDims; i++) {
+            if (dims.d[i] < 0) {
+                dims.d[i] = engine.getProfileDimensions(0, 0, nvinfer1::OptProfileSelector::kMAX).d[i];
+            }
+        }
+    }
+    return dims_volume(dims) * element_size;
+}
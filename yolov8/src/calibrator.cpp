@@ -1,9 +1,11 @@
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <fstream>
 #include <opencv2/dnn/dnn.hpp>
 #include "calibrator.h"
 #include "cuda_utils.h"
+#include "int8_scales.h"
 #include "utils.h"
 
 Int8EntropyCalibrator2::Int8EntropyCalibrator2(int batchsize, int input_w, int input_h, const char* img_dir, const char* calib_table_name,
@@ -78,3 +80,41 @@ void Int8EntropyCalibrator2::writeCalibrationCache(const void* cache, size_t len
     output.write(reinterpret_cast<const char*>(cache), length);
 }
 
+bool setInt8DynamicRanges(nvinfer1::INetworkDefinition* network, const std::string& file)
+{
+    std::map<std::string, float> scales;
+    std::string error;
+    if (!readInt8Scales(file, scales, error)) {
+        std::cerr << "ignoring int8 scales, " << error << std::endl;
+        return false;
+    }
+    if (scales.empty()) {
+        return false;
+    }
+    std::cout << "loading int8 scales: " << file << " (" << scales.size() << " entries)" << std::endl;
+
+    std::vector<nvinfer1::ITensor*> tensors;
+    std::vector<Int8Target> targets;
+    for (int i = 0; i < network->getNbInputs(); i++) {
+        tensors.push_back(network->getInput(i));
+        targets.push_back(Int8Target{network->getInput(i)->getName(), network->getInput(i)->getName()});
+    }
+    for (int i = 0; i < network->getNbLayers(); i++) {
+        nvinfer1::ILayer* layer = network->getLayer(i);
+        for (int j = 0; j < layer->getNbOutputs(); j++) {
+            tensors.push_back(layer->getOutput(j));
+            targets.push_back(Int8Target{layer->getOutput(j)->getName(), j == 0 ? layer->getName() : ""});
+        }
+    }
+    std::vector<float> ranges = int8DynamicRanges(scales, targets);
+    int applied = 0;
+    for (size_t i = 0; i < tensors.size(); i++) {
+        if (ranges[i] > 0.f) {
+            tensors[i]->setDynamicRange(-ranges[i], ranges[i]);
+            applied++;
+        }
+    }
+    std::cout << "int8 dynamic ranges set on " << applied << " tensors, " << tensors.size() - applied
+              << " tensors without a scale stay in higher precision" << std::endl;
+    return true;
+}
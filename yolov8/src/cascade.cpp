@@ -0,0 +1,202 @@
+#include "cascade.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+bool parse_cascade_args(int& argc, char** argv, CascadeOptions& opts) {
+    int kept = 0;
+    for (int i = 0; i < argc; i++) {
+        std::string arg(argv[i]);
+        bool ok = true;
+        if (i == 0 || (arg.compare(0, 13, "--cls_engine=") != 0 && arg.compare(0, 10, "--cascade_") != 0)) {
+            argv[kept++] = argv[i];
+        } else if (arg.compare(0, 13, "--cls_engine=") == 0) {
+            opts.cls_engine = arg.substr(13);
+            opts.enabled = !opts.cls_engine.empty();
+            ok = opts.enabled;
+        } else if (arg.compare(0, 18, "--cascade_classes=") == 0) {
+            opts.classes.clear();
+            std::stringstream ss(arg.substr(18));
+            std::string id;
+            while (std::getline(ss, id, ',')) {
+                opts.classes.push_back(atoi(id.c_str()));
+                ok &= !id.empty() && opts.classes.back() >= 0;
+            }
+        } else if (arg.compare(0, 15, "--cascade_topk=") == 0) {
+            opts.topk = atoi(arg.substr(15).c_str());
+            ok = opts.topk > 0;
+        } else if (arg.compare(0, 18, "--cascade_wait_ms=") == 0) {
+            opts.max_wait_ms = atof(arg.substr(18).c_str());
+            ok = opts.max_wait_ms >= 0.f;
+        } else if (arg.compare(0, 18, "--cascade_context=") == 0) {
+            opts.context = atof(arg.substr(18).c_str());
+            ok = opts.context >= 0.f;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "invalid argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    argc = kept;
+    return true;
+}
+
+void crop_to_planar(const cv::Mat& img, const float* bbox, float context, float* dst, int dst_w, int dst_h) {
+    const float side = std::max(1.f, std::max(bbox[2], bbox[3]) * (1.f + context));
+    const float x0 = bbox[0] + bbox[2] * 0.5f - side * 0.5f;
+    const float y0 = bbox[1] + bbox[3] * 0.5f - side * 0.5f;
+    const float sx = side / dst_w, sy = side / dst_h;
+    const float norm = 1.f / 255.f;
+    // horizontal taps are the same for every row: byte offsets of the two source pixels and the weight of the second,
+    // sampled at pixel centers like cv::resize with INTER_LINEAR
+    std::vector<int> left(dst_w), right(dst_w);
+    std::vector<float> fx(dst_w);
+    for (int x = 0; x < dst_w; x++) {
+        float src = x0 + (x + 0.5f) * sx - 0.5f;
+        int x1 = (int)std::floor(src);
+        fx[x] = src - x1;
+        left[x] = std::min(std::max(x1, 0), img.cols - 1) * 3;
+        right[x] = std::min(std::max(x1 + 1, 0), img.cols - 1) * 3;
+    }
+    // Separable: a source row is resized horizontally once into planar RGB and kept while the output rows that blend
+    // it are written, which for the usual crop smaller than the input is several of them. Source rows y and y + 1 go
+    // to different slots.
+    std::vector<float> rows(2 * 3 * dst_w);
+    int cached[2] = {-1, -1};
+    auto resized_row = [&](int y) {
+        y = std::min(std::max(y, 0), img.rows - 1);
+        float* out = rows.data() + (y & 1) * 3 * dst_w;
+        if (cached[y & 1] != y) {
+            cached[y & 1] = y;
+            const uint8_t* p = img.ptr<uint8_t>(y);
+            for (int x = 0; x < dst_w; x++) {
+                const uint8_t* l = p + left[x];
+                const uint8_t* r = p + right[x];
+                const float w = fx[x];
+                out[x] = (l[2] + (r[2] - l[2]) * w) * norm;
+                out[dst_w + x] = (l[1] + (r[1] - l[1]) * w) * norm;
+                out[2 * dst_w + x] = (l[0] + (r[0] - l[0]) * w) * norm;
+            }
+        }
+        return (const float*)out;
+    };
+    const int plane = dst_w * dst_h;
+    for (int y = 0; y < dst_h; y++) {
+        float src = y0 + (y + 0.5f) * sy - 0.5f;
+        int y1 = (int)std::floor(src);
+        const float fy = src - y1;
+        const float* top = resized_row(y1);
+        const float* bottom = resized_row(y1 + 1);
+        for (int c = 0; c < 3; c++) {
+            const float* t = top + c * dst_w;
+            const float* b = bottom + c * dst_w;
+            float* d = dst + c * plane + y * dst_w;
+            for (int x = 0; x < dst_w; x++) {
+                d[x] = t[x] + (b[x] - t[x]) * fy;
+            }
+        }
+    }
+}
+
+CropBatcher::CropBatcher(CropClassifier& classifier, const CascadeOptions& opts)
+    : classifier_(classifier), opts_(opts) {
+    slot_seq_.reserve(classifier.max_batch());
+    slot_det_.reserve(classifier.max_batch());
+}
+
+void CropBatcher::add(long id, const cv::Mat& img, const std::vector<Detection>& dets, double now_ms) {
+    const long seq = first_seq_ + frames_.size();
+    frames_.push_back(CascadeFrame());
+    CascadeFrame& frame = frames_.back();
+    frame.id = id;
+    frame.img = img;
+    frame.dets = dets;
+    frame.labels.assign(dets.size(), std::vector<ClsLabel>());
+    stats_.frames++;
+    const cv::Size input = classifier_.input_size();
+    const int crop_size = 3 * input.width * input.height;
+    for (size_t d = 0; d < dets.size(); d++) {
+        if (!opts_.classes.empty() &&
+            std::find(opts_.classes.begin(), opts_.classes.end(), (int)dets[d].class_id) == opts_.classes.end()) {
+            continue;
+        }
+        if (slot_seq_.empty()) {
+            batch_start_ms_ = now_ms;
+        }
+        crop_to_planar(img, dets[d].bbox, opts_.context, classifier_.input() + slot_seq_.size() * crop_size,
+                       input.width, input.height);
+        slot_seq_.push_back(seq);
+        slot_det_.push_back(d);
+        frame.pending++;
+        if ((int)slot_seq_.size() == classifier_.max_batch()) {
+            run_batch();
+        }
+    }
+    poll(now_ms);
+}
+
+void CropBatcher::poll(double now_ms) {
+    if (!slot_seq_.empty() && now_ms - batch_start_ms_ >= opts_.max_wait_ms) {
+        stats_.deadline_batches++;
+        run_batch();
+    }
+}
+
+void CropBatcher::flush() {
+    if (!slot_seq_.empty()) {
+        run_batch();
+    }
+}
+
+bool CropBatcher::pop(CascadeFrame& frame) {
+    if (frames_.empty() || frames_.front().pending > 0) {
+        return false;
+    }
+    frame = std::move(frames_.front());
+    frames_.pop_front();
+    first_seq_++;
+    return true;
+}
+
+void CropBatcher::run_batch() {
+    const int n = slot_seq_.size();
+    const int num_classes = classifier_.num_classes();
+    const int k = std::min(opts_.topk, num_classes);
+    const float* logits = classifier_.classify(n);
+    for (int i = 0; i < n; i++) {
+        const float* l = logits + (size_t)i * num_classes;
+        // top-k by logit, kept sorted in a k-long list; the softmax only needs the max and the sum of exponentials
+        std::vector<ClsLabel> top;
+        top.reserve(k + 1);
+        float max_logit = l[0];
+        for (int c = 0; c < num_classes; c++) {
+            max_logit = std::max(max_logit, l[c]);
+            if ((int)top.size() < k || l[c] > top.back().prob) {
+                auto it = std::upper_bound(top.begin(), top.end(), l[c],
+                                           [](float v, const ClsLabel& label) { return v > label.prob; });
+                top.insert(it, ClsLabel{c, l[c]});
+                if ((int)top.size() > k) {
+                    top.pop_back();
+                }
+            }
+        }
+        float sum = 0.f;
+        for (int c = 0; c < num_classes; c++) {
+            sum += expf(l[c] - max_logit);
+        }
+        for (auto& label : top) {
+            label.prob = expf(label.prob - max_logit) / sum;
+        }
+        CascadeFrame& frame = frames_[slot_seq_[i] - first_seq_];
+        frame.labels[slot_det_[i]].swap(top);
+        frame.pending--;
+    }
+    stats_.batches++;
+    stats_.crops += n;
+    slot_seq_.clear();
+    slot_det_.clear();
+}
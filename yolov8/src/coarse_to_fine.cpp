@@ -0,0 +1,192 @@
+#include "coarse_to_fine.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+bool parse_coarse_to_fine_args(int& argc, char** argv, CoarseToFineOptions& opts) {
+    int kept = 0;
+    for (int i = 0; i < argc; i++) {
+        std::string arg(argv[i]);
+        bool ok = true;
+        if (i == 0 || (arg.compare(0, 14, "--fine_engine=") != 0 && arg.compare(0, 6, "--c2f_") != 0)) {
+            argv[kept++] = argv[i];
+        } else if (arg.compare(0, 14, "--fine_engine=") == 0) {
+            opts.fine_engine = arg.substr(14);
+            opts.enabled = !opts.fine_engine.empty();
+            ok = opts.enabled;
+        } else if (arg.compare(0, 15, "--c2f_low_conf=") == 0) {
+            opts.low_conf = atof(arg.substr(15).c_str());
+            ok = opts.low_conf > 0.f && opts.low_conf < 1.f;
+        } else if (arg.compare(0, 12, "--c2f_small=") == 0) {
+            opts.small_side = atof(arg.substr(12).c_str());
+            ok = opts.small_side >= 0.f;
+        } else if (arg.compare(0, 15, "--c2f_max_rois=") == 0) {
+            opts.max_rois = atoi(arg.substr(15).c_str());
+            ok = opts.max_rois > 0;
+        } else if (arg.compare(0, 11, "--c2f_zoom=") == 0) {
+            opts.roi_zoom = atof(arg.substr(11).c_str());
+            ok = opts.roi_zoom > 0.f;
+        } else if (arg.compare(0, 12, "--c2f_merge=") == 0) {
+            std::string name = arg.substr(12);
+            opts.merge = name == "nms" ? TileMerge::kNms : TileMerge::kFusion;
+            ok = name == "nms" || name == "fusion";
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "invalid argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    argc = kept;
+    return true;
+}
+
+static bool contains(const cv::Rect& r, const float* b) {
+    return b[0] >= r.x && b[1] >= r.y && b[2] <= r.x + r.width && b[3] <= r.y + r.height;
+}
+
+// Seeds tried per region, the most confident candidates not yet covered; bounds planning to O(max_rois * 64 * n).
+static const int kMaxSeeds = 64;
+
+// Candidate boxes as structure of arrays, so the containment counts over all of them vectorize.
+struct CandidateBoxes {
+    std::vector<float> x1, y1, x2, y2;
+    std::vector<int> free;  // 1 until a region contains the box
+
+    // Number of free boxes inside r; with sums, also the sums of their x1 + x2 and y1 + y2.
+    int count(const cv::Rect& r, float* sum_x, float* sum_y) const {
+        const float rx0 = r.x, ry0 = r.y, rx1 = r.x + r.width, ry1 = r.y + r.height;
+        const int n = x1.size();
+        int count = 0;
+        for (int i = 0; i < n; i++) {
+            count += free[i] & (x1[i] >= rx0) & (y1[i] >= ry0) & (x2[i] <= rx1) & (y2[i] <= ry1);
+        }
+        if (sum_x != nullptr && count > 0) {
+            float sx = 0.f, sy = 0.f;
+            for (int i = 0; i < n; i++) {
+                float in = (float)(free[i] & (x1[i] >= rx0) & (y1[i] >= ry0) & (x2[i] <= rx1) & (y2[i] <= ry1));
+                sx += in * (x1[i] + x2[i]);
+                sy += in * (y1[i] + y2[i]);
+            }
+            *sum_x = sx;
+            *sum_y = sy;
+        }
+        return count;
+    }
+};
+
+std::vector<cv::Rect> plan_rois(const std::vector<Detection>& candidates, int frame_w, int frame_h, cv::Size roi_size,
+                                int max_rois, std::vector<char>& covered) {
+    const int n = candidates.size();
+    const int roi_w = std::min(roi_size.width, frame_w), roi_h = std::min(roi_size.height, frame_h);
+    covered.assign(n, 0);
+    std::vector<cv::Rect> rois;
+    std::vector<int> order(n);
+    CandidateBoxes boxes;
+    boxes.free.assign(n, 1);
+    for (int i = 0; i < n; i++) {
+        order[i] = i;
+        boxes.x1.push_back(candidates[i].bbox[0]);
+        boxes.y1.push_back(candidates[i].bbox[1]);
+        boxes.x2.push_back(candidates[i].bbox[2]);
+        boxes.y2.push_back(candidates[i].bbox[3]);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](int a, int b) { return candidates[a].conf > candidates[b].conf; });
+    auto window = [&](float cx, float cy) {
+        int x = std::min(frame_w - roi_w, std::max(0, (int)std::lround(cx - roi_w * 0.5f)));
+        int y = std::min(frame_h - roi_h, std::max(0, (int)std::lround(cy - roi_h * 0.5f)));
+        return cv::Rect(x, y, roi_w, roi_h);
+    };
+    while ((int)rois.size() < max_rois) {
+        cv::Rect best;
+        int best_count = 0;
+        int seeds = 0;
+        for (int k = 0; k < n && seeds < kMaxSeeds; k++) {
+            int s = order[k];
+            if (!boxes.free[s] || boxes.x2[s] - boxes.x1[s] > roi_w || boxes.y2[s] - boxes.y1[s] > roi_h) {
+                continue;
+            }
+            seeds++;
+            cv::Rect win = window((boxes.x1[s] + boxes.x2[s]) * 0.5f, (boxes.y1[s] + boxes.y2[s]) * 0.5f);
+            // one mean-shift step: center the region on the candidates it already contains
+            float sx = 0.f, sy = 0.f;
+            int count = boxes.count(win, &sx, &sy);
+            cv::Rect shifted = window(sx * 0.5f / count, sy * 0.5f / count);
+            int shifted_count = boxes.count(shifted, nullptr, nullptr);
+            if (shifted_count >= count) {
+                win = shifted;
+                count = shifted_count;
+            }
+            if (count > best_count) {
+                best = win;
+                best_count = count;
+            }
+        }
+        if (best_count == 0) {
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            covered[i] |= contains(best, candidates[i].bbox);
+            boxes.free[i] = !covered[i];
+        }
+        rois.push_back(best);
+    }
+    return rois;
+}
+
+std::vector<Detection> fuse_coarse_fine(const std::vector<Detection>& coarse, const std::vector<cv::Rect>& rois,
+                                        const std::vector<std::vector<Detection>>& fine,
+                                        const CoarseToFineOptions& opts) {
+    std::vector<Detection> dets;
+    for (const auto& det : coarse) {
+        if (det.conf < opts.conf_thresh) {
+            continue;
+        }
+        // the fine pass saw this object at higher resolution and decides on it
+        bool refined = false;
+        for (const auto& roi : rois) {
+            refined |= contains(roi, det.bbox);
+        }
+        if (!refined) {
+            dets.push_back(det);
+        }
+    }
+    for (const auto& res : fine) {
+        for (const auto& det : res) {
+            if (det.conf >= opts.conf_thresh) {
+                dets.push_back(det);
+            }
+        }
+    }
+    // objects crossing a region border are seen by both passes, or by two overlapping regions
+    merge_tile_detections(dets, opts.merge, opts.merge_thresh);
+    return dets;
+}
+
+void CoarseToFine::detect(const cv::Mat& frame, RoiDetector& coarse, RoiDetector& fine, std::vector<Detection>& dets) {
+    std::vector<std::vector<Detection>> coarse_res;
+    coarse.detect(frame, std::vector<cv::Rect>{cv::Rect(0, 0, frame.cols, frame.rows)}, coarse_res);
+    std::vector<Detection> candidates;
+    for (const auto& det : coarse_res[0]) {
+        float side = std::max(det.bbox[2] - det.bbox[0], det.bbox[3] - det.bbox[1]);
+        if (det.conf < opts_.conf_thresh || side < opts_.small_side) {
+            candidates.push_back(det);
+        }
+    }
+    cv::Size input = fine.input_size();
+    cv::Size roi_size((int)std::lround(input.width * opts_.roi_zoom), (int)std::lround(input.height * opts_.roi_zoom));
+    std::vector<char> covered;
+    std::vector<cv::Rect> rois = plan_rois(candidates, frame.cols, frame.rows, roi_size, opts_.max_rois, covered);
+    std::vector<std::vector<Detection>> fine_res;
+    if (!rois.empty()) {
+        fine.detect(frame, rois, fine_res);
+    }
+    dets = fuse_coarse_fine(coarse_res[0], rois, fine_res, opts_);
+    stats_.frames++;
+    stats_.rois += rois.size();
+    stats_.candidates += candidates.size();
+    stats_.uncovered += std::count(covered.begin(), covered.end(), 0);
+}
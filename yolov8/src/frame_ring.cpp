@@ -0,0 +1,228 @@
+#include "frame_ring.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include <new>
+
+static const uint32_t kFrameRingMagic = 0x46524e47;  // "FRNG"
+
+struct FrameRingHeader {
+    std::atomic<uint32_t> magic;  // written last by the creator
+    uint32_t slot_count;
+    uint64_t slot_bytes;
+    uint64_t slot_stride;
+    alignas(64) std::atomic<uint64_t> write_pos;  // next position producers claim
+    alignas(64) std::atomic<uint64_t> read_pos;   // next position the consumer releases
+    alignas(64) std::atomic<uint32_t> publish_seq;  // futex word, bumped on every publish
+    std::atomic<uint32_t> consumer_waiting;
+    std::atomic<uint64_t> dropped;
+};
+
+static size_t page_align(size_t size) {
+    return (size + 4095) / 4096 * 4096;
+}
+
+static void futex_wait(std::atomic<uint32_t>* addr, uint32_t value, int timeout_ms) {
+    timespec ts;
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    // not FUTEX_PRIVATE_FLAG, the word is shared between processes
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT, value, &ts, nullptr, 0);
+}
+
+static void futex_wake(std::atomic<uint32_t>* addr) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+FrameRing::~FrameRing() {
+    if (base_ != nullptr) {
+        munmap(base_, size_);
+    }
+    if (owner_) {
+        shm_unlink(name_.c_str());
+    }
+}
+
+bool FrameRing::create(const std::string& name, int slot_count, size_t slot_bytes) {
+    assert(base_ == nullptr && slot_count > 0);
+    name_ = "/" + name;
+    size_t slot_stride = kFrameSlotHeaderSize + page_align(slot_bytes);
+    size_ = page_align(sizeof(FrameRingHeader)) + slot_stride * slot_count;
+
+    shm_unlink(name_.c_str());
+    int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, size_) != 0) {
+        std::cerr << "could not create shared memory " << name_ << std::endl;
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    base_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base_ == MAP_FAILED) {
+        base_ = nullptr;
+        return false;
+    }
+    owner_ = true;
+
+    header_ = new (base_) FrameRingHeader();
+    assert(header_->write_pos.is_lock_free() && header_->publish_seq.is_lock_free());
+    header_->slot_count = slot_count;
+    header_->slot_bytes = slot_bytes;
+    header_->slot_stride = slot_stride;
+    header_->write_pos.store(0);
+    header_->read_pos.store(0);
+    header_->publish_seq.store(0);
+    header_->consumer_waiting.store(0);
+    header_->dropped.store(0);
+    for (int i = 0; i < slot_count; i++) {
+        FrameSlot* slot = new (slot_at(i)) FrameSlot();
+        slot->sequence.store(i);
+    }
+    read_cursor_ = 0;
+    header_->magic.store(kFrameRingMagic, std::memory_order_release);
+    return true;
+}
+
+bool FrameRing::open(const std::string& name) {
+    assert(base_ == nullptr);
+    name_ = "/" + name;
+    int fd = shm_open(name_.c_str(), O_RDWR, 0600);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FrameRingHeader)) {
+        std::cerr << "could not open shared memory " << name_ << std::endl;
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    size_ = st.st_size;
+    base_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base_ == MAP_FAILED) {
+        base_ = nullptr;
+        return false;
+    }
+    header_ = reinterpret_cast<FrameRingHeader*>(base_);
+    if (header_->magic.load(std::memory_order_acquire) != kFrameRingMagic) {
+        std::cerr << name_ << " is not an initialized frame ring" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+FrameSlot* FrameRing::slot_at(uint64_t pos) const {
+    uint8_t* slots = reinterpret_cast<uint8_t*>(base_) + page_align(sizeof(FrameRingHeader));
+    return reinterpret_cast<FrameSlot*>(slots + (pos % header_->slot_count) * header_->slot_stride);
+}
+
+size_t FrameRing::slot_bytes() const {
+    return header_->slot_bytes;
+}
+
+uint64_t FrameRing::dropped() const {
+    return header_->dropped.load();
+}
+
+FrameSlot* FrameRing::begin_write() {
+    uint64_t pos = header_->write_pos.load(std::memory_order_relaxed);
+    while (true) {
+        FrameSlot* slot = slot_at(pos);
+        int64_t diff = (int64_t)slot->sequence.load(std::memory_order_acquire) - (int64_t)pos;
+        if (diff == 0) {
+            // free for this lap, claim it
+            if (header_->write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                return slot;
+            }
+        } else if (diff < 0) {
+            // still held by the consumer from the previous lap
+            header_->dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        } else {
+            pos = header_->write_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void FrameRing::end_write(FrameSlot* slot) {
+    slot->sequence.store(slot->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    header_->publish_seq.fetch_add(1);
+    if (header_->consumer_waiting.load()) {
+        futex_wake(&header_->publish_seq);
+    }
+}
+
+FrameSlot* FrameRing::acquire(int timeout_ms) {
+    FrameSlot* slot = slot_at(read_cursor_);
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (slot->sequence.load(std::memory_order_acquire) != read_cursor_ + 1) {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int elapsed_ms = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+        if (elapsed_ms >= timeout_ms) {
+            return nullptr;
+        }
+        // announce the wait before sampling the futex word, a publish after the sample changes the word
+        header_->consumer_waiting.store(1);
+        uint32_t seq = header_->publish_seq.load();
+        if (slot->sequence.load(std::memory_order_acquire) != read_cursor_ + 1) {
+            futex_wait(&header_->publish_seq, seq, timeout_ms - elapsed_ms);
+        }
+        header_->consumer_waiting.store(0);
+    }
+    read_cursor_++;
+    return slot;
+}
+
+void FrameRing::release(FrameSlot* slot) {
+    uint64_t pos = header_->read_pos.load(std::memory_order_relaxed);
+    assert(slot == slot_at(pos) && pos < read_cursor_);
+    slot->sequence.store(pos + header_->slot_count, std::memory_order_release);
+    header_->read_pos.store(pos + 1, std::memory_order_relaxed);
+}
+
+uint32_t frame_rows(const FrameInfo& info) {
+    // the UV plane has a row for every two rows of Y, the last one also for an odd last row
+    return info.format == FrameFormat::kNV12 ? info.height + (info.height + 1) / 2 : info.height;
+}
+
+uint32_t nv12_height(uint32_t rows) {
+    // h + (h + 1) / 2 rows is 3k for h = 2k and 3k + 2 for h = 2k + 1, 2 * rows / 3 gives h back in both cases
+    return rows * 2 / 3;
+}
+
+bool check_frame_info(const FrameInfo& info, size_t slot_bytes, uint64_t max_pixels, std::string& error) {
+    if (info.format != FrameFormat::kBGR && info.format != FrameFormat::kNV12) {
+        error = "unknown format " + std::to_string((uint32_t)info.format);
+        return false;
+    }
+    uint64_t pixels = (uint64_t)info.width * info.height;
+    if (pixels == 0 || pixels > max_pixels) {
+        error = std::to_string(info.width) + "x" + std::to_string(info.height) + " is empty or over " +
+                std::to_string(max_pixels) + " pixels";
+        return false;
+    }
+    // a UV row holds a U, V pair for every two pixels, also for an odd last one
+    uint64_t row_bytes =
+            info.format == FrameFormat::kNV12 ? ((uint64_t)info.width + 1) / 2 * 2 : (uint64_t)info.width * 3;
+    if (info.stride < row_bytes) {
+        error = "stride " + std::to_string(info.stride) + " shorter than a row of " + std::to_string(row_bytes);
+        return false;
+    }
+    uint64_t bytes = (uint64_t)info.stride * frame_rows(info);
+    if (bytes > slot_bytes || info.size > slot_bytes) {
+        error = "frame of " + std::to_string(std::max<uint64_t>(bytes, info.size)) + " bytes over a slot of " +
+                std::to_string(slot_bytes);
+        return false;
+    }
+    return true;
+}
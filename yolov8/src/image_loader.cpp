@@ -0,0 +1,97 @@
+#include "image_loader.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+bool jpeg_size(const uint8_t* data, size_t size, int& width, int& height) {
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+        return false;
+    }
+    size_t i = 2;
+    while (i + 4 <= size) {
+        if (data[i] != 0xFF) {
+            return false;
+        }
+        uint8_t marker = data[i + 1];
+        if (marker == 0xFF) {
+            // fill byte before a marker
+            i++;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            // markers without a segment
+            i += 2;
+            continue;
+        }
+        if (marker == 0xD9 || marker == 0xDA) {
+            // the image or its entropy-coded data starts before any frame header
+            return false;
+        }
+        size_t length = (data[i + 2] << 8) | data[i + 3];
+        // SOF0..SOF15, except DHT (C4), JPG (C8) and DAC (CC): length, precision, height, width
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (length < 7 || i + 9 > size) {
+                return false;
+            }
+            height = (data[i + 5] << 8) | data[i + 6];
+            width = (data[i + 7] << 8) | data[i + 8];
+            return width > 0 && height > 0;
+        }
+        i += 2 + length;
+    }
+    return false;
+}
+
+static int reduced_side(int side, int factor) {
+    return (side + factor - 1) / factor;
+}
+
+int pick_reduce_factor(int width, int height, int input_w, int input_h) {
+    for (int factor = 8; factor > 1; factor /= 2) {
+        int w = reduced_side(width, factor), h = reduced_side(height, factor);
+        // the letterbox scale min(input_w / w, input_h / h) is at most 1 as long as one side still spans the input
+        if ((w >= input_w || h >= input_h) && (h >= input_w || w >= input_h)) {
+            return factor;
+        }
+    }
+    return 1;
+}
+
+bool decode_image(const std::vector<uint8_t>& encoded, int input_w, int input_h, DecodedImage& out) {
+    int width = 0, height = 0;
+    int factor = 1;
+    if (input_w > 0 && jpeg_size(encoded.data(), encoded.size(), width, height)) {
+        factor = pick_reduce_factor(width, height, input_w, input_h);
+    }
+    static const int flags[] = {cv::IMREAD_COLOR, cv::IMREAD_REDUCED_COLOR_2, cv::IMREAD_REDUCED_COLOR_4,
+                                cv::IMREAD_REDUCED_COLOR_8};
+    out.img = encoded.empty() ? cv::Mat() : cv::imdecode(encoded, flags[factor == 8 ? 3 : factor / 2]);
+    if (out.img.empty()) {
+        return false;
+    }
+    out.scale = factor;
+    if (factor == 1) {
+        out.original_size = out.img.size();
+    } else if (out.img.cols == reduced_side(height, factor) && out.img.rows == reduced_side(width, factor) &&
+               out.img.cols != out.img.rows) {
+        // turned by a quarter by the EXIF orientation
+        out.original_size = cv::Size(height, width);
+    } else {
+        out.original_size = cv::Size(width, height);
+    }
+    return true;
+}
+
+bool load_image(const std::string& path, int input_w, int input_h, DecodedImage& out) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> encoded((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return decode_image(encoded, input_w, input_h, out);
+}
+
+cv::Rect to_original_rect(const cv::Rect& r, const DecodedImage& image) {
+    int x = std::min(r.x * image.scale, image.original_size.width);
+    int y = std::min(r.y * image.scale, image.original_size.height);
+    int right = std::min((r.x + r.width) * image.scale, image.original_size.width);
+    int bottom = std::min((r.y + r.height) * image.scale, image.original_size.height);
+    return cv::Rect(x, y, right - x, bottom - y);
+}
@@ -0,0 +1,193 @@
+#include "inference_server.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "config.h"
+#include "image_loader.h"
+
+static bool read_all(int fd, void* buf, size_t size) {
+    char* p = static_cast<char*>(buf);
+    while (size > 0) {
+        ssize_t n = read(fd, p, size);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool write_all(int fd, const void* buf, size_t size) {
+    const char* p = static_cast<const char*>(buf);
+    while (size > 0) {
+        // MSG_NOSIGNAL, a client hanging up must not kill the server with SIGPIPE
+        ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Connections being served, bounded by run_inference_server.
+struct ConnectionSlots {
+    std::mutex mutex;
+    std::condition_variable freed;
+    int active = 0;
+};
+
+static void serve_client(int fd, BatchScheduler* scheduler, int default_deadline_ms, ResultCache* cache,
+                         cv::Size decode_size) {
+    const uint32_t invalid = 0xffffffff;
+    uint32_t header[2];
+    std::vector<uint8_t> encoded;
+    while (read_all(fd, header, sizeof(header))) {
+        if (header[1] > kMaxRequestBytes) {
+            // the rest of the stream can not be trusted to be in step, so the connection is dropped
+            write_all(fd, &invalid, sizeof(invalid));
+            break;
+        }
+        encoded.resize(header[1]);
+        if (!read_all(fd, encoded.data(), encoded.size())) {
+            break;
+        }
+        std::vector<Detection> result;
+        uint64_t key = 0;
+        bool hit = false;
+        if (cache != nullptr && cache->mode() == CacheKeyMode::kEncoded) {
+            key = cache->encoded_key(encoded.data(), encoded.size());
+            hit = cache->lookup(key, result);
+        }
+        if (!hit) {
+            auto job = std::make_shared<InferJob>();
+            DecodedImage decoded;
+            // the preprocessing buffers hold kMaxInputImageSize pixels
+            if (!decode_image(encoded, decode_size.width, decode_size.height, decoded) ||
+                (size_t)decoded.img.cols * decoded.img.rows > (size_t)kMaxInputImageSize) {
+                if (!write_all(fd, &invalid, sizeof(invalid))) {
+                    break;
+                }
+                continue;
+            }
+            job->img = decoded.img;
+            if (cache != nullptr && cache->mode() == CacheKeyMode::kPixels) {
+                key = cache->pixel_key(job->img);
+                hit = cache->lookup(key, result);
+            }
+            if (!hit) {
+                // clamped before it becomes an int, 0xffffffff would wrap to a deadline already passed
+                uint32_t requested_ms = std::min(header[0], kMaxDeadlineMs);
+                int deadline_ms = requested_ms > 0 ? (int)requested_ms : default_deadline_ms;
+                job->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(deadline_ms);
+                scheduler->submit(job).wait();
+                result = job->result;
+                if (decoded.scale > 1) {
+                    for (auto& det : result) {
+                        cv::Rect box(det.bbox[0], det.bbox[1], det.bbox[2], det.bbox[3]);
+                        cv::Rect r = to_original_rect(box, decoded);
+                        det.bbox[0] = r.x;
+                        det.bbox[1] = r.y;
+                        det.bbox[2] = r.width;
+                        det.bbox[3] = r.height;
+                    }
+                }
+                if (cache != nullptr) {
+                    cache->insert(key, result);
+                }
+            }
+        }
+
+        std::vector<ServerDetection> dets;
+        for (auto& det : result) {
+            ServerDetection d;
+            memcpy(d.bbox, det.bbox, sizeof(d.bbox));
+            d.conf = det.conf;
+            d.class_id = det.class_id;
+            dets.push_back(d);
+        }
+        uint32_t count = dets.size();
+        if (!write_all(fd, &count, sizeof(count)) ||
+            !write_all(fd, dets.data(), dets.size() * sizeof(ServerDetection))) {
+            break;
+        }
+    }
+    close(fd);
+}
+
+int run_inference_server(const std::string& socket_path, BatchScheduler& scheduler, int default_deadline_ms,
+                         ResultCache* cache, cv::Size decode_size, int max_connections) {
+    int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (server_fd < 0 || socket_path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "could not create socket " << socket_path << std::endl;
+        return -1;
+    }
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(socket_path.c_str());
+    if (bind(server_fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(server_fd, 64) < 0) {
+        std::cerr << "could not listen on " << socket_path << std::endl;
+        close(server_fd);
+        return -1;
+    }
+    std::cout << "serving on " << socket_path << std::endl;
+    auto slots = std::make_shared<ConnectionSlots>();
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(slots->mutex);
+            slots->freed.wait(lock, [&] { return slots->active < max_connections; });
+        }
+        int fd = accept(server_fd, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(slots->mutex);
+            slots->active++;
+        }
+        std::thread([=, &scheduler] {
+            serve_client(fd, &scheduler, default_deadline_ms, cache, decode_size);
+            std::lock_guard<std::mutex> lock(slots->mutex);
+            slots->active--;
+            slots->freed.notify_one();
+        }).detach();
+    }
+    return 0;
+}
+
+int connect_inference_server(const std::string& socket_path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+bool send_inference_request(int fd, const std::vector<uint8_t>& image, uint32_t deadline_ms) {
+    uint32_t header[2] = {deadline_ms, (uint32_t)image.size()};
+    return write_all(fd, header, sizeof(header)) && write_all(fd, image.data(), image.size());
+}
+
+bool read_inference_response(int fd, std::vector<ServerDetection>& dets) {
+    uint32_t count = 0;
+    dets.clear();
+    if (!read_all(fd, &count, sizeof(count)) || count == 0xffffffff) {
+        return false;
+    }
+    dets.resize(count);
+    return read_all(fd, dets.data(), count * sizeof(ServerDetection));
+}
@@ -0,0 +1,90 @@
+#include "int8_scales.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <cstring>
+#include <fstream>
+
+static std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+bool readInt8Scales(const std::string& file, std::map<std::string, float>& scales, std::string& error) {
+    scales.clear();
+    std::ifstream input(file);
+    if (!input.good()) {
+        return true;
+    }
+    std::string line;
+    bool calib_table = false;
+    for (int line_number = 1; std::getline(input, line); line_number++) {
+        line = trim(line);
+        if (line_number == 1 && line.compare(0, 4, "TRT-") == 0) {
+            calib_table = true;
+            continue;
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        auto fail = [&](const char* what) {
+            error = file + ":" + std::to_string(line_number) + ": " + what + ": " + line;
+            scales.clear();
+            return false;
+        };
+        size_t split = line.find_last_of(" \t");
+        if (split == std::string::npos) {
+            return fail("no scale");
+        }
+        std::string name = trim(line.substr(0, split));
+        std::string value = line.substr(split + 1);
+        if (!name.empty() && name.back() == ':') {
+            name.pop_back();
+        }
+        if (name.empty()) {
+            return fail("no name");
+        }
+        char* end = nullptr;
+        float scale = 0.f;
+        if (calib_table) {
+            unsigned long bits = strtoul(value.c_str(), &end, 16);
+            if (end == value.c_str() || *end != '\0' || value.size() > 8) {
+                return fail("bad hex scale");
+            }
+            uint32_t bits32 = (uint32_t)bits;
+            memcpy(&scale, &bits32, sizeof(scale));
+        } else {
+            scale = strtof(value.c_str(), &end);
+            if (end == value.c_str() || *end != '\0') {
+                return fail("bad scale");
+            }
+        }
+        if (scale == 0.f) {
+            continue;  // a constant zero tensor, left in higher precision
+        }
+        if (!(scale > 0.f) || isinf(scale)) {
+            return fail("scale not positive and finite");
+        }
+        scales[name] = scale;
+    }
+    return true;
+}
+
+std::vector<float> int8DynamicRanges(const std::map<std::string, float>& scales,
+                                     const std::vector<Int8Target>& targets) {
+    std::vector<float> ranges(targets.size(), 0.f);
+    for (size_t i = 0; i < targets.size(); i++) {
+        auto it = scales.find(targets[i].tensor_name);
+        if (it == scales.end() && !targets[i].layer_name.empty()) {
+            it = scales.find(targets[i].layer_name);
+        }
+        if (it != scales.end()) {
+            ranges[i] = 127.f * it->second;
+        }
+    }
+    return ranges;
+}
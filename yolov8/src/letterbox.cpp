@@ -0,0 +1,33 @@
+#include "letterbox.h"
+#include <algorithm>
+#include <cmath>
+
+static int align_up(int value, int stride) {
+    return (value + stride - 1) / stride * stride;
+}
+
+LetterboxShape rect_letterbox_shape(int img_w, int img_h, int max_w, int max_h, int stride) {
+    float r = std::min(max_w / (float)img_w, max_h / (float)img_h);
+    // round up, so the scaled image fits and is not shrunk below the scale of the fixed input; the tolerance keeps
+    // exact fits such as 1280x720 -> 640x360 from rounding up to the next stride
+    int w = std::min(align_up((int)std::ceil(img_w * r - 1e-3f), stride), max_w);
+    int h = std::min(align_up((int)std::ceil(img_h * r - 1e-3f), stride), max_h);
+    return LetterboxShape{std::max(w, stride), std::max(h, stride)};
+}
+
+LetterboxShape rect_letterbox_batch_shape(const std::vector<LetterboxShape>& img_sizes, int max_w, int max_h,
+                                          int stride) {
+    LetterboxShape shape{stride, stride};
+    for (const LetterboxShape& img : img_sizes) {
+        LetterboxShape s = rect_letterbox_shape(img.w, img.h, max_w, max_h, stride);
+        shape.w = std::max(shape.w, s.w);
+        shape.h = std::max(shape.h, s.h);
+    }
+    return shape;
+}
+
+float letterbox_padding_ratio(int img_w, int img_h, int shape_w, int shape_h) {
+    float r = std::min(shape_w / (float)img_w, shape_h / (float)img_h);
+    float content = (img_w * r) * (img_h * r);
+    return std::max(0.0f, 1.0f - content / ((float)shape_w * shape_h));
+}
@@ -87,16 +87,48 @@ static nvinfer1::IShuffleLayer* cv4_conv_combined(nvinfer1::INetworkDefinition*
     return cv2_shuffle;
 }
 
+static nvinfer1::IConcatenationLayer* detectHeadDynamic(nvinfer1::INetworkDefinition* network,
+                                                        std::map<std::string, nvinfer1::Weights>& weightMap,
+                                                        nvinfer1::ITensor& input, int base_in_channel,
+                                                        int base_out_channel, int num_class, const std::string& lname) {
+    nvinfer1::IElementWiseLayer* cv2_0 =
+            convBnSiLU(network, weightMap, input, base_in_channel, 3, 1, 1, "model.22.cv2." + lname + ".0");
+    nvinfer1::IElementWiseLayer* cv2_1 = convBnSiLU(network, weightMap, *cv2_0->getOutput(0), base_in_channel, 3, 1,
+                                                    1, "model.22.cv2." + lname + ".1");
+    nvinfer1::IConvolutionLayer* cv2_2 = network->addConvolutionNd(
+            *cv2_1->getOutput(0), 64, nvinfer1::DimsHW{1, 1}, weightMap["model.22.cv2." + lname + ".2.weight"],
+            weightMap["model.22.cv2." + lname + ".2.bias"]);
+    nvinfer1::IElementWiseLayer* cv3_0 =
+            convBnSiLU(network, weightMap, input, base_out_channel, 3, 1, 1, "model.22.cv3." + lname + ".0");
+    nvinfer1::IElementWiseLayer* cv3_1 = convBnSiLU(network, weightMap, *cv3_0->getOutput(0), base_out_channel, 3, 1,
+                                                    1, "model.22.cv3." + lname + ".1");
+    nvinfer1::IConvolutionLayer* cv3_2 = network->addConvolutionNd(
+            *cv3_1->getOutput(0), num_class, nvinfer1::DimsHW{1, 1}, weightMap["model.22.cv3." + lname + ".2.weight"],
+            weightMap["model.22.cv3." + lname + ".2.bias"]);
+
+    // The box branch goes through DFL before the concat, the grid is kept as H x W so the plugin can read it
+    nvinfer1::IShuffleLayer* dfl = DFLDynamic(network, weightMap, *cv2_2->getOutput(0), "model.22.dfl.conv.weight");
+    nvinfer1::ITensor* inputTensors[] = {dfl->getOutput(0), cv3_2->getOutput(0)};
+    nvinfer1::IConcatenationLayer* cat = network->addConcatenation(inputTensors, 2);
+    cat->setAxis(1);
+    return cat;
+}
+
 nvinfer1::IHostMemory* buildEngineYolov8Det(nvinfer1::IBuilder* builder, nvinfer1::IBuilderConfig* config,
                                             nvinfer1::DataType dt, const std::string& wts_path, float& gd, float& gw,
-                                            int& max_channels) {
+                                            int& max_channels, const RuntimeConfig& cfg) {
     std::map<std::string, nvinfer1::Weights> weightMap = loadWeights(wts_path);
     nvinfer1::INetworkDefinition* network = builder->createNetworkV2(0U);
 
     /*******************************************************************************************************
     ******************************************  YOLOV8 INPUT  **********************************************
     *******************************************************************************************************/
-    nvinfer1::ITensor* data = network->addInput(kInputTensorName, dt, nvinfer1::Dims3{3, kInputH, kInputW});
+    nvinfer1::ITensor* data = nullptr;
+    if (cfg.uint8_input) {
+        data = addUint8Input(network, kInputTensorName, cfg.input_h, cfg.input_w);
+    } else {
+        data = network->addInput(kInputTensorName, dt, nvinfer1::Dims3{3, cfg.input_h, cfg.input_w});
+    }
     assert(data);
 
     /*******************************************************************************************************
@@ -174,7 +206,7 @@ nvinfer1::IHostMemory* buildEngineYolov8Det(nvinfer1::IBuilder* builder, nvinfer
     *********************************************  YOLOV8 OUTPUT  ******************************************
     *******************************************************************************************************/
     int base_in_channel = (gw == 1.25) ? 80 : 64;
-    int base_out_channel = (gw == 0.25) ? std::max(64, std::min(kNumClass, 100)) : get_width(256, gw, max_channels);
+    int base_out_channel = (gw == 0.25) ? std::max(64, std::min(cfg.num_class, 100)) : get_width(256, gw, max_channels);
 
     // output0
     nvinfer1::IElementWiseLayer* conv22_cv2_0_0 =
@@ -191,7 +223,7 @@ nvinfer1::IHostMemory* buildEngineYolov8Det(nvinfer1::IBuilder* builder, nvinfer
     nvinfer1::IElementWiseLayer* conv22_cv3_0_1 = convBnSiLU(network, weightMap, *conv22_cv3_0_0->getOutput(0),
                                                              base_out_channel, 3, 1, 1, "model.22.cv3.0.1");
     nvinfer1::IConvolutionLayer* conv22_cv3_0_2 =
-            network->addConvolutionNd(*conv22_cv3_0_1->getOutput(0), kNumClass, nvinfer1::DimsHW{1, 1},
+            network->addConvolutionNd(*conv22_cv3_0_1->getOutput(0), cfg.num_class, nvinfer1::DimsHW{1, 1},
                                       weightMap["model.22.cv3.0.2.weight"], weightMap["model.22.cv3.0.2.bias"]);
     conv22_cv3_0_2->setStride(nvinfer1::DimsHW{1, 1});
     conv22_cv3_0_2->setPadding(nvinfer1::DimsHW{0, 0});
@@ -213,7 +245,7 @@ nvinfer1::IHostMemory* buildEngineYolov8Det(nvinfer1::IBuilder* builder, nvinfer
     nvinfer1::IElementWiseLayer* conv22_cv3_1_1 = convBnSiLU(network, weightMap, *conv22_cv3_1_0->getOutput(0),
                                                              base_out_channel, 3, 1, 1, "model.22.cv3.1.1");
     nvinfer1::IConvolutionLayer* conv22_cv3_1_2 =
-            network->addConvolutionNd(*conv22_cv3_1_1->getOutput(0), kNumClass, nvinfer1::DimsHW{1, 1},
+            network->addConvolutionNd(*conv22_cv3_1_1->getOutput(0), cfg.num_class, nvinfer1::DimsHW{1, 1},
                                       weightMap["model.22.cv3.1.2.weight"], weightMap["model.22.cv3.1.2.bias"]);
     conv22_cv3_1_2->setStrideNd(nvinfer1::DimsHW{1, 1});
     conv22_cv3_1_2->setPaddingNd(nvinfer1::DimsHW{0, 0});
@@ -233,7 +265,7 @@ nvinfer1::IHostMemory* buildEngineYolov8Det(nvinfer1::IBuilder* builder, nvinfer
     nvinfer1::IElementWiseLayer* conv22_cv3_2_1 = convBnSiLU(network, weightMap, *conv22_cv3_2_0->getOutput(0),
                                                              base_out_channel, 3, 1, 1, "model.22.cv3.2.1");
     nvinfer1::IConvolutionLayer* conv22_cv3_2_2 =
-            network->addConvolution(*conv22_cv3_2_1->getOutput(0), kNumClass, nvinfer1::DimsHW{1, 1},
+            network->addConvolution(*conv22_cv3_2_1->getOutput(0), cfg.num_class, nvinfer1::DimsHW{1, 1},
                                     weightMap["model.22.cv3.2.2.weight"], weightMap["model.22.cv3.2.2.bias"]);
     nvinfer1::ITensor* inputTensor22_2[] = {conv22_cv2_2_2->getOutput(0), conv22_cv3_2_2->getOutput(0)};
     nvinfer1::IConcatenationLayer* cat22_2 = network->addConcatenation(inputTensor22_2, 2);
@@ -244,70 +276,225 @@ nvinfer1::IHostMemory* buildEngineYolov8Det(nvinfer1::IBuilder* builder, nvinfer
 
     nvinfer1::IElementWiseLayer* conv_layers[] = {conv3, conv5, conv7};
     int strides[sizeof(conv_layers) / sizeof(conv_layers[0])];
-    calculateStrides(conv_layers, sizeof(conv_layers) / sizeof(conv_layers[0]), kInputH, strides);
+    calculateStrides(conv_layers, sizeof(conv_layers) / sizeof(conv_layers[0]), cfg.input_h, strides);
     int stridesLength = sizeof(strides) / sizeof(int);
 
+    int grid0 = (cfg.input_h / strides[0]) * (cfg.input_w / strides[0]);
+    int grid1 = (cfg.input_h / strides[1]) * (cfg.input_w / strides[1]);
+    int grid2 = (cfg.input_h / strides[2]) * (cfg.input_w / strides[2]);
+
     nvinfer1::IShuffleLayer* shuffle22_0 = network->addShuffle(*cat22_0->getOutput(0));
-    shuffle22_0->setReshapeDimensions(nvinfer1::Dims2{64 + kNumClass, (kInputH / strides[0]) * (kInputW / strides[0])});
-    nvinfer1::ISliceLayer* split22_0_0 = network->addSlice(
-            *shuffle22_0->getOutput(0), nvinfer1::Dims2{0, 0},
-            nvinfer1::Dims2{64, (kInputH / strides[0]) * (kInputW / strides[0])}, nvinfer1::Dims2{1, 1});
-    nvinfer1::ISliceLayer* split22_0_1 = network->addSlice(
-            *shuffle22_0->getOutput(0), nvinfer1::Dims2{64, 0},
-            nvinfer1::Dims2{kNumClass, (kInputH / strides[0]) * (kInputW / strides[0])}, nvinfer1::Dims2{1, 1});
+    shuffle22_0->setReshapeDimensions(nvinfer1::Dims2{64 + cfg.num_class, grid0});
+    nvinfer1::ISliceLayer* split22_0_0 = network->addSlice(*shuffle22_0->getOutput(0), nvinfer1::Dims2{0, 0},
+                                                           nvinfer1::Dims2{64, grid0}, nvinfer1::Dims2{1, 1});
+    nvinfer1::ISliceLayer* split22_0_1 =
+            network->addSlice(*shuffle22_0->getOutput(0), nvinfer1::Dims2{64, 0},
+                              nvinfer1::Dims2{cfg.num_class, grid0}, nvinfer1::Dims2{1, 1});
     nvinfer1::IShuffleLayer* dfl22_0 =
-            DFL(network, weightMap, *split22_0_0->getOutput(0), 4, (kInputH / strides[0]) * (kInputW / strides[0]), 1,
-                1, 0, "model.22.dfl.conv.weight");
+            DFL(network, weightMap, *split22_0_0->getOutput(0), 4, grid0, 1, 1, 0, "model.22.dfl.conv.weight");
     nvinfer1::ITensor* inputTensor22_dfl_0[] = {dfl22_0->getOutput(0), split22_0_1->getOutput(0)};
     nvinfer1::IConcatenationLayer* cat22_dfl_0 = network->addConcatenation(inputTensor22_dfl_0, 2);
 
     nvinfer1::IShuffleLayer* shuffle22_1 = network->addShuffle(*cat22_1->getOutput(0));
-    shuffle22_1->setReshapeDimensions(nvinfer1::Dims2{64 + kNumClass, (kInputH / strides[1]) * (kInputW / strides[1])});
-    nvinfer1::ISliceLayer* split22_1_0 = network->addSlice(
-            *shuffle22_1->getOutput(0), nvinfer1::Dims2{0, 0},
-            nvinfer1::Dims2{64, (kInputH / strides[1]) * (kInputW / strides[1])}, nvinfer1::Dims2{1, 1});
-    nvinfer1::ISliceLayer* split22_1_1 = network->addSlice(
-            *shuffle22_1->getOutput(0), nvinfer1::Dims2{64, 0},
-            nvinfer1::Dims2{kNumClass, (kInputH / strides[1]) * (kInputW / strides[1])}, nvinfer1::Dims2{1, 1});
+    shuffle22_1->setReshapeDimensions(nvinfer1::Dims2{64 + cfg.num_class, grid1});
+    nvinfer1::ISliceLayer* split22_1_0 = network->addSlice(*shuffle22_1->getOutput(0), nvinfer1::Dims2{0, 0},
+                                                           nvinfer1::Dims2{64, grid1}, nvinfer1::Dims2{1, 1});
+    nvinfer1::ISliceLayer* split22_1_1 =
+            network->addSlice(*shuffle22_1->getOutput(0), nvinfer1::Dims2{64, 0},
+                              nvinfer1::Dims2{cfg.num_class, grid1}, nvinfer1::Dims2{1, 1});
     nvinfer1::IShuffleLayer* dfl22_1 =
-            DFL(network, weightMap, *split22_1_0->getOutput(0), 4, (kInputH / strides[1]) * (kInputW / strides[1]), 1,
-                1, 0, "model.22.dfl.conv.weight");
+            DFL(network, weightMap, *split22_1_0->getOutput(0), 4, grid1, 1, 1, 0, "model.22.dfl.conv.weight");
     nvinfer1::ITensor* inputTensor22_dfl_1[] = {dfl22_1->getOutput(0), split22_1_1->getOutput(0)};
     nvinfer1::IConcatenationLayer* cat22_dfl_1 = network->addConcatenation(inputTensor22_dfl_1, 2);
 
     nvinfer1::IShuffleLayer* shuffle22_2 = network->addShuffle(*cat22_2->getOutput(0));
-    shuffle22_2->setReshapeDimensions(nvinfer1::Dims2{64 + kNumClass, (kInputH / strides[2]) * (kInputW / strides[2])});
-    nvinfer1::ISliceLayer* split22_2_0 = network->addSlice(
-            *shuffle22_2->getOutput(0), nvinfer1::Dims2{0, 0},
-            nvinfer1::Dims2{64, (kInputH / strides[2]) * (kInputW / strides[2])}, nvinfer1::Dims2{1, 1});
-    nvinfer1::ISliceLayer* split22_2_1 = network->addSlice(
-            *shuffle22_2->getOutput(0), nvinfer1::Dims2{64, 0},
-            nvinfer1::Dims2{kNumClass, (kInputH / strides[2]) * (kInputW / strides[2])}, nvinfer1::Dims2{1, 1});
+    shuffle22_2->setReshapeDimensions(nvinfer1::Dims2{64 + cfg.num_class, grid2});
+    nvinfer1::ISliceLayer* split22_2_0 = network->addSlice(*shuffle22_2->getOutput(0), nvinfer1::Dims2{0, 0},
+                                                           nvinfer1::Dims2{64, grid2}, nvinfer1::Dims2{1, 1});
+    nvinfer1::ISliceLayer* split22_2_1 =
+            network->addSlice(*shuffle22_2->getOutput(0), nvinfer1::Dims2{64, 0},
+                              nvinfer1::Dims2{cfg.num_class, grid2}, nvinfer1::Dims2{1, 1});
     nvinfer1::IShuffleLayer* dfl22_2 =
-            DFL(network, weightMap, *split22_2_0->getOutput(0), 4, (kInputH / strides[2]) * (kInputW / strides[2]), 1,
-                1, 0, "model.22.dfl.conv.weight");
+            DFL(network, weightMap, *split22_2_0->getOutput(0), 4, grid2, 1, 1, 0, "model.22.dfl.conv.weight");
     nvinfer1::ITensor* inputTensor22_dfl_2[] = {dfl22_2->getOutput(0), split22_2_1->getOutput(0)};
     nvinfer1::IConcatenationLayer* cat22_dfl_2 = network->addConcatenation(inputTensor22_dfl_2, 2);
 
     nvinfer1::IPluginV2Layer* yolo =
             addYoLoLayer(network, std::vector<nvinfer1::IConcatenationLayer*>{cat22_dfl_0, cat22_dfl_1, cat22_dfl_2},
-                         strides, stridesLength, false, false);
+                         strides, stridesLength, false, false, cfg.num_class, cfg.input_w, cfg.input_h,
+                         cfg.max_num_output_bbox);
 
     yolo->getOutput(0)->setName(kOutputTensorName);
     network->markOutput(*yolo->getOutput(0));
 
-    builder->setMaxBatchSize(kBatchSize);
+    builder->setMaxBatchSize(cfg.batch_size);
     config->setMaxWorkspaceSize(16 * (1 << 20));
 
-#if defined(USE_FP16)
-    config->setFlag(nvinfer1::BuilderFlag::kFP16);
-#elif defined(USE_INT8)
-    std::cout << "Your platform support int8: " << (builder->platformHasFastInt8() ? "true" : "false") << std::endl;
-    assert(builder->platformHasFastInt8());
-    config->setFlag(nvinfer1::BuilderFlag::kINT8);
-    auto* calibrator = new Int8EntropyCalibrator2(1, kInputW, kInputH, kInputQuantizationFolder, "int8calib.table",
-                                                  kInputTensorName);
-    config->setInt8Calibrator(calibrator);
+    if (cfg.precision == "fp16") {
+        config->setFlag(nvinfer1::BuilderFlag::kFP16);
+    } else if (cfg.precision == "int8") {
+        std::cout << "Your platform support int8: " << (builder->platformHasFastInt8() ? "true" : "false") << std::endl;
+        assert(builder->platformHasFastInt8());
+        config->setFlag(nvinfer1::BuilderFlag::kINT8);
+        if (!setInt8DynamicRanges(network, kInputQuantizationScales)) {
+            auto* calibrator = new Int8EntropyCalibrator2(1, cfg.input_w, cfg.input_h, kInputQuantizationFolder,
+                                                          "int8calib.table", kInputTensorName);
+            config->setInt8Calibrator(calibrator);
+        }
+    }
+#if defined(USE_SPARSE_WEIGHTS)
+    config->setFlag(nvinfer1::BuilderFlag::kSPARSE_WEIGHTS);
+#endif
+
+    std::cout << "Building engine, please wait for a while..." << std::endl;
+    nvinfer1::IHostMemory* serialized_model = builder->buildSerializedNetwork(*network, *config);
+    std::cout << "Build engine successfully!" << std::endl;
+
+    delete network;
+
+    for (auto& mem : weightMap) {
+        free((void*)(mem.second.values));
+    }
+    return serialized_model;
+}
+
+nvinfer1::IHostMemory* buildEngineYolov8DetDynamic(nvinfer1::IBuilder* builder, nvinfer1::IBuilderConfig* config,
+                                                   nvinfer1::DataType dt, const std::string& wts_path, float& gd,
+                                                   float& gw, int& max_channels, const RuntimeConfig& cfg) {
+    std::map<std::string, nvinfer1::Weights> weightMap = loadWeights(wts_path);
+    nvinfer1::INetworkDefinition* network = builder->createNetworkV2(
+            1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH));
+
+    /*******************************************************************************************************
+    ******************************************  YOLOV8 INPUT  **********************************************
+    *******************************************************************************************************/
+    nvinfer1::ITensor* data = network->addInput(kInputTensorName, dt, nvinfer1::Dims4{-1, 3, -1, -1});
+    assert(data);
+
+    /*******************************************************************************************************
+    *****************************************  YOLOV8 BACKBONE  ********************************************
+    *******************************************************************************************************/
+    nvinfer1::IElementWiseLayer* conv0 =
+            convBnSiLU(network, weightMap, *data, get_width(64, gw, max_channels), 3, 2, 1, "model.0");
+    nvinfer1::IElementWiseLayer* conv1 =
+            convBnSiLU(network, weightMap, *conv0->getOutput(0), get_width(128, gw, max_channels), 3, 2, 1, "model.1");
+    nvinfer1::IElementWiseLayer* conv2 = C2F(network, weightMap, *conv1->getOutput(0), get_width(128, gw, max_channels),
+                                             get_width(128, gw, max_channels), get_depth(3, gd), true, 0.5, "model.2");
+    nvinfer1::IElementWiseLayer* conv3 =
+            convBnSiLU(network, weightMap, *conv2->getOutput(0), get_width(256, gw, max_channels), 3, 2, 1, "model.3");
+    nvinfer1::IElementWiseLayer* conv4 = C2F(network, weightMap, *conv3->getOutput(0), get_width(256, gw, max_channels),
+                                             get_width(256, gw, max_channels), get_depth(6, gd), true, 0.5, "model.4");
+    nvinfer1::IElementWiseLayer* conv5 =
+            convBnSiLU(network, weightMap, *conv4->getOutput(0), get_width(512, gw, max_channels), 3, 2, 1, "model.5");
+    nvinfer1::IElementWiseLayer* conv6 = C2F(network, weightMap, *conv5->getOutput(0), get_width(512, gw, max_channels),
+                                             get_width(512, gw, max_channels), get_depth(6, gd), true, 0.5, "model.6");
+    nvinfer1::IElementWiseLayer* conv7 =
+            convBnSiLU(network, weightMap, *conv6->getOutput(0), get_width(1024, gw, max_channels), 3, 2, 1, "model.7");
+    nvinfer1::IElementWiseLayer* conv8 =
+            C2F(network, weightMap, *conv7->getOutput(0), get_width(1024, gw, max_channels),
+                get_width(1024, gw, max_channels), get_depth(3, gd), true, 0.5, "model.8");
+    nvinfer1::IElementWiseLayer* conv9 =
+            SPPF(network, weightMap, *conv8->getOutput(0), get_width(1024, gw, max_channels),
+                 get_width(1024, gw, max_channels), 5, "model.9");
+    /*******************************************************************************************************
+    *********************************************  YOLOV8 HEAD  ********************************************
+    *******************************************************************************************************/
+    float scale[] = {1.0, 1.0, 2.0, 2.0};
+    nvinfer1::IResizeLayer* upsample10 = network->addResize(*conv9->getOutput(0));
+    assert(upsample10);
+    upsample10->setResizeMode(nvinfer1::ResizeMode::kNEAREST);
+    upsample10->setScales(scale, 4);
+
+    nvinfer1::ITensor* inputTensor11[] = {upsample10->getOutput(0), conv6->getOutput(0)};
+    nvinfer1::IConcatenationLayer* cat11 = network->addConcatenation(inputTensor11, 2);
+
+    nvinfer1::IElementWiseLayer* conv12 =
+            C2F(network, weightMap, *cat11->getOutput(0), get_width(512, gw, max_channels),
+                get_width(512, gw, max_channels), get_depth(3, gd), false, 0.5, "model.12");
+
+    nvinfer1::IResizeLayer* upsample13 = network->addResize(*conv12->getOutput(0));
+    assert(upsample13);
+    upsample13->setResizeMode(nvinfer1::ResizeMode::kNEAREST);
+    upsample13->setScales(scale, 4);
+
+    nvinfer1::ITensor* inputTensor14[] = {upsample13->getOutput(0), conv4->getOutput(0)};
+    nvinfer1::IConcatenationLayer* cat14 = network->addConcatenation(inputTensor14, 2);
+
+    nvinfer1::IElementWiseLayer* conv15 =
+            C2F(network, weightMap, *cat14->getOutput(0), get_width(256, gw, max_channels),
+                get_width(256, gw, max_channels), get_depth(3, gd), false, 0.5, "model.15");
+    nvinfer1::IElementWiseLayer* conv16 = convBnSiLU(network, weightMap, *conv15->getOutput(0),
+                                                     get_width(256, gw, max_channels), 3, 2, 1, "model.16");
+    nvinfer1::ITensor* inputTensor17[] = {conv16->getOutput(0), conv12->getOutput(0)};
+    nvinfer1::IConcatenationLayer* cat17 = network->addConcatenation(inputTensor17, 2);
+    nvinfer1::IElementWiseLayer* conv18 =
+            C2F(network, weightMap, *cat17->getOutput(0), get_width(512, gw, max_channels),
+                get_width(512, gw, max_channels), get_depth(3, gd), false, 0.5, "model.18");
+    nvinfer1::IElementWiseLayer* conv19 = convBnSiLU(network, weightMap, *conv18->getOutput(0),
+                                                     get_width(512, gw, max_channels), 3, 2, 1, "model.19");
+    nvinfer1::ITensor* inputTensor20[] = {conv19->getOutput(0), conv9->getOutput(0)};
+    nvinfer1::IConcatenationLayer* cat20 = network->addConcatenation(inputTensor20, 2);
+    nvinfer1::IElementWiseLayer* conv21 =
+            C2F(network, weightMap, *cat20->getOutput(0), get_width(1024, gw, max_channels),
+                get_width(1024, gw, max_channels), get_depth(3, gd), false, 0.5, "model.21");
+
+    /*******************************************************************************************************
+    *********************************************  YOLOV8 OUTPUT  ******************************************
+    *******************************************************************************************************/
+    int base_in_channel = (gw == 1.25) ? 80 : 64;
+    int base_out_channel = (gw == 0.25) ? std::max(64, std::min(cfg.num_class, 100)) : get_width(256, gw, max_channels);
+
+    nvinfer1::IConcatenationLayer* cat22_0 = detectHeadDynamic(network, weightMap, *conv15->getOutput(0),
+                                                               base_in_channel, base_out_channel, cfg.num_class, "0");
+    nvinfer1::IConcatenationLayer* cat22_1 = detectHeadDynamic(network, weightMap, *conv18->getOutput(0),
+                                                               base_in_channel, base_out_channel, cfg.num_class, "1");
+    nvinfer1::IConcatenationLayer* cat22_2 = detectHeadDynamic(network, weightMap, *conv21->getOutput(0),
+                                                               base_in_channel, base_out_channel, cfg.num_class, "2");
+
+    /*******************************************************************************************************
+    *********************************************  YOLOV8 DETECT  ******************************************
+    *******************************************************************************************************/
+    // Feature map sizes are unknown until inference, so the strides can not be derived from them
+    int strides[] = {8, 16, 32};
+    int stridesLength = sizeof(strides) / sizeof(int);
+    nvinfer1::IPluginV2Layer* yolo =
+            addYoLoLayerDynamic(network, std::vector<nvinfer1::IConcatenationLayer*>{cat22_0, cat22_1, cat22_2},
+                                strides, stridesLength, cfg.num_class, cfg.max_num_output_bbox);
+
+    yolo->getOutput(0)->setName(kOutputTensorName);
+    network->markOutput(*yolo->getOutput(0));
+
+    // Any batch up to batch_size and any stride-aligned resolution up to input_h x input_w, tuned for the largest
+    nvinfer1::IOptimizationProfile* profile = builder->createOptimizationProfile();
+    profile->setDimensions(kInputTensorName, nvinfer1::OptProfileSelector::kMIN, nvinfer1::Dims4{1, 3, 32, 32});
+    profile->setDimensions(kInputTensorName, nvinfer1::OptProfileSelector::kOPT,
+                           nvinfer1::Dims4{cfg.batch_size, 3, cfg.input_h, cfg.input_w});
+    profile->setDimensions(kInputTensorName, nvinfer1::OptProfileSelector::kMAX,
+                           nvinfer1::Dims4{cfg.batch_size, 3, cfg.input_h, cfg.input_w});
+    config->addOptimizationProfile(profile);
+    config->setMaxWorkspaceSize(16 * (1 << 20));
+
+    if (cfg.precision == "fp16") {
+        config->setFlag(nvinfer1::BuilderFlag::kFP16);
+    } else if (cfg.precision == "int8") {
+        std::cout << "Your platform support int8: " << (builder->platformHasFastInt8() ? "true" : "false") << std::endl;
+        assert(builder->platformHasFastInt8());
+        config->setFlag(nvinfer1::BuilderFlag::kINT8);
+        if (!setInt8DynamicRanges(network, kInputQuantizationScales)) {
+            // The calibrator feeds one full-size image at a time
+            nvinfer1::IOptimizationProfile* calib_profile = builder->createOptimizationProfile();
+            nvinfer1::Dims4 calib_dims{1, 3, cfg.input_h, cfg.input_w};
+            calib_profile->setDimensions(kInputTensorName, nvinfer1::OptProfileSelector::kMIN, calib_dims);
+            calib_profile->setDimensions(kInputTensorName, nvinfer1::OptProfileSelector::kOPT, calib_dims);
+            calib_profile->setDimensions(kInputTensorName, nvinfer1::OptProfileSelector::kMAX, calib_dims);
+            config->setCalibrationProfile(calib_profile);
+            auto* calibrator = new Int8EntropyCalibrator2(1, cfg.input_w, cfg.input_h, kInputQuantizationFolder,
+                                                          "int8calib.table", kInputTensorName);
+            config->setInt8Calibrator(calibrator);
+        }
+    }
+#if defined(USE_SPARSE_WEIGHTS)
+    config->setFlag(nvinfer1::BuilderFlag::kSPARSE_WEIGHTS);
 #endif
 
     std::cout << "Building engine, please wait for a while..." << std::endl;
@@ -615,9 +802,14 @@ nvinfer1::IHostMemory* buildEngineYolov8DetP6(nvinfer1::IBuilder* builder, nvinf
     std::cout << "Your platform support int8: " << (builder->platformHasFastInt8() ? "true" : "false") << std::endl;
     assert(builder->platformHasFastInt8());
     config->setFlag(nvinfer1::BuilderFlag::kINT8);
-    auto* calibrator = new Int8EntropyCalibrator2(1, kInputW, kInputH, kInputQuantizationFolder, "int8calib.table",
-                                                  kInputTensorName);
-    config->setInt8Calibrator(calibrator);
+    if (!setInt8DynamicRanges(network, kInputQuantizationScales)) {
+        auto* calibrator = new Int8EntropyCalibrator2(1, kInputW, kInputH, kInputQuantizationFolder, "int8calib.table",
+                                                      kInputTensorName);
+        config->setInt8Calibrator(calibrator);
+    }
+#endif
+#if defined(USE_SPARSE_WEIGHTS)
+    config->setFlag(nvinfer1::BuilderFlag::kSPARSE_WEIGHTS);
 #endif
 
     std::cout << "Building engine, please wait for a while..." << std::endl;
@@ -925,9 +1117,14 @@ nvinfer1::IHostMemory* buildEngineYolov8DetP2(nvinfer1::IBuilder* builder, nvinf
     std::cout << "Your platform support int8: " << (builder->platformHasFastInt8() ? "true" : "false") << std::endl;
     assert(builder->platformHasFastInt8());
     config->setFlag(nvinfer1::BuilderFlag::kINT8);
-    auto* calibrator = new Int8EntropyCalibrator2(1, kInputW, kInputH, kInputQuantizationFolder, "int8calib.table",
-                                                  kInputTensorName);
-    config->setInt8Calibrator(calibrator);
+    if (!setInt8DynamicRanges(network, kInputQuantizationScales)) {
+        auto* calibrator = new Int8EntropyCalibrator2(1, kInputW, kInputH, kInputQuantizationFolder, "int8calib.table",
+                                                      kInputTensorName);
+        config->setInt8Calibrator(calibrator);
+    }
+#endif
+#if defined(USE_SPARSE_WEIGHTS)
+    config->setFlag(nvinfer1::BuilderFlag::kSPARSE_WEIGHTS);
 #endif
 
     std::cout << "Building engine, please wait for a while..." << std::endl;
@@ -988,9 +1185,10 @@ nvinfer1::IHostMemory* buildEngineYolov8Cls(nvinfer1::IBuilder* builder, nvinfer
                                                            nvinfer1::DimsHW{dims.d[1], dims.d[2]});
     assert(pool2);
 
-    // Fully connected layer declaration
+    // Fully connected layer declaration, one output per class of the .wts
+    int num_class = weightMap["model.9.linear.bias"].count;
     nvinfer1::IFullyConnectedLayer* yolo = network->addFullyConnected(
-            *pool2->getOutput(0), kClsNumClass, weightMap["model.9.linear.weight"], weightMap["model.9.linear.bias"]);
+            *pool2->getOutput(0), num_class, weightMap["model.9.linear.weight"], weightMap["model.9.linear.bias"]);
     assert(yolo);
 
     // Set the name for the output tensor and mark it as network output
@@ -1008,9 +1206,14 @@ nvinfer1::IHostMemory* buildEngineYolov8Cls(nvinfer1::IBuilder* builder, nvinfer
     std::cout << "Your platform supports int8: " << (builder->platformHasFastInt8() ? "true" : "false") << std::endl;
     assert(builder->platformHasFastInt8());
     config->setFlag(nvinfer1::BuilderFlag::kINT8);
-    auto* calibrator = new Int8EntropyCalibrator2(1, kClsInputW, kClsInputH, kInputQuantizationFolder,
-                                                  "int8calib.table", kInputTensorName);
-    config->setInt8Calibrator(calibrator);
+    if (!setInt8DynamicRanges(network, kInputQuantizationScales)) {
+        auto* calibrator = new Int8EntropyCalibrator2(1, kClsInputW, kClsInputH, kInputQuantizationFolder,
+                                                      "int8calib.table", kInputTensorName);
+        config->setInt8Calibrator(calibrator);
+    }
+#endif
+#if defined(USE_SPARSE_WEIGHTS)
+    config->setFlag(nvinfer1::BuilderFlag::kSPARSE_WEIGHTS);
 #endif
 
     // Begin building the engine; this may take a while
@@ -1258,9 +1461,14 @@ nvinfer1::IHostMemory* buildEngineYolov8Seg(nvinfer1::IBuilder* builder, nvinfer
     std::cout << "Your platform support int8: " << (builder->platformHasFastInt8() ? "true" : "false") << std::endl;
     assert(builder->platformHasFastInt8());
     config->setFlag(nvinfer1::BuilderFlag::kINT8);
-    auto* calibrator = new Int8EntropyCalibrator2(1, kInputW, kInputH, kInputQuantizationFolder, "int8calib.table",
-                                                  kInputTensorName);
-    config->setInt8Calibrator(calibrator);
+    if (!setInt8DynamicRanges(network, kInputQuantizationScales)) {
+        auto* calibrator = new Int8EntropyCalibrator2(1, kInputW, kInputH, kInputQuantizationFolder, "int8calib.table",
+                                                      kInputTensorName);
+        config->setInt8Calibrator(calibrator);
+    }
+#endif
+#if defined(USE_SPARSE_WEIGHTS)
+    config->setFlag(nvinfer1::BuilderFlag::kSPARSE_WEIGHTS);
 #endif
 
     std::cout << "Building engine, please wait for a while..." << std::endl;
@@ -1505,9 +1713,14 @@ nvinfer1::IHostMemory* buildEngineYolov8Pose(nvinfer1::IBuilder* builder, nvinfe
     std::cout << "Your platform support int8: " << (builder->platformHasFastInt8() ? "true" : "false") << std::endl;
     assert(builder->platformHasFastInt8());
     config->setFlag(nvinfer1::BuilderFlag::kINT8);
-    auto* calibrator = new Int8EntropyCalibrator2(1, kInputW, kInputH, kInputQuantizationFolder, "int8calib.table",
-                                                  kInputTensorName);
-    config->setInt8Calibrator(calibrator);
+    if (!setInt8DynamicRanges(network, kInputQuantizationScales)) {
+        auto* calibrator = new Int8EntropyCalibrator2(1, kInputW, kInputH, kInputQuantizationFolder, "int8calib.table",
+                                                      kInputTensorName);
+        config->setInt8Calibrator(calibrator);
+    }
+#endif
+#if defined(USE_SPARSE_WEIGHTS)
+    config->setFlag(nvinfer1::BuilderFlag::kSPARSE_WEIGHTS);
 #endif
 
     std::cout << "Building engine, please wait for a while..." << std::endl;
@@ -1835,9 +2048,14 @@ nvinfer1::IHostMemory* buildEngineYolov8PoseP6(nvinfer1::IBuilder* builder, nvin
     std::cout << "Your platform support int8: " << (builder->platformHasFastInt8() ? "true" : "false") << std::endl;
     assert(builder->platformHasFastInt8());
     config->setFlag(nvinfer1::BuilderFlag::kINT8);
-    auto* calibrator = new Int8EntropyCalibrator2(1, kInputW, kInputH, kInputQuantizationFolder, "int8calib.table",
-                                                  kInputTensorName);
-    config->setInt8Calibrator(calibrator);
+    if (!setInt8DynamicRanges(network, kInputQuantizationScales)) {
+        auto* calibrator = new Int8EntropyCalibrator2(1, kInputW, kInputH, kInputQuantizationFolder, "int8calib.table",
+                                                      kInputTensorName);
+        config->setInt8Calibrator(calibrator);
+    }
+#endif
+#if defined(USE_SPARSE_WEIGHTS)
+    config->setFlag(nvinfer1::BuilderFlag::kSPARSE_WEIGHTS);
 #endif
 
     std::cout << "Building engine, please wait for a while..." << std::endl;
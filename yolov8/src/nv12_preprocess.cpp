@@ -0,0 +1,121 @@
+#include "nv12_preprocess.h"
+#include <algorithm>
+#include <vector>
+#include "uint8_input.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void nv12_letterbox_reference(const uint8_t* y_plane, const uint8_t* uv_plane, int width, int height, int stride,
+                              float* dst, int dst_width, int dst_height) {
+    float d2s[6];
+    letterbox_d2s(width, height, dst_width, dst_height, d2s);
+    int area = dst_width * dst_height;
+    for (int dy = 0; dy < dst_height; dy++) {
+        for (int dx = 0; dx < dst_width; dx++) {
+            float rgb[3];
+            nv12_letterbox_pixel(y_plane, uv_plane, width, height, stride, d2s, dx, dy, rgb);
+            float* p = dst + dy * dst_width + dx;
+            p[0] = rgb[0];
+            p[area] = rgb[1];
+            p[2 * area] = rgb[2];
+        }
+    }
+}
+
+#if defined(__SSE2__)
+// nv12_to_rgb on four pixels
+static inline void nv12_to_rgb_sse(__m128 y, __m128 u, __m128 v, __m128 rgb[3]) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 max = _mm_set1_ps(255.f);
+    __m128 c = _mm_mul_ps(_mm_max_ps(_mm_sub_ps(y, _mm_set1_ps(16.f)), zero), _mm_set1_ps(kNv12Cy));
+    u = _mm_sub_ps(u, _mm_set1_ps(128.f));
+    v = _mm_sub_ps(v, _mm_set1_ps(128.f));
+    __m128 r = _mm_add_ps(c, _mm_mul_ps(_mm_set1_ps(kNv12Cvr), v));
+    __m128 g = _mm_add_ps(_mm_add_ps(c, _mm_mul_ps(_mm_set1_ps(kNv12Cvg), v)), _mm_mul_ps(_mm_set1_ps(kNv12Cug), u));
+    __m128 b = _mm_add_ps(c, _mm_mul_ps(_mm_set1_ps(kNv12Cub), u));
+    rgb[0] = _mm_div_ps(_mm_min_ps(_mm_max_ps(r, zero), max), max);
+    rgb[1] = _mm_div_ps(_mm_min_ps(_mm_max_ps(g, zero), max), max);
+    rgb[2] = _mm_div_ps(_mm_min_ps(_mm_max_ps(b, zero), max), max);
+}
+#endif
+
+void nv12_letterbox(const uint8_t* y_plane, const uint8_t* uv_plane, int width, int height, int stride, float* dst,
+                    int dst_width, int dst_height) {
+#if !defined(__SSE2__)
+    nv12_letterbox_reference(y_plane, uv_plane, width, height, stride, dst, dst_width, dst_height);
+#else
+    float d2s[6];
+    letterbox_d2s(width, height, dst_width, dst_height, d2s);
+    const int area = dst_width * dst_height;
+    const float border = nv12_div(128.f, 255.f);
+    // The steps of nv12_letterbox_pixel that only depend on the column, done once per column
+    std::vector<int> x_low(dst_width, 0);
+    std::vector<float> lx(dst_width, 0.f), hx(dst_width, 0.f);
+    std::vector<char> inside_x(dst_width, 0);
+    for (int dx = 0; dx < dst_width; dx++) {
+        float src_x = nv12_add(nv12_add(nv12_mul(d2s[0], (float)dx), d2s[2]), 0.5f);
+        inside_x[dx] = !(src_x <= -1 || src_x >= width);
+        if (inside_x[dx]) {
+            x_low[dx] = floorf(src_x);
+            lx[dx] = nv12_sub(src_x, (float)x_low[dx]);
+            hx[dx] = nv12_sub(1.f, lx[dx]);
+        }
+    }
+    for (int dy = 0; dy < dst_height; dy++) {
+        float* p0 = dst + dy * dst_width;
+        float src_y = nv12_add(nv12_add(nv12_mul(d2s[4], (float)dy), d2s[5]), 0.5f);
+        if (src_y <= -1 || src_y >= height) {
+            std::fill(p0, p0 + dst_width, border);
+            std::fill(p0 + area, p0 + area + dst_width, border);
+            std::fill(p0 + 2 * area, p0 + 2 * area + dst_width, border);
+            continue;
+        }
+        int y_low = floorf(src_y);
+        float ly = nv12_sub(src_y, (float)y_low);
+        float hy = nv12_sub(1.f, ly);
+        const __m128 vly = _mm_set1_ps(ly), vhy = _mm_set1_ps(hy);
+        int dx = 0;
+        for (; dx + 4 <= dst_width; dx += 4) {
+            // taps[i][c]: channel c of tap i of the four pixels, gathered, then blended four pixels at a time
+            alignas(16) float taps[4][3][4];
+            for (int l = 0; l < 4; l++) {
+                for (int i = 0; i < 4; i++) {
+                    float tap[3];
+                    nv12_tap(y_plane, uv_plane, width, height, stride, x_low[dx + l] + (i & 1), y_low + (i >> 1),
+                             tap);
+                    taps[i][0][l] = tap[0];
+                    taps[i][1][l] = tap[1];
+                    taps[i][2][l] = tap[2];
+                }
+            }
+            __m128 vlx = _mm_loadu_ps(&lx[dx]), vhx = _mm_loadu_ps(&hx[dx]);
+            __m128 w[4] = {_mm_mul_ps(vhy, vhx), _mm_mul_ps(vhy, vlx), _mm_mul_ps(vly, vhx), _mm_mul_ps(vly, vlx)};
+            __m128 yuv[3];
+            for (int c = 0; c < 3; c++) {
+                yuv[c] = _mm_setzero_ps();
+                for (int i = 0; i < 4; i++) {
+                    yuv[c] = _mm_add_ps(yuv[c], _mm_mul_ps(w[i], _mm_load_ps(taps[i][c])));
+                }
+            }
+            __m128 rgb[3];
+            nv12_to_rgb_sse(yuv[0], yuv[1], yuv[2], rgb);
+            _mm_storeu_ps(p0 + dx, rgb[0]);
+            _mm_storeu_ps(p0 + area + dx, rgb[1]);
+            _mm_storeu_ps(p0 + 2 * area + dx, rgb[2]);
+            for (int l = 0; l < 4; l++) {
+                if (!inside_x[dx + l]) {
+                    p0[dx + l] = p0[area + dx + l] = p0[2 * area + dx + l] = border;
+                }
+            }
+        }
+        for (; dx < dst_width; dx++) {
+            float rgb[3];
+            nv12_letterbox_pixel(y_plane, uv_plane, width, height, stride, d2s, dx, dy, rgb);
+            p0[dx] = rgb[0];
+            p0[area + dx] = rgb[1];
+            p0[2 * area + dx] = rgb[2];
+        }
+    }
+#endif
+}
@@ -1,23 +1,23 @@
 #include "postprocess.h"
 #include "utils.h"
 
-cv::Rect get_rect(cv::Mat& img, float bbox[4]) {
+cv::Rect get_rect(cv::Mat& img, float bbox[4], int input_w, int input_h) {
     float l, r, t, b;
-    float r_w = kInputW / (img.cols * 1.0);
-    float r_h = kInputH / (img.rows * 1.0);
+    float r_w = input_w / (img.cols * 1.0);
+    float r_h = input_h / (img.rows * 1.0);
 
     if (r_h > r_w) {
         l = bbox[0];
         r = bbox[2];
-        t = bbox[1] - (kInputH - r_w * img.rows) / 2;
-        b = bbox[3] - (kInputH - r_w * img.rows) / 2;
+        t = bbox[1] - (input_h - r_w * img.rows) / 2;
+        b = bbox[3] - (input_h - r_w * img.rows) / 2;
         l = l / r_w;
         r = r / r_w;
         t = t / r_w;
         b = b / r_w;
     } else {
-        l = bbox[0] - (kInputW - r_h * img.cols) / 2;
-        r = bbox[2] - (kInputW - r_h * img.cols) / 2;
+        l = bbox[0] - (input_w - r_h * img.cols) / 2;
+        r = bbox[2] - (input_w - r_h * img.cols) / 2;
         t = bbox[1];
         b = bbox[3];
         l = l / r_h;
@@ -155,12 +155,13 @@ void batch_process(std::vector<std::vector<Detection>>& res_batch, const float*
     }
 }
 
-void draw_bbox(std::vector<cv::Mat>& img_batch, std::vector<std::vector<Detection>>& res_batch) {
+void draw_bbox(std::vector<cv::Mat>& img_batch, std::vector<std::vector<Detection>>& res_batch, int input_w,
+               int input_h) {
     for (size_t i = 0; i < img_batch.size(); i++) {
         auto& res = res_batch[i];
         cv::Mat img = img_batch[i];
         for (size_t j = 0; j < res.size(); j++) {
-            cv::Rect r = get_rect(img, res[j].bbox);
+            cv::Rect r = get_rect(img, res[j].bbox, input_w, input_h);
             cv::rectangle(img, r, cv::Scalar(0x27, 0xC1, 0x36), 2);
             cv::putText(img, std::to_string((int)res[j].class_id), cv::Point(r.x, r.y - 1), cv::FONT_HERSHEY_PLAIN, 1.2,
                         cv::Scalar(0xFF, 0xFF, 0xFF), 2);
@@ -1,8 +1,26 @@
 #include "preprocess.h"
 #include "cuda_utils.h"
+#include "nv12_preprocess.h"
+#include "uint8_input.h"
 
 static uint8_t *img_buffer_host = nullptr;
 static uint8_t *img_buffer_device = nullptr;
+// size of both buffers, max_image_size BGR pixels
+static size_t img_buffer_bytes = 0;
+
+// A continuous BGR image that fits the buffers: img itself, or img downscaled on the CPU keeping its aspect ratio.
+// The letterbox of the smaller image covers the same part of the input, so boxes still map back to img.
+static cv::Mat fit_img_buffer(const cv::Mat &img) {
+    size_t bytes = (size_t) img.cols * img.rows * 3;
+    if (bytes <= img_buffer_bytes) {
+        return img.isContinuous() ? img : img.clone();
+    }
+    double scale = sqrt((double) img_buffer_bytes / bytes);
+    cv::Mat reduced;
+    cv::resize(img, reduced, cv::Size(std::max(1, (int) (img.cols * scale)), std::max(1, (int) (img.rows * scale))),
+               0, 0, cv::INTER_AREA);
+    return reduced;
+}
 
 
 __global__ void
@@ -90,36 +108,105 @@ warpaffine_kernel(uint8_t *src, int src_line_size, int src_width, int src_height
 
 
 
+// One thread per output pixel of the NV12 letterbox, nv12_letterbox is the CPU version
+__global__ void warpaffine_nv12_kernel(const uint8_t *y_plane, const uint8_t *uv_plane, int src_line_size,
+                                       int src_width, int src_height, float *dst, int dst_width, int dst_height,
+                                       AffineMatrix d2s, int edge) {
+    int position = blockDim.x * blockIdx.x + threadIdx.x;
+    if (position >= edge) return;
+    int dx = position % dst_width;
+    int dy = position / dst_width;
+    float rgb[3];
+    nv12_letterbox_pixel(y_plane, uv_plane, src_width, src_height, src_line_size, d2s.value, dx, dy, rgb);
+    int area = dst_width * dst_height;
+    float *pdst_c0 = dst + dy * dst_width + dx;
+    pdst_c0[0] = rgb[0];
+    pdst_c0[area] = rgb[1];
+    pdst_c0[2 * area] = rgb[2];
+}
+
+static void warpaffine_launch(uint8_t *src_device, int src_line_size, int src_width, int src_height, float *dst,
+                              int dst_width, int dst_height, cudaStream_t stream) {
+    AffineMatrix d2s;
+    letterbox_d2s(src_width, src_height, dst_width, dst_height, d2s.value);
+
+    int jobs = dst_height * dst_width;
+    int threads = 256;
+    int blocks = ceil(jobs / (float) threads);
+    warpaffine_kernel<<<blocks, threads, 0, stream>>>(
+            src_device, src_line_size, src_width,
+            src_height, dst, dst_width,
+            dst_height, 128, d2s, jobs);
+}
+
 void cuda_preprocess(uint8_t *src, int src_width, int src_height, float *dst, int dst_width, int dst_height,
                      cudaStream_t stream) {
-    int img_size = src_width * src_height * 3;
+    if ((size_t) src_width * src_height * 3 > img_buffer_bytes) {
+        cv::Mat reduced = fit_img_buffer(cv::Mat(src_height, src_width, CV_8UC3, src));
+        cuda_preprocess(reduced.ptr(), reduced.cols, reduced.rows, dst, dst_width, dst_height, stream);
+        return;
+    }
+    size_t img_size = (size_t) src_width * src_height * 3;
     // copy data to pinned memory
     memcpy(img_buffer_host, src, img_size);
     // copy data to device memory
     CUDA_CHECK(cudaMemcpyAsync(img_buffer_device, img_buffer_host, img_size, cudaMemcpyHostToDevice, stream));
+    warpaffine_launch(img_buffer_device, src_width * 3, src_width, src_height, dst, dst_width, dst_height, stream);
+}
 
-    AffineMatrix s2d, d2s;
-    float scale = std::min(dst_height / (float) src_height, dst_width / (float) src_width);
-
-    s2d.value[0] = scale;
-    s2d.value[1] = 0;
-    s2d.value[2] = -scale * src_width * 0.5 + dst_width * 0.5;
-    s2d.value[3] = 0;
-    s2d.value[4] = scale;
-    s2d.value[5] = -scale * src_height * 0.5 + dst_height * 0.5;
-    cv::Mat m2x3_s2d(2, 3, CV_32F, s2d.value);
-    cv::Mat m2x3_d2s(2, 3, CV_32F, d2s.value);
-    cv::invertAffineTransform(m2x3_s2d, m2x3_d2s);
-
-    memcpy(d2s.value, m2x3_d2s.ptr<float>(0), sizeof(d2s.value));
+void cuda_preprocess_registered(uint8_t *src, int src_width, int src_height, int src_line_size, float *dst,
+                                int dst_width, int dst_height, cudaStream_t stream) {
+    if ((size_t) src_line_size * src_height > img_buffer_bytes) {
+        cv::Mat reduced = fit_img_buffer(cv::Mat(src_height, src_width, CV_8UC3, src, src_line_size));
+        cuda_preprocess(reduced.ptr(), reduced.cols, reduced.rows, dst, dst_width, dst_height, stream);
+        return;
+    }
+    // src is already page-locked, DMA it straight to the device without staging through img_buffer_host
+    CUDA_CHECK(cudaMemcpyAsync(img_buffer_device, src, (size_t)src_line_size * src_height, cudaMemcpyHostToDevice,
+                               stream));
+    warpaffine_launch(img_buffer_device, src_line_size, src_width, src_height, dst, dst_width, dst_height, stream);
+}
 
+void cuda_preprocess_nv12_registered(uint8_t *src, int src_width, int src_height, int src_line_size, float *dst,
+                                     int dst_width, int dst_height, cudaStream_t stream) {
+    // the Y plane and the half-height UV plane after it, rows of src_line_size bytes
+    size_t y_size = (size_t) src_line_size * src_height;
+    if (y_size + (size_t) src_line_size * ((src_height + 1) / 2) > img_buffer_bytes) {
+        // letterboxed on the CPU to the same bits, only the input tensor is uploaded
+        std::vector<float> input((size_t) dst_width * dst_height * 3);
+        nv12_letterbox(src, src + y_size, src_width, src_height, src_line_size, input.data(), dst_width, dst_height);
+        CUDA_CHECK(cudaMemcpyAsync(dst, input.data(), input.size() * sizeof(float), cudaMemcpyHostToDevice, stream));
+        CUDA_CHECK(cudaStreamSynchronize(stream));
+        return;
+    }
+    CUDA_CHECK(cudaMemcpyAsync(img_buffer_device, src, y_size + (size_t) src_line_size * ((src_height + 1) / 2),
+                               cudaMemcpyHostToDevice, stream));
+    AffineMatrix d2s;
+    letterbox_d2s(src_width, src_height, dst_width, dst_height, d2s.value);
     int jobs = dst_height * dst_width;
     int threads = 256;
     int blocks = ceil(jobs / (float) threads);
-    warpaffine_kernel<<<blocks, threads, 0, stream>>>(
-            img_buffer_device, src_width * 3, src_width,
-            src_height, dst, dst_width,
-            dst_height, 128, d2s, jobs);
+    warpaffine_nv12_kernel<<<blocks, threads, 0, stream>>>(img_buffer_device, img_buffer_device + y_size,
+                                                           src_line_size, src_width, src_height, dst, dst_width,
+                                                           dst_height, d2s, jobs);
+}
+
+bool cuda_frame_upload(const cv::Mat &img, cudaStream_t stream) {
+    size_t img_size = (size_t) img.cols * img.rows * 3;
+    if (img_size > img_buffer_bytes) {
+        std::cerr << "frame of " << img.cols << "x" << img.rows << " does not fit the preprocess buffers" << std::endl;
+        return false;
+    }
+    memcpy(img_buffer_host, img.ptr(), img_size);
+    CUDA_CHECK(cudaMemcpyAsync(img_buffer_device, img_buffer_host, img_size, cudaMemcpyHostToDevice, stream));
+    return true;
+}
+
+void cuda_roi_preprocess(const cv::Mat &img, const cv::Rect &roi, float *dst, int dst_width, int dst_height,
+                         cudaStream_t stream) {
+    // the roi is a view into the uploaded frame, rows keep the stride of the whole frame
+    uint8_t *src = img_buffer_device + ((size_t) roi.y * img.cols + roi.x) * 3;
+    warpaffine_launch(src, img.cols * 3, roi.width, roi.height, dst, dst_width, dst_height, stream);
 }
 
 
@@ -138,11 +225,29 @@ void cuda_batch_preprocess(std::vector<cv::Mat> &img_batch,
 
 
 
+void cuda_batch_preprocess_uint8(std::vector<cv::Mat> &img_batch, uint8_t *dst, int dst_width, int dst_height,
+                                 cudaStream_t stream) {
+    size_t dst_size = (size_t) dst_width * dst_height * 3;
+    // uploaded in chunks of as many images as the pinned buffer holds, e.g. 5 at 1280x1280
+    size_t chunk = std::max<size_t>(1, img_buffer_bytes / dst_size);
+    for (size_t first = 0; first < img_batch.size(); first += chunk) {
+        size_t n = std::min(chunk, img_batch.size() - first);
+        // the last upload from the pinned buffer must be done before it is overwritten
+        CUDA_CHECK(cudaStreamSynchronize(stream));
+        for (size_t i = 0; i < n; i++) {
+            letterbox_uint8(img_batch[first + i], img_buffer_host + dst_size * i, dst_width, dst_height);
+        }
+        CUDA_CHECK(cudaMemcpyAsync(dst + dst_size * first, img_buffer_host, dst_size * n, cudaMemcpyHostToDevice,
+                                   stream));
+    }
+}
+
 void cuda_preprocess_init(int max_image_size) {
+    img_buffer_bytes = (size_t) max_image_size * 3;
     // prepare input data in pinned memory
-    CUDA_CHECK(cudaMallocHost((void **) &img_buffer_host, max_image_size * 3));
+    CUDA_CHECK(cudaMallocHost((void **) &img_buffer_host, img_buffer_bytes));
     // prepare input data in device memory
-    CUDA_CHECK(cudaMalloc((void **) &img_buffer_device, max_image_size * 3));
+    CUDA_CHECK(cudaMalloc((void **) &img_buffer_device, img_buffer_bytes));
 }
 
 void cuda_preprocess_destroy() {
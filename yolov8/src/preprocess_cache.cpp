@@ -0,0 +1,159 @@
+#include "preprocess_cache.h"
+#include <algorithm>
+#include <cstring>
+
+bool operator==(const InputSpec& a, const InputSpec& b) {
+    return a.width == b.width && a.height == b.height && a.resize == b.resize && a.order == b.order &&
+           memcmp(a.mean, b.mean, sizeof(a.mean)) == 0 && memcmp(a.std, b.std, sizeof(a.std)) == 0 &&
+           a.dtype == b.dtype && a.pad == b.pad;
+}
+
+int PreprocessCache::add_model(const InputSpec& spec) {
+    size_t t = 0;
+    while (t < tensors_.size() && !(tensors_[t].spec == spec)) {
+        t++;
+    }
+    if (t == tensors_.size()) {
+        TensorStage tensor;
+        tensor.spec = spec;
+        tensor.lut.resize(3 * 256);
+        for (int c = 0; c < 3; c++) {
+            for (int v = 0; v < 256; v++) {
+                tensor.lut[c * 256 + v] = (v / 255.f - spec.mean[c]) / spec.std[c];
+            }
+        }
+        size_t bytes = (size_t)3 * spec.width * spec.height *
+                       (spec.dtype == InputDType::kFloat32 ? sizeof(float) : sizeof(uint8_t));
+        tensor.storage.resize((bytes + sizeof(float) - 1) / sizeof(float));
+        tensor.out.data = tensor.storage.data();
+        tensor.out.bytes = bytes;
+        tensors_.push_back(std::move(tensor));
+        // the resizes are planned again for the next frame
+        planned_ = cv::Size();
+    }
+    model_tensor_.push_back(t);
+    return model_tensor_.size() - 1;
+}
+
+void PreprocessCache::plan(cv::Size frame_size) {
+    resizes_.clear();
+    const int iw = frame_size.width, ih = frame_size.height;
+    for (auto& tensor : tensors_) {
+        const InputSpec& spec = tensor.spec;
+        cv::Rect src(0, 0, iw, ih);
+        cv::Rect content(0, 0, spec.width, spec.height);
+        if (spec.resize == ResizeMode::kLetterbox) {
+            // the rounding of preprocess_img, so boxes map back the same way
+            float r_w = spec.width / (iw * 1.0);
+            float r_h = spec.height / (ih * 1.0);
+            if (r_h > r_w) {
+                content.height = r_w * ih;
+                content.y = (spec.height - content.height) / 2;
+            } else {
+                content.width = r_h * iw;
+                content.x = (spec.width - content.width) / 2;
+            }
+        } else if (spec.resize == ResizeMode::kCenterCrop) {
+            int m = std::min(iw, ih);
+            src = cv::Rect((iw - m) / 2, (ih - m) / 2, m, m);
+        }
+        size_t r = 0;
+        while (r < resizes_.size() && !(resizes_[r].src == src && resizes_[r].size == content.size())) {
+            r++;
+        }
+        if (r == resizes_.size()) {
+            ResizeStage stage;
+            stage.src = src;
+            stage.size = content.size();
+            resizes_.push_back(stage);
+        }
+        tensor.resize = r;
+        tensor.out.src = src;
+        tensor.out.content = content;
+        tensor.frame = -1;
+    }
+    planned_ = frame_size;
+}
+
+void PreprocessCache::set_frame(const cv::Mat& frame) {
+    frame_ = frame;
+    frame_id_++;
+    stats_.frames++;
+    if (frame.size() != planned_) {
+        plan(frame.size());
+    }
+}
+
+const cv::Mat& PreprocessCache::resized(int index) {
+    ResizeStage& stage = resizes_[index];
+    if (stage.frame != frame_id_) {
+        if (stage.size == frame_.size()) {
+            // a full-frame spec of the frame size, nothing to resize
+            stage.image = frame_;
+        } else {
+            cv::resize(frame_(stage.src), stage.image, stage.size, 0, 0, cv::INTER_LINEAR);
+            stats_.resizes++;
+        }
+        stage.frame = frame_id_;
+    }
+    return stage.image;
+}
+
+void PreprocessCache::fill(TensorStage& tensor, const cv::Mat& image) {
+    const InputSpec& spec = tensor.spec;
+    const cv::Rect& content = tensor.out.content;
+    const bool padded = content.width != spec.width || content.height != spec.height;
+    // byte of a BGR pixel that goes to each tensor channel
+    const int ch[3] = {spec.order == ChannelOrder::kRGB ? 2 : 0, 1, spec.order == ChannelOrder::kRGB ? 0 : 2};
+    if (spec.dtype == InputDType::kUint8) {
+        uint8_t* dst = (uint8_t*)tensor.storage.data();
+        if (padded) {
+            memset(dst, spec.pad, tensor.out.bytes);
+        }
+        for (int y = 0; y < content.height; y++) {
+            const uint8_t* s = image.ptr<uint8_t>(y);
+            uint8_t* d = dst + ((size_t)(content.y + y) * spec.width + content.x) * 3;
+            if (spec.order == ChannelOrder::kBGR) {
+                memcpy(d, s, content.width * 3);
+                continue;
+            }
+            for (int x = 0; x < content.width; x++) {
+                d[x * 3] = s[x * 3 + 2];
+                d[x * 3 + 1] = s[x * 3 + 1];
+                d[x * 3 + 2] = s[x * 3];
+            }
+        }
+        return;
+    }
+    const int plane = spec.width * spec.height;
+    float* planes[3] = {tensor.storage.data(), tensor.storage.data() + plane, tensor.storage.data() + 2 * plane};
+    const float* lut[3] = {&tensor.lut[0], &tensor.lut[256], &tensor.lut[512]};
+    if (padded) {
+        for (int c = 0; c < 3; c++) {
+            std::fill(planes[c], planes[c] + plane, lut[c][spec.pad]);
+        }
+    }
+    for (int y = 0; y < content.height; y++) {
+        const uint8_t* s = image.ptr<uint8_t>(y);
+        const size_t offset = (size_t)(content.y + y) * spec.width + content.x;
+        float* d0 = planes[0] + offset;
+        float* d1 = planes[1] + offset;
+        float* d2 = planes[2] + offset;
+        for (int x = 0; x < content.width; x++) {
+            d0[x] = lut[0][s[x * 3 + ch[0]]];
+            d1[x] = lut[1][s[x * 3 + ch[1]]];
+            d2[x] = lut[2][s[x * 3 + ch[2]]];
+        }
+    }
+}
+
+const PreprocessedInput& PreprocessCache::input(int model) {
+    stats_.requests++;
+    TensorStage& tensor = tensors_[model_tensor_[model]];
+    if (tensor.frame != frame_id_) {
+        fill(tensor, resized(tensor.resize));
+        tensor.frame = frame_id_;
+        stats_.tensors++;
+    }
+    return tensor.out;
+}
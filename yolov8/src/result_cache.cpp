@@ -0,0 +1,340 @@
+#include "result_cache.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+static const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t kPrime3 = 0x165667B19E3779F9ull;
+static const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl64(acc, 31);
+    return acc * kPrime1;
+}
+
+static inline uint64_t xxh64_merge_round(uint64_t acc, uint64_t val) {
+    acc ^= xxh64_round(0, val);
+    return acc * kPrime1 + kPrime4;
+}
+
+// Reference XXH64 for little-endian machines. At several GB/s per core, hashing an upload costs far less than
+// decoding it.
+uint64_t xxh64(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+    uint64_t h;
+    if (size >= 32) {
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        do {
+            v1 = xxh64_round(v1, read64(p));
+            v2 = xxh64_round(v2, read64(p + 8));
+            v3 = xxh64_round(v3, read64(p + 16));
+            v4 = xxh64_round(v4, read64(p + 24));
+            p += 32;
+        } while (p + 32 <= end);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64_merge_round(h, v1);
+        h = xxh64_merge_round(h, v2);
+        h = xxh64_merge_round(h, v3);
+        h = xxh64_merge_round(h, v4);
+    } else {
+        h = seed + kPrime5;
+    }
+    h += size;
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxh64_round(0, read64(p));
+        h = rotl64(h, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * kPrime1;
+        h = rotl64(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (*p) * kPrime5;
+        h = rotl64(h, 11) * kPrime1;
+    }
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+bool parse_cache_key_mode(const std::string& name, CacheKeyMode& mode) {
+    if (name == "encoded") {
+        mode = CacheKeyMode::kEncoded;
+    } else if (name == "pixels") {
+        mode = CacheKeyMode::kPixels;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+ResultCache::ResultCache(size_t budget_bytes, uint64_t config_id, CacheKeyMode mode)
+    : budget_bytes_(budget_bytes), config_id_(config_id), mode_(mode) {}
+
+uint64_t ResultCache::encoded_key(const void* data, size_t size) const {
+    return xxh64(data, size, config_id_);
+}
+
+uint64_t ResultCache::pixel_key(const cv::Mat& img) const {
+    const int kW = 17, kH = 16;
+    // mean gray of each cell of a kW x kH grid, computed directly instead of cv::resize so the hash does not
+    // depend on the OpenCV version
+    uint32_t gray[kH][kW];
+    for (int gy = 0; gy < kH; gy++) {
+        int y0 = gy * img.rows / kH, y1 = std::max(y0 + 1, (gy + 1) * img.rows / kH);
+        for (int gx = 0; gx < kW; gx++) {
+            int x0 = gx * img.cols / kW, x1 = std::max(x0 + 1, (gx + 1) * img.cols / kW);
+            uint64_t sum = 0;
+            for (int y = y0; y < y1; y++) {
+                const uint8_t* row = img.data + (size_t)y * img.step + x0 * 3;
+                for (int x = x0; x < x1; x++, row += 3) {
+                    sum += row[0] + 2 * row[1] + row[2];
+                }
+            }
+            gray[gy][gx] = (uint32_t)(sum / ((uint64_t)(y1 - y0) * (x1 - x0)));
+        }
+    }
+    // 256 gradient bits followed by the image size
+    uint64_t bits[(kW - 1) * kH / 64 + 1] = {0};
+    bits[(kW - 1) * kH / 64] = ((uint64_t)img.cols << 32) | (uint32_t)img.rows;
+    for (int gy = 0; gy < kH; gy++) {
+        for (int gx = 0; gx + 1 < kW; gx++) {
+            int bit = gy * (kW - 1) + gx;
+            if (gray[gy][gx] < gray[gy][gx + 1]) {
+                bits[bit / 64] |= 1ull << (bit % 64);
+            }
+        }
+    }
+    return xxh64(bits, sizeof(bits), config_id_);
+}
+
+size_t ResultCache::entry_bytes(size_t num_dets) {
+    // list node, index node and the boxes
+    return sizeof(Entry) + 4 * sizeof(void*) + 2 * sizeof(void*) + sizeof(uint64_t) +
+           num_dets * sizeof(CachedDetection);
+}
+
+bool ResultCache::lookup(uint64_t key, std::vector<Detection>& dets) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        stats_.misses++;
+        return false;
+    }
+    stats_.hits++;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    dets.clear();
+    for (const auto& c : it->second->dets) {
+        Detection det;
+        memset(&det, 0, sizeof(det));
+        memcpy(det.bbox, c.bbox, sizeof(c.bbox));
+        det.conf = c.conf;
+        det.class_id = c.class_id;
+        dets.push_back(det);
+    }
+    return true;
+}
+
+void ResultCache::insert_locked(uint64_t key, std::vector<CachedDetection> dets) {
+    size_t bytes = entry_bytes(dets.size());
+    if (bytes > budget_bytes_) {
+        return;
+    }
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        stats_.bytes -= entry_bytes(it->second->dets.size());
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+    while (stats_.bytes + bytes > budget_bytes_ && !lru_.empty()) {
+        stats_.bytes -= entry_bytes(lru_.back().dets.size());
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+        stats_.evictions++;
+    }
+    lru_.push_front(Entry{key, std::move(dets)});
+    index_[key] = lru_.begin();
+    stats_.bytes += bytes;
+}
+
+void ResultCache::insert(uint64_t key, const std::vector<Detection>& dets) {
+    std::vector<CachedDetection> cached(dets.size());
+    for (size_t i = 0; i < dets.size(); i++) {
+        memcpy(cached[i].bbox, dets[i].bbox, sizeof(cached[i].bbox));
+        cached[i].conf = dets[i].conf;
+        cached[i].class_id = dets[i].class_id;
+    }
+    std::string save_path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        insert_locked(key, std::move(cached));
+        if (save_every_ > 0 && ++unsaved_inserts_ >= save_every_) {
+            unsaved_inserts_ = 0;
+            save_path = persist_path_;
+        }
+    }
+    if (!save_path.empty()) {
+        save(save_path);
+    }
+}
+
+void ResultCache::set_persistence(const std::string& path, int save_every) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    persist_path_ = path;
+    save_every_ = path.empty() ? 0 : save_every;
+}
+
+// File layout, native byte order: header, then per entry uint64 key, uint64 count and count CachedDetection.
+struct ResultCacheFileHeader {
+    char magic[8];
+    uint64_t config_id;
+    uint64_t entries;
+};
+static const char kResultCacheMagic[8] = {'Y', 'V', '8', 'C', 'A', 'C', 'H', '1'};
+
+bool ResultCache::load(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ResultCacheFileHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "mmap " << path << " failed" << std::endl;
+        return false;
+    }
+    const uint8_t* p = static_cast<const uint8_t*>(mapping);
+    const uint8_t* end = p + size;
+    ResultCacheFileHeader header;
+    memcpy(&header, p, sizeof(header));
+    p += sizeof(header);
+    bool ok = memcmp(header.magic, kResultCacheMagic, sizeof(kResultCacheMagic)) == 0;
+    if (ok && header.config_id != config_id_) {
+        std::cerr << path << " was written for another engine or config, ignored" << std::endl;
+        ok = false;
+    }
+
+    // entries are stored most recently used first, inserting them in reverse keeps that order
+    std::vector<Entry> entries;
+    for (uint64_t i = 0; ok && i < header.entries; i++) {
+        uint64_t key, count;
+        ok = p + 2 * sizeof(uint64_t) <= end;
+        if (ok) {
+            memcpy(&key, p, sizeof(key));
+            memcpy(&count, p + sizeof(key), sizeof(count));
+            p += 2 * sizeof(uint64_t);
+            ok = count <= (size_t)(end - p) / sizeof(CachedDetection);
+        }
+        if (ok) {
+            Entry e{key, std::vector<CachedDetection>(count)};
+            memcpy(e.dets.data(), p, count * sizeof(CachedDetection));
+            p += count * sizeof(CachedDetection);
+            entries.push_back(std::move(e));
+        }
+    }
+    munmap(mapping, size);
+    if (!ok) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    lru_.clear();
+    index_.clear();
+    stats_.bytes = 0;
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        insert_locked(it->key, std::move(it->dets));
+    }
+    return true;
+}
+
+bool ResultCache::save(const std::string& path) {
+    // written from a snapshot, so lookups are only blocked while it is copied
+    std::vector<Entry> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        snapshot.assign(lru_.begin(), lru_.end());
+    }
+    std::lock_guard<std::mutex> save_lock(save_mutex_);
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        ResultCacheFileHeader header;
+        memcpy(header.magic, kResultCacheMagic, sizeof(kResultCacheMagic));
+        header.config_id = config_id_;
+        header.entries = snapshot.size();
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& e : snapshot) {
+            uint64_t count = e.dets.size();
+            out.write(reinterpret_cast<const char*>(&e.key), sizeof(e.key));
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            out.write(reinterpret_cast<const char*>(e.dets.data()), count * sizeof(CachedDetection));
+        }
+        if (!out.good()) {
+            std::cerr << "write " << tmp << " error!" << std::endl;
+            return false;
+        }
+    }
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        std::cerr << "rename " << tmp << " to " << path << " failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+ResultCacheStats ResultCache::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ResultCacheStats s = stats_;
+    s.entries = lru_.size();
+    return s;
+}
+
+uint64_t result_cache_config_id(const std::string& engine_path, float conf_thresh, float nms_thresh,
+                                int max_num_output_bbox, CacheKeyMode mode) {
+    std::ifstream file(engine_path, std::ios::binary);
+    std::vector<char> engine((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    struct {
+        float conf_thresh;
+        float nms_thresh;
+        int max_num_output_bbox;
+        int mode;
+    } settings = {conf_thresh, nms_thresh, max_num_output_bbox, (int)mode};
+    return xxh64(&settings, sizeof(settings), xxh64(engine.data(), engine.size()));
+}
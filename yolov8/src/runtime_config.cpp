@@ -0,0 +1,209 @@
+#include "runtime_config.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "types.h"
+
+RuntimeConfig::RuntimeConfig()
+    : batch_size(kBatchSize),
+      input_h(kInputH),
+      input_w(kInputW),
+      num_class(kNumClass),
+      conf_thresh(kConfThresh),
+      nms_thresh(kNmsThresh),
+      max_num_output_bbox(kMaxNumOutputBbox),
+      gpu_id(kGpuId),
+      dynamic(false),
+      uint8_input(false),
+      decode_reduce(false),
+      verbose(-1),
+      buffers(BufferStrategy::kDevice),
+      cache_mb(0),
+      cache_key(CacheKeyMode::kEncoded) {
+#if defined(USE_FP16)
+    precision = "fp16";
+#elif defined(USE_INT8)
+    precision = "int8";
+#else
+    precision = "fp32";
+#endif
+}
+
+static std::string trim(const std::string& str) {
+    size_t first = str.find_first_not_of(" \t\r");
+    if (first == std::string::npos) {
+        return "";
+    }
+    size_t last = str.find_last_not_of(" \t\r");
+    return str.substr(first, last - first + 1);
+}
+
+template <typename T>
+static bool parse_number(const std::string& value, T& out) {
+    std::istringstream iss(value);
+    T v;
+    if (!(iss >> v) || !iss.eof()) {
+        return false;
+    }
+    out = v;
+    return true;
+}
+
+bool set_runtime_config_value(RuntimeConfig& cfg, const std::string& key, const std::string& value) {
+    bool ok = false;
+    if (key == "precision") {
+        ok = value == "fp32" || value == "fp16" || value == "int8";
+        if (ok) {
+            cfg.precision = value;
+        }
+    } else if (key == "batch_size") {
+        ok = parse_number(value, cfg.batch_size);
+    } else if (key == "input_h") {
+        ok = parse_number(value, cfg.input_h);
+    } else if (key == "input_w") {
+        ok = parse_number(value, cfg.input_w);
+    } else if (key == "num_class") {
+        ok = parse_number(value, cfg.num_class);
+    } else if (key == "conf_thresh") {
+        ok = parse_number(value, cfg.conf_thresh);
+    } else if (key == "nms_thresh") {
+        ok = parse_number(value, cfg.nms_thresh);
+    } else if (key == "max_num_output_bbox") {
+        ok = parse_number(value, cfg.max_num_output_bbox);
+    } else if (key == "gpu_id") {
+        ok = parse_number(value, cfg.gpu_id);
+    } else if (key == "dynamic") {
+        ok = value == "0" || value == "1";
+        if (ok) {
+            cfg.dynamic = value == "1";
+        }
+    } else if (key == "uint8_input") {
+        ok = value == "0" || value == "1";
+        if (ok) {
+            cfg.uint8_input = value == "1";
+        }
+    } else if (key == "decode_reduce") {
+        ok = value == "0" || value == "1";
+        if (ok) {
+            cfg.decode_reduce = value == "1";
+        }
+    } else if (key == "verbose") {
+        ok = value == "0" || value == "1";
+        if (ok) {
+            cfg.verbose = value == "1";
+        }
+    } else if (key == "trace") {
+        ok = !value.empty();
+        cfg.trace = value;
+    } else if (key == "buffers") {
+        ok = parse_buffer_strategy(value, cfg.buffers);
+    } else if (key == "cache_mb") {
+        int mb = 0;
+        ok = parse_number(value, mb) && mb >= 0;
+        if (ok) {
+            cfg.cache_mb = mb;
+        }
+    } else if (key == "cache_key") {
+        ok = parse_cache_key_mode(value, cfg.cache_key);
+    } else if (key == "cache_file") {
+        ok = !value.empty();
+        cfg.cache_file = value;
+    }
+    if (!ok) {
+        std::cerr << "invalid config entry: " << key << " = " << value << std::endl;
+    }
+    return ok;
+}
+
+bool load_runtime_config_file(const std::string& path, RuntimeConfig& cfg) {
+    std::ifstream file(path);
+    if (!file.good()) {
+        std::cerr << "read " << path << " error!" << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line = line.substr(0, comment);
+        }
+        line = trim(line);
+        if (line.empty()) {
+            continue;
+        }
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "invalid config line: " << line << std::endl;
+            return false;
+        }
+        if (!set_runtime_config_value(cfg, trim(line.substr(0, eq)), trim(line.substr(eq + 1)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parse_runtime_config_args(int& argc, char** argv, RuntimeConfig& cfg) {
+    int kept = 0;
+    for (int i = 0; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (i == 0 || arg.compare(0, 2, "--") != 0) {
+            argv[kept++] = argv[i];
+            continue;
+        }
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "invalid argument: " << arg << std::endl;
+            return false;
+        }
+        std::string key = arg.substr(2, eq - 2);
+        std::string value = arg.substr(eq + 1);
+        bool ok = key == "config" ? load_runtime_config_file(value, cfg) : set_runtime_config_value(cfg, key, value);
+        if (!ok) {
+            return false;
+        }
+    }
+    argc = kept;
+    return true;
+}
+
+bool validate_runtime_config(const RuntimeConfig& cfg) {
+    bool ok = true;
+    if (cfg.batch_size <= 0) {
+        std::cerr << "batch_size must be positive" << std::endl;
+        ok = false;
+    }
+    if (cfg.input_h <= 0 || cfg.input_w <= 0 || cfg.input_h % 32 != 0 || cfg.input_w % 32 != 0) {
+        std::cerr << "input_h and input_w must be positive multiples of 32" << std::endl;
+        ok = false;
+    }
+    if (cfg.num_class <= 0 || cfg.max_num_output_bbox <= 0) {
+        std::cerr << "num_class and max_num_output_bbox must be positive" << std::endl;
+        ok = false;
+    }
+    if (cfg.conf_thresh < 0.f || cfg.conf_thresh > 1.f || cfg.nms_thresh < 0.f || cfg.nms_thresh > 1.f) {
+        std::cerr << "conf_thresh and nms_thresh must be in [0, 1]" << std::endl;
+        ok = false;
+    }
+    if (cfg.uint8_input && (cfg.dynamic || cfg.precision == "int8")) {
+        std::cerr << "uint8_input is not supported with dynamic or int8 engines" << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+void update_runtime_config_from_engine(RuntimeConfig& cfg, int max_batch_size, int input_h, int input_w,
+                                       int output_elements) {
+    cfg.batch_size = max_batch_size;
+    cfg.input_h = input_h;
+    cfg.input_w = input_w;
+    cfg.max_num_output_bbox = (output_elements - 1) * sizeof(float) / sizeof(Detection);
+}
+
+int output_size_per_image(const RuntimeConfig& cfg) {
+    return cfg.max_num_output_bbox * sizeof(Detection) / sizeof(float) + 1;
+}
+
+size_t input_size_per_batch(const RuntimeConfig& cfg) {
+    return (size_t)cfg.batch_size * 3 * cfg.input_h * cfg.input_w;
+}
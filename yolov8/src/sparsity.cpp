@@ -0,0 +1,77 @@
+#include "sparsity.h"
+#include <math.h>
+#include <stddef.h>
+
+void prune_2to4(std::vector<float>& w, int out, int in, int kk) {
+    for (int o = 0; o < out; o++) {
+        for (int c = 0; c + 4 <= in; c += 4) {
+            for (int s = 0; s < kk; s++) {
+                float* g[4];
+                for (int i = 0; i < 4; i++) {
+                    g[i] = &w[((size_t)o * in + c + i) * kk + s];
+                }
+                int keep0 = 0;
+                for (int i = 1; i < 4; i++) {
+                    if (fabsf(*g[i]) > fabsf(*g[keep0]))
+                        keep0 = i;
+                }
+                int keep1 = keep0 == 0 ? 1 : 0;
+                for (int i = 0; i < 4; i++) {
+                    if (i != keep0 && fabsf(*g[i]) > fabsf(*g[keep1]))
+                        keep1 = i;
+                }
+                for (int i = 0; i < 4; i++) {
+                    if (i != keep0 && i != keep1)
+                        *g[i] = 0.f;
+                }
+            }
+        }
+    }
+}
+
+bool check_2to4(const std::vector<float>& w, int out, int in, int kk) {
+    for (int o = 0; o < out; o++) {
+        for (int c = 0; c + 4 <= in; c += 4) {
+            for (int s = 0; s < kk; s++) {
+                int nonzero = 0;
+                for (int i = 0; i < 4; i++) {
+                    nonzero += w[((size_t)o * in + c + i) * kk + s] != 0.f;
+                }
+                if (nonzero > 2)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+PruneStats prune_conv_2to4(std::vector<float>& w, int out, int in, int kk) {
+    std::vector<float> original = w;
+    prune_2to4(w, out, in, kk);
+    double err = 0, norm = 0;
+    size_t zeros = 0;
+    for (size_t i = 0; i < w.size(); i++) {
+        err += (double)(original[i] - w[i]) * (original[i] - w[i]);
+        norm += (double)original[i] * original[i];
+        zeros += w[i] == 0.f;
+    }
+    PruneStats stats;
+    stats.sparsity = w.empty() ? 0.f : (float)zeros / w.size();
+    stats.rel_error = norm > 0 ? (float)sqrt(err / norm) : 0.f;
+    stats.valid = check_2to4(w, out, in, kk);
+    return stats;
+}
+
+int conv_kernel_size(const std::vector<int>& shape, int count, int out) {
+    if (out <= 0 || count % out != 0) {
+        return 0;
+    }
+    if (!shape.empty()) {
+        if (shape.size() != 4 || shape[0] != out || shape[2] != shape[3] ||
+            (long long)shape[1] * shape[2] * shape[3] * out != count) {
+            return 0;
+        }
+        return shape[2];
+    }
+    return (count / out) % 9 != 0 ? 1 : 0;
+}
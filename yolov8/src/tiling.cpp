@@ -0,0 +1,234 @@
+#include "tiling.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+bool parse_tile_args(int& argc, char** argv, TileOptions& opts) {
+    int kept = 0;
+    for (int i = 0; i < argc; i++) {
+        std::string arg(argv[i]);
+        bool ok = true;
+        if (i == 0 || arg.compare(0, 6, "--tile") != 0) {
+            argv[kept++] = argv[i];
+        } else if (arg == "--tile") {
+            opts.enabled = true;
+        } else if (arg.compare(0, 12, "--tile_size=") == 0) {
+            ok = sscanf(arg.c_str() + 12, "%dx%d", &opts.tile_w, &opts.tile_h) == 2 && opts.tile_w > 0 &&
+                 opts.tile_h > 0;
+            opts.enabled = true;
+        } else if (arg.compare(0, 15, "--tile_overlap=") == 0) {
+            opts.overlap = atof(arg.substr(15).c_str());
+            ok = opts.overlap >= 0.f && opts.overlap < 1.f;
+        } else if (arg.compare(0, 12, "--tile_full=") == 0) {
+            opts.full_frame = atoi(arg.substr(12).c_str()) != 0;
+        } else if (arg.compare(0, 13, "--tile_merge=") == 0) {
+            std::string name = arg.substr(13);
+            opts.merge = name == "nms" ? TileMerge::kNms : TileMerge::kFusion;
+            ok = name == "nms" || name == "fusion";
+        } else if (arg.compare(0, 20, "--tile_merge_thresh=") == 0) {
+            opts.merge_thresh = atof(arg.substr(20).c_str());
+            ok = opts.merge_thresh > 0.f && opts.merge_thresh <= 1.f;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "invalid argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    argc = kept;
+    return true;
+}
+
+Tile make_tile(const cv::Rect& roi, int input_w, int input_h) {
+    Tile tile;
+    tile.roi = roi;
+    // same letterbox as warpaffine_launch in preprocess.cu
+    tile.scale = std::min(input_h / (float)roi.height, input_w / (float)roi.width);
+    tile.pad_x = (input_w - tile.scale * roi.width) * 0.5f;
+    tile.pad_y = (input_h - tile.scale * roi.height) * 0.5f;
+    return tile;
+}
+
+// Start offsets of tiles of size tile along a side of size total, at most step apart, the last one at total - tile.
+static std::vector<int> tile_offsets(int total, int tile, int step) {
+    std::vector<int> offsets;
+    if (total <= tile) {
+        offsets.push_back(0);
+        return offsets;
+    }
+    int count = (total - tile + step - 1) / step + 1;
+    for (int i = 0; i < count; i++) {
+        offsets.push_back(std::min(i * step, total - tile));
+    }
+    return offsets;
+}
+
+std::vector<Tile> plan_tiles(int frame_w, int frame_h, int input_w, int input_h, const TileOptions& opts) {
+    int tile_w = opts.tile_w > 0 ? opts.tile_w : input_w;
+    int tile_h = opts.tile_h > 0 ? opts.tile_h : input_h;
+    int step_x = std::max(1, (int)std::floor(tile_w * (1.f - opts.overlap)));
+    int step_y = std::max(1, (int)std::floor(tile_h * (1.f - opts.overlap)));
+    std::vector<int> xs = tile_offsets(frame_w, tile_w, step_x);
+    std::vector<int> ys = tile_offsets(frame_h, tile_h, step_y);
+    std::vector<Tile> tiles;
+    bool single = xs.size() == 1 && ys.size() == 1;
+    if (opts.full_frame || single) {
+        tiles.push_back(make_tile(cv::Rect(0, 0, frame_w, frame_h), input_w, input_h));
+    }
+    if (single) {
+        return tiles;
+    }
+    for (int y : ys) {
+        for (int x : xs) {
+            cv::Rect roi(x, y, std::min(tile_w, frame_w - x), std::min(tile_h, frame_h - y));
+            tiles.push_back(make_tile(roi, input_w, input_h));
+        }
+    }
+    return tiles;
+}
+
+void tile_to_frame(const Tile& tile, std::vector<Detection>& dets) {
+    const float inv = 1.f / tile.scale;
+    const float x0 = tile.roi.x, y0 = tile.roi.y;
+    const float x1 = tile.roi.x + tile.roi.width, y1 = tile.roi.y + tile.roi.height;
+    for (auto& det : dets) {
+        det.bbox[0] = std::min(x1, std::max(x0, x0 + (det.bbox[0] - tile.pad_x) * inv));
+        det.bbox[1] = std::min(y1, std::max(y0, y0 + (det.bbox[1] - tile.pad_y) * inv));
+        det.bbox[2] = std::min(x1, std::max(x0, x0 + (det.bbox[2] - tile.pad_x) * inv));
+        det.bbox[3] = std::min(y1, std::max(y0, y0 + (det.bbox[3] - tile.pad_y) * inv));
+    }
+}
+
+// Boxes registered in every cell of a uniform grid they overlap, stored as one array per cell range (CSR). Two boxes
+// that overlap share at least one cell.
+struct BoxGrid {
+    float x0, y0, inv_cell;
+    int cols, rows;
+    std::vector<int> start, items;
+
+    void cells(const float* b, int& cx0, int& cy0, int& cx1, int& cy1) const {
+        cx0 = std::min(cols - 1, std::max(0, (int)((b[0] - x0) * inv_cell)));
+        cy0 = std::min(rows - 1, std::max(0, (int)((b[1] - y0) * inv_cell)));
+        cx1 = std::min(cols - 1, std::max(0, (int)((b[2] - x0) * inv_cell)));
+        cy1 = std::min(rows - 1, std::max(0, (int)((b[3] - y0) * inv_cell)));
+    }
+
+    // boxes holds [x1, y1, x2, y2] per box
+    void build(const std::vector<float>& boxes) {
+        const int n = boxes.size() / 4;
+        float x1 = boxes[2], y1 = boxes[3], side = 0.f;
+        x0 = boxes[0];
+        y0 = boxes[1];
+        for (int i = 0; i < n; i++) {
+            const float* b = &boxes[4 * i];
+            x0 = std::min(x0, b[0]);
+            y0 = std::min(y0, b[1]);
+            x1 = std::max(x1, b[2]);
+            y1 = std::max(y1, b[3]);
+            side += std::max(b[2] - b[0], b[3] - b[1]);
+        }
+        // cells of about twice the mean box size, at most 256 x 256 of them
+        float cell = std::max({2.f * side / n, 1.f, (x1 - x0) / 256, (y1 - y0) / 256});
+        inv_cell = 1.f / cell;
+        cols = (int)((x1 - x0) * inv_cell) + 1;
+        rows = (int)((y1 - y0) * inv_cell) + 1;
+        start.assign(cols * rows + 1, 0);
+        int cx0, cy0, cx1, cy1;
+        for (int i = 0; i < n; i++) {
+            cells(&boxes[4 * i], cx0, cy0, cx1, cy1);
+            for (int cy = cy0; cy <= cy1; cy++) {
+                for (int cx = cx0; cx <= cx1; cx++) {
+                    start[cy * cols + cx + 1]++;
+                }
+            }
+        }
+        for (int c = 0; c < cols * rows; c++) {
+            start[c + 1] += start[c];
+        }
+        items.resize(start.back());
+        std::vector<int> fill(start.begin(), start.end() - 1);
+        for (int i = 0; i < n; i++) {
+            cells(&boxes[4 * i], cx0, cy0, cx1, cy1);
+            for (int cy = cy0; cy <= cy1; cy++) {
+                for (int cx = cx0; cx <= cx1; cx++) {
+                    items[fill[cy * cols + cx]++] = i;
+                }
+            }
+        }
+    }
+};
+
+static float overlap_ratio(const float* a, const float* b, bool over_smaller) {
+    float w = std::min(a[2], b[2]) - std::max(a[0], b[0]);
+    float h = std::min(a[3], b[3]) - std::max(a[1], b[1]);
+    if (w <= 0.f || h <= 0.f) {
+        return 0.f;
+    }
+    float inter = w * h;
+    float area_a = (a[2] - a[0]) * (a[3] - a[1]), area_b = (b[2] - b[0]) * (b[3] - b[1]);
+    float denom = over_smaller ? std::min(area_a, area_b) : area_a + area_b - inter;
+    return denom > 0.f ? inter / denom : 0.f;
+}
+
+// Both merges visit the boxes by decreasing confidence; a box that is still free claims its free neighbours above
+// the threshold. NMS drops them, fusion grows the claiming box to their union.
+void merge_tile_detections(std::vector<Detection>& dets, TileMerge merge, float thresh) {
+    if (dets.size() < 2) {
+        return;
+    }
+    const bool fusion = merge == TileMerge::kFusion;
+    const int n = dets.size();
+    // compact copies, a Detection carries mask and keypoint fields the merge does not look at
+    std::vector<float> boxes(4 * n), conf(n);
+    std::vector<int> cls(n), order(n);
+    for (int i = 0; i < n; i++) {
+        std::copy(dets[i].bbox, dets[i].bbox + 4, &boxes[4 * i]);
+        conf[i] = dets[i].conf;
+        cls[i] = (int)dets[i].class_id;
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return conf[a] > conf[b]; });
+    BoxGrid grid;
+    grid.build(boxes);
+    std::vector<char> claimed(n, 0);
+    std::vector<int> seen(n, -1);
+    std::vector<Detection> res;
+    for (int i : order) {
+        if (claimed[i]) {
+            continue;
+        }
+        claimed[i] = 1;
+        const float* bi = &boxes[4 * i];
+        res.push_back(dets[i]);
+        float* out = res.back().bbox;
+        int cx0, cy0, cx1, cy1;
+        grid.cells(bi, cx0, cy0, cx1, cy1);
+        for (int cy = cy0; cy <= cy1; cy++) {
+            for (int cx = cx0; cx <= cx1; cx++) {
+                int cell = cy * grid.cols + cx;
+                for (int k = grid.start[cell]; k < grid.start[cell + 1]; k++) {
+                    int j = grid.items[k];
+                    if (claimed[j] || seen[j] == i || cls[j] != cls[i]) {
+                        continue;
+                    }
+                    seen[j] = i;
+                    const float* bj = &boxes[4 * j];
+                    if (overlap_ratio(bi, bj, fusion) > thresh) {
+                        claimed[j] = 1;
+                        if (fusion) {
+                            out[0] = std::min(out[0], bj[0]);
+                            out[1] = std::min(out[1], bj[1]);
+                            out[2] = std::max(out[2], bj[2]);
+                            out[3] = std::max(out[3], bj[3]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    dets.swap(res);
+}
@@ -0,0 +1,152 @@
+#include "trace.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+std::atomic<bool> g_trace_enabled{false};
+
+namespace {
+
+// Written only by its thread; head counts all spans ever recorded and is published with release so the exporter sees
+// complete entries.
+struct TraceRing {
+    std::unique_ptr<TraceSpan[]> spans{new TraceSpan[kTraceRingSize]};
+    std::atomic<uint64_t> head{0};
+    int tid = 0;
+    std::string thread_name;
+};
+
+// Rings outlive their threads, so spans of finished workers are still exported.
+std::mutex g_rings_mutex;
+std::vector<std::unique_ptr<TraceRing>> g_rings;
+
+// trace_now_ticks() and trace_now_ns() at the first trace_enable(true), the start of the tick rate measurement.
+int64_t g_calibration_ticks = 0;
+int64_t g_calibration_ns = 0;
+
+TraceRing* thread_ring() {
+    thread_local TraceRing* ring = nullptr;
+    if (ring == nullptr) {
+        std::unique_ptr<TraceRing> r(new TraceRing());
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        r->tid = (int)g_rings.size() + 1;
+        ring = r.get();
+        g_rings.push_back(std::move(r));
+    }
+    return ring;
+}
+
+std::string json_escape(const std::string& s) {
+    std::string res;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            res += '\\';
+        }
+        res += (unsigned char)c < 0x20 ? ' ' : c;
+    }
+    return res;
+}
+
+// Ticks per ns over the time since the first trace_enable(true), at least 10ms so the rate is good to about 1e-5.
+double ticks_per_ns() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (g_calibration_ns == 0) {
+        return 1.0;
+    }
+    int64_t elapsed_ns = trace_now_ns() - g_calibration_ns;
+    if (elapsed_ns < 10000000) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(10000000 - elapsed_ns));
+    }
+    int64_t ticks = trace_now_ticks();
+    return (double)(ticks - g_calibration_ticks) / (trace_now_ns() - g_calibration_ns);
+#else
+    return 1.0;
+#endif
+}
+
+}  // namespace
+
+void trace_enable(bool enabled) {
+    if (enabled) {
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        if (g_calibration_ns == 0) {
+            g_calibration_ticks = trace_now_ticks();
+            g_calibration_ns = trace_now_ns();
+        }
+    }
+    g_trace_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void trace_set_thread_name(const std::string& name) {
+    thread_ring()->thread_name = name;
+}
+
+void trace_record(const char* name, int64_t begin, int64_t end) {
+    TraceRing* ring = thread_ring();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    TraceSpan& span = ring->spans[head & (kTraceRingSize - 1)];
+    span.name = name;
+    span.begin = begin;
+    span.end = end;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+size_t trace_span_count() {
+    std::lock_guard<std::mutex> lock(g_rings_mutex);
+    size_t count = 0;
+    for (auto& ring : g_rings) {
+        count += std::min<uint64_t>(ring->head.load(std::memory_order_acquire), kTraceRingSize);
+    }
+    return count;
+}
+
+void trace_clear() {
+    std::lock_guard<std::mutex> lock(g_rings_mutex);
+    for (auto& ring : g_rings) {
+        ring->head.store(0, std::memory_order_release);
+    }
+}
+
+bool trace_write_chrome_json(const std::string& path) {
+    std::ofstream out(path);
+    if (!out.good()) {
+        std::cerr << "write " << path << " error!" << std::endl;
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(g_rings_mutex);
+    double rate = ticks_per_ns();
+
+    // timestamps relative to the first span keep the numbers short
+    int64_t origin = INT64_MAX;
+    for (auto& ring : g_rings) {
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (uint64_t i = head - std::min<uint64_t>(head, kTraceRingSize); i < head; i++) {
+            origin = std::min(origin, ring->spans[i & (kTraceRingSize - 1)].begin);
+        }
+    }
+
+    // one event per line, times in microseconds
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [" << std::endl;
+    bool first = true;
+    for (auto& ring : g_rings) {
+        std::string thread_name = ring->thread_name.empty() ? "thread " + std::to_string(ring->tid) : ring->thread_name;
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << ring->tid
+            << ", \"args\": {\"name\": \"" << json_escape(thread_name) << "\"}}";
+        first = false;
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (uint64_t i = head - std::min<uint64_t>(head, kTraceRingSize); i < head; i++) {
+            const TraceSpan& span = ring->spans[i & (kTraceRingSize - 1)];
+            out << ",\n{\"name\": \"" << json_escape(span.name) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+                << ring->tid << ", \"ts\": " << (span.begin - origin) / rate / 1000.0
+                << ", \"dur\": " << (span.end - span.begin) / rate / 1000.0 << "}";
+        }
+    }
+    out << "\n]}" << std::endl;
+    return out.good();
+}
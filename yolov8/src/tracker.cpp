@@ -0,0 +1,500 @@
+#include "tracker.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Process and measurement noise relative to the box size, as in ByteTrack and BoT-SORT: x and w scale with the
+// width, y and h with the height. With a diagonal noise model every (position, velocity) pair evolves on its own, so
+// the 8x8 covariance of the reference filter reduces to four 2x2 blocks.
+static const float kStdWeightPosition = 1.f / 20;
+static const float kStdWeightVelocity = 1.f / 160;
+
+ByteTracker::ByteTracker(const TrackerOptions& opts) : opts_(opts) {
+    const int T = opts_.max_tracks, D = opts_.max_detections;
+    for (int d = 0; d < 4; d++) {
+        mean_[d].resize(T);
+        vel_[d].resize(T);
+        p00_[d].resize(T);
+        p01_[d].resize(T);
+        p11_[d].resize(T);
+        box_[d].resize(T);
+        det_box_[d].resize(D);
+        pass_box_[d].resize(D);
+    }
+    id_.resize(T);
+    class_.resize(T);
+    hits_.resize(T);
+    lost_.resize(T);
+    since_update_.resize(T);
+    confirmed_.resize(T);
+    conf_.resize(T);
+    area_.resize(T);
+    det_area_.resize(D);
+    det_conf_.resize(D);
+    det_class_.resize(D);
+    pass_area_.resize(D);
+    pass_class_.resize(D);
+    iou_.resize((size_t)T * D);
+    track_match_.resize(T);
+    det_match_.resize(D);
+    pass_tracks_.reserve(T);
+    rest_tracks_.reserve(T);
+    unconfirmed_.reserve(T);
+    pass_dets_.reserve(D);
+    rest_dets_.reserve(D);
+    low_dets_.reserve(D);
+    output_.reserve(T);
+    if (opts_.hungarian) {
+        int n = std::max(T, D);
+        parent_.resize(T + D);
+        group_start_.resize(T + D + 1);
+        group_order_.resize(T + D);
+        group_rows_.reserve(T);
+        group_cols_.reserve(D);
+        cost_.resize((size_t)T * D);
+        u_.resize(n + 1);
+        v_.resize(n + 1);
+        minv_.resize(n + 1);
+        p_.resize(n + 1);
+        way_.resize(n + 1);
+        used_.resize(n + 1);
+    } else {
+        candidates_.reserve((size_t)T * D);
+    }
+}
+
+void ByteTracker::reset() {
+    num_ = 0;
+    num_dets_ = 0;
+    next_id_ = 1;
+    frame_ = 0;
+    output_.clear();
+}
+
+void ByteTracker::predict_states() {
+    const int n = num_;
+    for (int d = 0; d < 4; d++) {
+        // sizes are read before they are advanced, so all four pairs use the same scale
+        const float* scale = d % 2 == 0 ? mean_[2].data() : mean_[3].data();
+        float* x = mean_[d].data();
+        float* v = vel_[d].data();
+        float* p00 = p00_[d].data();
+        float* p01 = p01_[d].data();
+        float* p11 = p11_[d].data();
+        for (int i = 0; i < n; i++) {
+            float sp = kStdWeightPosition * scale[i];
+            float sv = kStdWeightVelocity * scale[i];
+            x[i] += v[i];
+            p00[i] += 2.f * p01[i] + p11[i] + sp * sp;
+            p01[i] += p11[i];
+            p11[i] += sv * sv;
+        }
+    }
+    const float* cx = mean_[0].data();
+    const float* cy = mean_[1].data();
+    const float* w = mean_[2].data();
+    const float* h = mean_[3].data();
+    for (int i = 0; i < n; i++) {
+        float bw = std::max(w[i], 1e-3f), bh = std::max(h[i], 1e-3f);
+        box_[0][i] = cx[i] - 0.5f * bw;
+        box_[1][i] = cy[i] - 0.5f * bh;
+        box_[2][i] = cx[i] + 0.5f * bw;
+        box_[3][i] = cy[i] + 0.5f * bh;
+        area_[i] = bw * bh;
+    }
+}
+
+void ByteTracker::compute_iou(const std::vector<int>& tracks, const std::vector<int>& dets) {
+    const int nd = dets.size();
+    for (int j = 0; j < nd; j++) {
+        int k = dets[j];
+        for (int d = 0; d < 4; d++) {
+            pass_box_[d][j] = det_box_[d][k];
+        }
+        pass_area_[j] = det_area_[k];
+        pass_class_[j] = det_class_[k];
+    }
+    const float* __restrict dx1 = pass_box_[0].data();
+    const float* __restrict dy1 = pass_box_[1].data();
+    const float* __restrict dx2 = pass_box_[2].data();
+    const float* __restrict dy2 = pass_box_[3].data();
+    const float* __restrict da = pass_area_.data();
+    const int* __restrict dc = pass_class_.data();
+    const int any_class = opts_.per_class ? 0 : 1;
+    for (size_t t = 0; t < tracks.size(); t++) {
+        int slot = tracks[t];
+        const float tx1 = box_[0][slot], ty1 = box_[1][slot], tx2 = box_[2][slot], ty2 = box_[3][slot];
+        const float ta = area_[slot];
+        const int tc = class_[slot];
+        float* __restrict row = &iou_[t * nd];
+        // selects and an integer class test instead of std::min/max and ?: keep the loop branch-free, so it vectorizes
+        for (int j = 0; j < nd; j++) {
+            float iw = (tx2 < dx2[j] ? tx2 : dx2[j]) - (tx1 > dx1[j] ? tx1 : dx1[j]);
+            float ih = (ty2 < dy2[j] ? ty2 : dy2[j]) - (ty1 > dy1[j] ? ty1 : dy1[j]);
+            iw = iw > 0.f ? iw : 0.f;
+            ih = ih > 0.f ? ih : 0.f;
+            float inter = iw * ih;
+            float same = (float)((tc == dc[j]) | any_class);
+            row[j] = same * inter / (ta + da[j] - inter + 1e-6f);
+        }
+    }
+}
+
+void ByteTracker::associate(std::vector<int>& tracks, std::vector<int>& dets, float min_iou) {
+    if (tracks.empty() || dets.empty()) {
+        return;
+    }
+    compute_iou(tracks, dets);
+    if (opts_.hungarian) {
+        match_hungarian(tracks, dets, min_iou);
+    } else {
+        match_greedy(tracks, dets, min_iou);
+    }
+}
+
+void ByteTracker::match_greedy(std::vector<int>& tracks, std::vector<int>& dets, float min_iou) {
+    const int nd = dets.size();
+    candidates_.clear();
+    for (size_t t = 0; t < tracks.size(); t++) {
+        const float* row = &iou_[t * nd];
+        for (int j = 0; j < nd; j++) {
+            if (row[j] >= min_iou) {
+                candidates_.push_back({row[j], (int)t, j});
+            }
+        }
+    }
+    std::sort(candidates_.begin(), candidates_.end(), [](const Candidate& a, const Candidate& b) {
+        return a.iou > b.iou || (a.iou == b.iou && (a.track < b.track || (a.track == b.track && a.det < b.det)));
+    });
+    for (const auto& c : candidates_) {
+        int slot = tracks[c.track], det = dets[c.det];
+        if (track_match_[slot] < 0 && det_match_[det] < 0) {
+            track_match_[slot] = det;
+            det_match_[det] = slot;
+        }
+    }
+}
+
+int ByteTracker::find_root(int node) {
+    while (parent_[node] != node) {
+        parent_[node] = parent_[parent_[node]];
+        node = parent_[node];
+    }
+    return node;
+}
+
+// Tracks and detections linked by an IoU above min_iou form independent groups, usually of one or two each. Solving
+// every group on its own keeps the optimal assignment cheap even with hundreds of tracks.
+void ByteTracker::match_hungarian(std::vector<int>& tracks, std::vector<int>& dets, float min_iou) {
+    const int nt = tracks.size(), nd = dets.size(), nodes = nt + nd;
+    for (int i = 0; i < nodes; i++) {
+        parent_[i] = i;
+    }
+    for (int t = 0; t < nt; t++) {
+        const float* row = &iou_[(size_t)t * nd];
+        for (int j = 0; j < nd; j++) {
+            if (row[j] >= min_iou) {
+                int a = find_root(t), b = find_root(nt + j);
+                if (a != b) {
+                    parent_[a] = b;
+                }
+            }
+        }
+    }
+    // counting sort of the nodes by root; afterwards group r is [r ? group_start_[r - 1] : 0, group_start_[r])
+    std::fill(group_start_.begin(), group_start_.begin() + nodes + 1, 0);
+    for (int i = 0; i < nodes; i++) {
+        parent_[i] = find_root(i);
+        group_start_[parent_[i] + 1]++;
+    }
+    for (int r = 0; r < nodes; r++) {
+        group_start_[r + 1] += group_start_[r];
+    }
+    for (int i = 0; i < nodes; i++) {
+        group_order_[group_start_[parent_[i]]++] = i;
+    }
+    for (int r = 0; r < nodes; r++) {
+        int begin = r > 0 ? group_start_[r - 1] : 0, end = group_start_[r];
+        group_rows_.clear();
+        group_cols_.clear();
+        for (int k = begin; k < end; k++) {
+            int node = group_order_[k];
+            if (node < nt) {
+                group_rows_.push_back(node);
+            } else {
+                group_cols_.push_back(node - nt);
+            }
+        }
+        if (group_rows_.empty() || group_cols_.empty()) {
+            continue;
+        }
+        if (group_rows_.size() == 1 && group_cols_.size() == 1) {
+            int slot = tracks[group_rows_[0]], det = dets[group_cols_[0]];
+            track_match_[slot] = det;
+            det_match_[det] = slot;
+            continue;
+        }
+        bool transposed = group_rows_.size() > group_cols_.size();
+        int rows = transposed ? group_cols_.size() : group_rows_.size();
+        int cols = transposed ? group_rows_.size() : group_cols_.size();
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) {
+                int t = transposed ? group_rows_[j] : group_rows_[i];
+                int d = transposed ? group_cols_[i] : group_cols_[j];
+                float iou = iou_[(size_t)t * nd + d];
+                cost_[(size_t)i * cols + j] = iou >= min_iou ? 1.0 - iou : 1.0;
+            }
+        }
+        solve_assignment(rows, cols);
+        for (int j = 1; j <= cols; j++) {
+            if (p_[j] == 0) {
+                continue;
+            }
+            int t = transposed ? group_rows_[j - 1] : group_rows_[p_[j] - 1];
+            int d = transposed ? group_cols_[p_[j] - 1] : group_cols_[j - 1];
+            if (iou_[(size_t)t * nd + d] >= min_iou) {
+                track_match_[tracks[t]] = dets[d];
+                det_match_[dets[d]] = tracks[t];
+            }
+        }
+    }
+}
+
+// Hungarian algorithm with potentials, O(rows^2 cols) for rows <= cols. p_[j] is the 1-based row assigned to column
+// j, or 0.
+void ByteTracker::solve_assignment(int rows, int cols) {
+    const double inf = std::numeric_limits<double>::max();
+    std::fill(u_.begin(), u_.begin() + rows + 1, 0.0);
+    std::fill(v_.begin(), v_.begin() + cols + 1, 0.0);
+    std::fill(p_.begin(), p_.begin() + cols + 1, 0);
+    std::fill(way_.begin(), way_.begin() + cols + 1, 0);
+    for (int i = 1; i <= rows; i++) {
+        p_[0] = i;
+        int j0 = 0;
+        std::fill(minv_.begin(), minv_.begin() + cols + 1, inf);
+        std::fill(used_.begin(), used_.begin() + cols + 1, 0);
+        do {
+            used_[j0] = 1;
+            int i0 = p_[j0], j1 = 0;
+            double delta = inf;
+            for (int j = 1; j <= cols; j++) {
+                if (!used_[j]) {
+                    double cur = cost_[(size_t)(i0 - 1) * cols + (j - 1)] - u_[i0] - v_[j];
+                    if (cur < minv_[j]) {
+                        minv_[j] = cur;
+                        way_[j] = j0;
+                    }
+                    if (minv_[j] < delta) {
+                        delta = minv_[j];
+                        j1 = j;
+                    }
+                }
+            }
+            for (int j = 0; j <= cols; j++) {
+                if (used_[j]) {
+                    u_[p_[j]] += delta;
+                    v_[j] -= delta;
+                } else {
+                    minv_[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p_[j0] != 0);
+        do {
+            int j1 = way_[j0];
+            p_[j0] = p_[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+}
+
+void ByteTracker::update_state(int slot, int det) {
+    float z[4] = {(det_box_[0][det] + det_box_[2][det]) * 0.5f, (det_box_[1][det] + det_box_[3][det]) * 0.5f,
+                  det_box_[2][det] - det_box_[0][det], det_box_[3][det] - det_box_[1][det]};
+    float scale[2] = {mean_[2][slot], mean_[3][slot]};
+    for (int d = 0; d < 4; d++) {
+        float sr = kStdWeightPosition * scale[d % 2];
+        float p00 = p00_[d][slot], p01 = p01_[d][slot], p11 = p11_[d][slot];
+        float s = p00 + sr * sr;
+        float k0 = p00 / s, k1 = p01 / s;
+        float y = z[d] - mean_[d][slot];
+        mean_[d][slot] += k0 * y;
+        vel_[d][slot] += k1 * y;
+        p00_[d][slot] = (1.f - k0) * p00;
+        p01_[d][slot] = (1.f - k0) * p01;
+        p11_[d][slot] = p11 - k1 * p01;
+    }
+    conf_[slot] = det_conf_[det];
+    hits_[slot]++;
+    lost_[slot] = 0;
+    since_update_[slot] = 0;
+    confirmed_[slot] = 1;
+}
+
+void ByteTracker::start_track(int det) {
+    int slot = num_++;
+    float z[4] = {(det_box_[0][det] + det_box_[2][det]) * 0.5f, (det_box_[1][det] + det_box_[3][det]) * 0.5f,
+                  det_box_[2][det] - det_box_[0][det], det_box_[3][det] - det_box_[1][det]};
+    for (int d = 0; d < 4; d++) {
+        float scale = z[2 + d % 2];
+        float sp = 2.f * kStdWeightPosition * scale, sv = 10.f * kStdWeightVelocity * scale;
+        mean_[d][slot] = z[d];
+        vel_[d][slot] = 0.f;
+        p00_[d][slot] = sp * sp;
+        p01_[d][slot] = 0.f;
+        p11_[d][slot] = sv * sv;
+    }
+    id_[slot] = next_id_++;
+    class_[slot] = det_class_[det];
+    conf_[slot] = det_conf_[det];
+    hits_[slot] = 1;
+    lost_[slot] = 0;
+    since_update_[slot] = 0;
+    // tracks of the first frame count right away, later ones need a second detection
+    confirmed_[slot] = frame_ == 1;
+}
+
+void ByteTracker::remove_slot(int slot) {
+    int last = --num_;
+    if (slot == last) {
+        return;
+    }
+    for (int d = 0; d < 4; d++) {
+        mean_[d][slot] = mean_[d][last];
+        vel_[d][slot] = vel_[d][last];
+        p00_[d][slot] = p00_[d][last];
+        p01_[d][slot] = p01_[d][last];
+        p11_[d][slot] = p11_[d][last];
+        box_[d][slot] = box_[d][last];
+    }
+    area_[slot] = area_[last];
+    id_[slot] = id_[last];
+    class_[slot] = class_[last];
+    conf_[slot] = conf_[last];
+    hits_[slot] = hits_[last];
+    lost_[slot] = lost_[last];
+    since_update_[slot] = since_update_[last];
+    confirmed_[slot] = confirmed_[last];
+    track_match_[slot] = track_match_[last];
+}
+
+void ByteTracker::box_of(int slot, float bbox[4]) const {
+    float w = std::max(mean_[2][slot], 0.f), h = std::max(mean_[3][slot], 0.f);
+    bbox[0] = mean_[0][slot] - 0.5f * w;
+    bbox[1] = mean_[1][slot] - 0.5f * h;
+    bbox[2] = mean_[0][slot] + 0.5f * w;
+    bbox[3] = mean_[1][slot] + 0.5f * h;
+}
+
+void ByteTracker::write_output() {
+    output_.clear();
+    for (int slot = 0; slot < num_; slot++) {
+        if (!confirmed_[slot] || lost_[slot] > 0) {
+            continue;
+        }
+        Track t;
+        t.id = id_[slot];
+        box_of(slot, t.bbox);
+        t.conf = conf_[slot];
+        t.class_id = class_[slot];
+        t.hits = hits_[slot];
+        t.frames_since_update = since_update_[slot];
+        output_.push_back(t);
+    }
+}
+
+const std::vector<Track>& ByteTracker::update(const std::vector<Detection>& dets) {
+    frame_++;
+    predict_states();
+
+    num_dets_ = 0;
+    for (const auto& det : dets) {
+        if (num_dets_ == opts_.max_detections) {
+            break;
+        }
+        if (det.conf < opts_.low_thresh) {
+            continue;
+        }
+        int k = num_dets_++;
+        for (int d = 0; d < 4; d++) {
+            det_box_[d][k] = det.bbox[d];
+        }
+        det_area_[k] = std::max(0.f, det.bbox[2] - det.bbox[0]) * std::max(0.f, det.bbox[3] - det.bbox[1]);
+        det_conf_[k] = det.conf;
+        det_class_[k] = (int)det.class_id;
+    }
+    std::fill(track_match_.begin(), track_match_.begin() + num_, -1);
+    std::fill(det_match_.begin(), det_match_.begin() + num_dets_, -1);
+
+    // first pass: confident detections against confirmed tracks, including lost ones
+    pass_tracks_.clear();
+    unconfirmed_.clear();
+    for (int slot = 0; slot < num_; slot++) {
+        (confirmed_[slot] ? pass_tracks_ : unconfirmed_).push_back(slot);
+    }
+    pass_dets_.clear();
+    low_dets_.clear();
+    for (int k = 0; k < num_dets_; k++) {
+        (det_conf_[k] >= opts_.high_thresh ? pass_dets_ : low_dets_).push_back(k);
+    }
+    associate(pass_tracks_, pass_dets_, opts_.match_iou);
+
+    // second pass: low-score detections continue the tracks that were tracked until now
+    rest_tracks_.clear();
+    for (int slot : pass_tracks_) {
+        if (track_match_[slot] < 0 && lost_[slot] == 0) {
+            rest_tracks_.push_back(slot);
+        }
+    }
+    associate(rest_tracks_, low_dets_, opts_.low_match_iou);
+
+    // tracks seen once only get the confident detections nobody else took
+    rest_dets_.clear();
+    for (int k : pass_dets_) {
+        if (det_match_[k] < 0) {
+            rest_dets_.push_back(k);
+        }
+    }
+    associate(unconfirmed_, rest_dets_, opts_.unconfirmed_iou);
+
+    for (int slot = 0; slot < num_; slot++) {
+        if (track_match_[slot] >= 0) {
+            update_state(slot, track_match_[slot]);
+        } else {
+            lost_[slot]++;
+            since_update_[slot]++;
+        }
+    }
+    for (int slot = num_ - 1; slot >= 0; slot--) {
+        if (track_match_[slot] < 0 && (!confirmed_[slot] || lost_[slot] > opts_.max_lost)) {
+            remove_slot(slot);
+        }
+    }
+    for (int k : rest_dets_) {
+        if (det_match_[k] < 0 && det_conf_[k] >= opts_.new_track_thresh && num_ < opts_.max_tracks) {
+            start_track(k);
+        }
+    }
+    write_output();
+    return output_;
+}
+
+const std::vector<Track>& ByteTracker::predict() {
+    predict_states();
+    for (int slot = 0; slot < num_; slot++) {
+        since_update_[slot]++;
+    }
+    write_output();
+    return output_;
+}
+
+float ByteTracker::max_relative_uncertainty() const {
+    float res = 0.f;
+    for (int slot = 0; slot < num_; slot++) {
+        if (confirmed_[slot] && lost_[slot] == 0) {
+            float var = std::max(p00_[0][slot], p00_[1][slot]);
+            res = std::max(res, std::sqrt(var) / std::max(mean_[3][slot], 1.f));
+        }
+    }
+    return res;
+}
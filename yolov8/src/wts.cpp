@@ -0,0 +1,117 @@
+#include "wts.h"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+float halfToFloat(uint16_t h) {
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1f;
+    uint32_t mantissa = h & 0x3ff;
+    uint32_t bits;
+    if (exponent == 0x1f) {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else {
+        // subnormal half, renormalize
+        exponent = 113;
+        while ((mantissa & 0x400) == 0) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+bool readWtsEntry(std::istream& input, std::string& name, std::string& type, float*& values, uint32_t& count,
+                  std::vector<int>* shape) {
+    values = nullptr;
+    if (shape) {
+        shape->clear();
+    }
+    if (!(input >> name >> type)) {
+        return false;
+    }
+    uint64_t shape_elements = 0;
+    if (type == "shape") {
+        std::string dims;
+        if (!(input >> dims >> type)) {
+            return false;
+        }
+        uint64_t elements = 1;
+        for (const char* p = dims.c_str();; p++) {
+            char* end = nullptr;
+            long d = strtol(p, &end, 10);
+            if (end == p || d <= 0) {
+                return false;
+            }
+            elements *= d;
+            if (shape) {
+                shape->push_back(d);
+            }
+            p = end;
+            if (*p == '\0') {
+                break;
+            }
+            if (*p != 'x') {
+                return false;
+            }
+        }
+        shape_elements = elements;
+    }
+    if (type != "fp16" && type != "int8") {
+        char* end = nullptr;
+        unsigned long size = strtoul(type.c_str(), &end, 10);
+        if (end == type.c_str() || *end != '\0') {
+            return false;
+        }
+        count = size;
+        type = "fp32";
+    } else if (!(input >> std::dec >> count)) {
+        return false;
+    }
+    if (shape_elements != 0 && shape_elements != count) {
+        return false;
+    }
+
+    float* val = reinterpret_cast<float*>(malloc(sizeof(float) * count));
+    uint32_t bits;
+    if (type == "fp32") {
+        for (uint32_t x = 0; x < count && input >> std::hex >> bits; x++) {
+            memcpy(&val[x], &bits, sizeof(float));
+        }
+    } else if (type == "fp16") {
+        for (uint32_t x = 0; x < count && input >> std::hex >> bits; x++) {
+            val[x] = halfToFloat((uint16_t)bits);
+        }
+    } else {
+        // per-channel symmetric int8, dequantized as q * scale[channel]
+        uint32_t channels = 0;
+        input >> std::dec >> channels;
+        if (!input || channels == 0 || count % channels != 0) {
+            free(val);
+            input.setstate(std::ios::failbit);
+            return false;
+        }
+        std::vector<float> scales(channels);
+        for (uint32_t c = 0; c < channels && input >> std::hex >> bits; c++) {
+            memcpy(&scales[c], &bits, sizeof(float));
+        }
+        uint32_t per_channel = count / channels;
+        for (uint32_t x = 0; x < count && input >> std::hex >> bits; x++) {
+            val[x] = (float)(int8_t)(uint8_t)bits * scales[x / per_channel];
+        }
+    }
+    input >> std::dec;
+    if (!input) {
+        free(val);
+        return false;
+    }
+    values = val;
+    return true;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "cascade.h"
+
+// Painted objects and a mock classifier that reads them back, for the cascade test and yolov8_cascade_bench.
+
+// bbox as [x, y, w, h], what CropBatcher takes
+static inline Detection make_xywh_det(float x, float y, float w, float h, int class_id) {
+    Detection det;
+    memset(&det, 0, sizeof(Detection));
+    det.bbox[0] = x;
+    det.bbox[1] = y;
+    det.bbox[2] = w;
+    det.bbox[3] = h;
+    det.conf = 0.9f;
+    det.class_id = class_id;
+    return det;
+}
+
+// Objects are painted with B = id % 256, G = id / 256 and R = 200. The mock reads the id back from the center pixel
+// of the crop and makes it the most likely class, or returns fixed logits when timing.
+class MockClassifier : public CropClassifier {
+   public:
+    MockClassifier(int max_batch, bool decode)
+        : max_batch_(max_batch), decode_(decode), input_((size_t)max_batch * 3 * kClsInputH * kClsInputW),
+          logits_((size_t)max_batch * kClsNumClass) {
+        for (size_t i = 0; i < logits_.size(); i++) {
+            logits_[i] = (float)((i * 2654435761u) % 1000) / 100.f;
+        }
+    }
+
+    int max_batch() const override { return max_batch_; }
+    cv::Size input_size() const override { return cv::Size(kClsInputW, kClsInputH); }
+    int num_classes() const override { return kClsNumClass; }
+    float* input() override { return input_.data(); }
+
+    const float* classify(int n) override {
+        batch_sizes_.push_back(n);
+        if (!decode_) {
+            return logits_.data();
+        }
+        const int plane = kClsInputH * kClsInputW;
+        const int center = (kClsInputH / 2) * kClsInputW + kClsInputW / 2;
+        for (int i = 0; i < n; i++) {
+            const float* crop = input_.data() + (size_t)i * 3 * plane;
+            int id = (int)std::lround(crop[2 * plane + center] * 255) +
+                     256 * (int)std::lround(crop[plane + center] * 255);
+            float* l = logits_.data() + (size_t)i * kClsNumClass;
+            for (int c = 0; c < kClsNumClass; c++) {
+                l[c] = -0.01f * std::abs(c - id % kClsNumClass);
+            }
+            l[id % kClsNumClass] = 10.f;
+        }
+        return logits_.data();
+    }
+
+    std::vector<int> batch_sizes_;
+
+   private:
+    int max_batch_;
+    bool decode_;
+    std::vector<float> input_;
+    std::vector<float> logits_;
+};
+
+// count boxes of 10 to 200 pixels with ids from first_id, painted into img. Each lies in its own cell of a 210 pixel
+// grid, so they do not overlap unless there are more boxes than cells.
+static inline std::vector<Detection> make_objects(cv::Mat& img, int count, int first_id, std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    const int cols = img.cols / 210, cells = cols * (img.rows / 210);
+    std::vector<Detection> dets;
+    for (int i = 0; i < count; i++) {
+        int w = 10 + (int)(190 * unit(rng)), h = 10 + (int)(190 * unit(rng));
+        int x = (i % cells) % cols * 210 + (int)((210 - w) * unit(rng));
+        int y = (i % cells) / cols * 210 + (int)((210 - h) * unit(rng));
+        int id = first_id + i;
+        for (int r = y; r < y + h; r++) {
+            uint8_t* p = img.ptr<uint8_t>(r) + x * 3;
+            for (int c = 0; c < w; c++, p += 3) {
+                p[0] = id % 256;
+                p[1] = id / 256;
+                p[2] = 200;
+            }
+        }
+        dets.push_back(make_xywh_det(x, y, w, h, id % 4));
+    }
+    return dets;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "image_loader.h"
+
+// Photo-like frames and their JPEGs, for the decode test and yolov8_decode_bench.
+
+// smooth gradients with noise, a photo-like amount of detail for the entropy decoder
+static inline void make_frame(cv::Mat& img, std::mt19937& rng) {
+    std::uniform_int_distribution<int> noise(-12, 12);
+    for (int y = 0; y < img.rows; y++) {
+        uint8_t* p = img.ptr<uint8_t>(y);
+        for (int x = 0; x < img.cols; x++) {
+            p[x * 3] = std::min(255, std::max(0, 60 + x * 80 / img.cols + noise(rng)));
+            p[x * 3 + 1] = std::min(255, std::max(0, 60 + y * 80 / img.rows + noise(rng)));
+            p[x * 3 + 2] = std::min(255, std::max(0, 100 + noise(rng)));
+        }
+    }
+}
+
+static inline std::vector<uint8_t> encode(const cv::Mat& img) {
+    std::vector<uint8_t> jpeg;
+    cv::imencode(".jpg", img, jpeg, std::vector<int>{cv::IMWRITE_JPEG_QUALITY, 90});
+    return jpeg;
+}
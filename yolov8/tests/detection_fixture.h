@@ -0,0 +1,25 @@
+#pragma once
+#include <string.h>
+#include <algorithm>
+#include "types.h"
+
+// Boxes for the tests and benches of the CPU stages after NMS, bbox as [x1, y1, x2, y2].
+
+static inline Detection make_det(float x1, float y1, float x2, float y2, float conf, int class_id = 0) {
+    Detection det;
+    memset(&det, 0, sizeof(Detection));
+    det.bbox[0] = x1;
+    det.bbox[1] = y1;
+    det.bbox[2] = x2;
+    det.bbox[3] = y2;
+    det.conf = conf;
+    det.class_id = class_id;
+    return det;
+}
+
+static inline float box_iou(const float* a, const float* b) {
+    float w = std::max(0.f, std::min(a[2], b[2]) - std::max(a[0], b[0]));
+    float h = std::max(0.f, std::min(a[3], b[3]) - std::max(a[1], b[1]));
+    float inter = w * h;
+    return inter / ((a[2] - a[0]) * (a[3] - a[1]) + (b[2] - b[0]) * (b[3] - b[1]) - inter);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Synthetic fixed-camera sequence for the motion gate test and yolov8_motion_bench.
+
+struct Sequence {
+    int width, height;
+    std::vector<uint8_t> background;
+    std::mt19937 rng;
+    cv::Mat frame;
+
+    Sequence(int w, int h) : width(w), height(h), background((size_t)w * h * 3), rng(1), frame(h, w, CV_8UC3) {
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                for (int c = 0; c < 3; c++) {
+                    double v = 64 + 48 * std::sin(x * 0.05 + c) + 40 * std::cos(y * 0.03);
+                    background[((size_t)y * w + x) * 3 + c] = (uint8_t)v;
+                }
+            }
+        }
+    }
+
+    // background with noise of +-noise, and a size x size object with a horizontal gradient at (ox, oy) if size > 0
+    const cv::Mat& render(int noise, int ox, int oy, int size) {
+        for (int y = 0; y < height; y++) {
+            uint8_t* row = frame.data + (size_t)y * frame.step;
+            const uint8_t* bg = &background[(size_t)y * width * 3];
+            bool in_y = size > 0 && y >= oy && y < oy + size;
+            for (int x = 0; x < width * 3; x++) {
+                int v = bg[x] + (int)(rng() % (2 * noise + 1)) - noise;
+                if (in_y && x / 3 >= ox && x / 3 < ox + size) {
+                    v = 20 + 210 * (x / 3 - ox) / size;
+                }
+                row[x] = (uint8_t)std::min(255, std::max(0, v));
+            }
+        }
+        return frame;
+    }
+};
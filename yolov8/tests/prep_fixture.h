@@ -0,0 +1,43 @@
+#pragma once
+#include "preprocess_cache.h"
+
+// Input specs of the models that share preprocessing, and frames for the preprocess cache test and yolov8_prep_bench.
+
+static inline InputSpec yolov8_spec() {
+    InputSpec spec;  // 640x640 letterbox, RGB / 255
+    return spec;
+}
+
+static inline InputSpec yolop_spec() {
+    InputSpec spec;
+    spec.width = 640;
+    spec.height = 384;
+    const float mean[3] = {0.485f, 0.456f, 0.406f}, std[3] = {0.229f, 0.224f, 0.225f};
+    memcpy(spec.mean, mean, sizeof(mean));
+    memcpy(spec.std, std, sizeof(std));
+    return spec;
+}
+
+static inline InputSpec cls_spec() {
+    InputSpec spec;
+    spec.width = 224;
+    spec.height = 224;
+    spec.resize = ResizeMode::kCenterCrop;
+    return spec;
+}
+
+static inline InputSpec uint8_spec() {
+    InputSpec spec;  // for an engine that normalizes on the GPU
+    spec.order = ChannelOrder::kBGR;
+    spec.dtype = InputDType::kUint8;
+    return spec;
+}
+
+static inline void make_pattern_frame(cv::Mat& img, int seed) {
+    for (int y = 0; y < img.rows; y++) {
+        uint8_t* p = img.ptr<uint8_t>(y);
+        for (int x = 0; x < img.cols * 3; x++) {
+            p[x] = (x * 7 + y * 13 + seed * 31 + (x * y >> 6)) & 255;
+        }
+    }
+}
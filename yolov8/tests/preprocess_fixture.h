@@ -0,0 +1,110 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "uint8_input.h"
+
+// Frames and the float path of the engine input on the CPU, for the NV12 and uint8 input tests and their benches.
+
+// warpaffine_kernel of preprocess.cu on the CPU, one call per output pixel
+static inline void warpaffine_reference(const cv::Mat& img, float* dst, int dst_width, int dst_height) {
+    const uint8_t const_value_st = 128;
+    float d2s[6];
+    letterbox_d2s(img.cols, img.rows, dst_width, dst_height, d2s);
+    const int src_width = img.cols, src_height = img.rows, src_line_size = img.step;
+    const uint8_t* src = img.ptr<uint8_t>(0);
+    for (int dy = 0; dy < dst_height; dy++) {
+        for (int dx = 0; dx < dst_width; dx++) {
+            float src_x = d2s[0] * dx + d2s[1] * dy + d2s[2] + 0.5f;
+            float src_y = d2s[3] * dx + d2s[4] * dy + d2s[5] + 0.5f;
+            float c0, c1, c2;
+            if (src_x <= -1 || src_x >= src_width || src_y <= -1 || src_y >= src_height) {
+                c0 = c1 = c2 = const_value_st;
+            } else {
+                int y_low = floorf(src_y);
+                int x_low = floorf(src_x);
+                int y_high = y_low + 1;
+                int x_high = x_low + 1;
+                uint8_t const_value[] = {const_value_st, const_value_st, const_value_st};
+                float ly = src_y - y_low;
+                float lx = src_x - x_low;
+                float hy = 1 - ly;
+                float hx = 1 - lx;
+                float w1 = hy * hx, w2 = hy * lx, w3 = ly * hx, w4 = ly * lx;
+                const uint8_t* v1 = const_value;
+                const uint8_t* v2 = const_value;
+                const uint8_t* v3 = const_value;
+                const uint8_t* v4 = const_value;
+                if (y_low >= 0) {
+                    if (x_low >= 0)
+                        v1 = src + y_low * src_line_size + x_low * 3;
+                    if (x_high < src_width)
+                        v2 = src + y_low * src_line_size + x_high * 3;
+                }
+                if (y_high < src_height) {
+                    if (x_low >= 0)
+                        v3 = src + y_high * src_line_size + x_low * 3;
+                    if (x_high < src_width)
+                        v4 = src + y_high * src_line_size + x_high * 3;
+                }
+                c0 = w1 * v1[0] + w2 * v2[0] + w3 * v3[0] + w4 * v4[0];
+                c1 = w1 * v1[1] + w2 * v2[1] + w3 * v3[1] + w4 * v4[1];
+                c2 = w1 * v1[2] + w2 * v2[2] + w3 * v3[2] + w4 * v4[2];
+            }
+            int area = dst_width * dst_height;
+            float* pdst_c0 = dst + dy * dst_width + dx;
+            pdst_c0[0] = c2 / 255.0f;
+            pdst_c0[area] = c1 / 255.0f;
+            pdst_c0[2 * area] = c0 / 255.0f;
+        }
+    }
+}
+
+// smooth gradients with noise, so the resize blends different values everywhere
+static inline void make_gradient_frame(cv::Mat& img, std::mt19937& rng) {
+    std::uniform_int_distribution<int> noise(-20, 20);
+    for (int y = 0; y < img.rows; y++) {
+        uint8_t* p = img.ptr<uint8_t>(y);
+        for (int x = 0; x < img.cols; x++) {
+            p[x * 3] = std::min(255, std::max(0, x * 255 / img.cols + noise(rng)));
+            p[x * 3 + 1] = std::min(255, std::max(0, y * 255 / img.rows + noise(rng)));
+            p[x * 3 + 2] = std::min(255, std::max(0, 128 + noise(rng) * 6));
+        }
+    }
+}
+
+// NV12 in rows of stride bytes, laid out as in a frame slot (see frame_rows): a Y gradient with noise and chroma
+// around gray, inside the RGB gamut so that cvtColor never saturates
+static inline cv::Mat make_nv12(int width, int height, int stride, std::mt19937& rng) {
+    std::uniform_int_distribution<int> noise(-10, 10);
+    cv::Mat rows(height + (height + 1) / 2, stride, CV_8UC1, cv::Scalar(0));
+    cv::Mat nv12 = rows(cv::Rect(0, 0, (width + 1) / 2 * 2, rows.rows));
+    for (int y = 0; y < height; y++) {
+        uint8_t* p = nv12.ptr<uint8_t>(y);
+        for (int x = 0; x < width; x++) {
+            p[x] = 70 + (x + y) * 120 / (width + height) + noise(rng);
+        }
+    }
+    for (int y = 0; y < (height + 1) / 2; y++) {
+        uint8_t* p = nv12.ptr<uint8_t>(height + y);
+        for (int x = 0; x < (width + 1) / 2; x++) {
+            p[2 * x] = 128 + (x * 30 / width - 8) + noise(rng);
+            p[2 * x + 1] = 128 + (y * 30 / height - 8) + noise(rng);
+        }
+    }
+    return nv12;
+}
+
+// what blobFromImages(..., 1 / 255., swapRB) makes of a letterboxed BGR image
+static inline void to_chw(const cv::Mat& img, float* dst) {
+    const int area = img.cols * img.rows;
+    for (int y = 0; y < img.rows; y++) {
+        const uint8_t* p = img.ptr<uint8_t>(y);
+        for (int x = 0; x < img.cols; x++) {
+            int i = y * img.cols + x;
+            dst[i] = p[x * 3 + 2] / 255.f;
+            dst[area + i] = p[x * 3 + 1] / 255.f;
+            dst[2 * area + i] = p[x * 3] / 255.f;
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "bn_fold.h"
+#include "test_harness.h"
+
+// conv -> BatchNorm2d and the conv folded by fold_batchnorm, plus its bias, give the same output on random tensors,
+// for 1x1 and 3x3 kernels, and folding keeps zero weights zero, so 2:4 pruned weights stay sparse.
+
+// stride 1, zero padding k / 2, CHW
+static void conv2d(const std::vector<float>& x, int c_in, int h, int w, const float* weight, const float* bias,
+                   int c_out, int k, std::vector<float>& y) {
+    int p = k / 2;
+    y.assign((size_t)c_out * h * w, 0.f);
+    for (int o = 0; o < c_out; o++) {
+        for (int i = 0; i < h; i++) {
+            for (int j = 0; j < w; j++) {
+                float sum = bias ? bias[o] : 0.f;
+                for (int c = 0; c < c_in; c++) {
+                    for (int u = 0; u < k; u++) {
+                        for (int v = 0; v < k; v++) {
+                            int yy = i + u - p, xx = j + v - p;
+                            if (yy >= 0 && yy < h && xx >= 0 && xx < w) {
+                                sum += weight[((o * c_in + c) * k + u) * k + v] * x[(c * h + yy) * w + xx];
+                            }
+                        }
+                    }
+                }
+                y[(o * h + i) * w + j] = sum;
+            }
+        }
+    }
+}
+
+TEST_CASE(bn_fold) {
+    std::mt19937 rng(3);
+    std::normal_distribution<float> normal(0.f, 1.f);
+    std::uniform_real_distribution<float> uniform(0.1f, 2.f);
+    const int shapes[][3] = {{3, 16, 3}, {32, 64, 1}, {64, 32, 3}, {96, 48, 1}};  // c_in, c_out, k
+    const float eps = 1e-3f;
+    const int h = 12, w = 10;
+    float worst = 0.f;
+    bool sparse = true;
+    for (const auto& s : shapes) {
+        int c_in = s[0], c_out = s[1], k = s[2];
+        std::vector<float> x(c_in * h * w), weight(c_out * c_in * k * k);
+        std::vector<float> gamma(c_out), beta(c_out), mean(c_out), var(c_out), bias(c_out);
+        for (auto& v : x) v = normal(rng);
+        for (size_t i = 0; i < weight.size(); i++) {
+            weight[i] = i % 4 < 2 ? 0.f : normal(rng) * 0.1f;  // 2:4 pattern along the input
+        }
+        for (int c = 0; c < c_out; c++) {
+            gamma[c] = uniform(rng);
+            beta[c] = normal(rng);
+            mean[c] = normal(rng);
+            var[c] = uniform(rng) * uniform(rng);
+        }
+        var[0] = 0.f;  // a dead channel, only eps keeps the division finite
+
+        std::vector<float> y, y_folded;
+        conv2d(x, c_in, h, w, weight.data(), nullptr, c_out, k, y);
+        for (int c = 0; c < c_out; c++) {
+            for (int i = 0; i < h * w; i++) {
+                float& v = y[c * h * w + i];
+                v = gamma[c] * (v - mean[c]) / sqrtf(var[c] + eps) + beta[c];
+            }
+        }
+        fold_batchnorm(weight.data(), weight.size(), gamma.data(), beta.data(), mean.data(), var.data(), c_out, eps,
+                       bias.data());
+        conv2d(x, c_in, h, w, weight.data(), bias.data(), c_out, k, y_folded);
+
+        float err = 0.f, peak = 0.f;
+        for (size_t i = 0; i < y.size(); i++) {
+            err = std::max(err, fabsf(y[i] - y_folded[i]));
+            peak = std::max(peak, fabsf(y[i]));
+        }
+        for (size_t i = 0; i < weight.size(); i++) {
+            sparse &= i % 4 >= 2 || weight[i] == 0.f;
+        }
+        printf("      %3d -> %3d, %dx%d: largest difference %.2e of outputs up to %.2f\n", c_in, c_out, k, k, err,
+               peak);
+        worst = std::max(worst, err / peak);
+    }
+    bool ok = true;
+    ok &= check(worst < 1e-5f, "the folded conv + bias gives the output of conv -> BatchNorm2d");
+    ok &= check(sparse, "zero weights stay zero, 2:4 pruned weights keep their pattern");
+    return ok;
+}
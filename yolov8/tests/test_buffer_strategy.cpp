@@ -0,0 +1,46 @@
+#include <cstdint>
+#include <cstring>
+#include "buffer_strategy.h"
+#include "test_harness.h"
+
+// The host strategy, the one that runs without a GPU: buffers are aligned and padded to kBufferAlignment, both views
+// are the same memory, and the data flow of an inference round-trips through buffer_to_device and buffer_to_host.
+
+TEST_CASE(buffer_strategy) {
+    bool ok = true;
+    bool names = true;
+    for (BufferStrategy s :
+         {BufferStrategy::kDevice, BufferStrategy::kMapped, BufferStrategy::kManaged, BufferStrategy::kHost}) {
+        BufferStrategy parsed = BufferStrategy::kDevice;
+        names &= parse_buffer_strategy(buffer_strategy_name(s), parsed) && parsed == s;
+    }
+    BufferStrategy unknown = BufferStrategy::kMapped;
+    ok &= check(names && !parse_buffer_strategy("pinned", unknown) && unknown == BufferStrategy::kMapped,
+                "strategy names round-trip, unknown names are rejected");
+
+    const size_t input_bytes = 3 * 640 * 640 * sizeof(float), output_bytes = 1001 * 4 + 1;
+    BufferSet buffers(BufferStrategy::kHost);
+    BufferPair input = buffers.allocate(input_bytes, true);
+    BufferPair output = buffers.allocate(output_bytes, false);
+    ok &= check((uintptr_t)input.host % kBufferAlignment == 0 && (uintptr_t)output.device % kBufferAlignment == 0 &&
+                        input.bytes >= input_bytes && output.bytes == align_buffer_size(output_bytes) &&
+                        output.bytes % kBufferAlignment == 0,
+                "buffers are aligned and padded to kBufferAlignment");
+    ok &= check(input.host == input.device && output.host == output.device && buffers.device_bytes() == 0 &&
+                        buffers.host_bytes() == input.bytes + output.bytes,
+                "host and device views are one host allocation");
+
+    bool round_trip = true;
+    for (int i = 0; i < 3; i++) {
+        memset(input.host, i + 1, input_bytes);
+        buffer_to_device(BufferStrategy::kHost, input.device, input.host, input_bytes, nullptr);
+        memcpy(output.device, input.device, output_bytes);  // stands in for the engine
+        buffer_to_host(BufferStrategy::kHost, output.host, output.device, output_bytes, nullptr);
+        const unsigned char* out = (const unsigned char*)output.host;
+        round_trip &= out[0] == i + 1 && out[output_bytes - 1] == i + 1;
+    }
+    ok &= check(round_trip, "the output written on the device side is read back on the host");
+    buffers.release();
+    ok &= check(buffers.host_bytes() == 0, "release frees every buffer");
+    return ok;
+}
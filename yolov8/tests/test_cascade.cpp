@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "cascade.h"
+#include "cascade_fixture.h"
+#include "test_harness.h"
+
+// A crop is the bilinear resize of its square around the box, in planar RGB; crops of many frames are packed into
+// full batches and their top-k classes land on the detections they came from, in frame order; a slow stream of frames
+// gets partial batches within the wait limit.
+
+TEST_CASE(cascade) {
+    bool ok = true;
+
+    // B = x and G = y are linear, so bilinear sampling reproduces them exactly away from the border
+    cv::Mat ramp(200, 250, CV_8UC3);
+    for (int y = 0; y < ramp.rows; y++) {
+        for (int x = 0; x < ramp.cols; x++) {
+            uint8_t* p = ramp.ptr<uint8_t>(y) + x * 3;
+            p[0] = x;
+            p[1] = y;
+            p[2] = 17;
+        }
+    }
+    const int size = 64;
+    std::vector<float> crop(3 * size * size);
+    const float box[4] = {60.f, 40.f, 90.f, 120.f};
+    crop_to_planar(ramp, box, 0.f, crop.data(), size, size);
+    float err = 0.f;
+    const float scale = 120.f / size;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            float sx = std::min(249.f, std::max(0.f, 45.f + (x + 0.5f) * scale - 0.5f));
+            float sy = std::min(199.f, std::max(0.f, 40.f + (y + 0.5f) * scale - 0.5f));
+            err = std::max(err, std::abs(crop[2 * size * size + y * size + x] * 255 - sx));
+            err = std::max(err, std::abs(crop[size * size + y * size + x] * 255 - sy));
+            err = std::max(err, std::abs(crop[y * size + x] * 255 - 17));
+        }
+    }
+    printf("      120 px square crop to %dx%d: largest error %.4f levels\n", size, size, err);
+    ok &= check(err < 1e-3f, "crops are the bilinear resize of the square around the box, planar RGB");
+
+    // many frames, crops of classes 1 and 3 only
+    const int max_batch = 16;
+    MockClassifier cls(max_batch, true);
+    CascadeOptions opts;
+    opts.classes = {1, 3};
+    opts.max_wait_ms = 1e9f;
+    CropBatcher batcher(cls, opts);
+    std::mt19937 rng(1);
+    std::vector<std::vector<Detection>> sent;
+    int selected = 0, boxes = 0;
+    for (int f = 0; f < 40; f++) {
+        cv::Mat img(720, 1280, CV_8UC3);
+        sent.push_back(make_objects(img, f % 7 == 0 ? 0 : f % 13, f * 100, rng));
+        boxes += sent.back().size();
+        for (const auto& det : sent.back()) {
+            selected += (int)det.class_id % 2;
+        }
+        batcher.add(f, img, sent.back(), f);
+    }
+    std::vector<CascadeFrame> out;
+    CascadeFrame frame;
+    while (batcher.pop(frame)) {
+        out.push_back(frame);
+    }
+    size_t ready = out.size();
+    batcher.flush();
+    while (batcher.pop(frame)) {
+        out.push_back(frame);
+    }
+    bool ordered = out.size() == sent.size(), labeled = true;
+    for (size_t f = 0; ordered && f < out.size(); f++) {
+        ordered &= out[f].id == (long)f && out[f].dets.size() == sent[f].size();
+        for (size_t d = 0; d < out[f].dets.size(); d++) {
+            const auto& labels = out[f].labels[d];
+            int id = (int)(f * 100 + d);
+            if ((int)out[f].dets[d].class_id % 2 == 0) {
+                labeled &= labels.empty();
+                continue;
+            }
+            labeled &= labels.size() == 3 && labels[0].class_id == id % kClsNumClass && labels[0].prob > 0.9f &&
+                       labels[0].prob >= labels[1].prob && labels[1].prob >= labels[2].prob;
+        }
+    }
+    const CascadeStats& s = batcher.stats();
+    bool full = true;
+    for (size_t b = 0; b + 1 < cls.batch_sizes_.size(); b++) {
+        full &= cls.batch_sizes_[b] == max_batch;
+    }
+    printf("      40 frames, %d of %d boxes classified in %ld batches of up to %d, %zu frames ready before the flush\n",
+           selected, boxes, s.batches, max_batch, ready);
+    ok &= check(s.crops == selected && full && s.batches == (selected + max_batch - 1) / max_batch,
+                "crops of many frames fill whole batches");
+    ok &= check(ordered && labeled, "top-k lands on the detection of each crop, frames come out in order");
+
+    // a frame every 30 ms with one crop, polled every 5 ms
+    MockClassifier slow_cls(max_batch, true);
+    CascadeOptions slow_opts;
+    CropBatcher slow(slow_cls, slow_opts);
+    std::vector<double> added, waited;
+    for (int t = 0; t <= 600; t += 5) {
+        if (t % 30 == 0) {
+            cv::Mat img(360, 640, CV_8UC3);
+            slow.add(added.size(), img, make_objects(img, 1, added.size(), rng), t);
+            added.push_back(t);
+        } else {
+            slow.poll(t);
+        }
+        while (slow.pop(frame)) {
+            waited.push_back(t - added[frame.id]);
+        }
+    }
+    double max_wait = *std::max_element(waited.begin(), waited.end());
+    printf("      a frame every 30 ms, %zu frames: %ld batches, longest wait %.0f ms\n", added.size(),
+           slow.stats().batches, max_wait);
+    ok &= check(slow.stats().deadline_batches > 0 && max_wait <= slow_opts.max_wait_ms + 5,
+                "partial batches run once a crop has waited max_wait_ms");
+    return ok;
+}
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "coarse_to_fine.h"
+#include "detection_fixture.h"
+#include "test_harness.h"
+
+// The mock engines see a synthetic 4K scene through the same letterbox as the real ones: an object's confidence grows
+// with its size in input pixels and its box is rounded to the input pixel grid, so a 640 coarse pass reports distant
+// objects as uncertain and imprecise. The fine pass must recover them within the region budget without duplicates,
+// and the budget must go to the largest clusters. Prints the GPU work against running the fine engine over the whole
+// frame.
+
+class MockDetector : public RoiDetector {
+   public:
+    MockDetector(const std::vector<Detection>& objects, cv::Size input, float conf_thresh)
+        : objects_(objects), input_(input), conf_thresh_(conf_thresh) {}
+
+    cv::Size input_size() const override { return input_; }
+
+    void detect(const cv::Mat& frame, const std::vector<cv::Rect>& rois,
+                std::vector<std::vector<Detection>>& res) override {
+        res.assign(rois.size(), std::vector<Detection>());
+        for (size_t r = 0; r < rois.size(); r++) {
+            Tile tile = make_tile(rois[r], input_.width, input_.height);
+            float rx1 = rois[r].x + rois[r].width, ry1 = rois[r].y + rois[r].height;
+            for (const auto& o : objects_) {
+                float x1 = std::max(o.bbox[0], (float)rois[r].x), y1 = std::max(o.bbox[1], (float)rois[r].y);
+                float x2 = std::min(o.bbox[2], rx1), y2 = std::min(o.bbox[3], ry1);
+                if (x2 <= x1 || y2 <= y1 ||
+                    (x2 - x1) * (y2 - y1) < 0.2f * (o.bbox[2] - o.bbox[0]) * (o.bbox[3] - o.bbox[1])) {
+                    continue;
+                }
+                float side = std::max(x2 - x1, y2 - y1) * tile.scale;
+                float conf = std::min(0.95f, side / 24.f);
+                if (conf < conf_thresh_) {
+                    continue;
+                }
+                // the network resolves boxes to about an input pixel
+                auto snap = [&](float v, float origin, float pad) {
+                    return origin + (std::round((v - origin) * tile.scale + pad) - pad) / tile.scale;
+                };
+                res[r].push_back(make_det(snap(x1, rois[r].x, tile.pad_x), snap(y1, rois[r].y, tile.pad_y),
+                                          snap(x2, rois[r].x, tile.pad_x), snap(y2, rois[r].y, tile.pad_y), conf,
+                                          (int)o.class_id));
+            }
+        }
+        calls_++;
+        input_pixels_ += (long)rois.size() * input_.area();
+    }
+
+    int calls_ = 0;
+    long input_pixels_ = 0;
+
+   private:
+    std::vector<Detection> objects_;
+    cv::Size input_;
+    float conf_thresh_;
+};
+
+// clusters[i] small objects (12 to 40 pixels) in an area of spread x spread pixels around centers[i]
+static void add_clusters(std::vector<Detection>& objects, const std::vector<cv::Point>& centers,
+                         const std::vector<int>& sizes, int spread, std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    for (size_t c = 0; c < centers.size(); c++) {
+        // on a jittered grid, so the objects do not overlap each other
+        int cols = (int)std::ceil(std::sqrt((float)sizes[c]));
+        float cell = (float)spread / cols;
+        for (int i = 0; i < sizes[c]; i++) {
+            float w = std::min(cell * 0.8f, 12 + 28 * unit(rng)), h = std::min(cell * 0.8f, 12 + 28 * unit(rng));
+            float x = centers[c].x - spread * 0.5f + (i % cols) * cell + (cell - w) * unit(rng);
+            float y = centers[c].y - spread * 0.5f + (i / cols) * cell + (cell - h) * unit(rng);
+            objects.push_back(make_det(x, y, x + w, y + h, 1.f, i % 2));
+        }
+    }
+}
+
+static int count_found(const std::vector<Detection>& objects, const std::vector<Detection>& dets) {
+    int found = 0;
+    for (const auto& o : objects) {
+        for (const auto& d : dets) {
+            if (d.class_id == o.class_id && box_iou(o.bbox, d.bbox) > 0.9f) {
+                found++;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+TEST_CASE(coarse_to_fine) {
+    bool ok = true;
+    const cv::Mat frame(2160, 3840, CV_8UC3);
+    std::mt19937 rng(1);
+    CoarseToFineOptions opts;
+
+    // three clusters of distant objects and a few large ones
+    std::vector<Detection> objects;
+    add_clusters(objects, {cv::Point(700, 600), cv::Point(2400, 1500), cv::Point(3300, 500)}, {16, 25, 9}, 600, rng);
+    objects.push_back(make_det(100, 1200, 500, 1900, 1.f, 0));
+    objects.push_back(make_det(1500, 200, 1900, 500, 1.f, 1));
+    MockDetector coarse(objects, cv::Size(640, 640), opts.low_conf);
+    MockDetector fine(objects, cv::Size(1280, 1280), opts.conf_thresh);
+    CoarseToFine c2f(opts);
+    std::vector<Detection> dets;
+    c2f.detect(frame, coarse, fine, dets);
+    const CoarseToFineStats& s = c2f.stats();
+    // the same fine engine on the whole frame: once letterboxed, or tiled at the resolution of the regions
+    MockDetector full(objects, cv::Size(1280, 1280), opts.conf_thresh);
+    std::vector<std::vector<Detection>> full_res;
+    full.detect(frame, std::vector<cv::Rect>{cv::Rect(0, 0, frame.cols, frame.rows)}, full_res);
+    int full_found = 0;
+    for (const auto& o : objects) {
+        for (const auto& d : full_res[0]) {
+            full_found += box_iou(o.bbox, d.bbox) > 0.9f;
+        }
+    }
+    printf("      %zu objects: a full-frame 1280 pass finds %d, coarse-to-fine %d with %zu boxes in %ld regions\n",
+           objects.size(), full_found, count_found(objects, dets), dets.size(), s.rois);
+    ok &= check(s.rois == 3 && s.uncovered == 0, "one region per cluster, all candidates covered");
+    ok &= check(count_found(objects, dets) == (int)objects.size() && dets.size() == objects.size(),
+                "fine pass recovers every object, without duplicates");
+    printf("      GPU input pixels: %.2fx of a 1280 engine tiled over the whole frame at the region resolution\n",
+           (double)(coarse.input_pixels_ + fine.input_pixels_) / frame.cols / frame.rows);
+
+    // ten clusters of different sizes, four regions
+    std::vector<Detection> many;
+    std::vector<cv::Point> centers;
+    std::vector<int> sizes;
+    for (int c = 0; c < 10; c++) {
+        centers.push_back(cv::Point(400 + (c % 5) * 760, 500 + (c / 5) * 1100));
+        sizes.push_back(3 + c);
+    }
+    add_clusters(many, centers, sizes, 500, rng);
+    std::vector<Detection> candidates = many;
+    std::vector<char> covered;
+    std::vector<cv::Rect> rois = plan_rois(candidates, 3840, 2160, cv::Size(1280, 1280), 4, covered);
+    int n_covered = std::count(covered.begin(), covered.end(), 1);
+    bool inside = true;
+    for (const auto& r : rois) {
+        inside &= r.x >= 0 && r.y >= 0 && r.x + r.width <= 3840 && r.y + r.height <= 2160 && r.width == 1280;
+    }
+    printf("      10 clusters of 3 to 12: 4 regions cover %d of %zu candidates\n", n_covered, many.size());
+    ok &= check(rois.size() == 4 && inside, "the budget limits the regions, which stay in the frame");
+    // a 1280 region spans two neighbouring clusters 760 apart, so the best four take the largest pairs
+    ok &= check(n_covered >= 12 + 11 + 10 + 9, "the budget goes to the largest clusters");
+
+    // nothing uncertain or small: no fine pass
+    std::vector<Detection> large = {make_det(100, 100, 900, 900, 1.f, 0)};
+    MockDetector coarse_large(large, cv::Size(640, 640), opts.low_conf);
+    MockDetector fine_large(large, cv::Size(1280, 1280), opts.conf_thresh);
+    CoarseToFine c2f_large(opts);
+    c2f_large.detect(frame, coarse_large, fine_large, dets);
+    ok &= check(fine_large.calls_ == 0 && dets.size() == 1, "frames without candidates skip the fine pass");
+    return ok;
+}
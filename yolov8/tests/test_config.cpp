@@ -0,0 +1,114 @@
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "runtime_config.h"
+#include "test_harness.h"
+#include "types.h"
+
+// RuntimeConfig starts from config.h, single values, "key = value" files and "--key=value" arguments are parsed and
+// invalid ones rejected, parse_runtime_config_args leaves the positional arguments in order with later arguments
+// winning over --config files, validate_runtime_config rejects unusable settings, and the buffer sizes taken from an
+// engine's bindings give back the binding sizes.
+
+static std::string write_file(const std::string& text) {
+    std::string path = temp_path("config.cfg");
+    std::ofstream(path) << text;
+    return path;
+}
+
+// argv as main gets it, the strings live in args
+static std::vector<char*> make_argv(std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    for (auto& a : args) {
+        argv.push_back(&a[0]);
+    }
+    return argv;
+}
+
+TEST_CASE(config) {
+    bool ok = true;
+    // std::cerr gets the messages of the rejected entries, keep the check output readable
+    std::streambuf* cerr_buf = std::cerr.rdbuf(nullptr);
+
+    RuntimeConfig defaults;
+    ok &= check(defaults.batch_size == kBatchSize && defaults.input_h == kInputH && defaults.input_w == kInputW &&
+                        defaults.num_class == kNumClass && defaults.max_num_output_bbox == kMaxNumOutputBbox &&
+                        defaults.conf_thresh == kConfThresh && !defaults.dynamic && defaults.cache_mb == 0 &&
+                        defaults.verbose == -1,
+                "defaults come from config.h");
+
+    RuntimeConfig cfg;
+    bool values = set_runtime_config_value(cfg, "batch_size", "8") && set_runtime_config_value(cfg, "input_h", "960") &&
+                  set_runtime_config_value(cfg, "conf_thresh", "0.25") &&
+                  set_runtime_config_value(cfg, "precision", "fp16") &&
+                  set_runtime_config_value(cfg, "buffers", "mapped") && set_runtime_config_value(cfg, "dynamic", "1") &&
+                  set_runtime_config_value(cfg, "verbose", "0");
+    ok &= check(values && cfg.batch_size == 8 && cfg.input_h == 960 && cfg.conf_thresh == 0.25f &&
+                        cfg.precision == "fp16" && cfg.buffers == BufferStrategy::kMapped && cfg.dynamic &&
+                        cfg.verbose == 0,
+                "single values");
+    bool rejected = !set_runtime_config_value(cfg, "batch_size", "8x") &&
+                    !set_runtime_config_value(cfg, "batch_size", "") &&
+                    !set_runtime_config_value(cfg, "precision", "fp8") &&
+                    !set_runtime_config_value(cfg, "dynamic", "yes") &&
+                    !set_runtime_config_value(cfg, "verbose", "-1") &&
+                    !set_runtime_config_value(cfg, "cache_mb", "-1") &&
+                    !set_runtime_config_value(cfg, "batchsize", "8");
+    ok &= check(rejected && cfg.batch_size == 8 && cfg.cache_mb == 0,
+                "invalid values and unknown keys are rejected and leave the config unchanged");
+
+    std::string path = write_file("# tuning run\n  batch_size = 4  \ninput_w=1280 # wide\n\r\nnms_thresh\t=\t0.5\n");
+    cfg = RuntimeConfig();
+    bool file = load_runtime_config_file(path, cfg) && cfg.batch_size == 4 && cfg.input_w == 1280 &&
+                cfg.nms_thresh == 0.5f;
+    std::ofstream(path) << "batch_size = 4\ninput_w 1280\n";
+    file &= !load_runtime_config_file(path, cfg) && !load_runtime_config_file("/nonexistent/yolov8.cfg", cfg);
+    ok &= check(file, "config files with comments, blank lines and spaces; lines without '=' and missing files fail");
+
+    std::ofstream(path) << "batch_size = 4\ninput_h = 320\n";
+    std::vector<std::string> args = {"yolov8_det", "--config=" + path, "-d", "--batch_size=2", "yolov8n.engine",
+                                     "../images", "c"};
+    std::vector<char*> argv = make_argv(args);
+    int argc = argv.size();
+    cfg = RuntimeConfig();
+    bool parsed = parse_runtime_config_args(argc, argv.data(), cfg) && argc == 5 &&
+                  std::string(argv[1]) == "-d" && std::string(argv[2]) == "yolov8n.engine" &&
+                  std::string(argv[4]) == "c" && cfg.batch_size == 2 && cfg.input_h == 320;
+    ok &= check(parsed, "--key=value arguments are consumed, positional ones kept in order, later ones win");
+
+    std::vector<std::string> bad_args = {"yolov8_det", "-d", "--batch_size", "yolov8n.engine"};
+    argv = make_argv(bad_args);
+    argc = argv.size();
+    ok &= check(!parse_runtime_config_args(argc, argv.data(), cfg), "arguments without a value are rejected");
+    unlink(path.c_str());
+
+    cfg = RuntimeConfig();
+    bool valid = validate_runtime_config(cfg);
+    cfg.input_h = 650;
+    valid &= !validate_runtime_config(cfg);
+    cfg = RuntimeConfig();
+    cfg.batch_size = 0;
+    valid &= !validate_runtime_config(cfg);
+    cfg = RuntimeConfig();
+    cfg.nms_thresh = 1.5f;
+    valid &= !validate_runtime_config(cfg);
+    cfg = RuntimeConfig();
+    cfg.uint8_input = true;
+    cfg.precision = "int8";
+    valid &= !validate_runtime_config(cfg);
+    ok &= check(valid, "validation rejects inputs not a multiple of 32, empty batches, thresholds and uint8 with int8");
+
+    // an engine built with other settings than the binary's config.h: batch 4, 960x960, 300 boxes
+    int output_elements = 300 * sizeof(Detection) / sizeof(float) + 1;
+    cfg = RuntimeConfig();
+    update_runtime_config_from_engine(cfg, 4, 960, 960, output_elements);
+    ok &= check(cfg.batch_size == 4 && cfg.input_h == 960 && cfg.input_w == 960 && cfg.max_num_output_bbox == 300 &&
+                        output_size_per_image(cfg) == output_elements &&
+                        input_size_per_batch(cfg) == (size_t)4 * 3 * 960 * 960,
+                "buffer sizes follow the engine's bindings");
+
+    std::cerr.rdbuf(cerr_buf);
+    return ok;
+}
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "config.h"
+#include "decode_fixture.h"
+#include "test_harness.h"
+
+// The JPEG header parser and the factor picked for common photo and video sizes, and boxes on a reduced decode map
+// back onto the objects of the full image: solid rectangles are drawn into large frames, found again by color in each
+// reduced decode, and must land within one reduced pixel of where they were drawn once mapped with to_original_rect.
+
+struct Object {
+    cv::Rect box;
+    uint8_t bgr[3];
+};
+
+static void fill(cv::Mat& img, const Object& o) {
+    for (int y = o.box.y; y < o.box.y + o.box.height; y++) {
+        uint8_t* p = img.ptr<uint8_t>(y);
+        for (int x = o.box.x; x < o.box.x + o.box.width; x++) {
+            std::copy(o.bgr, o.bgr + 3, p + x * 3);
+        }
+    }
+}
+
+// bounding box of the pixels within 60 levels of the object's color, as a detector would draw it
+static cv::Rect find(const cv::Mat& img, const Object& o) {
+    int x0 = img.cols, y0 = img.rows, x1 = -1, y1 = -1;
+    for (int y = 0; y < img.rows; y++) {
+        const uint8_t* p = img.ptr<uint8_t>(y);
+        for (int x = 0; x < img.cols; x++) {
+            bool match = true;
+            for (int c = 0; c < 3; c++) {
+                match &= std::abs(p[x * 3 + c] - o.bgr[c]) < 60;
+            }
+            if (match) {
+                x0 = std::min(x0, x);
+                y0 = std::min(y0, y);
+                x1 = std::max(x1, x);
+                y1 = std::max(y1, y);
+            }
+        }
+    }
+    return x1 < 0 ? cv::Rect() : cv::Rect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+}
+
+TEST_CASE(decode) {
+    bool ok = true;
+    const int input_w = 640, input_h = 640;
+    std::mt19937 rng(5);
+
+    cv::Mat small(333, 1001, CV_8UC3);
+    make_frame(small, rng);
+    std::vector<uint8_t> jpeg = encode(small);
+    int w = 0, h = 0;
+    bool parsed = jpeg_size(jpeg.data(), jpeg.size(), w, h) && w == 1001 && h == 333;
+    const uint8_t png[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    ok &= check(parsed && !jpeg_size(jpeg.data(), 20, w, h) && !jpeg_size(png, sizeof(png), w, h),
+                "jpeg_size reads the frame header, rejects truncated JPEGs and other formats");
+
+    const int factors[][3] = {{6000, 4000, 8}, {4000, 3000, 4}, {3000, 4000, 4}, {1920, 1080, 2},
+                              {1280, 720, 2},  {1000, 600, 1},  {640, 640, 1},   {320, 240, 1}};
+    bool picked = true;
+    for (const auto& f : factors) {
+        int factor = pick_reduce_factor(f[0], f[1], input_w, input_h);
+        printf("      %4dx%-4d -> 1/%d\n", f[0], f[1], factor);
+        picked &= factor == f[2];
+    }
+    ok &= check(picked, "the largest factor that still letterboxes down to 640x640");
+
+    DecodedImage full;
+    ok &= check(decode_image(jpeg, 0, 0, full) && full.scale == 1 && full.img.size() == cv::Size(1001, 333) &&
+                        full.original_size == full.img.size(),
+                "input_w = 0 decodes at full size");
+
+    const Object objects[] = {{cv::Rect(1003, 517, 611, 389), {0, 0, 255}},
+                              {cv::Rect(2650, 1777, 233, 1041), {0, 255, 0}},
+                              {cv::Rect(77, 1500, 1500, 91), {255, 0, 0}},
+                              {cv::Rect(1250, 150, 129, 137), {255, 255, 255}}};
+    const int frames[][2] = {{6000, 4000}, {4000, 3000}, {3000, 4000}, {3001, 2999}};
+    bool mapped = true, reduced = true;
+    for (const auto& f : frames) {
+        cv::Mat img(f[1], f[0], CV_8UC3);
+        make_frame(img, rng);
+        for (const auto& o : objects) {
+            fill(img, o);
+        }
+        DecodedImage decoded;
+        reduced &= decode_image(encode(img), input_w, input_h, decoded) &&
+                   decoded.scale == pick_reduce_factor(f[0], f[1], input_w, input_h) && decoded.scale > 1 &&
+                   decoded.original_size == img.size() &&
+                   decoded.img.size() == cv::Size((f[0] + decoded.scale - 1) / decoded.scale,
+                                                  (f[1] + decoded.scale - 1) / decoded.scale);
+        int worst = 0;
+        for (const auto& o : objects) {
+            cv::Rect r = to_original_rect(find(decoded.img, o), decoded);
+            int err = std::max(std::max(std::abs(r.x - o.box.x), std::abs(r.y - o.box.y)),
+                               std::max(std::abs(r.x + r.width - o.box.x - o.box.width),
+                                        std::abs(r.y + r.height - o.box.y - o.box.height)));
+            worst = std::max(worst, err);
+        }
+        printf("      %4dx%-4d decoded at 1/%d as %dx%d, box edges at most %d pixels off\n", f[0], f[1],
+               decoded.scale, decoded.img.cols, decoded.img.rows, worst);
+        mapped &= worst <= decoded.scale;
+    }
+    ok &= check(reduced, "JPEGs are decoded at the picked factor and keep their original size");
+    ok &= check(mapped, "boxes on the reduced decode map back to within one reduced pixel");
+    return ok;
+}
@@ -0,0 +1,57 @@
+#include <cstdint>
+#include <string>
+#include "frame_ring.h"
+#include "test_harness.h"
+
+// The NV12 layout of frame_rows and nv12_height, also for odd sizes, and check_frame_info rejecting frame infos that
+// do not fit their slot, including sizes whose 32-bit products overflow.
+
+static FrameInfo frame_info(FrameFormat format, uint32_t width, uint32_t height, uint32_t stride, uint64_t size) {
+    FrameInfo info{};
+    info.format = format;
+    info.width = width;
+    info.height = height;
+    info.stride = stride;
+    info.size = size;
+    return info;
+}
+
+TEST_CASE(frame_ring) {
+    bool ok = true;
+    std::string error;
+    const size_t slot = 1920 * 1080 * 3;
+    const uint64_t max_pixels = 1920 * 1080;
+    ok &= check(check_frame_info(frame_info(FrameFormat::kBGR, 1920, 1080, 1920 * 3, slot), slot, max_pixels, error) &&
+                        check_frame_info(frame_info(FrameFormat::kNV12, 1920, 1080, 2048, 2048 * 1620), slot,
+                                         max_pixels, error),
+                "BGR and padded NV12 frames that fill their slot");
+    bool layout = frame_rows(frame_info(FrameFormat::kNV12, 1920, 1080, 1920, 0)) == 1620 &&
+                  frame_rows(frame_info(FrameFormat::kNV12, 641, 361, 642, 0)) == 361 + 181 &&
+                  frame_rows(frame_info(FrameFormat::kBGR, 641, 361, 1923, 0)) == 361;
+    for (uint32_t h = 1; h <= 8192; h++) {
+        layout &= nv12_height(frame_rows(frame_info(FrameFormat::kNV12, 640, h, 640, 0))) == h;
+    }
+    ok &= check(layout, "NV12 frames have a UV row for an odd last row, nv12_height undoes frame_rows");
+    ok &= check(check_frame_info(frame_info(FrameFormat::kNV12, 641, 361, 642, 642 * 542), slot, max_pixels, error) &&
+                        !check_frame_info(frame_info(FrameFormat::kNV12, 641, 361, 641, 0), slot, max_pixels, error),
+                "odd NV12 widths need a stride that holds the last U, V pair");
+    ok &= check(!check_frame_info(frame_info(FrameFormat::kBGR, 1920, 1080, 1920, slot), slot, max_pixels, error) &&
+                        !check_frame_info(frame_info(FrameFormat::kNV12, 1920, 1080, 1000, 0), slot, max_pixels, error),
+                "strides shorter than a row");
+    ok &= check(!check_frame_info(frame_info(FrameFormat::kBGR, 1280, 1080, 6144, 0), slot, max_pixels, error) &&
+                        !check_frame_info(frame_info(FrameFormat::kBGR, 640, 480, 640 * 3, slot + 1), slot, max_pixels,
+                                          error),
+                "frames or sizes past the end of the slot");
+    // 65536 x 65536 overflows 32 bits, stride 2^31 x 3 rows overflows 32 bits too
+    ok &= check(!check_frame_info(frame_info(FrameFormat::kBGR, 1920, 1088, 1920 * 3, 0), slot, max_pixels, error) &&
+                        !check_frame_info(frame_info(FrameFormat::kBGR, 65536, 65536, 196608, 0), slot, UINT64_MAX,
+                                          error) &&
+                        !check_frame_info(frame_info(FrameFormat::kBGR, 1, 3, 0x80000000u, 0), slot, max_pixels,
+                                          error),
+                "frames over max_pixels, also where 32-bit products overflow");
+    ok &= check(!check_frame_info(frame_info(FrameFormat::kBGR, 0, 1080, 0, 0), slot, max_pixels, error) &&
+                        !check_frame_info(frame_info((FrameFormat)7, 640, 480, 1920, 0), slot, max_pixels, error) &&
+                        error == "unknown format 7",
+                "empty frames and unknown formats");
+    return ok;
+}
@@ -0,0 +1,57 @@
+#include "test_harness.h"
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// filled by the TestRegistration of each test file before main runs, in no particular order
+static std::vector<std::pair<std::string, TestFn>>& registry() {
+    static std::vector<std::pair<std::string, TestFn>> tests;
+    return tests;
+}
+
+TestRegistration::TestRegistration(const char* name, TestFn fn) {
+    registry().emplace_back(name, fn);
+}
+
+bool check(bool ok, const char* what) {
+    std::cout << (ok ? "ok    " : "FAIL  ") << what << std::endl;
+    return ok;
+}
+
+std::string temp_path(const std::string& name) {
+    return "/tmp/yolov8_tests_" + std::to_string(getpid()) + "_" + name;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::pair<std::string, TestFn>> tests = registry();
+    std::sort(tests.begin(), tests.end());
+    std::vector<std::string> selected(argv + 1, argv + argc);
+    int run = 0;
+    std::vector<std::string> failed;
+    for (const auto& test : tests) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), test.first) == selected.end()) {
+            continue;
+        }
+        std::cout << "[" << test.first << "]" << std::endl;
+        run++;
+        if (!test.second()) {
+            failed.push_back(test.first);
+        }
+    }
+    if (run == 0) {
+        std::cerr << "no test matches, the tests are:";
+        for (const auto& test : tests) {
+            std::cerr << " " << test.first;
+        }
+        std::cerr << std::endl;
+        return 1;
+    }
+    std::cout << run - failed.size() << " of " << run << " tests passed";
+    for (const auto& name : failed) {
+        std::cout << (&name == &failed[0] ? ", failed: " : " ") << name;
+    }
+    std::cout << std::endl;
+    return failed.empty() ? 0 : 1;
+}
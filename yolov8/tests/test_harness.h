@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+
+// The CPU checks of the pipeline parts, built into one executable, yolov8_tests. The yolov8_*_bench programs only
+// time. A test is a function that runs its checks and returns whether all of them passed:
+//
+//   TEST_CASE(letterbox) {
+//       bool ok = true;
+//       ok &= check(rect_letterbox_shape(1280, 720, 640, 640).h == 384, "16:9 images");
+//       return ok;
+//   }
+//
+//   ./yolov8_tests                 // all tests, exits 1 if one fails
+//   ./yolov8_tests tracker server  // only these
+
+// Prints "ok" or "FAIL" with what was checked and returns ok.
+bool check(bool ok, const char* what);
+
+// Path of a scratch file unique to this process, name is appended to it.
+std::string temp_path(const std::string& name);
+
+typedef bool (*TestFn)();
+
+struct TestRegistration {
+    TestRegistration(const char* name, TestFn fn);
+};
+
+#define TEST_CASE(name)                                                     \
+    static bool test_##name();                                              \
+    static TestRegistration test_##name##_registration(#name, test_##name); \
+    static bool test_##name()
@@ -0,0 +1,88 @@
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "int8_scales.h"
+#include "test_harness.h"
+
+// readInt8Scales reads plain QAT exports and TensorRT calibration tables, including names with spaces, and rejects
+// malformed lines naming the file and line. On a mock network with the layer and tensor names convBnSiLU and TensorRT
+// give the first block of yolov8, int8DynamicRanges prefers the tensor name, falls back to the layer name only for a
+// layer's first output, and leaves the rest unset.
+
+static std::string write_file(const std::string& text) {
+    std::string path = temp_path("scales.txt");
+    std::ofstream(path) << text;
+    return path;
+}
+
+static bool read(const std::string& text, std::map<std::string, float>& scales, std::string& error) {
+    std::string path = write_file(text);
+    bool ok = readInt8Scales(path, scales, error);
+    unlink(path.c_str());
+    return ok;
+}
+
+TEST_CASE(int8_scales) {
+    bool ok = true;
+    std::map<std::string, float> scales;
+    std::string error;
+
+    bool plain = read("# exported from QAT\n\nimages 0.0078125\nmodel.0.act 0.05\r\nmodel.0.conv\t1.5e-2\n"
+                      "model.1.act 0\n",
+                      scales, error) &&
+                 scales.size() == 3 && scales["images"] == 0.0078125f && scales["model.0.act"] == 0.05f &&
+                 scales["model.0.conv"] == 0.015f;
+    ok &= check(plain, "plain name scale lines, comments, blank lines, tabs and CRLF; zero scales left out");
+
+    bool table = read("TRT-8401-EntropyCalibration2\nimages: 3c010a14\n(Unnamed Layer* 3) [Convolution]_output: "
+                      "3d4ccccd\n",
+                      scales, error) &&
+                 scales.size() == 2 && scales["images"] > 0.0078f && scales["images"] < 0.0079f &&
+                 scales["(Unnamed Layer* 3) [Convolution]_output"] == 0.05f;
+    ok &= check(table, "calibration tables, with TensorRT's names that contain spaces");
+
+    bool missing = readInt8Scales("/nonexistent/int8_scales.txt", scales, error) && scales.empty();
+    ok &= check(missing, "a missing file gives no scales");
+
+    const char* bad[][2] = {{"images 0.01\nmodel.0.act\n", ":2: no scale"},
+                            {"images 0.01\nmodel.0.act 0.0x\n", ":2: bad scale"},
+                            {"images 0.01\nmodel.0.act 1e99\n", ":2: scale not positive"},
+                            {"images 0.01\n\nmodel.0.act -0.5\n", ":3: scale not positive"},
+                            {"model.0.act nan\n", ":1: scale not positive"},
+                            {"TRT-8401-EntropyCalibration2\nimages: 3c01zz14\n", ":2: bad hex scale"},
+                            {"TRT-8401-EntropyCalibration2\nimages: 3c010a14a\n", ":2: bad hex scale"},
+                            {"TRT-8401-EntropyCalibration2\n: 3c010a14\n", ":2: no name"}};
+    bool rejected = true;
+    for (const auto& b : bad) {
+        scales.clear();
+        bool read_ok = read(b[0], scales, error);
+        rejected &= !read_ok && scales.empty() && error.find(b[1]) != std::string::npos;
+        if (read_ok || error.find(b[1]) == std::string::npos) {
+            std::cout << "      expected \"" << b[1] << "\", got \"" << error << "\"" << std::endl;
+        }
+    }
+    ok &= check(rejected, "malformed lines are rejected with the file and line");
+
+    // the first block of yolov8 as convBnSiLU names it, with TensorRT's default tensor names, and a layer with two
+    // outputs
+    std::vector<Int8Target> network = {{"images", "images"},
+                                       {"(Unnamed Layer* 0) [Convolution]_output", "model.0.conv"},
+                                       {"(Unnamed Layer* 1) [Activation]_output", "model.0.sigmoid"},
+                                       {"(Unnamed Layer* 2) [ElementWise]_output", "model.0.act"},
+                                       {"(Unnamed Layer* 3) [Slice]_output", "model.2.split"},
+                                       {"(Unnamed Layer* 3) [Slice]_output_1", ""}};
+    std::map<std::string, float> qat = {{"images", 1.f / 128},
+                                        {"model.0.act", 0.05f},
+                                        {"model.0.conv", 0.1f},
+                                        {"(Unnamed Layer* 0) [Convolution]_output", 0.2f},
+                                        {"model.2.split", 0.3f}};
+    std::vector<float> ranges = int8DynamicRanges(qat, network);
+    bool mapped = ranges.size() == network.size() && ranges[0] == 127.f / 128 && ranges[1] == 127.f * 0.2f &&
+                  ranges[2] == 0.f && ranges[3] == 127.f * 0.05f && ranges[4] == 127.f * 0.3f && ranges[5] == 0.f;
+    ok &= check(mapped,
+                "tensor names first, then layer names for first outputs, tensors without a scale are left unset");
+    return ok;
+}
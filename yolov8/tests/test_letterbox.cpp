@@ -0,0 +1,45 @@
+#include <math.h>
+#include "letterbox.h"
+#include "test_harness.h"
+
+// rect_letterbox_shape picks stride-aligned shapes within the maximum that scale the image as much as the fixed
+// square does, a batch shares the elementwise maximum, and letterbox_padding_ratio on known cases.
+
+static float scale(int img_w, int img_h, int w, int h) {
+    return fminf(w / (float)img_w, h / (float)img_h);
+}
+
+TEST_CASE(letterbox) {
+    bool ok = true;
+    LetterboxShape hd = rect_letterbox_shape(1280, 720, 640, 640);
+    LetterboxShape portrait = rect_letterbox_shape(1080, 1920, 640, 640);
+    LetterboxShape square = rect_letterbox_shape(500, 500, 640, 640);
+    ok &= check(hd.w == 640 && hd.h == 384 && portrait.w == 384 && portrait.h == 640 && square.w == 640 &&
+                        square.h == 640,
+                "16:9, 9:16 and square images");
+
+    bool aligned = true;
+    for (int w = 16; w <= 4096; w += 37) {
+        for (int h = 16; h <= 4096; h += 53) {
+            LetterboxShape s = rect_letterbox_shape(w, h, 640, 480);
+            aligned &= s.w % 32 == 0 && s.h % 32 == 0 && s.w >= 32 && s.h >= 32 && s.w <= 640 && s.h <= 480;
+            // the same scale as the fixed input, so the rect shape loses no resolution
+            aligned &= scale(w, h, s.w, s.h) >= scale(w, h, 640, 480) - 1e-6f;
+        }
+    }
+    ok &= check(aligned, "shapes are stride-aligned, within the maximum and keep the scale of the fixed input");
+
+    LetterboxShape thin = rect_letterbox_shape(4000, 10, 640, 640);
+    ok &= check(thin.w == 640 && thin.h == 32, "shapes are at least one stride");
+
+    LetterboxShape batch = rect_letterbox_batch_shape({{1280, 720}, {1080, 1920}, {640, 480}}, 640, 640);
+    LetterboxShape same = rect_letterbox_batch_shape({{1920, 1080}, {1280, 720}}, 640, 640);
+    ok &= check(batch.w == 640 && batch.h == 640 && same.w == 640 && same.h == 384,
+                "a batch shares the elementwise maximum of its shapes");
+
+    ok &= check(fabsf(letterbox_padding_ratio(1280, 720, 640, 640) - 0.4375f) < 1e-6f &&
+                        fabsf(letterbox_padding_ratio(1280, 720, 640, 384) - 0.0625f) < 1e-6f &&
+                        fabsf(letterbox_padding_ratio(640, 480, 640, 480)) < 1e-6f,
+                "padding ratios");
+    return ok;
+}
@@ -0,0 +1,55 @@
+#include "motion_fixture.h"
+#include "motion_gate.h"
+#include "test_harness.h"
+
+// Sequences are a textured static background with per-pixel sensor noise: without motion the detector must only run
+// on the first frame and every max_stale + 1 frames; with a moving object it must run often enough that the reused
+// boxes never lag the object by more than a few pixels, and the reported regions must contain the object. A change of
+// the frame size must force a run.
+
+TEST_CASE(motion_gate) {
+    const int frames = 300, width = 1920, height = 1080;
+    bool ok = true;
+    MotionGateOptions opts;
+    Sequence seq(width, height);
+
+    MotionGate gate(opts);
+    int runs = 0, expected = 0;
+    for (int f = 0; f < frames; f++) {
+        runs += gate.check(seq.render(6, 0, 0, 0)).run_detector;
+        expected += f % (opts.max_stale + 1) == 0;
+    }
+    printf("      static, noise +-6: %d of %d frames run the detector, %d expected\n", runs, frames, expected);
+    ok &= check(runs == expected, "static frames only run on the staleness bound");
+
+    // a 48x48 object crossing the frame at 1 px per frame
+    gate.reset();
+    runs = 0;
+    int max_lag = 0, last_x = 0;
+    bool covered = true;
+    for (int f = 0; f < frames; f++) {
+        int x = 100 + f % (width - 200), y = height / 2;
+        const MotionDecision& d = gate.check(seq.render(6, x, y, 48));
+        if (d.run_detector) {
+            runs++;
+            last_x = x;
+            bool inside = false;
+            for (const auto& r : d.regions) {
+                inside |= r.x <= x && r.y <= y && r.x + r.width >= x + 48 && r.y + r.height >= y + 48;
+            }
+            covered &= inside;
+        }
+        max_lag = std::max(max_lag, std::abs(x - last_x));
+    }
+    printf("      moving object: %d of %d frames run the detector, reused boxes lag by up to %d px\n", runs, frames,
+           max_lag);
+    ok &= check(max_lag <= 6, "reused boxes stay within 6 px of a moving object");
+    ok &= check(covered, "regions contain the moving object");
+
+    gate.reset();
+    MotionGate resized(opts);
+    resized.check(seq.render(0, 0, 0, 0));
+    Sequence smaller(width / 2, height / 2);
+    ok &= check(resized.check(smaller.render(0, 0, 0, 0)).run_detector, "a new frame size forces a run");
+    return ok;
+}
@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "nv12_preprocess.h"
+#include "preprocess_fixture.h"
+#include "test_harness.h"
+
+// For several frame shapes and strides:
+//   - the SSE2 nv12_letterbox gives exactly the bits of nv12_letterbox_reference, the per-pixel function the CUDA
+//     kernel runs, also for odd widths and heights, whose last UV row and pair cover a single row or column;
+//   - both are within half a level of cvtColor(COLOR_YUV2BGR_NV12) followed by warpaffine_kernel, with the same
+//     border, for the even shapes cvtColor takes.
+
+TEST_CASE(nv12) {
+    const int w = 640, h = 640;
+    std::mt19937 rng(7);
+    const int sizes[][3] = {{1920, 1080, 1920}, {1280, 720, 1344}, {720, 1280, 768}, {640, 640, 640},
+                            {1002, 334, 1024},  {320, 240, 384},   {641, 361, 642},  {1279, 721, 1280}};
+    std::vector<float> simd(3 * w * h), reference(3 * w * h), bgr_path(3 * w * h);
+    bool same = true, border = true;
+    float worst = 0.f;
+    for (const auto& size : sizes) {
+        int width = size[0], height = size[1], stride = size[2];
+        cv::Mat nv12 = make_nv12(width, height, stride, rng);
+        const uint8_t* y_plane = nv12.ptr<uint8_t>(0);
+        const uint8_t* uv_plane = nv12.ptr<uint8_t>(height);
+        nv12_letterbox(y_plane, uv_plane, width, height, stride, simd.data(), w, h);
+        nv12_letterbox_reference(y_plane, uv_plane, width, height, stride, reference.data(), w, h);
+        same &= memcmp(simd.data(), reference.data(), simd.size() * sizeof(float)) == 0;
+        if (width % 2 != 0 || height % 2 != 0) {
+            printf("      %4dx%-4d (stride %4d) -> %dx%d: odd size, compared with the reference only\n", width, height,
+                   stride, w, h);
+            continue;
+        }
+
+        cv::Mat bgr;
+        cv::cvtColor(nv12, bgr, cv::COLOR_YUV2BGR_NV12);
+        warpaffine_reference(bgr, bgr_path.data(), w, h);
+        float err = 0.f;
+        double sum = 0.;
+        for (size_t i = 0; i < bgr_path.size(); i++) {
+            float diff = std::abs(simd[i] - bgr_path[i]) * 255.f;
+            err = std::max(err, diff);
+            sum += diff;
+        }
+        if (width != height) {
+            border &= simd[0] == bgr_path[0] && simd[simd.size() - 1] == bgr_path[bgr_path.size() - 1];
+        }
+        printf("      %4dx%-4d (stride %4d) -> %dx%d: largest difference to cvtColor + warpaffine %.3f levels, "
+               "mean %.3f\n",
+               width, height, stride, w, h, err, sum / bgr_path.size());
+        worst = std::max(worst, err);
+    }
+    bool ok = true;
+    ok &= check(same, "SSE2 nv12_letterbox is bit-identical to the per-pixel reference of the CUDA kernel");
+    ok &= check(worst <= 0.5f + 1e-3f, "within half a level of cvtColor + warpaffine_kernel");
+    ok &= check(border, "the same 128 border");
+    return ok;
+}
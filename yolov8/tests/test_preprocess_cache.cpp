@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "prep_fixture.h"
+#include "preprocess_cache.h"
+#include "test_harness.h"
+
+// Equal specs share a tensor and letterbox specs of the same scale share a resize, every tensor is exactly what the
+// model's own preprocessing makes, also after the frame size changes, and a tensor is computed once per frame however
+// many models ask for it.
+
+// The preprocessing of a model on its own, written as directly as possible.
+static std::vector<uint8_t> reference(const cv::Mat& img, const InputSpec& spec) {
+    cv::Rect src(0, 0, img.cols, img.rows), content(0, 0, spec.width, spec.height);
+    if (spec.resize == ResizeMode::kLetterbox) {
+        float r_w = spec.width / (img.cols * 1.0), r_h = spec.height / (img.rows * 1.0);
+        if (r_h > r_w) {
+            content.height = r_w * img.rows;
+            content.y = (spec.height - content.height) / 2;
+        } else {
+            content.width = r_h * img.cols;
+            content.x = (spec.width - content.width) / 2;
+        }
+    } else if (spec.resize == ResizeMode::kCenterCrop) {
+        int m = std::min(img.cols, img.rows);
+        src = cv::Rect((img.cols - m) / 2, (img.rows - m) / 2, m, m);
+    }
+    cv::Mat re;
+    cv::resize(img(src), re, content.size(), 0, 0, cv::INTER_LINEAR);
+    const int plane = spec.width * spec.height;
+    const bool f32 = spec.dtype == InputDType::kFloat32;
+    std::vector<uint8_t> out(plane * 3 * (f32 ? sizeof(float) : 1));
+    for (int y = 0; y < spec.height; y++) {
+        for (int x = 0; x < spec.width; x++) {
+            bool inside = x >= content.x && x < content.x + content.width && y >= content.y &&
+                          y < content.y + content.height;
+            for (int c = 0; c < 3; c++) {
+                int bgr = spec.order == ChannelOrder::kRGB ? 2 - c : c;
+                uint8_t v = inside ? re.ptr<uint8_t>(y - content.y)[(x - content.x) * 3 + bgr] : spec.pad;
+                if (f32) {
+                    ((float*)out.data())[c * plane + y * spec.width + x] = (v / 255.f - spec.mean[c]) / spec.std[c];
+                } else {
+                    out[(y * spec.width + x) * 3 + c] = v;
+                }
+            }
+        }
+    }
+    return out;
+}
+
+static bool matches(PreprocessCache& cache, const std::vector<int>& models, const std::vector<InputSpec>& specs,
+                    const cv::Mat& img) {
+    bool ok = true;
+    for (size_t m = 0; m < models.size(); m++) {
+        const PreprocessedInput& in = cache.input(models[m]);
+        std::vector<uint8_t> ref = reference(img, specs[m]);
+        ok &= in.bytes == ref.size() && memcmp(in.data, ref.data(), ref.size()) == 0;
+    }
+    return ok;
+}
+
+TEST_CASE(preprocess_cache) {
+    bool ok = true;
+    // yolov8 detection and pose take the same input
+    std::vector<InputSpec> specs = {yolov8_spec(), yolov8_spec(), yolop_spec(), cls_spec(), uint8_spec()};
+    PreprocessCache cache;
+    std::vector<int> models;
+    for (const auto& spec : specs) {
+        models.push_back(cache.add_model(spec));
+    }
+    cv::Mat frame(720, 1280, CV_8UC3);
+    make_pattern_frame(frame, 0);
+    cache.set_frame(frame);
+    printf("      5 models on 1280x720: %d tensors, %d resizes\n", cache.tensor_count(), cache.resize_count());
+    ok &= check(cache.tensor_count() == 4 && cache.input(models[0]).data == cache.input(models[1]).data,
+                "models with equal specs share one tensor");
+    // 640x640, 640x384 and the uint8 640x640 all scale 1280x720 to 640x360
+    ok &= check(cache.resize_count() == 2, "letterboxes of the same scale share one resize");
+    ok &= check(matches(cache, models, specs, frame), "every tensor equals the model's own preprocessing");
+
+    PreprocessCacheStats before = cache.stats();
+    for (int f = 1; f <= 3; f++) {
+        make_pattern_frame(frame, f);
+        cache.set_frame(frame);
+        ok &= matches(cache, models, specs, frame);
+        for (int m : models) {
+            cache.input(m);
+        }
+    }
+    PreprocessCacheStats s = cache.stats();
+    printf("      3 frames: %ld requests, %ld tensors and %ld resizes computed\n", s.requests - before.requests,
+           s.tensors - before.tensors, s.resizes - before.resizes);
+    ok &= check(s.tensors - before.tensors == 3 * 4 && s.resizes - before.resizes == 3 * 2,
+                "each tensor and resize is computed once per frame");
+
+    cv::Mat portrait(1280, 720, CV_8UC3);
+    make_pattern_frame(portrait, 4);
+    cache.set_frame(portrait);
+    ok &= check(cache.resize_count() == 3 && matches(cache, models, specs, portrait),
+                "a new frame size replans the shared resizes");
+    return ok;
+}
@@ -0,0 +1,95 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "result_cache.h"
+#include "test_harness.h"
+
+// XXH64 against its reference values, LRU eviction under the memory budget, the persistence round trip and the pixel
+// key.
+
+static std::vector<Detection> make_dets(int n, float tag) {
+    std::vector<Detection> dets(n);
+    for (int i = 0; i < n; i++) {
+        memset(&dets[i], 0, sizeof(Detection));
+        dets[i].bbox[0] = tag;
+        dets[i].bbox[1] = i;
+        dets[i].bbox[2] = 10.f + i;
+        dets[i].bbox[3] = 20.f + i;
+        dets[i].conf = 0.5f;
+        dets[i].class_id = i % 80;
+    }
+    return dets;
+}
+
+// smooth synthetic frame: gradient background and a few boxes, noise of +-amplitude per pixel
+static cv::Mat make_frame(int w, int h, int seed, int noise) {
+    cv::Mat img(h, w, CV_8UC3);
+    std::mt19937 rng(seed);
+    std::mt19937 noise_rng(seed * 7919 + noise);
+    int bx = rng() % (w / 2), by = rng() % (h / 2);
+    for (int y = 0; y < h; y++) {
+        uint8_t* row = img.data + (size_t)y * img.step;
+        for (int x = 0; x < w; x++) {
+            int base = (x * 255 / w + y * 128 / h + seed * 37) & 0xff;
+            if (x > bx && x < bx + w / 3 && y > by && y < by + h / 3) {
+                base = 255 - base;
+            }
+            for (int c = 0; c < 3; c++) {
+                int v = base + (noise > 0 ? (int)(noise_rng() % (2 * noise + 1)) - noise : 0);
+                row[x * 3 + c] = (uint8_t)std::min(255, std::max(0, v));
+            }
+        }
+    }
+    return img;
+}
+
+TEST_CASE(result_cache) {
+    bool ok = true;
+    ok &= check(xxh64("", 0) == 0xEF46DB3751D8E999ull && xxh64("a", 1) == 0xD24EC4F1A98C6E5Bull &&
+                        xxh64("abc", 3) == 0x44BC2CF5AD770999ull,
+                "xxh64 reference values");
+
+    // room for three entries of 10 boxes (about 330 bytes each with bookkeeping) but not four
+    const size_t budget = 1100;
+    ResultCache cache(budget, 42);
+    std::vector<Detection> dets;
+    cache.insert(1, make_dets(10, 1.f));
+    cache.insert(2, make_dets(10, 2.f));
+    cache.insert(3, make_dets(10, 3.f));
+    bool hit1 = cache.lookup(1, dets) && dets.size() == 10 && dets[0].bbox[0] == 1.f && dets[9].class_id == 9.f;
+    cache.insert(4, make_dets(10, 4.f));  // evicts 2, the least recently used after the lookup of 1
+    ResultCacheStats s = cache.stats();
+    ok &= check(hit1, "lookup returns the stored boxes");
+    ok &= check(s.evictions >= 1 && !cache.lookup(2, dets) && cache.lookup(1, dets) && cache.lookup(4, dets),
+                "least recently used entry is evicted first");
+    ok &= check(cache.stats().bytes <= budget, "memory stays within the budget");
+    cache.insert(5, make_dets(1000, 5.f));
+    ok &= check(!cache.lookup(5, dets) && cache.lookup(1, dets), "results larger than the budget are not stored");
+
+    std::string path = temp_path("cache.bin");
+    ok &= check(cache.save(path), "save");
+    ResultCache loaded(cache.stats().bytes, 42);
+    bool round_trip = loaded.load(path) && loaded.stats().entries == cache.stats().entries;
+    round_trip = round_trip && loaded.lookup(4, dets) && dets.size() == 10 && dets[3].bbox[1] == 3.f;
+    ok &= check(round_trip, "load restores the entries");
+    ResultCache other(1 << 20, 43);
+    ok &= check(!other.load(path) && other.stats().entries == 0, "a file for another config is ignored");
+    remove(path.c_str());
+
+    cv::Mat a = make_frame(640, 480, 1, 0);
+    int same = 0;
+    for (int i = 1; i <= 10; i++) {
+        same += cache.pixel_key(a) == cache.pixel_key(make_frame(640, 480, 1, i % 3 + 1));
+    }
+    int distinct = 0;
+    for (int i = 2; i <= 11; i++) {
+        distinct += cache.pixel_key(a) != cache.pixel_key(make_frame(640, 480, i, 0));
+    }
+    std::cout << "      pixel key: " << same << "/10 noisy copies match, " << distinct << "/10 other frames differ"
+              << std::endl;
+    ok &= check(cache.pixel_key(a) == cache.pixel_key(make_frame(640, 480, 1, 0)) && distinct == 10,
+                "pixel key is stable and separates different frames");
+    return ok;
+}
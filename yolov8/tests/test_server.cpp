@@ -0,0 +1,103 @@
+#include <poll.h>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+#include "batch_scheduler.h"
+#include "inference_server.h"
+#include "test_harness.h"
+
+// The limits of the server against a mock engine: requests over kMaxRequestBytes are refused without being read,
+// images over kMaxInputImageSize pixels are refused before they reach the engine, clients past max_connections wait
+// until one disconnects, and BatchSchedulerOptions::thread_init runs on the thread of the batches.
+
+static std::vector<uint8_t> encode_jpeg(int w, int h) {
+    std::vector<uint8_t> jpeg;
+    cv::imencode(".jpg", cv::Mat(h, w, CV_8UC3, cv::Scalar::all(128)), jpeg);
+    return jpeg;
+}
+
+// One request and its response, false for a refused image or a closed connection
+static bool request(int fd, const std::vector<uint8_t>& image, std::vector<ServerDetection>& dets) {
+    return send_inference_request(fd, image, 0) && read_inference_response(fd, dets);
+}
+
+TEST_CASE(server) {
+    std::string socket_path = temp_path("server.sock");
+    BatchSchedulerOptions opts;
+    opts.max_batch = 4;
+    // run_inference_server has no stop, so its thread keeps the scheduler and the state of the mock engine until the
+    // test binary exits and they are never freed
+    struct MockEngine {
+        std::thread::id init_thread;
+        std::atomic<int> jobs{0};
+        std::atomic<bool> init_first{true};
+    };
+    MockEngine* engine = new MockEngine();
+    // yolov8_det sets the CUDA device of the scheduler thread here
+    opts.thread_init = [engine]() { engine->init_thread = std::this_thread::get_id(); };
+    // one box over the whole image
+    BatchScheduler* scheduler = new BatchScheduler(opts, [engine](std::vector<std::shared_ptr<InferJob>>& batch) {
+        engine->init_first = engine->init_first && engine->init_thread == std::this_thread::get_id();
+        for (auto& job : batch) {
+            Detection det{};
+            det.bbox[2] = job->img.cols;
+            det.bbox[3] = job->img.rows;
+            det.conf = 1.f;
+            job->result.assign(1, det);
+            engine->jobs++;
+        }
+    });
+    const int max_connections = 2;
+    std::thread([socket_path, scheduler] {
+        run_inference_server(socket_path, *scheduler, 100, nullptr, cv::Size(), max_connections);
+    }).detach();
+    int c1 = -1;
+    for (int i = 0; i < 100 && c1 < 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        c1 = connect_inference_server(socket_path);
+    }
+    bool ok = true;
+    std::vector<uint8_t> small = encode_jpeg(64, 48);
+    std::vector<ServerDetection> dets;
+    ok &= check(c1 >= 0 && request(c1, small, dets) && dets.size() == 1 && dets[0].bbox[2] == 64.f,
+                "a small image is detected");
+    ok &= check(engine->init_first, "thread_init runs on the scheduler thread before its batches");
+    uint64_t misses = scheduler->stats().deadline_misses;
+    bool clamped = send_inference_request(c1, small, 0xffffffff) && read_inference_response(c1, dets) &&
+                   dets.size() == 1 && scheduler->stats().deadline_misses == misses;
+    ok &= check(clamped, "a deadline of 0xffffffff ms is clamped instead of wrapping to one already passed");
+
+    // 3008 x 3008 is over kMaxInputImageSize, a flat JPEG of it is only a few hundred KB
+    int before = engine->jobs;
+    bool large = !request(c1, encode_jpeg(3008, 3008), dets) && engine->jobs == before;
+    ok &= check(large && request(c1, small, dets) && dets.size() == 1,
+                "images over kMaxInputImageSize are refused before the engine, the connection stays usable");
+
+    int c2 = connect_inference_server(socket_path);
+    uint32_t header[2] = {0, kMaxRequestBytes + 1};
+    uint32_t reply = 0;
+    bool oversize = c2 >= 0 && write(c2, header, sizeof(header)) == sizeof(header) &&
+                    read(c2, &reply, sizeof(reply)) == sizeof(reply) && reply == 0xffffffff &&
+                    read(c2, &reply, sizeof(reply)) == 0;
+    ok &= check(oversize, "requests over kMaxRequestBytes are refused unread and the connection closed");
+    if (c2 >= 0) {
+        close(c2);
+    }
+
+    // c1 and c2 hold both connections, c3 waits in the backlog until one of them leaves
+    c2 = connect_inference_server(socket_path);
+    bool served = c2 >= 0 && request(c2, small, dets);
+    int c3 = connect_inference_server(socket_path);
+    pollfd waiting{c3, POLLIN, 0};
+    bool bounded = served && c3 >= 0 && send_inference_request(c3, small, 0) && poll(&waiting, 1, 300) == 0;
+    close(c1);
+    bounded &= read_inference_response(c3, dets) && dets.size() == 1;
+    ok &= check(bounded, "clients past max_connections are served once another disconnects");
+    for (int fd : {c2, c3}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    unlink(socket_path.c_str());
+    return ok;
+}
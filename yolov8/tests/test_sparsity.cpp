@@ -0,0 +1,121 @@
+#include <math.h>
+#include <stdlib.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "sparsity.h"
+#include "test_harness.h"
+#include "wts.h"
+
+// prune_2to4 keeps the 2 largest magnitudes of every group of 4 input channels, check_2to4 accepts the result and
+// rejects denser weights, and prune_conv_2to4 reports the sparsity and relative error. The kernel size comes from the
+// shape tag of the .wts entry; without it a 1x1 conv over 576 channels, model.9.cv1 of yolov8m, is refused instead of
+// pruned as a 3x3 conv over 64, which breaks the 2:4 pattern of the real layout.
+
+static std::vector<float> random_weights(size_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> dist(0.f, 0.05f);
+    std::vector<float> w(n);
+    for (auto& v : w) {
+        v = dist(rng);
+    }
+    return w;
+}
+
+TEST_CASE(sparsity) {
+    bool ok = true;
+
+    // one output channel, 8 input channels, 1x1: two groups
+    std::vector<float> w = {0.1f, -0.4f, 0.3f, 0.2f, 0.f, 0.5f, -0.5f, 0.5f};
+    prune_2to4(w, 1, 8, 1);
+    std::vector<float> expected = {0.f, -0.4f, 0.3f, 0.f, 0.f, 0.5f, -0.5f, 0.f};
+    ok &= check(w == expected, "the 2 largest magnitudes of each group are kept, ties keep the lower channel");
+
+    // 3x3: groups run along the input channels at each kernel position, not along the 9 positions
+    std::vector<float> w3 = random_weights(2 * 8 * 9, 1);
+    prune_2to4(w3, 2, 8, 9);
+    bool per_position = true;
+    for (int o = 0; o < 2; o++) {
+        for (int c = 0; c < 8; c += 4) {
+            for (int s = 0; s < 9; s++) {
+                int nonzero = 0;
+                for (int i = 0; i < 4; i++) {
+                    nonzero += w3[(o * 8 + c + i) * 9 + s] != 0.f;
+                }
+                per_position &= nonzero == 2;
+            }
+        }
+    }
+    ok &= check(per_position, "3x3 kernels are pruned per kernel position");
+
+    std::vector<float> dense = random_weights(4 * 16 * 9, 2);
+    std::vector<float> three = dense;
+    for (size_t i = 0; i < three.size(); i += 4) {
+        three[i] = 0.f;  // 3 of 4 non-zero in every group of a 1x1 layout
+    }
+    bool rejects = !check_2to4(dense, 4, 16, 9) && !check_2to4(three, 4, 144, 1);
+    ok &= check(rejects && check_2to4(std::vector<float>(64), 4, 16, 1),
+                "check_2to4 rejects groups with more than 2 non-zero weights");
+
+    // 6 input channels: the last 2 do not fill a group and are left alone
+    std::vector<float> tail = {0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f};
+    prune_2to4(tail, 1, 6, 1);
+    ok &= check(tail[4] == 0.5f && tail[5] == 0.6f && tail[0] == 0.f && tail[1] == 0.f,
+                "input channels past the last full group are not pruned");
+
+    std::vector<float> report = {3.f, 4.f, 0.f, 0.f, 1.f, 1.f, 1.f, 1.f};
+    PruneStats stats = prune_conv_2to4(report, 1, 8, 1);
+    // zeroed 1 and 1 of a tensor of norm sqrt(9 + 16 + 4)
+    ok &= check(stats.valid && stats.sparsity == 0.5f && fabsf(stats.rel_error - sqrtf(2.f / 29.f)) < 1e-6f,
+                "prune_conv_2to4 reports sparsity, relative error and validity");
+
+    std::vector<int> none;
+    ok &= check(conv_kernel_size({32, 16, 3, 3}, 32 * 16 * 9, 32) == 3 &&
+                    conv_kernel_size({192, 576, 1, 1}, 192 * 576, 192) == 1 &&
+                    conv_kernel_size(none, 32 * 20, 32) == 1,
+                "kernel size from the shape tag, or 1x1 when the weights per output do not divide by 9");
+    ok &= check(conv_kernel_size(none, 192 * 576, 192) == 0 && conv_kernel_size(none, 32 * 16 * 9, 32) == 0 &&
+                    conv_kernel_size({32, 16, 3, 3}, 32 * 16, 32) == 0 &&
+                    conv_kernel_size({32, 16, 3, 3}, 32 * 16 * 9, 16) == 0 &&
+                    conv_kernel_size({32, 16, 3, 1}, 32 * 16 * 3, 32) == 0,
+                "ambiguous layouts and shapes that do not match the weights give 0");
+
+    // model.9.cv1 of yolov8m: 1x1 from 576 to 288 channels. Pruned as 3x3 over 64 channels, the groups of the
+    // guessed layout mix input channels 9 apart, so the real 1x1 groups are left with 3 or 4 non-zero weights.
+    const int out = 288, in = 576;
+    std::vector<float> cv1 = random_weights((size_t)out * in, 3);
+    std::vector<float> guessed = cv1;
+    prune_2to4(guessed, out, in / 9, 9);
+    std::vector<float> tagged = cv1;
+    prune_2to4(tagged, out, in, conv_kernel_size({out, in, 1, 1}, out * in, out));
+    ok &= check(!check_2to4(guessed, out, in, 1) && check_2to4(tagged, out, in, 1),
+                "576-channel 1x1 conv: the 3x3 guess breaks 2:4, the shape tag keeps it");
+
+    std::istringstream entry("model.9.cv1.conv.weight shape 2x4x1x1 8 3f800000 0 0 0 0 0 0 bf800000\n"
+                             "model.9.cv1.conv.weight shape 2x4x1x1 fp16 8 3c00 0 0 0 0 0 0 bc00\n"
+                             "model.9.cv1.bn.bias 2 3f800000 0\n");
+    std::string name, type;
+    float* values = nullptr;
+    uint32_t count = 0;
+    std::vector<int> shape;
+    bool tag = readWtsEntry(entry, name, type, values, count, &shape) && type == "fp32" && count == 8 &&
+               shape == std::vector<int>({2, 4, 1, 1}) && values[0] == 1.f && values[7] == -1.f;
+    free(values);
+    tag &= readWtsEntry(entry, name, type, values, count, &shape) && type == "fp16" && shape.size() == 4 &&
+           values[7] == -1.f;
+    free(values);
+    tag &= readWtsEntry(entry, name, type, values, count, &shape) && shape.empty() && count == 2;
+    free(values);
+    ok &= check(tag, "readWtsEntry reads the shape tag of fp32 and fp16 entries, none for 1-D tensors");
+
+    const char* bad[] = {"w shape 2x4x1x1 4 0 0 0 0\n", "w shape 2x0x1x1 0\n", "w shape 2x4x1y1 8 0 0 0 0 0 0 0 0\n",
+                         "w shape 8\n"};
+    bool rejected = true;
+    for (const char* b : bad) {
+        std::istringstream in(b);
+        rejected &= !readWtsEntry(in, name, type, values, count, &shape);
+    }
+    ok &= check(rejected, "shape tags that do not match the size or do not parse are rejected");
+    return ok;
+}
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "test_harness.h"
+#include "tile_fixture.h"
+#include "tiling.h"
+
+// The planned tiles cover the frame with the requested overlap, boxes survive the round trip through a tile's
+// letterbox, and merging the clipped views several tiles have of the same objects gives back one box per object with
+// fusion, while NMS keeps some parts of objects cut at tile borders.
+
+struct MergeResult {
+    int found = 0;
+    int boxes = 0;
+};
+
+static MergeResult run_merge(const std::vector<Tile>& tiles, const std::vector<Detection>& objects, TileMerge merge,
+                             std::mt19937& rng) {
+    std::vector<std::vector<Detection>> outputs = tile_outputs(tiles, objects, 0.2f, rng);
+    std::vector<Detection> dets;
+    for (size_t t = 0; t < tiles.size(); t++) {
+        tile_to_frame(tiles[t], outputs[t]);
+        dets.insert(dets.end(), outputs[t].begin(), outputs[t].end());
+    }
+    merge_tile_detections(dets, merge, 0.5f);
+    MergeResult r;
+    r.boxes = dets.size();
+    for (const auto& o : objects) {
+        for (const auto& d : dets) {
+            if (d.class_id == o.class_id && box_iou(o.bbox, d.bbox) > 0.95f) {
+                r.found++;
+                break;
+            }
+        }
+    }
+    return r;
+}
+
+TEST_CASE(tiling) {
+    bool ok = true;
+    TileOptions opts;
+    std::vector<Tile> tiles = plan_tiles(3840, 2160, 640, 640, opts);
+    bool sizes = tiles[0].roi == cv::Rect(0, 0, 3840, 2160);
+    std::vector<int> cover(3840 * 2160, 0);
+    int min_overlap = 640;
+    for (size_t t = 1; t < tiles.size(); t++) {
+        const cv::Rect& r = tiles[t].roi;
+        sizes &= r.width == 640 && r.height == 640 && tiles[t].scale == 1.f && tiles[t].pad_x == 0.f;
+        for (int y = r.y; y < r.y + r.height; y++) {
+            for (int x = r.x; x < r.x + r.width; x++) {
+                cover[y * 3840 + x]++;
+            }
+        }
+        for (size_t u = 1; u < tiles.size(); u++) {
+            const cv::Rect& s = tiles[u].roi;
+            if (s.y == r.y && s.x > r.x && s.x < r.x + r.width) {
+                min_overlap = std::min(min_overlap, r.x + r.width - s.x);
+            }
+        }
+    }
+    printf("      3840x2160: %zu tiles of 640x640 plus the full frame, min horizontal overlap %d px\n",
+           tiles.size() - 1, min_overlap);
+    ok &= check(sizes && tiles.size() == 1 + 8 * 4, "tiles have the input size, full frame first");
+    ok &= check(*std::min_element(cover.begin(), cover.end()) > 0, "tiles cover the frame");
+    ok &= check(min_overlap >= 128, "neighbours overlap by at least 20%");
+    std::vector<Tile> small = plan_tiles(500, 300, 640, 640, opts);
+    ok &= check(small.size() == 1 && small[0].roi == cv::Rect(0, 0, 500, 300), "a small frame is a single tile");
+
+    std::mt19937 rng(1);
+    std::vector<Detection> probe = {make_det(1000.5f, 700.25f, 1030.f, 760.f, 0.9f, 0)};
+    float err = 0.f;
+    for (const Tile& tile : tiles) {
+        std::vector<std::vector<Detection>> out = tile_outputs(std::vector<Tile>{tile}, probe, 1.f, rng);
+        if (out[0].empty()) {
+            continue;
+        }
+        tile_to_frame(tile, out[0]);
+        for (int k = 0; k < 4; k++) {
+            err = std::max(err, std::abs(out[0][0].bbox[k] - probe[0].bbox[k]));
+        }
+    }
+    ok &= check(err < 1e-2f, "boxes map back to frame pixels through tile and full-frame letterboxes");
+
+    std::vector<Detection> objects = make_objects(400, 3840, 2160, rng);
+    TileOptions tiles_only = opts;
+    tiles_only.full_frame = false;
+    std::vector<Tile> plan = plan_tiles(3840, 2160, 640, 640, tiles_only);
+    MergeResult fusion = run_merge(plan, objects, TileMerge::kFusion, rng);
+    MergeResult nms = run_merge(plan, objects, TileMerge::kNms, rng);
+    printf("      %zu objects: fusion recovers %d with %d boxes, nms %d with %d boxes\n", objects.size(), fusion.found,
+           fusion.boxes, nms.found, nms.boxes);
+    ok &= check(fusion.found == (int)objects.size() && fusion.boxes == (int)objects.size(),
+                "fusion gives one full box per object");
+    ok &= check(nms.found <= fusion.found && nms.boxes >= fusion.boxes,
+                "nms keeps partial boxes of cut objects, fusion does not");
+    return ok;
+}
@@ -0,0 +1,121 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "test_harness.h"
+#include "trace.h"
+
+// Spans recorded on several threads are exported and the file is read back: one thread_name per thread, the expected
+// number of spans per thread (the newest kTraceRingSize), non-negative durations, increasing start times, and a 20ms
+// sleep on the main thread comes out as 20ms once the span ticks are converted to ns.
+
+static void record_spans(int thread_idx, int n) {
+    trace_set_thread_name("worker " + std::to_string(thread_idx));
+    for (int i = 0; i < n; i++) {
+        TraceScope outer(i % 2 ? "odd" : "even");
+    }
+}
+
+struct ThreadCheck {
+    std::string name;
+    int spans = 0;
+    double last_ts = -1.0;
+    bool ordered = true;
+};
+
+// The exporter writes one event per line, so the check reads it back with sscanf instead of a JSON parser.
+static bool check_trace(const std::string& path, int threads, int spans_per_thread) {
+    std::ifstream in(path);
+    std::string line;
+    std::map<int, ThreadCheck> seen;
+    double sleep_us = -1.0;
+    bool ok = true;
+    if (!std::getline(in, line) || line.find("\"traceEvents\"") == std::string::npos) {
+        std::cerr << "missing traceEvents header" << std::endl;
+        return false;
+    }
+    while (std::getline(in, line)) {
+        int tid = 0;
+        double ts = 0.0, dur = 0.0;
+        char name[64] = {0};
+        if (line.find("\"ph\": \"M\"") != std::string::npos) {
+            if (sscanf(line.c_str(), "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                                     "\"args\": {\"name\": \"%63[^\"]\"}}",
+                       &tid, name) != 2) {
+                std::cerr << "bad metadata event: " << line << std::endl;
+                ok = false;
+            }
+            seen[tid].name = name;
+        } else if (line.find("\"ph\": \"X\"") != std::string::npos) {
+            if (sscanf(line.c_str(), "{\"name\": \"%63[^\"]\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %lf, "
+                                     "\"dur\": %lf}",
+                       name, &tid, &ts, &dur) != 4 || dur < 0.0) {
+                std::cerr << "bad span event: " << line << std::endl;
+                ok = false;
+                continue;
+            }
+            if (std::string(name) == "sleep") {
+                sleep_us = dur;
+            }
+            ThreadCheck& t = seen[tid];
+            t.spans++;
+            t.ordered = t.ordered && ts >= t.last_ts;
+            t.last_ts = ts;
+        }
+    }
+
+    int expected = std::min<int>(spans_per_thread, kTraceRingSize);
+    int workers = 0;
+    for (auto& kv : seen) {
+        if (kv.second.name.compare(0, 7, "worker ") != 0) {
+            continue;
+        }
+        workers++;
+        if (kv.second.spans != expected || !kv.second.ordered) {
+            std::cerr << kv.second.name << ": " << kv.second.spans << " spans, expected " << expected
+                      << (kv.second.ordered ? "" : ", out of order") << std::endl;
+            ok = false;
+        }
+    }
+    if (workers != threads) {
+        std::cerr << workers << " worker threads in the trace, expected " << threads << std::endl;
+        ok = false;
+    }
+    // sleep_for only oversleeps, by the scheduler's latency
+    if (sleep_us < 20000.0 || sleep_us > 25000.0) {
+        std::cerr << "20ms sleep exported as " << sleep_us << "us" << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+TEST_CASE(trace) {
+    const int threads = 4;
+    const std::string path = temp_path("trace.json");
+    trace_set_thread_name("main");
+    trace_clear();
+    trace_enable(true);
+    int spans_per_thread = kTraceRingSize + 1000;  // wraps every ring once
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(record_spans, i, spans_per_thread);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    {
+        TraceScope scope("sleep");
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    trace_enable(false);
+    bool ok = check(trace_write_chrome_json(path), "the trace is written");
+    ok &= check(ok && check_trace(path, threads, spans_per_thread),
+                "the exported spans match the recorded ones per thread, the sleep keeps its duration");
+    trace_clear();
+    remove(path.c_str());
+    return ok;
+}
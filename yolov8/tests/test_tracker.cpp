@@ -0,0 +1,144 @@
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "test_harness.h"
+#include "tracker.h"
+#include "tracker_fixture.h"
+
+// Every object is mapped to the track covering it with IoU > 0.5 on each frame; a change of that track ID is an ID
+// switch. The scene is tracked with detection on every frame and on every third frame (predict() in between), greedy
+// and Hungarian; the ID switches must stay within the limit and update() and predict() must not allocate after
+// warm-up. The Hungarian matcher must get the assignment of a crafted conflict that greedy matching gets wrong, and
+// swap fewer IDs than greedy on objects crossing each other's paths.
+
+// counts the allocations of the whole test binary, the tracker runs alone between two reads
+static size_t g_allocations = 0;
+
+void* operator new(size_t size) {
+    g_allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Pairs of 80 px objects that pass each other head-on, their paths half a box apart, with detections jittered by 10%
+// of the box. Near the crossing a track's prediction often overlaps the other object's detection most, so the best
+// single IoU and the best assignment of the pair disagree. The pairs are 300 px apart, each crossing is on its own.
+static Scene make_crossing_scene(int pairs, int frames, int seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> jitter(0.f, 1.f);
+    const float size = 80.f, speed = 4.f;
+    std::vector<Object> objects;
+    for (int p = 0; p < pairs; p++) {
+        float cy = 100.f + 300.f * p;
+        objects.push_back({100.f, cy, size, size, speed, 0.f});
+        objects.push_back({100.f + speed * frames, cy + size / 2, size, size, -speed, 0.f});
+    }
+    Scene scene;
+    for (int f = 0; f < frames; f++) {
+        std::vector<Detection> dets;
+        for (auto& o : objects) {
+            o.cx += o.vx;
+            float cx = o.cx + 0.1f * size * jitter(rng), cy = o.cy + 0.1f * size * jitter(rng);
+            dets.push_back(make_det(cx - size / 2, cy - size / 2, cx + size / 2, cy + size / 2, 0.9f));
+        }
+        scene.truth.push_back(objects);
+        scene.detections.push_back(dets);
+    }
+    return scene;
+}
+
+struct RunResult {
+    int id_switches = 0;
+    int64_t object_frames = 0;
+    int64_t covered = 0;
+    size_t steady_allocations = 0;
+    int detector_frames = 0;
+};
+
+static RunResult run(const Scene& scene, bool hungarian, int interval) {
+    TrackerOptions opts;
+    opts.hungarian = hungarian;
+    ByteTracker tracker(opts);
+    KeyframeScheduler scheduler(interval, 0.15f);
+    RunResult res;
+    std::vector<int> last_id(scene.truth[0].size(), -1);
+    for (size_t f = 0; f < scene.truth.size(); f++) {
+        size_t before = g_allocations;
+        bool key = scheduler.is_keyframe(tracker);
+        const std::vector<Track>& tracks = key ? tracker.update(scene.detections[f]) : tracker.predict();
+        if (f >= 50) {
+            res.steady_allocations += g_allocations - before;
+        }
+        res.detector_frames += key;
+        if (f < 10) {
+            continue;  // tracks need a second detection to be reported
+        }
+        for (size_t i = 0; i < scene.truth[f].size(); i++) {
+            const Object& o = scene.truth[f][i];
+            float gt[4] = {o.cx - o.w / 2, o.cy - o.h / 2, o.cx + o.w / 2, o.cy + o.h / 2};
+            float best = 0.5f;
+            int id = -1;
+            for (const auto& t : tracks) {
+                float v = box_iou(gt, t.bbox);
+                if (v > best) {
+                    best = v;
+                    id = t.id;
+                }
+            }
+            res.object_frames++;
+            if (id < 0) {
+                continue;
+            }
+            res.covered++;
+            res.id_switches += last_id[i] >= 0 && last_id[i] != id;
+            last_id[i] = id;
+        }
+    }
+    return res;
+}
+
+// Two tracks side by side and two detections: the best single IoU pairs track A with d1, which leaves B without a
+// partner. The optimal assignment pairs A with d2 and B with d1.
+static bool check_assignment(bool hungarian) {
+    TrackerOptions opts;
+    opts.hungarian = hungarian;
+    ByteTracker tracker(opts);
+    std::vector<Detection> first = {make_det(0, 0, 100, 100, 0.9f), make_det(60, 0, 160, 100, 0.9f)};
+    tracker.update(first);
+    std::vector<Detection> second = {make_det(20, 0, 120, 100, 0.9f), make_det(-30, 0, 70, 100, 0.9f)};
+    const std::vector<Track>& tracks = tracker.update(second);
+    return tracks.size() == 2;
+}
+
+TEST_CASE(tracker) {
+    const int num_objects = 60, frames = 600;
+    const double max_switch_rate = 2.0;  // per 1000 object-frames
+    bool ok = true;
+    ok &= check(check_assignment(true) && !check_assignment(false),
+                "hungarian resolves a conflict that greedy matching leaves unmatched");
+    Scene crossing = make_crossing_scene(100, 60, 1);
+    RunResult greedy = run(crossing, false, 1), optimal = run(crossing, true, 1);
+    printf("      100 crossings: %d id switches greedy, %d hungarian\n", greedy.id_switches, optimal.id_switches);
+    ok &= check(optimal.id_switches < greedy.id_switches, "hungarian swaps fewer ids than greedy on crossing tracks");
+
+    Scene scene = make_scene(num_objects, frames, 1920, 1080, 1);
+    for (int interval : {1, 3}) {
+        for (bool hungarian : {false, true}) {
+            RunResult r = run(scene, hungarian, interval);
+            double rate = 1000.0 * r.id_switches / r.object_frames;
+            printf("      every %d frames, %-9s: %d detector frames, %.1f%% covered, %d id switches (%.2f per 1000)\n",
+                   interval, hungarian ? "hungarian" : "greedy", r.detector_frames, 100.0 * r.covered / r.object_frames,
+                   r.id_switches, rate);
+            ok &= check(rate <= max_switch_rate, "id switches within the limit");
+            ok &= check(r.steady_allocations == 0, "no allocations after warm-up");
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "uint8_input.h"
+#include "preprocess_fixture.h"
+#include "test_harness.h"
+
+// The CPU reference of the Uint8Input_TRT plugin reorders and scales the bytes as the float path does, and
+// letterboxing to bytes followed by it gives the output of warpaffine_kernel to within half a level for landscape,
+// portrait, upscaled and unscaled frames, with the same border.
+
+TEST_CASE(uint8_input) {
+    bool ok = true;
+    const int w = 640, h = 640;
+
+    uint8_t pixels[2 * 3] = {10, 20, 30, 200, 100, 0};
+    float planar[2 * 3];
+    uint8_input_reference(pixels, planar, 1, 1, 2);
+    ok &= check(planar[0] == 30 / 255.f && planar[1] == 0.f && planar[2] == 20 / 255.f && planar[3] == 100 / 255.f &&
+                        planar[4] == 10 / 255.f && planar[5] == 200 / 255.f,
+                "the plugin reference turns HWC BGR bytes into RGB planes / 255");
+
+    std::mt19937 rng(3);
+    const int sizes[][2] = {{1280, 720}, {1920, 1080}, {720, 1280}, {320, 240}, {640, 640}, {1001, 333}};
+    std::vector<uint8_t> bytes(3 * w * h);
+    std::vector<float> engine_input(3 * w * h), float_input(3 * w * h);
+    float worst = 0.f;
+    bool border = true;
+    for (const auto& size : sizes) {
+        cv::Mat img(size[1], size[0], CV_8UC3);
+        make_gradient_frame(img, rng);
+        letterbox_uint8(img, bytes.data(), w, h);
+        uint8_input_reference(bytes.data(), engine_input.data(), 1, h, w);
+        warpaffine_reference(img, float_input.data(), w, h);
+        float err = 0.f;
+        double sum = 0.;
+        for (size_t i = 0; i < float_input.size(); i++) {
+            float diff = std::abs(engine_input[i] - float_input[i]) * 255.f;
+            err = std::max(err, diff);
+            sum += diff;
+        }
+        // the corners of a letterbox that is not square to the frame are border
+        if (size[0] != size[1]) {
+            border &= bytes[0] == 128 && bytes[bytes.size() - 1] == 128 && float_input[0] == 128 / 255.f;
+        }
+        printf("      %4dx%-4d -> %dx%d: largest difference %.3f levels, mean %.3f\n", size[0], size[1], w, h, err,
+               sum / float_input.size());
+        worst = std::max(worst, err);
+    }
+    ok &= check(worst <= 0.5f + 1e-3f, "uint8 letterbox + plugin reference match warpaffine_kernel to half a level");
+    ok &= check(border, "both paths pad with 128");
+    return ok;
+}
@@ -0,0 +1,108 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "test_harness.h"
+#include "wts.h"
+#include "wts_fixture.h"
+
+// Entries written as gen_wts.py does are read back with readWtsEntry, the parser of loadWeights: fp32 is bit-exact,
+// halfToFloat decodes every half exactly, fp16 and per-channel int8 stay within half a step of the stored value, the
+// DFL projection 0..15 is stored exactly, and malformed entries are rejected.
+
+static bool read_back(const std::string& text, std::vector<float>& v) {
+    std::istringstream input(text);
+    std::string name, type;
+    float* values = nullptr;
+    uint32_t count = 0;
+    if (!readWtsEntry(input, name, type, values, count)) {
+        return false;
+    }
+    v.assign(values, values + count);
+    free(values);
+    return true;
+}
+
+TEST_CASE(wts) {
+    bool ok = true;
+    std::mt19937 rng(9);
+    std::normal_distribution<float> normal(0.f, 0.05f);
+    const int out = 32, per_channel = 16 * 9;
+    std::vector<float> w(out * per_channel);
+    for (auto& x : w) x = normal(rng);
+    w[5] = 0.f;
+    w[6] = -0.f;
+    w[7] = 1e-40f;  // fp32 subnormal
+    w[8] = 3e-6f;   // fp16 subnormal
+    for (int i = 0; i < per_channel; i++) {
+        w[per_channel + i] = 0.f;  // a pruned channel, scale at its floor
+    }
+
+    std::ostringstream fp32, fp16, int8;
+    write_entry(fp32, "model.0.conv.weight", w, out, "fp32");
+    write_entry(fp16, "model.0.conv.weight", w, out, "fp16");
+    write_entry(int8, "model.0.conv.weight", w, out, "int8");
+    std::vector<float> r32, r16, r8;
+    bool read = read_back(fp32.str(), r32) && read_back(fp16.str(), r16) && read_back(int8.str(), r8);
+    ok &= check(read && r32.size() == w.size() && r16.size() == w.size() && r8.size() == w.size(),
+                "the three entry types read back with their size");
+    if (!read) {
+        return false;
+    }
+
+    bool exact = true;
+    for (size_t i = 0; i < w.size(); i++) {
+        exact &= to_bits(r32[i]) == to_bits(w[i]);
+    }
+    ok &= check(exact, "fp32 is bit-exact, signed zeros and subnormals included");
+
+    bool halves = true;
+    for (uint32_t h = 0; h < 0x10000; h++) {
+        float f = halfToFloat((uint16_t)h);
+        bool nan = (h & 0x7c00) == 0x7c00 && (h & 0x3ff);
+        halves &= nan ? f != f : float_to_half(f) == h;
+    }
+    ok &= check(halves, "halfToFloat decodes all 65536 halves exactly");
+
+    float worst16 = 0.f, worst8 = 0.f;
+    for (size_t i = 0; i < w.size(); i++) {
+        // a unit in the last place of the half, 2^-24 below its normal range
+        float ulp = fabsf(w[i]) < 6.1035e-5f ? 5.96e-8f : ldexpf(1.f, ilogbf(w[i]) - 10);
+        worst16 = std::max(worst16, fabsf(r16[i] - w[i]) / ulp);
+    }
+    for (int c = 0; c < out; c++) {
+        float peak = 0.f, err = 0.f;
+        for (int i = 0; i < per_channel; i++) {
+            peak = std::max(peak, fabsf(w[c * per_channel + i]));
+            err = std::max(err, fabsf(r8[c * per_channel + i] - w[c * per_channel + i]));
+        }
+        worst8 = std::max(worst8, peak > 0.f ? err / (peak / 127.f) : err);
+    }
+    printf("      largest error: fp16 %.3f ulp, int8 %.3f of the channel's step\n", worst16, worst8);
+    ok &= check(worst16 <= 0.5f && worst8 <= 0.5f + 1e-4f, "fp16 and int8 are within half a step");
+
+    std::vector<float> dfl(16), r_dfl, r_int8;
+    for (int i = 0; i < 16; i++) dfl[i] = i;
+    std::ostringstream dfl_int8, conv_int8;
+    write_entry(dfl_int8, "model.22.dfl.conv.weight", dfl, 1, "int8");
+    write_entry(conv_int8, "model.22.cv2.conv.weight", dfl, 1, "int8");
+    read_back(dfl_int8.str(), r_dfl);
+    read_back(conv_int8.str(), r_int8);
+    float dfl_err = 0.f;
+    for (int i = 0; i < 16; i++) {
+        dfl_err = std::max(dfl_err, fabsf(r_int8[i] - i));
+    }
+    printf("      0..15 as int8 would be off by up to %.3f\n", dfl_err);
+    ok &= check(r_dfl == dfl, "-p int8 keeps the DFL projection exact");
+
+    std::vector<float> v;
+    ok &= check(!read_back("model.0.conv.weight 4 3f800000 3f800000", v) &&
+                        !read_back("model.0.conv.weight 4x 3f800000", v) &&
+                        !read_back("model.0.conv.weight int8 6 4 3f800000 3f800000 3f800000 3f800000 01 01", v) &&
+                        !read_back("model.0.conv.weight fp16 2 3c00 zz", v),
+                "truncated and malformed entries are rejected");
+    return ok;
+}
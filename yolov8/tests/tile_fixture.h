@@ -0,0 +1,54 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "detection_fixture.h"
+#include "tiling.h"
+
+// Objects of a large frame and what a detector would see of them through each tile, for the tiling test and
+// yolov8_tile_bench.
+
+// What a detector would report per tile: the visible part of every object that shows at least min_visible of its
+// area in the tile, in network input pixels, with some jitter on the confidence.
+static inline std::vector<std::vector<Detection>> tile_outputs(const std::vector<Tile>& tiles,
+                                                               const std::vector<Detection>& objects,
+                                                               float min_visible, std::mt19937& rng) {
+    std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+    std::vector<std::vector<Detection>> out(tiles.size());
+    for (size_t t = 0; t < tiles.size(); t++) {
+        const Tile& tile = tiles[t];
+        float tx1 = tile.roi.x + tile.roi.width, ty1 = tile.roi.y + tile.roi.height;
+        for (const auto& o : objects) {
+            float x1 = std::max(o.bbox[0], (float)tile.roi.x), y1 = std::max(o.bbox[1], (float)tile.roi.y);
+            float x2 = std::min(o.bbox[2], tx1), y2 = std::min(o.bbox[3], ty1);
+            if (x2 <= x1 || y2 <= y1) {
+                continue;
+            }
+            float visible = (x2 - x1) * (y2 - y1) / ((o.bbox[2] - o.bbox[0]) * (o.bbox[3] - o.bbox[1]));
+            if (visible < min_visible) {
+                continue;
+            }
+            auto to_input = [&](float v, float origin, float pad) { return (v - origin) * tile.scale + pad; };
+            out[t].push_back(make_det(to_input(x1, tile.roi.x, tile.pad_x), to_input(y1, tile.roi.y, tile.pad_y),
+                                      to_input(x2, tile.roi.x, tile.pad_x), to_input(y2, tile.roi.y, tile.pad_y),
+                                      o.conf + jitter(rng), (int)o.class_id));
+        }
+    }
+    return out;
+}
+
+static inline std::vector<Detection> make_objects(int n, int frame_w, int frame_h, std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    std::vector<Detection> objects;
+    // small objects on a jittered grid, so they do not overlap each other
+    int cols = (int)std::ceil(std::sqrt(n * (float)frame_w / frame_h));
+    int rows = (n + cols - 1) / cols;
+    float cw = (float)frame_w / cols, ch = (float)frame_h / rows;
+    for (int i = 0; i < n; i++) {
+        float w = std::min(cw, 12 + 36 * unit(rng)) * 0.8f, h = std::min(ch, 12 + 36 * unit(rng)) * 0.8f;
+        float x = (i % cols) * cw + (cw - w) * unit(rng), y = (i / cols) * ch + (ch - h) * unit(rng);
+        objects.push_back(make_det(x, y, x + w, y + h, 0.6f + 0.3f * unit(rng), i % 3));
+    }
+    return objects;
+}
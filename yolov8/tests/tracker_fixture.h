@@ -0,0 +1,60 @@
+#pragma once
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "detection_fixture.h"
+
+// Synthetic scenes for the tracker test and yolov8_tracker_bench. Objects move with constant velocity and bounce off
+// the frame border. Their detections are jittered, dropped now and then, sometimes scored low (partial occlusion), and
+// mixed with false positives.
+
+struct Object {
+    float cx, cy, w, h, vx, vy;
+};
+
+struct Scene {
+    std::vector<std::vector<Object>> truth;        // per frame
+    std::vector<std::vector<Detection>> detections;  // per frame
+};
+
+static inline Scene make_scene(int num_objects, int frames, int width, int height, int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    std::normal_distribution<float> jitter(0.f, 1.f);
+    std::vector<Object> objects(num_objects);
+    for (auto& o : objects) {
+        o.w = 30 + 60 * unit(rng);
+        o.h = o.w * (1.f + unit(rng));
+        o.cx = o.w + (width - 2 * o.w) * unit(rng);
+        o.cy = o.h + (height - 2 * o.h) * unit(rng);
+        o.vx = 8 * unit(rng) - 4;
+        o.vy = 6 * unit(rng) - 3;
+    }
+    Scene scene;
+    for (int f = 0; f < frames; f++) {
+        std::vector<Detection> dets;
+        for (auto& o : objects) {
+            o.cx += o.vx;
+            o.cy += o.vy;
+            if (o.cx - o.w / 2 < 0 || o.cx + o.w / 2 > width) o.vx = -o.vx;
+            if (o.cy - o.h / 2 < 0 || o.cy + o.h / 2 > height) o.vy = -o.vy;
+            float r = unit(rng);
+            if (r < 0.05f) {
+                continue;  // missed
+            }
+            float conf = r < 0.15f ? 0.2f + 0.25f * unit(rng) : 0.65f + 0.3f * unit(rng);
+            float s = 0.03f * o.w;
+            float cx = o.cx + s * jitter(rng), cy = o.cy + s * jitter(rng);
+            float w = o.w * (1.f + 0.03f * jitter(rng)), h = o.h * (1.f + 0.03f * jitter(rng));
+            dets.push_back(make_det(cx - w / 2, cy - h / 2, cx + w / 2, cy + h / 2, conf));
+        }
+        for (int i = 0; i < 1 + num_objects / 20; i++) {
+            float x = width * unit(rng), y = height * unit(rng), w = 20 + 80 * unit(rng);
+            dets.push_back(make_det(x, y, x + w, y + w, 0.2f + 0.45f * unit(rng)));
+        }
+        std::sort(dets.begin(), dets.end(), [](const Detection& a, const Detection& b) { return a.conf > b.conf; });
+        scene.truth.push_back(objects);
+        scene.detections.push_back(dets);
+    }
+    return scene;
+}
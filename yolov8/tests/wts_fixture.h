@@ -0,0 +1,74 @@
+#pragma once
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// .wts entries written the way gen_wts.py writes them, for the wts test and yolov8_wts_bench.
+
+static inline uint32_t to_bits(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+// binary32 -> binary16 rounded to nearest even, what struct.pack('>e') writes
+static inline uint16_t float_to_half(float f) {
+    uint32_t x = to_bits(f);
+    uint16_t sign = (x >> 16) & 0x8000;
+    uint32_t abs = x & 0x7fffffff;
+    if (abs > 0x7f800000) {
+        return sign | 0x7e00;
+    }
+    if (abs >= 0x477ff000) {  // rounds to beyond 65504
+        return sign | 0x7c00;
+    }
+    if (abs < 0x38800000) {  // subnormal half
+        float magic = fabsf(f) + 0.5f;  // 2^-1 puts the half subnormal step, 2^-24, in the last mantissa bit
+        return sign | (uint16_t)(to_bits(magic) - to_bits(0.5f));
+    }
+    uint32_t rounded = abs + 0xfff + ((abs >> 13) & 1);
+    return sign | (uint16_t)((rounded - 0x38000000) >> 13);
+}
+
+// One tensor as gen_wts.py writes it for precision, 4-D weights are out_channels rows
+static inline void write_entry(std::ostream& out, const std::string& name, const std::vector<float>& v,
+                               int out_channels, const std::string& precision) {
+    char hex[16];
+    if (precision == "int8" && out_channels > 0 && name.find(".dfl.") == std::string::npos) {
+        int per_channel = v.size() / out_channels;
+        std::vector<float> scales(out_channels);
+        out << name << " int8 " << v.size() << " " << out_channels << " ";
+        for (int c = 0; c < out_channels; c++) {
+            float peak = 0.f;
+            for (int i = 0; i < per_channel; i++) {
+                peak = std::max(peak, fabsf(v[c * per_channel + i]));
+            }
+            scales[c] = std::max(peak / 127.f, 1e-12f);
+            snprintf(hex, sizeof(hex), " %08x", to_bits(scales[c]));
+            out << hex;
+        }
+        for (size_t i = 0; i < v.size(); i++) {
+            float q = std::min(127.f, std::max(-127.f, nearbyintf(v[i] / scales[i / per_channel])));
+            snprintf(hex, sizeof(hex), " %02x", (uint8_t)(int8_t)q);
+            out << hex;
+        }
+    } else if (precision == "fp16") {
+        out << name << " fp16 " << v.size() << " ";
+        for (float x : v) {
+            snprintf(hex, sizeof(hex), " %04x", float_to_half(x));
+            out << hex;
+        }
+    } else {
+        out << name << " " << v.size() << " ";
+        for (float x : v) {
+            snprintf(hex, sizeof(hex), " %08x", to_bits(x));
+            out << hex;
+        }
+    }
+    out << "\n";
+}
@@ -0,0 +1,119 @@
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "buffer_strategy.h"
+#include "cuda_utils.h"
+#include "latency_stats.h"
+#include "types.h"
+
+// Compares the buffer strategies on the data flow of an inference: the CPU writes the input, it is made visible to
+// the GPU, the GPU reads it and writes the output (a device-to-device copy stands in for the engine), the output is
+// made visible to the CPU and read there. Sizes default to a yolov8 640x640 batch of 1.
+//   ./yolov8_buffer_bench [device|mapped|managed|host|all] [iterations] [input bytes] [output bytes]
+// "all" runs every strategy the machine supports, without a GPU that is only host. Exits 1 if the output read back is
+// not what was written; yolov8_tests checks the sizing and alignment of the host strategy.
+
+static std::vector<BufferStrategy> supported_strategies() {
+    std::vector<BufferStrategy> res;
+    int devices = 0;
+    if (cudaGetDeviceCount(&devices) == cudaSuccess && devices > 0) {
+        int device = 0, can_map = 0, managed = 0;
+        CUDA_CHECK(cudaGetDevice(&device));
+        CUDA_CHECK(cudaDeviceGetAttribute(&can_map, cudaDevAttrCanMapHostMemory, device));
+        CUDA_CHECK(cudaDeviceGetAttribute(&managed, cudaDevAttrManagedMemory, device));
+        res.push_back(BufferStrategy::kDevice);
+        if (can_map) {
+            res.push_back(BufferStrategy::kMapped);
+        }
+        if (managed) {
+            res.push_back(BufferStrategy::kManaged);
+        }
+    }
+    res.push_back(BufferStrategy::kHost);
+    return res;
+}
+
+static bool run_strategy(BufferStrategy strategy, int iterations, size_t input_bytes, size_t output_bytes) {
+    cudaStream_t stream = nullptr;
+    bool gpu = strategy != BufferStrategy::kHost;
+    if (gpu) {
+        CUDA_CHECK(cudaStreamCreate(&stream));
+    }
+    BufferSet buffers(strategy);
+    BufferPair input = buffers.allocate(input_bytes, true);
+    BufferPair output = buffers.allocate(output_bytes, true);
+    bool ok = true;
+
+    size_t copy_bytes = std::min(input_bytes, output_bytes);
+    std::vector<double> samples;
+    for (int i = 0; i < iterations + 1 && ok; i++) {
+        auto start = std::chrono::steady_clock::now();
+        memset(input.host, i & 0xff, input_bytes);  // preprocessing on the CPU
+        buffer_to_device(strategy, input.device, input.host, input_bytes, stream);
+        if (gpu) {
+            CUDA_CHECK(cudaMemcpyAsync(output.device, input.device, copy_bytes, cudaMemcpyDeviceToDevice, stream));
+        } else {
+            memcpy(output.device, input.device, copy_bytes);
+        }
+        buffer_to_host(strategy, output.host, output.device, output_bytes, stream);
+        if (gpu) {
+            CUDA_CHECK(cudaStreamSynchronize(stream));
+        }
+        // postprocessing reads every cache line of the output
+        const unsigned char* out = (const unsigned char*)output.host;
+        for (size_t b = 0; b < copy_bytes; b += 64) {
+            ok = ok && out[b] == (i & 0xff);
+        }
+        if (i > 0) {  // the first iteration pays for page faults and migrations
+            samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                                      .count());
+        }
+    }
+    if (!ok) {
+        std::cerr << buffer_strategy_name(strategy) << ": wrong output" << std::endl;
+    } else {
+        double p50 = latency_percentile(samples, 50);
+        double p99 = latency_percentile(samples, 99);
+        std::cout << std::left << std::setw(10) << buffer_strategy_name(strategy) << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(10) << p50 << std::setw(10) << p99 << std::setw(12)
+                  << buffers.device_bytes() << std::setw(12) << buffers.host_bytes() << std::endl;
+    }
+    buffers.release();
+    if (gpu) {
+        CUDA_CHECK(cudaStreamDestroy(stream));
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    std::string which = argc > 1 ? argv[1] : "all";
+    int iterations = argc > 2 ? atoi(argv[2]) : 200;
+    size_t input_bytes = argc > 3 ? strtoull(argv[3], nullptr, 10) : 3 * 640 * 640 * sizeof(float);
+    size_t output_bytes = argc > 4 ? strtoull(argv[4], nullptr, 10) : sizeof(float) + 1000 * sizeof(Detection);
+
+    std::vector<BufferStrategy> strategies;
+    BufferStrategy strategy;
+    if (which == "all") {
+        strategies = supported_strategies();
+    } else if (parse_buffer_strategy(which, strategy)) {
+        strategies.push_back(strategy);
+    } else {
+        std::cerr << "unknown strategy " << which << ", expected device, mapped, managed, host or all" << std::endl;
+        return -1;
+    }
+
+    std::cout << iterations << " iterations, input " << input_bytes << " bytes, output " << output_bytes << " bytes"
+              << std::endl;
+    std::cout << std::left << std::setw(10) << "strategy" << std::right << std::setw(10) << "p50 ms" << std::setw(10)
+              << "p99 ms" << std::setw(12) << "device B" << std::setw(12) << "host B" << std::endl;
+    bool ok = true;
+    for (BufferStrategy s : strategies) {
+        ok = run_strategy(s, iterations, input_bytes, output_bytes) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "coarse_to_fine.h"
+#include "tests/detection_fixture.h"
+
+// Benchmark of the CPU stages of coarse-to-fine detection, yolov8_tests checks them against mock engines.
+//   ./yolov8_c2f_bench [candidates] [iterations]
+// Times region planning and fusion for the given number of candidates.
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 300;
+    int iterations = argc > 2 ? atoi(argv[2]) : 100;
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    std::vector<Detection> candidates;
+    for (int i = 0; i < n; i++) {
+        float x = 3800 * unit(rng), y = 2120 * unit(rng);
+        candidates.push_back(make_det(x, y, x + 12 + 28 * unit(rng), y + 12 + 28 * unit(rng), unit(rng) * 0.5f, i % 2));
+    }
+    CoarseToFineOptions opts;
+    std::vector<std::vector<Detection>> fine(opts.max_rois);
+    for (int i = 0; i < n; i++) {
+        fine[i % opts.max_rois].push_back(candidates[i]);
+        fine[i % opts.max_rois].back().conf = 0.9f;
+    }
+    double plan_us = 0, fuse_us = 0;
+    long rois = 0;
+    for (int it = 0; it < iterations; it++) {
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<char> covered;
+        std::vector<cv::Rect> r = plan_rois(candidates, 3840, 2160, cv::Size(1280, 1280), opts.max_rois, covered);
+        auto t1 = std::chrono::steady_clock::now();
+        std::vector<Detection> dets = fuse_coarse_fine(candidates, r, fine, opts);
+        auto t2 = std::chrono::steady_clock::now();
+        plan_us += std::chrono::duration<double, std::micro>(t1 - t0).count();
+        fuse_us += std::chrono::duration<double, std::micro>(t2 - t1).count();
+        rois += r.size();
+    }
+    printf("%d candidates, %d regions: plan %.1f us, fuse %.1f us\n", n, (int)(rois / iterations),
+           plan_us / iterations, fuse_us / iterations);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "result_cache.h"
+
+// Benchmark of the result cache, yolov8_tests checks eviction, persistence and the keys.
+//   ./yolov8_cache_bench [requests] [unique images] [zipf exponent] [budget KB] [miss ms]
+// Replays a duplicate-heavy stream: requests pick one of the unique encoded images with Zipf popularity, each is
+// hashed and looked up, misses are inserted. Prints the hit rate, the cost of hash + lookup per request and the
+// throughput with and without the cache when a miss costs "miss ms" (decode, preprocess, inference and NMS).
+
+static std::vector<Detection> make_dets(int n, float tag) {
+    std::vector<Detection> dets(n);
+    for (int i = 0; i < n; i++) {
+        memset(&dets[i], 0, sizeof(Detection));
+        dets[i].bbox[0] = tag;
+        dets[i].bbox[1] = i;
+        dets[i].bbox[2] = 10.f + i;
+        dets[i].bbox[3] = 20.f + i;
+        dets[i].conf = 0.5f;
+        dets[i].class_id = i % 80;
+    }
+    return dets;
+}
+
+int main(int argc, char** argv) {
+    int requests = argc > 1 ? atoi(argv[1]) : 100000;
+    int unique = argc > 2 ? atoi(argv[2]) : 2000;
+    double zipf = argc > 3 ? atof(argv[3]) : 1.0;
+    size_t budget = (argc > 4 ? atoi(argv[4]) : 1024) * (size_t)1024;
+    double miss_ms = argc > 5 ? atof(argv[5]) : 5.0;
+
+    // unique encoded images of 20-200 KB, like jpeg uploads
+    std::mt19937 rng(0);
+    std::vector<std::vector<uint8_t>> images(unique);
+    for (auto& img : images) {
+        img.resize(20000 + rng() % 180000);
+        for (auto& b : img) {
+            b = rng() & 0xff;
+        }
+    }
+    std::vector<double> weights(unique);
+    for (int i = 0; i < unique; i++) {
+        weights[i] = 1.0 / std::pow(i + 1, zipf);
+    }
+    std::discrete_distribution<int> popularity(weights.begin(), weights.end());
+    std::vector<int> stream(requests);
+    size_t bytes = 0;
+    for (auto& r : stream) {
+        r = popularity(rng);
+        bytes += images[r].size();
+    }
+
+    ResultCache cache(budget, 42);
+    std::vector<Detection> dets;
+    auto start = std::chrono::steady_clock::now();
+    for (int r : stream) {
+        uint64_t key = cache.encoded_key(images[r].data(), images[r].size());
+        if (!cache.lookup(key, dets)) {
+            cache.insert(key, make_dets(r % 20, (float)r));  // the pipeline would run here
+        }
+    }
+    double cache_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    ResultCacheStats s = cache.stats();
+    double hit_rate = (double)s.hits / requests;
+    double without = requests * miss_ms / 1000.0;
+    double with = cache_s + s.misses * miss_ms / 1000.0;
+    printf("%d requests over %d images (zipf %.2f), budget %zu KB\n", requests, unique, zipf, budget / 1024);
+    printf("hit rate %.1f%%, %zu entries, %zu KB, %llu evictions\n", 100.0 * hit_rate, s.entries, s.bytes / 1024,
+           (unsigned long long)s.evictions);
+    printf("hash + lookup: %.2f us per request, %.2f GB/s hashed\n", cache_s * 1e6 / requests, bytes / cache_s / 1e9);
+    printf("at %.1f ms per miss: %.0f img/s without cache, %.0f img/s with\n", miss_ms, requests / without,
+           requests / with);
+    return 0;
+}
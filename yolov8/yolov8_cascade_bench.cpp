@@ -0,0 +1,41 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "cascade.h"
+#include "tests/cascade_fixture.h"
+
+// Benchmark of the detection to classification cascade with a mock classifier, yolov8_tests checks the crops and
+// the batching.
+//   ./yolov8_cascade_bench [frames] [max batch]
+// Times cropping, packing and scattering at 1, 20 and 200 crops per 1080p frame.
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 50;
+    int max_batch = argc > 2 ? atoi(argv[2]) : 32;
+    std::mt19937 rng(2);
+    for (int per_frame : {1, 20, 200}) {
+        cv::Mat img(1080, 1920, CV_8UC3);
+        std::vector<Detection> dets = make_objects(img, per_frame, 0, rng);
+        MockClassifier cls(max_batch, false);
+        CascadeOptions opts;
+        CropBatcher batcher(cls, opts);
+        CascadeFrame frame;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            batcher.add(f, img, dets, f);
+            while (batcher.pop(frame)) {
+            }
+        }
+        batcher.flush();
+        while (batcher.pop(frame)) {
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        double us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+        const CascadeStats& s = batcher.stats();
+        printf("%3d crops per frame: %.1f us per frame, %.2f us per crop, %ld batches, %.1f crops per batch\n",
+               per_frame, us / frames, us / s.crops, s.batches, (double)s.crops / s.batches);
+    }
+    return 0;
+}
@@ -1,3 +1,4 @@
+#include "buffer_strategy.h"
 #include "cuda_utils.h"
 #include "logging.h"
 #include "utils.h"
@@ -14,7 +15,6 @@
 using namespace nvinfer1;
 
 static Logger gLogger;
-const static int kOutputSize = kClsNumClass;
 
 void batch_preprocess(std::vector<cv::Mat>& imgs, float* output, int dst_width=224, int dst_height=224) {
     for (size_t b = 0; b < imgs.size(); b++) {
@@ -124,7 +124,7 @@ bool parse_args(int argc, char** argv, std::string& wts, std::string& engine, fl
     return true;
 }
 
-void prepare_buffers(ICudaEngine* engine, float** gpu_input_buffer, float** gpu_output_buffer, float** cpu_input_buffer, float** output_buffer_host) {
+void prepare_buffers(ICudaEngine* engine, BufferSet& buffers, float** gpu_input_buffer, float** gpu_output_buffer, float** cpu_input_buffer, float** output_buffer_host) {
     assert(engine->getNbBindings() == 2);
     // In order to bind the buffers, we need to know the names of the input and output tensors.
     // Note that indices are guaranteed to be less than IEngine::getNbBindings()
@@ -132,18 +132,19 @@ void prepare_buffers(ICudaEngine* engine, float** gpu_input_buffer, float** gpu_
     const int outputIndex = engine->getBindingIndex(kOutputTensorName);
     assert(inputIndex == 0);
     assert(outputIndex == 1);
-    // Create GPU buffers on device
-    CUDA_CHECK(cudaMalloc((void**)gpu_input_buffer, kBatchSize * 3 * kClsInputH * kClsInputW * sizeof(float)));
-    CUDA_CHECK(cudaMalloc((void**)gpu_output_buffer, kBatchSize * kOutputSize * sizeof(float)));
-
-    *cpu_input_buffer = new float[kBatchSize * 3 * kClsInputH * kClsInputW];
-    *output_buffer_host = new float[kBatchSize * kOutputSize];
+    // Create host and GPU buffers sized from the bindings, both are written or read on the CPU
+    BufferPair input = buffers.allocate(binding_bytes(*engine, inputIndex), true);
+    BufferPair output = buffers.allocate(binding_bytes(*engine, outputIndex), true);
+    *gpu_input_buffer = (float*)input.device;
+    *gpu_output_buffer = (float*)output.device;
+    *cpu_input_buffer = (float*)input.host;
+    *output_buffer_host = (float*)output.host;
 }
 
-void infer(IExecutionContext& context, cudaStream_t& stream, void **buffers, float* input, float* output, int batchSize) {
-    CUDA_CHECK(cudaMemcpyAsync(buffers[0], input, batchSize * 3 * kClsInputH * kClsInputW * sizeof(float), cudaMemcpyHostToDevice, stream));
+void infer(IExecutionContext& context, cudaStream_t& stream, BufferStrategy strategy, void **buffers, float* input, float* output, int batchSize, int outputSize) {
+    buffer_to_device(strategy, buffers[0], input, batchSize * 3 * kClsInputH * kClsInputW * sizeof(float), stream);
     context.enqueue(batchSize, buffers, stream, nullptr);
-    CUDA_CHECK(cudaMemcpyAsync(output, buffers[1], batchSize * kOutputSize * sizeof(float), cudaMemcpyDeviceToHost, stream));
+    buffer_to_host(strategy, output, buffers[1], batchSize * outputSize * sizeof(float), stream);
     cudaStreamSynchronize(stream);
 }
 
@@ -201,11 +202,14 @@ int main(int argc, char** argv) {
     std::string engine_name = "";
     float gd = 0.0f, gw = 0.0f;
     std::string img_dir;
+    BufferStrategy strategy = BufferStrategy::kDevice;
 
-    if (!parse_args(argc, argv, wts_name, engine_name, gd, gw, img_dir)) {
+    if (!parse_buffer_args(argc, argv, strategy) || strategy == BufferStrategy::kHost ||
+        !parse_args(argc, argv, wts_name, engine_name, gd, gw, img_dir)) {
         std::cerr << "arguments not right!" << std::endl;
         std::cerr << "./yolov8_cls -s [.wts] [.engine] [n/s/m/l/x or c gd gw]  // serialize model to plan file" << std::endl;
         std::cerr << "./yolov8_cls -d [.engine] ../samples  // deserialize plan file and run inference" << std::endl;
+        std::cerr << "optional: --buffers=device|mapped|managed  // how input and output reach the GPU" << std::endl;
         return -1;
     }
 
@@ -227,7 +231,10 @@ int main(int argc, char** argv) {
     float* device_buffers[2];
     float* cpu_input_buffer = nullptr;
     float* output_buffer_host = nullptr;
-    prepare_buffers(engine, &device_buffers[0], &device_buffers[1], &cpu_input_buffer, &output_buffer_host);
+    BufferSet buffers(strategy);
+    prepare_buffers(engine, buffers, &device_buffers[0], &device_buffers[1], &cpu_input_buffer, &output_buffer_host);
+    // the number of classes is the size of the output binding, whatever kClsNumClass was when this binary was built
+    const int num_classes = engine->getBindingDimensions(1).d[0];
 
     // Read images from directory
     std::vector<std::string> file_names;
@@ -255,28 +262,25 @@ int main(int argc, char** argv) {
 
         // Run inference
         auto start = std::chrono::system_clock::now();
-        infer(*context, stream, (void**)device_buffers, cpu_input_buffer, output_buffer_host, kBatchSize);
+        infer(*context, stream, strategy, (void**)device_buffers, cpu_input_buffer, output_buffer_host, kBatchSize, num_classes);
         auto end = std::chrono::system_clock::now();
         std::cout << "inference time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms" << std::endl;
 
         // Postprocess and get top-k result
         for (size_t b = 0; b < img_name_batch.size(); b++) {
-            float* p = &output_buffer_host[b * kOutputSize];
-            auto res = softmax(p, kOutputSize);
+            float* p = &output_buffer_host[b * num_classes];
+            auto res = softmax(p, num_classes);
             auto topk_idx = topk(res, 3);
             std::cout << img_name_batch[b] << std::endl;
             for (auto idx: topk_idx) {
-              std::cout << "  " << classes[idx] << " " << res[idx] << std::endl;
+              std::cout << "  " << (idx < (int)classes.size() ? classes[idx] : std::to_string(idx)) << " " << res[idx] << std::endl;
         }
         }
     }
 
     // Release stream and buffers
     cudaStreamDestroy(stream);
-    CUDA_CHECK(cudaFree(device_buffers[0]));
-    CUDA_CHECK(cudaFree(device_buffers[1]));
-    delete[] cpu_input_buffer;
-    delete[] output_buffer_host;
+    buffers.release();
   // Destroy the engine
     delete context;
     delete engine;
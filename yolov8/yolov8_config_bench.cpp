@@ -0,0 +1,47 @@
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "runtime_config.h"
+#include "types.h"
+
+// Benchmark of the runtime configuration of yolov8_det, yolov8_tests checks the parsing.
+//   ./yolov8_config_bench [iterations]
+// Times parsing a command line with a config file that many times.
+
+static std::string write_file(const std::string& text) {
+    std::string path = "/tmp/yolov8_config_bench_" + std::to_string(getpid()) + ".cfg";
+    std::ofstream(path) << text;
+    return path;
+}
+
+// argv as main gets it, the strings live in args
+static std::vector<char*> make_argv(std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    for (auto& a : args) {
+        argv.push_back(&a[0]);
+    }
+    return argv;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 10000;
+    std::string path = write_file("batch_size = 8\ninput_h = 960\ninput_w = 960\nconf_thresh = 0.25\n");
+    auto t0 = std::chrono::steady_clock::now();
+    int parsed = 0;
+    for (int i = 0; i < iterations; i++) {
+        std::vector<std::string> args = {"yolov8_det", "--config=" + path, "-d", "yolov8n.engine", "../images", "c",
+                                         "--buffers=mapped"};
+        std::vector<char*> args_argv = make_argv(args);
+        int args_argc = args_argv.size();
+        RuntimeConfig cfg;
+        parsed += parse_runtime_config_args(args_argc, args_argv.data(), cfg) && validate_runtime_config(cfg);
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    unlink(path.c_str());
+    printf("parsed %d command lines with a config file, %.2f us each\n", parsed, us / iterations);
+    return 0;
+}
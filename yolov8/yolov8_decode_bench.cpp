@@ -0,0 +1,38 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "config.h"
+#include "image_loader.h"
+#include "tests/decode_fixture.h"
+
+// Benchmark of decode-time JPEG downscaling (--decode_reduce=1), yolov8_tests checks the factor and the box mapping.
+//   ./yolov8_decode_bench [width] [height] [iterations]
+// Times a full-size and a reduced decode of a width x height JPEG.
+
+int main(int argc, char** argv) {
+    int w = argc > 1 ? atoi(argv[1]) : 6000;
+    int h = argc > 2 ? atoi(argv[2]) : 4000;
+    int iterations = argc > 3 ? atoi(argv[3]) : 10;
+    const int input_w = 640, input_h = 640;
+    std::mt19937 rng(6);
+    cv::Mat img(h, w, CV_8UC3);
+    make_frame(img, rng);
+    std::vector<uint8_t> jpeg = encode(img);
+    DecodedImage decoded;
+    for (int input : {0, input_w}) {
+        decode_image(jpeg, input, input_h, decoded);
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            decode_image(jpeg, input, input_h, decoded);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        const cv::Mat& out = decoded.img;
+        printf("%dx%d JPEG (%.2f MB) at 1/%d: %dx%d, %.2f MB of pixels, %.2f ms, %s kMaxInputImageSize\n", w, h,
+               jpeg.size() / 1e6, decoded.scale, out.cols, out.rows, out.cols * out.rows * 3 / 1e6,
+               std::chrono::duration<double, std::milli>(t1 - t0).count() / iterations,
+               out.cols * out.rows <= kMaxInputImageSize ? "within" : "over");
+    }
+    return 0;
+}
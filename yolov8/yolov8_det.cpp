@@ -1,20 +1,36 @@
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <opencv2/opencv.hpp>
+#include "batch_scheduler.h"
+#include "bench.h"
+#include "buffer_strategy.h"
+#include "cascade.h"
+#include "coarse_to_fine.h"
 #include "cuda_utils.h"
+#include "frame_ring.h"
+#include "image_loader.h"
+#include "inference_server.h"
+#include "letterbox.h"
 #include "logging.h"
 #include "model.h"
+#include "motion_gate.h"
 #include "postprocess.h"
 #include "preprocess.h"
+#include "profiler.h"
+#include "result_cache.h"
+#include "runtime_config.h"
+#include "tiling.h"
+#include "trace.h"
+#include "tracker.h"
 #include "utils.h"
 
 Logger gLogger;
 using namespace nvinfer1;
-const int kOutputSize = kMaxNumOutputBbox * sizeof(Detection) / sizeof(float) + 1;
 
 void serialize_engine(std::string& wts_name, std::string& engine_name, int& is_p, std::string& sub_type, float& gd,
-                      float& gw, int& max_channels) {
+                      float& gw, int& max_channels, const RuntimeConfig& cfg) {
     IBuilder* builder = createInferBuilder(gLogger);
     IBuilderConfig* config = builder->createBuilderConfig();
     IHostMemory* serialized_engine = nullptr;
@@ -23,8 +39,12 @@ void serialize_engine(std::string& wts_name, std::string& engine_name, int& is_p
         serialized_engine = buildEngineYolov8DetP6(builder, config, DataType::kFLOAT, wts_name, gd, gw, max_channels);
     } else if (is_p == 2) {
         serialized_engine = buildEngineYolov8DetP2(builder, config, DataType::kFLOAT, wts_name, gd, gw, max_channels);
+    } else if (cfg.dynamic) {
+        serialized_engine =
+                buildEngineYolov8DetDynamic(builder, config, DataType::kFLOAT, wts_name, gd, gw, max_channels, cfg);
     } else {
-        serialized_engine = buildEngineYolov8Det(builder, config, DataType::kFLOAT, wts_name, gd, gw, max_channels);
+        serialized_engine =
+                buildEngineYolov8Det(builder, config, DataType::kFLOAT, wts_name, gd, gw, max_channels, cfg);
     }
 
     assert(serialized_engine);
@@ -40,7 +60,7 @@ void serialize_engine(std::string& wts_name, std::string& engine_name, int& is_p
     delete builder;
 }
 
-void deserialize_engine(std::string& engine_name, IRuntime** runtime, ICudaEngine** engine,
+void deserialize_engine(const std::string& engine_name, IRuntime** runtime, ICudaEngine** engine,
                         IExecutionContext** context) {
     std::ifstream file(engine_name, std::ios::binary);
     if (!file.good()) {
@@ -65,9 +85,31 @@ void deserialize_engine(std::string& engine_name, IRuntime** runtime, ICudaEngin
     delete[] serialized_engine;
 }
 
-void prepare_buffer(ICudaEngine* engine, float** input_buffer_device, float** output_buffer_device,
-                    float** output_buffer_host, float** decode_ptr_host, float** decode_ptr_device,
-                    std::string cuda_post_process) {
+// Takes batch, input and output sizes from the engine, whatever the config says. Returns the number of output boxes.
+static int configure_from_engine(ICudaEngine* engine, RuntimeConfig& cfg) {
+    auto out_dims = engine->getBindingDimensions(1);
+    cfg.dynamic = !engine->hasImplicitBatchDimension();
+    cfg.uint8_input = false;
+    if (cfg.dynamic) {
+        // buffers are sized for the largest shape of the optimization profile, each batch may use less
+        auto max_dims = engine->getProfileDimensions(0, 0, OptProfileSelector::kMAX);
+        update_runtime_config_from_engine(cfg, max_dims.d[0], max_dims.d[2], max_dims.d[3], out_dims.d[1]);
+        return out_dims.d[1];
+    }
+    // {H, W, 3} for a uint8_input engine, {3, H, W} otherwise; input sizes are multiples of 32 so never 3
+    auto in_dims = engine->getBindingDimensions(0);
+    cfg.uint8_input = in_dims.d[2] == 3;
+    if (cfg.uint8_input) {
+        update_runtime_config_from_engine(cfg, engine->getMaxBatchSize(), in_dims.d[0], in_dims.d[1], out_dims.d[0]);
+    } else {
+        update_runtime_config_from_engine(cfg, engine->getMaxBatchSize(), in_dims.d[1], in_dims.d[2], out_dims.d[0]);
+    }
+    return out_dims.d[0];
+}
+
+void prepare_buffer(ICudaEngine* engine, BufferSet& buffers, float** input_buffer_device,
+                    float** output_buffer_device, float** output_buffer_host, float** decode_ptr_host,
+                    float** decode_ptr_device, std::string cuda_post_process, const RuntimeConfig& cfg) {
     assert(engine->getNbBindings() == 2);
     // In order to bind the buffers, we need to know the names of the input and output tensors.
     // Note that indices are guaranteed to be less than IEngine::getNbBindings()
@@ -75,202 +117,1270 @@ void prepare_buffer(ICudaEngine* engine, float** input_buffer_device, float** ou
     const int outputIndex = engine->getBindingIndex(kOutputTensorName);
     assert(inputIndex == 0);
     assert(outputIndex == 1);
-    // Create GPU buffers on device
-    CUDA_CHECK(cudaMalloc((void**)input_buffer_device, kBatchSize * 3 * kInputH * kInputW * sizeof(float)));
-    CUDA_CHECK(cudaMalloc((void**)output_buffer_device, kBatchSize * kOutputSize * sizeof(float)));
+    // Sized from the bindings, the input is written on the GPU by the preprocess kernel so it needs no host view. The
+    // uint8_input binding is declared float but holds bytes.
+    size_t input_bytes = binding_bytes(*engine, inputIndex);
+    BufferPair input = buffers.allocate(cfg.uint8_input ? input_bytes / sizeof(float) : input_bytes, false);
+    BufferPair output = buffers.allocate(binding_bytes(*engine, outputIndex), cuda_post_process == "c");
+    *input_buffer_device = (float*)input.device;
+    *output_buffer_device = (float*)output.device;
     if (cuda_post_process == "c") {
-        *output_buffer_host = new float[kBatchSize * kOutputSize];
+        *output_buffer_host = (float*)output.host;
     } else if (cuda_post_process == "g") {
-        if (kBatchSize > 1) {
+        if (cfg.batch_size > 1) {
             std::cerr << "Do not yet support GPU post processing for multiple batches" << std::endl;
             exit(0);
         }
-        // Allocate memory for decode_ptr_host and copy to device
-        *decode_ptr_host = new float[1 + kMaxNumOutputBbox * bbox_element];
-        CUDA_CHECK(cudaMalloc((void**)decode_ptr_device, sizeof(float) * (1 + kMaxNumOutputBbox * bbox_element)));
+        // decode and nms results, written on the GPU and read back on the host
+        BufferPair decode = buffers.allocate(sizeof(float) * (1 + cfg.max_num_output_bbox * bbox_element), true);
+        *decode_ptr_host = (float*)decode.host;
+        *decode_ptr_device = (float*)decode.device;
     }
 }
 
 void infer(IExecutionContext& context, cudaStream_t& stream, void** buffers, float* output, int batchsize,
-           float* decode_ptr_host, float* decode_ptr_device, int model_bboxes, std::string cuda_post_process) {
+           float* decode_ptr_host, float* decode_ptr_device, int model_bboxes, std::string cuda_post_process,
+           const RuntimeConfig& cfg) {
     // infer on the batch asynchronously, and DMA output back to host
     auto start = std::chrono::system_clock::now();
-    context.enqueue(batchsize, buffers, stream, nullptr);
+    if (cfg.dynamic) {
+        // batch size and resolution were set on the context with setBindingDimensions
+        context.enqueueV2(buffers, stream, nullptr);
+    } else {
+        context.enqueue(batchsize, buffers, stream, nullptr);
+    }
     if (cuda_post_process == "c") {
-        CUDA_CHECK(cudaMemcpyAsync(output, buffers[1], batchsize * kOutputSize * sizeof(float), cudaMemcpyDeviceToHost,
-                                   stream));
+        buffer_to_host(cfg.buffers, output, buffers[1], batchsize * output_size_per_image(cfg) * sizeof(float), stream);
         auto end = std::chrono::system_clock::now();
-        std::cout << "inference time: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
-                  << "ms" << std::endl;
+        if (cfg.verbose != 0) {
+            std::cout << "inference time: "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms"
+                      << std::endl;
+        }
     } else if (cuda_post_process == "g") {
-        CUDA_CHECK(
-                cudaMemsetAsync(decode_ptr_device, 0, sizeof(float) * (1 + kMaxNumOutputBbox * bbox_element), stream));
-        cuda_decode((float*)buffers[1], model_bboxes, kConfThresh, decode_ptr_device, kMaxNumOutputBbox, stream);
-        cuda_nms(decode_ptr_device, kNmsThresh, kMaxNumOutputBbox, stream);  //cuda nms
-        CUDA_CHECK(cudaMemcpyAsync(decode_ptr_host, decode_ptr_device,
-                                   sizeof(float) * (1 + kMaxNumOutputBbox * bbox_element), cudaMemcpyDeviceToHost,
+        CUDA_CHECK(cudaMemsetAsync(decode_ptr_device, 0, sizeof(float) * (1 + cfg.max_num_output_bbox * bbox_element),
                                    stream));
+        cuda_decode((float*)buffers[1], model_bboxes, cfg.conf_thresh, decode_ptr_device, cfg.max_num_output_bbox,
+                    stream);
+        cuda_nms(decode_ptr_device, cfg.nms_thresh, cfg.max_num_output_bbox, stream);  //cuda nms
+        buffer_to_host(cfg.buffers, decode_ptr_host, decode_ptr_device,
+                       sizeof(float) * (1 + cfg.max_num_output_bbox * bbox_element), stream);
         auto end = std::chrono::system_clock::now();
-        std::cout << "inference and gpu postprocess time: "
-                  << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms" << std::endl;
+        if (cfg.verbose != 0) {
+            std::cout << "inference and gpu postprocess time: "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms"
+                      << std::endl;
+        }
     }
 
     CUDA_CHECK(cudaStreamSynchronize(stream));
 }
 
-bool parse_args(int argc, char** argv, std::string& wts, std::string& engine, int& is_p, std::string& img_dir,
-                std::string& sub_type, std::string& cuda_post_process, float& gd, float& gw, int& max_channels) {
+// Size of an image of detect_batch. NV12 frames are single-channel Mats of the frame_rows of their slot, their Y rows
+// followed by their UV rows.
+static cv::Size frame_size(const cv::Mat& img) {
+    return img.type() == CV_8UC1 ? cv::Size(img.cols, nv12_height(img.rows)) : img.size();
+}
+
+// Preprocess, infer and postprocess one batch, shared by the directory loop, the server and the shared-memory
+// consumer. Returns the network input size the batch was letterboxed to, which get_rect and draw_bbox need.
+// registered_input: the images live in cudaHostRegister'ed memory and are copied to the GPU without staging, and may
+// be NV12 (see frame_size) unless the engine has uint8_input.
+cv::Size detect_batch(IExecutionContext& context, cudaStream_t& stream, float** device_buffers,
+                      float* output_buffer_host, float* decode_ptr_host, float* decode_ptr_device, int model_bboxes,
+                      const std::string& cuda_post_process, std::vector<cv::Mat>& img_batch,
+                      std::vector<std::vector<Detection>>& res_batch, const RuntimeConfig& cfg,
+                      bool registered_input = false) {
+    // Dynamic engines letterbox to the smallest stride-aligned shape that fits the batch instead of a square
+    int input_w = cfg.input_w;
+    int input_h = cfg.input_h;
+    int batch_size = img_batch.size();
+    if (cfg.dynamic) {
+        std::vector<LetterboxShape> img_sizes;
+        for (auto& img : img_batch) {
+            cv::Size size = frame_size(img);
+            img_sizes.push_back(LetterboxShape{size.width, size.height});
+        }
+        LetterboxShape shape = rect_letterbox_batch_shape(img_sizes, cfg.input_w, cfg.input_h);
+        input_w = shape.w;
+        input_h = shape.h;
+        context.setBindingDimensions(0, Dims4{batch_size, 3, input_h, input_w});
+    }
+    // Preprocess
+    TRACE_SCOPE("detect_batch");
+    if (cfg.uint8_input) {
+        // letterboxed on the CPU, the engine normalizes
+        TRACE_SCOPE("cuda_batch_preprocess_uint8");
+        cuda_batch_preprocess_uint8(img_batch, (uint8_t*)device_buffers[0], input_w, input_h, stream);
+    } else if (registered_input) {
+        TRACE_SCOPE("cuda_preprocess_registered");
+        int dst_size = input_w * input_h * 3;
+        for (size_t i = 0; i < img_batch.size(); i++) {
+            const cv::Mat& img = img_batch[i];
+            if (img.type() == CV_8UC1) {
+                cuda_preprocess_nv12_registered(img.data, img.cols, frame_size(img).height, img.step,
+                                                device_buffers[0] + dst_size * i, input_w, input_h, stream);
+            } else {
+                cuda_preprocess_registered(img.data, img.cols, img.rows, img.step, device_buffers[0] + dst_size * i,
+                                           input_w, input_h, stream);
+            }
+            CUDA_CHECK(cudaStreamSynchronize(stream));
+        }
+    } else {
+        TRACE_SCOPE("cuda_batch_preprocess");
+        cuda_batch_preprocess(img_batch, device_buffers[0], input_w, input_h, stream);
+    }
+    // Run inference
+    {
+        TRACE_SCOPE("infer");
+        infer(context, stream, (void**)device_buffers, output_buffer_host, batch_size, decode_ptr_host,
+              decode_ptr_device, model_bboxes, cuda_post_process, cfg);
+    }
+    if (cuda_post_process == "c") {
+        // NMS
+        TRACE_SCOPE("batch_nms");
+        batch_nms(res_batch, output_buffer_host, img_batch.size(), output_size_per_image(cfg), cfg.conf_thresh,
+                  cfg.nms_thresh);
+    } else if (cuda_post_process == "g") {
+        //Process gpu decode and nms results
+        TRACE_SCOPE("batch_process");
+        batch_process(res_batch, decode_ptr_host, img_batch.size(), bbox_element, img_batch);
+    }
+    return cv::Size(input_w, input_h);
+}
+
+// Converts the boxes of a detect_batch result from the letterboxed network input to [x, y, w, h] in pixels of
+// their image.
+static void boxes_to_image(std::vector<cv::Mat>& img_batch, std::vector<std::vector<Detection>>& res_batch,
+                           cv::Size input_size) {
+    for (size_t j = 0; j < img_batch.size(); j++) {
+        for (auto& det : res_batch[j]) {
+            cv::Rect r = get_rect(img_batch[j], det.bbox, input_size.width, input_size.height);
+            det.bbox[0] = r.x;
+            det.bbox[1] = r.y;
+            det.bbox[2] = r.width;
+            det.bbox[3] = r.height;
+        }
+    }
+}
+
+// Letterboxes the regions of tiles from one upload of img into the batch slots, runs them in batches of up to
+// cfg.batch_size and returns the boxes of each region as [x1, y1, x2, y2] in frame pixels, clipped to the region.
+// Shared by --tile and the engines of --fine_engine; needs CPU post-processing ("c").
+static void detect_rois(IExecutionContext& context, cudaStream_t& stream, float** device_buffers,
+                        float* output_buffer_host, int model_bboxes, const cv::Mat& img, const std::vector<Tile>& tiles,
+                        std::vector<std::vector<Detection>>& res, const RuntimeConfig& cfg) {
+    res.assign(tiles.size(), std::vector<Detection>());
+    if ((int64_t)img.cols * img.rows > kMaxTiledImageSize) {
+        std::cerr << "frame of " << img.cols << "x" << img.rows << " is larger than kMaxTiledImageSize, skipped"
+                  << std::endl;
+        return;
+    }
+    if (!cuda_frame_upload(img, stream)) {
+        return;
+    }
+    const int dst_size = cfg.input_w * cfg.input_h * 3;
+    for (size_t first = 0; first < tiles.size(); first += cfg.batch_size) {
+        int batch_size = std::min(tiles.size() - first, (size_t)cfg.batch_size);
+        {
+            TRACE_SCOPE("cuda_roi_preprocess");
+            for (int i = 0; i < batch_size; i++) {
+                cuda_roi_preprocess(img, tiles[first + i].roi, device_buffers[0] + dst_size * i, cfg.input_w,
+                                    cfg.input_h, stream);
+            }
+        }
+        if (cfg.dynamic) {
+            context.setBindingDimensions(0, Dims4{batch_size, 3, cfg.input_h, cfg.input_w});
+        }
+        {
+            TRACE_SCOPE("infer");
+            infer(context, stream, (void**)device_buffers, output_buffer_host, batch_size, nullptr, nullptr,
+                  model_bboxes, "c", cfg);
+        }
+        std::vector<std::vector<Detection>> res_batch;
+        {
+            TRACE_SCOPE("batch_nms");
+            batch_nms(res_batch, output_buffer_host, batch_size, output_size_per_image(cfg), cfg.conf_thresh,
+                      cfg.nms_thresh);
+        }
+        for (int i = 0; i < batch_size; i++) {
+            tile_to_frame(tiles[first + i], res_batch[i]);
+            res[first + i].swap(res_batch[i]);
+        }
+    }
+}
+
+// Converts [x1, y1, x2, y2] boxes to [x, y, w, h], the layout of boxes_to_image.
+static void corners_to_rects(std::vector<Detection>& dets) {
+    for (auto& det : dets) {
+        det.bbox[2] -= det.bbox[0];
+        det.bbox[3] -= det.bbox[1];
+    }
+}
+
+// --tile: detects on overlapping tiles of a large frame at full resolution, plus the whole frame if asked, and merges
+// the boxes of all tiles. Returns [x, y, w, h] in frame pixels.
+static void detect_tiled(IExecutionContext& context, cudaStream_t& stream, float** device_buffers,
+                         float* output_buffer_host, int model_bboxes, const TileOptions& opts, cv::Mat& img,
+                         std::vector<Detection>& dets, const RuntimeConfig& cfg) {
+    TRACE_SCOPE("detect_tiled");
+    std::vector<Tile> tiles = plan_tiles(img.cols, img.rows, cfg.input_w, cfg.input_h, opts);
+    std::vector<std::vector<Detection>> res;
+    detect_rois(context, stream, device_buffers, output_buffer_host, model_bboxes, img, tiles, res, cfg);
+    dets.clear();
+    for (auto& r : res) {
+        dets.insert(dets.end(), r.begin(), r.end());
+    }
+    {
+        TRACE_SCOPE("merge_tile_detections");
+        merge_tile_detections(dets, opts.merge, opts.merge_thresh);
+    }
+    corners_to_rects(dets);
+}
+
+// A deserialized engine with its buffers as a RoiDetector for CoarseToFine. cfg is the engine's own, e.g. with the
+// lower confidence threshold of the coarse pass. Does not own the engine; the buffers are read at each call, so they
+// may be prepared after construction.
+class EngineRoiDetector : public RoiDetector {
+   public:
+    EngineRoiDetector(IExecutionContext& context, cudaStream_t& stream, float** device_buffers,
+                      float** output_buffer_host, int model_bboxes, const RuntimeConfig& cfg)
+        : context_(context),
+          stream_(stream),
+          device_buffers_(device_buffers),
+          output_buffer_host_(output_buffer_host),
+          model_bboxes_(model_bboxes),
+          cfg_(cfg) {}
+
+    cv::Size input_size() const override { return cv::Size(cfg_.input_w, cfg_.input_h); }
+
+    void detect(const cv::Mat& frame, const std::vector<cv::Rect>& rois,
+                std::vector<std::vector<Detection>>& res) override {
+        std::vector<Tile> tiles;
+        for (const auto& roi : rois) {
+            tiles.push_back(make_tile(roi, cfg_.input_w, cfg_.input_h));
+        }
+        detect_rois(context_, stream_, device_buffers_, *output_buffer_host_, model_bboxes_, frame, tiles, res, cfg_);
+    }
+
+   private:
+    IExecutionContext& context_;
+    cudaStream_t& stream_;
+    float** device_buffers_;
+    float** output_buffer_host_;
+    int model_bboxes_;
+    RuntimeConfig cfg_;
+};
+
+// A yolov8_cls engine with its own buffers as the CropClassifier of the cascade. Does not own the engine.
+class EngineCropClassifier : public CropClassifier {
+   public:
+    EngineCropClassifier(IExecutionContext& context, cudaStream_t& stream, BufferSet& buffers)
+        : context_(context), stream_(stream), strategy_(buffers.strategy()) {
+        const ICudaEngine& engine = context.getEngine();
+        assert(engine.getNbBindings() == 2);
+        auto in_dims = engine.getBindingDimensions(0);
+        input_size_ = cv::Size(in_dims.d[2], in_dims.d[1]);
+        num_classes_ = engine.getBindingDimensions(1).d[0];
+        max_batch_ = engine.getMaxBatchSize();
+        // the crops are written and the logits read on the CPU
+        input_ = buffers.allocate(binding_bytes(engine, 0), true);
+        output_ = buffers.allocate(binding_bytes(engine, 1), true);
+    }
+
+    int max_batch() const override { return max_batch_; }
+    cv::Size input_size() const override { return input_size_; }
+    int num_classes() const override { return num_classes_; }
+    float* input() override { return (float*)input_.host; }
+
+    const float* classify(int n) override {
+        TRACE_SCOPE("classify_crops");
+        void* bindings[2] = {input_.device, output_.device};
+        buffer_to_device(strategy_, input_.device, input_.host, n * 3 * input_size_.area() * sizeof(float), stream_);
+        context_.enqueue(n, bindings, stream_, nullptr);
+        buffer_to_host(strategy_, output_.host, output_.device, n * num_classes_ * sizeof(float), stream_);
+        CUDA_CHECK(cudaStreamSynchronize(stream_));
+        return (const float*)output_.host;
+    }
+
+   private:
+    IExecutionContext& context_;
+    cudaStream_t& stream_;
+    BufferStrategy strategy_;
+    BufferPair input_, output_;
+    cv::Size input_size_;
+    int num_classes_;
+    int max_batch_;
+};
+
+using DetectFn = std::function<void(std::vector<cv::Mat>&, std::vector<std::vector<Detection>>&)>;
+
+// Answers the images whose key is in the cache and runs detect, which must return boxes in image pixels, on the
+// others as one batch, caching their results.
+static void detect_batch_cached(ResultCache& cache, const std::vector<uint64_t>& keys, std::vector<cv::Mat>& img_batch,
+                                std::vector<std::vector<Detection>>& res_batch, const DetectFn& detect) {
+    TRACE_SCOPE("detect_batch_cached");
+    res_batch.assign(img_batch.size(), std::vector<Detection>());
+    std::vector<cv::Mat> misses;
+    std::vector<size_t> miss_index;
+    for (size_t j = 0; j < img_batch.size(); j++) {
+        if (!cache.lookup(keys[j], res_batch[j])) {
+            misses.push_back(img_batch[j]);
+            miss_index.push_back(j);
+        }
+    }
+    if (misses.empty()) {
+        return;
+    }
+    std::vector<std::vector<Detection>> miss_res;
+    detect(misses, miss_res);
+    for (size_t k = 0; k < misses.size(); k++) {
+        res_batch[miss_index[k]] = miss_res[k];
+        cache.insert(keys[miss_index[k]], miss_res[k]);
+    }
+}
+
+// draw_bbox for boxes that are already [x, y, w, h] in image pixels.
+static void draw_image_boxes(cv::Mat& img, const std::vector<Detection>& dets) {
+    for (const auto& det : dets) {
+        cv::Rect r(det.bbox[0], det.bbox[1], det.bbox[2], det.bbox[3]);
+        cv::rectangle(img, r, cv::Scalar(0x27, 0xC1, 0x36), 2);
+        cv::putText(img, std::to_string((int)det.class_id), cv::Point(r.x, r.y - 1), cv::FONT_HERSHEY_PLAIN, 1.2,
+                    cv::Scalar(0xFF, 0xFF, 0xFF), 2);
+    }
+}
+
+// Draws and writes the frames whose crops are all classified, with the most probable class under each classified box,
+// and prints the top-k classes. Frame ids index file_names.
+static void write_cascade_frames(CropBatcher& batcher, const std::vector<std::string>& file_names) {
+    CascadeFrame frame;
+    while (batcher.pop(frame)) {
+        TRACE_SCOPE("draw_bbox");
+        draw_image_boxes(frame.img, frame.dets);
+        std::cout << file_names[frame.id] << std::endl;
+        for (size_t d = 0; d < frame.dets.size(); d++) {
+            if (frame.labels[d].empty()) {
+                continue;
+            }
+            const float* bbox = frame.dets[d].bbox;
+            cv::putText(frame.img, std::to_string(frame.labels[d][0].class_id),
+                        cv::Point(bbox[0], bbox[1] + bbox[3] + 14), cv::FONT_HERSHEY_PLAIN, 1.2,
+                        cv::Scalar(0x27, 0xC1, 0x36), 2);
+            std::cout << "  box " << d << " class " << (int)frame.dets[d].class_id << ":";
+            for (const auto& label : frame.labels[d]) {
+                std::cout << " " << label.class_id << " (" << label.prob << ")";
+            }
+            std::cout << std::endl;
+        }
+        cv::imwrite("_" + file_names[frame.id], frame.img);
+    }
+}
+
+static double steady_ms() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Reads an image and, with a cache, its key: the hash of the file bytes, or of the decoded pixels. With
+// cfg.decode_reduce, JPEGs are decoded at the smallest DCT scale that still covers the network input.
+static DecodedImage read_image(const std::string& path, ResultCache* cache, uint64_t& key, const RuntimeConfig& cfg) {
+    DecodedImage decoded;
+    if (!cfg.decode_reduce && (cache == nullptr || cache->mode() == CacheKeyMode::kPixels)) {
+        decoded.img = cv::imread(path);
+        decoded.original_size = decoded.img.size();
+        key = cache != nullptr && !decoded.img.empty() ? cache->pixel_key(decoded.img) : 0;
+        return decoded;
+    }
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> encoded((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    decode_image(encoded, cfg.decode_reduce ? cfg.input_w : 0, cfg.input_h, decoded);
+    key = 0;
+    if (cache != nullptr && cache->mode() == CacheKeyMode::kEncoded) {
+        key = cache->encoded_key(encoded.data(), encoded.size());
+    } else if (cache != nullptr && !decoded.img.empty()) {
+        key = cache->pixel_key(decoded.img);
+    }
+    return decoded;
+}
+
+// Scales an image decoded at 1/scale back to the size of its file for drawing, and its boxes, when given in pixels of
+// the decoded image, to pixels of the file, the same ones -serve answers with.
+static void restore_original_size(const DecodedImage& decoded, cv::Mat& img, std::vector<Detection>* dets) {
+    if (decoded.scale == 1 || img.empty()) {
+        return;
+    }
+    for (size_t d = 0; dets != nullptr && d < dets->size(); d++) {
+        float* bbox = (*dets)[d].bbox;
+        cv::Rect r = to_original_rect(cv::Rect(bbox[0], bbox[1], bbox[2], bbox[3]), decoded);
+        bbox[0] = r.x;
+        bbox[1] = r.y;
+        bbox[2] = r.width;
+        bbox[3] = r.height;
+    }
+    cv::resize(img, img, decoded.original_size, 0, 0, cv::INTER_LINEAR);
+}
+
+// Runs detect (cached if there is a cache) on the frames in which the motion gate sees change, all frames without a
+// gate, and gives the other frames the boxes of the last frame the detector ran on, which last_dets carries across
+// batches. Returns the number of frames that reused boxes.
+static int detect_batch_gated(MotionGate* gate, ResultCache* cache, const std::vector<uint64_t>& keys,
+                              std::vector<cv::Mat>& img_batch, std::vector<std::vector<Detection>>& res_batch,
+                              std::vector<Detection>& last_dets, const DetectFn& detect) {
+    std::vector<cv::Mat> run_batch;
+    std::vector<uint64_t> run_keys;
+    std::vector<size_t> run_index;
+    for (size_t j = 0; j < img_batch.size(); j++) {
+        TRACE_SCOPE("motion_gate");
+        if (gate == nullptr || gate->check(img_batch[j]).run_detector) {
+            run_batch.push_back(img_batch[j]);
+            run_keys.push_back(keys[j]);
+            run_index.push_back(j);
+        }
+    }
+    std::vector<std::vector<Detection>> run_res;
+    if (cache != nullptr && !run_batch.empty()) {
+        detect_batch_cached(*cache, run_keys, run_batch, run_res, detect);
+    } else if (!run_batch.empty()) {
+        detect(run_batch, run_res);
+    }
+    res_batch.resize(img_batch.size());
+    int reused = 0;
+    for (size_t j = 0, k = 0; j < img_batch.size(); j++) {
+        if (k < run_index.size() && run_index[k] == j) {
+            last_dets = run_res[k++];
+        } else {
+            reused++;
+        }
+        res_batch[j] = last_dets;
+    }
+    return reused;
+}
+
+// -track: runs the detector on every interval-th frame of a video, earlier when a coasting track gets uncertain, and
+// ByteTracker on all frames. With a motion gate, keyframes without motion only advance the tracks. Writes the frames
+// with track IDs to _<video name>.avi.
+static int run_tracker(const std::string& video_path, int interval, MotionGate* gate, const DetectFn& detect) {
+    cv::VideoCapture cap(video_path);
+    if (!cap.isOpened()) {
+        std::cerr << "cannot open " << video_path << std::endl;
+        return -1;
+    }
+    double fps = cap.get(cv::CAP_PROP_FPS);
+    std::string out_path = "_" + video_path.substr(video_path.find_last_of('/') + 1) + ".avi";
+    cv::VideoWriter writer;
+    ByteTracker tracker;
+    KeyframeScheduler scheduler(interval, 0.15f);
+    std::vector<Detection> dets;
+    cv::Mat frame;
+    int frames = 0, detector_frames = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (cap.read(frame)) {
+        const std::vector<Track>* tracks = nullptr;
+        if (scheduler.is_keyframe(tracker) && (gate == nullptr || gate->check(frame).run_detector)) {
+            std::vector<cv::Mat> img_batch = {frame};
+            std::vector<std::vector<Detection>> res_batch;
+            detect(img_batch, res_batch);
+            dets = res_batch[0];
+            for (auto& det : dets) {
+                // [x, y, w, h] to corners
+                det.bbox[2] += det.bbox[0];
+                det.bbox[3] += det.bbox[1];
+            }
+            TRACE_SCOPE("tracker_update");
+            tracks = &tracker.update(dets);
+            detector_frames++;
+        } else {
+            TRACE_SCOPE("tracker_predict");
+            tracks = &tracker.predict();
+        }
+        for (const auto& t : *tracks) {
+            cv::Rect r(cv::Point(t.bbox[0], t.bbox[1]), cv::Point(t.bbox[2], t.bbox[3]));
+            cv::Scalar color((t.id * 67) % 256, (t.id * 151) % 256, (t.id * 37 + 128) % 256);
+            cv::rectangle(frame, r, color, 2);
+            cv::putText(frame, std::to_string(t.id), cv::Point(r.x, r.y - 1), cv::FONT_HERSHEY_PLAIN, 1.2, color, 2);
+        }
+        if (!writer.isOpened()) {
+            writer.open(out_path, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), fps > 0 ? fps : 30, frame.size());
+        }
+        writer.write(frame);
+        frames++;
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << frames << " frames, " << detector_frames << " with detection, " << frames / s << " fps, written to "
+              << out_path << std::endl;
+    return 0;
+}
+
+// --bench: the -d pipeline on synthetic 1280x720 frames, without disk I/O. GPU stages are timed with cudaEvents, the
+// CPU postprocess with steady_clock. Preprocessing stages each image through pinned memory, so its stage includes
+// the H2D copy.
+int run_detect_bench(const BenchOptions& opts, IExecutionContext& context, cudaStream_t& stream,
+                     float** device_buffers, float* output_buffer_host, float* decode_ptr_host,
+                     float* decode_ptr_device, int model_bboxes, const std::string& cuda_post_process,
+                     const RuntimeConfig& cfg) {
+    std::vector<cv::Mat> img_batch = make_bench_images(cfg.batch_size, 1280, 720);
+    int batch_size = img_batch.size();
+    if (cfg.dynamic) {
+        context.setBindingDimensions(0, Dims4{batch_size, 3, cfg.input_h, cfg.input_w});
+    }
+    GpuStageTimer timer(stream);
+    BenchStats stats = run_bench(opts, [&](BenchStats& s) {
+        TRACE_SCOPE("bench_iteration");
+        timer.start();
+        if (cfg.uint8_input) {
+            TRACE_SCOPE("cuda_batch_preprocess_uint8");
+            cuda_batch_preprocess_uint8(img_batch, (uint8_t*)device_buffers[0], cfg.input_w, cfg.input_h, stream);
+        } else {
+            TRACE_SCOPE("cuda_batch_preprocess");
+            cuda_batch_preprocess(img_batch, device_buffers[0], cfg.input_w, cfg.input_h, stream);
+        }
+        timer.mark("preprocess");
+        {
+            TRACE_SCOPE("enqueue");
+            if (cfg.dynamic) {
+                context.enqueueV2((void**)device_buffers, stream, nullptr);
+            } else {
+                context.enqueue(batch_size, (void**)device_buffers, stream, nullptr);
+            }
+        }
+        timer.mark("inference");
+        std::vector<std::vector<Detection>> res_batch;
+        if (cuda_post_process == "c") {
+            buffer_to_host(cfg.buffers, output_buffer_host, device_buffers[1],
+                           batch_size * output_size_per_image(cfg) * sizeof(float), stream);
+            timer.mark("d2h");
+            {
+                TRACE_SCOPE("stream_sync");
+                CUDA_CHECK(cudaStreamSynchronize(stream));
+            }
+            timer.collect(s);
+            TRACE_SCOPE("batch_nms");
+            auto start = std::chrono::steady_clock::now();
+            batch_nms(res_batch, output_buffer_host, batch_size, output_size_per_image(cfg), cfg.conf_thresh,
+                      cfg.nms_thresh);
+            s.add("decode+nms",
+                  std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        } else {
+            size_t decode_bytes = sizeof(float) * (1 + cfg.max_num_output_bbox * bbox_element);
+            CUDA_CHECK(cudaMemsetAsync(decode_ptr_device, 0, decode_bytes, stream));
+            cuda_decode((float*)device_buffers[1], model_bboxes, cfg.conf_thresh, decode_ptr_device,
+                        cfg.max_num_output_bbox, stream);
+            timer.mark("decode");
+            cuda_nms(decode_ptr_device, cfg.nms_thresh, cfg.max_num_output_bbox, stream);
+            timer.mark("nms");
+            buffer_to_host(cfg.buffers, decode_ptr_host, decode_ptr_device, decode_bytes, stream);
+            timer.mark("d2h");
+            {
+                TRACE_SCOPE("stream_sync");
+                CUDA_CHECK(cudaStreamSynchronize(stream));
+            }
+            timer.collect(s);
+            TRACE_SCOPE("batch_process");
+            auto start = std::chrono::steady_clock::now();
+            batch_process(res_batch, decode_ptr_host, batch_size, bbox_element, img_batch);
+            s.add("postprocess",
+                  std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+    });
+    return stats.report(opts, "yolov8_det", batch_size) ? 0 : -1;
+}
+
+// Stops tracing and writes the spans recorded so far to --trace, if it was given.
+static void write_trace(const RuntimeConfig& cfg) {
+    if (cfg.trace.empty()) {
+        return;
+    }
+    trace_enable(false);
+    if (trace_write_chrome_json(cfg.trace)) {
+        std::cout << trace_span_count() << " spans written to " << cfg.trace
+                  << ", open it in chrome://tracing or ui.perfetto.dev" << std::endl;
+    }
+}
+
+// --bench_mock: the CPU stages of -d, decode + NMS of the yolo layer output and mapping the boxes back to the image,
+// on synthetic engine output. Needs no GPU, so pre/post regressions can be tracked in CI.
+int run_mock_bench(const BenchOptions& opts, const RuntimeConfig& cfg) {
+    std::mt19937 rng(0);
+    int output_size = output_size_per_image(cfg);
+    std::vector<float> output((size_t)cfg.batch_size * output_size);
+    for (int b = 0; b < cfg.batch_size; b++) {
+        fill_mock_output<Detection>(&output[(size_t)b * output_size], output_size, cfg.max_num_output_bbox,
+                                    cfg.input_w, cfg.input_h, cfg.num_class, true, rng);
+    }
+    std::vector<cv::Mat> img_batch = make_bench_images(cfg.batch_size, 1280, 720);
+    BenchStats stats = run_bench(opts, [&](BenchStats& s) {
+        TRACE_SCOPE("bench_iteration");
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<std::vector<Detection>> res_batch;
+        {
+            TRACE_SCOPE("batch_nms");
+            batch_nms(res_batch, output.data(), cfg.batch_size, output_size, cfg.conf_thresh, cfg.nms_thresh);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        TRACE_SCOPE("get_rect");
+        for (int b = 0; b < cfg.batch_size; b++) {
+            for (auto& det : res_batch[b]) {
+                get_rect(img_batch[b], det.bbox, cfg.input_w, cfg.input_h);
+            }
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        s.add("decode+nms", std::chrono::duration<double, std::milli>(t1 - t0).count());
+        s.add("get_rect", std::chrono::duration<double, std::milli>(t2 - t1).count());
+    });
+    return stats.report(opts, "yolov8_det mock", cfg.batch_size) ? 0 : -1;
+}
+
+// Consumes frames that capture processes write into the shared-memory ring ring_name (see frame_ring.h), in batches
+// of up to the engine's max batch, and prints the detections of each frame. Frames are preprocessed in place and
+// their slots released before inference; frames whose info does not fit their slot or kMaxInputImageSize are
+// dropped. Runs until the process is killed.
+int run_shm_consumer(const std::string& ring_name, int slots, IExecutionContext& context, cudaStream_t& stream,
+                     float** device_buffers, float* output_buffer_host, int model_bboxes, const RuntimeConfig& cfg) {
+    FrameRing ring;
+    if (!ring.create(ring_name, slots, (size_t)kMaxInputImageSize * 3)) {
+        return -1;
+    }
+    CUDA_CHECK(cudaHostRegister(ring.mapping(), ring.mapping_size(), cudaHostRegisterDefault));
+    std::cout << "waiting for frames on /dev/shm/" << ring_name << std::endl;
+    while (true) {
+        std::vector<FrameSlot*> held;
+        FrameSlot* slot = ring.acquire(1000);
+        while (slot != nullptr) {
+            held.push_back(slot);
+            slot = (int)held.size() < cfg.batch_size ? ring.acquire(0) : nullptr;
+        }
+        if (held.empty()) {
+            continue;
+        }
+
+        // Mat headers over the slots. NV12 frames are letterboxed from their planes by detect_batch; an engine with
+        // uint8_input letterboxes BGR on the CPU, so for it they are converted to BGR behind their own data in the
+        // same slot
+        std::vector<cv::Mat> img_batch;
+        std::vector<FrameInfo> infos;
+        for (FrameSlot* s : held) {
+            // a copy, producers share the mapping and could change the info after it was checked
+            const FrameInfo info = s->info;
+            std::string error;
+            if (!check_frame_info(info, ring.slot_bytes(), kMaxInputImageSize, error)) {
+                std::cerr << "dropping frame " << info.frame_id << " of source " << info.source_id << ": " << error
+                          << std::endl;
+                continue;
+            }
+            if (info.format == FrameFormat::kNV12 && !cfg.uint8_input) {
+                img_batch.push_back(cv::Mat(frame_rows(info), info.width, CV_8UC1, s->data(), info.stride));
+            } else if (info.format == FrameFormat::kNV12) {
+                if (info.width % 2 != 0 || info.height % 2 != 0) {
+                    // cvtColor only takes whole 2x2 chroma blocks
+                    std::cerr << "NV12 frame " << info.frame_id << " of odd size " << info.width << "x" << info.height
+                              << " needs an engine without uint8_input" << std::endl;
+                    continue;
+                }
+                size_t bgr_offset = (info.size + 4095) / 4096 * 4096;
+                if (bgr_offset + (size_t)info.width * info.height * 3 > ring.slot_bytes()) {
+                    std::cerr << "NV12 frame " << info.frame_id << " too large to convert in place" << std::endl;
+                    continue;
+                }
+                cv::Mat nv12(frame_rows(info), info.width, CV_8UC1, s->data(), info.stride);
+                cv::Mat bgr(info.height, info.width, CV_8UC3, s->data() + bgr_offset);
+                cv::cvtColor(nv12, bgr, cv::COLOR_YUV2BGR_NV12);
+                img_batch.push_back(bgr);
+            } else {
+                img_batch.push_back(cv::Mat(info.height, info.width, CV_8UC3, s->data(), info.stride));
+            }
+            infos.push_back(info);
+        }
+
+        std::vector<std::vector<Detection>> res_batch;
+        cv::Size input_size(cfg.input_w, cfg.input_h);
+        if (!img_batch.empty()) {
+            input_size = detect_batch(context, stream, device_buffers, output_buffer_host, nullptr, nullptr,
+                                      model_bboxes, "c", img_batch, res_batch, cfg, true);
+        }
+        // preprocessing has synchronized, the pixels are no longer needed
+        for (FrameSlot* s : held) {
+            ring.release(s);
+        }
+
+        for (size_t j = 0; j < img_batch.size(); j++) {
+            std::cout << "source " << infos[j].source_id << " frame " << infos[j].frame_id << ":";
+            // get_rect only reads the image size, the released pixels are not touched
+            cv::Mat frame(infos[j].height, infos[j].width, CV_8UC3, img_batch[j].data);
+            for (auto& det : res_batch[j]) {
+                cv::Rect r = get_rect(frame, det.bbox, input_size.width, input_size.height);
+                std::cout << " [" << (int)det.class_id << " " << det.conf << " " << r << "]";
+            }
+            std::cout << std::endl;
+        }
+    }
+    return 0;
+}
+
+// What the command line asks for: the mode and its positional arguments, and the options of the pipeline stages.
+struct DetArgs {
+    std::string wts_name;
+    std::string engine_name;
+    std::string img_dir;
+    std::string sub_type;
+    std::string cuda_post_process;
+    int is_p = 0;
+    float gd = 0.0f, gw = 0.0f;
+    int max_channels = 0;
+    std::string socket_path;
+    int deadline_ms = 50;
+    std::string ring_name;
+    int ring_slots = 8;
+    std::string video_path;
+    int track_interval = 1;
+    std::string profile_prefix;
+    int profile_iters = 1;
+    BenchOptions bench;
+    MotionGateOptions motion;
+    TileOptions tiles;
+    CoarseToFineOptions c2f;
+    CascadeOptions cascade;
+};
+
+// Consumes the --options of all stages and the runtime config, and compacts argv to the positional arguments.
+static bool parse_option_args(int& argc, char** argv, DetArgs& args, RuntimeConfig& cfg) {
+    return parse_profile_args(argc, argv, args.profile_prefix, args.profile_iters) &&
+           parse_bench_args(argc, argv, args.bench) && parse_motion_gate_args(argc, argv, args.motion) &&
+           parse_tile_args(argc, argv, args.tiles) && parse_coarse_to_fine_args(argc, argv, args.c2f) &&
+           parse_cascade_args(argc, argv, args.cascade) && parse_runtime_config_args(argc, argv, cfg) &&
+           validate_runtime_config(cfg);
+}
+
+bool parse_args(int argc, char** argv, DetArgs& args) {
+    if (args.bench.enabled && argc >= 3 && argc <= 4 && std::string(argv[1]) == "-d") {
+        // the images are generated in memory, no image folder
+        args.engine_name = std::string(argv[2]);
+        args.cuda_post_process = argc == 4 ? std::string(argv[3]) : "c";
+        return true;
+    }
     if (argc < 4)
         return false;
     if (std::string(argv[1]) == "-s" && (argc == 5 || argc == 7)) {
-        wts = std::string(argv[2]);
-        engine = std::string(argv[3]);
+        args.wts_name = std::string(argv[2]);
+        args.engine_name = std::string(argv[3]);
         auto sub_type = std::string(argv[4]);
 
         if (sub_type[0] == 'n') {
-            gd = 0.33;
-            gw = 0.25;
-            max_channels = 1024;
+            args.gd = 0.33;
+            args.gw = 0.25;
+            args.max_channels = 1024;
         } else if (sub_type[0] == 's') {
-            gd = 0.33;
-            gw = 0.50;
-            max_channels = 1024;
+            args.gd = 0.33;
+            args.gw = 0.50;
+            args.max_channels = 1024;
         } else if (sub_type[0] == 'm') {
-            gd = 0.67;
-            gw = 0.75;
-            max_channels = 576;
+            args.gd = 0.67;
+            args.gw = 0.75;
+            args.max_channels = 576;
         } else if (sub_type[0] == 'l') {
-            gd = 1.0;
-            gw = 1.0;
-            max_channels = 512;
+            args.gd = 1.0;
+            args.gw = 1.0;
+            args.max_channels = 512;
         } else if (sub_type[0] == 'x') {
-            gd = 1.0;
-            gw = 1.25;
-            max_channels = 640;
+            args.gd = 1.0;
+            args.gw = 1.25;
+            args.max_channels = 640;
         } else {
             return false;
         }
         if (sub_type.size() == 2 && sub_type[1] == '6') {
-            is_p = 6;
+            args.is_p = 6;
         } else if (sub_type.size() == 2 && sub_type[1] == '2') {
-            is_p = 2;
+            args.is_p = 2;
         }
+    } else if (std::string(argv[1]) == "-serve" && (argc == 4 || argc == 5)) {
+        args.engine_name = std::string(argv[2]);
+        args.socket_path = std::string(argv[3]);
+        args.deadline_ms = argc == 5 ? atoi(argv[4]) : args.deadline_ms;
+        args.cuda_post_process = "c";
+    } else if (std::string(argv[1]) == "-shm" && (argc == 4 || argc == 5)) {
+        args.engine_name = std::string(argv[2]);
+        args.ring_name = std::string(argv[3]);
+        args.ring_slots = argc == 5 ? atoi(argv[4]) : args.ring_slots;
+        args.cuda_post_process = "c";
+    } else if (std::string(argv[1]) == "-track" && (argc == 4 || argc == 5)) {
+        args.engine_name = std::string(argv[2]);
+        args.video_path = std::string(argv[3]);
+        args.track_interval = argc == 5 ? atoi(argv[4]) : args.track_interval;
+        args.cuda_post_process = "c";
     } else if (std::string(argv[1]) == "-d" && argc == 5) {
-        engine = std::string(argv[2]);
-        img_dir = std::string(argv[3]);
-        cuda_post_process = std::string(argv[4]);
+        args.engine_name = std::string(argv[2]);
+        args.img_dir = std::string(argv[3]);
+        args.cuda_post_process = std::string(argv[4]);
     } else {
         return false;
     }
     return true;
 }
 
-int main(int argc, char** argv) {
-    cudaSetDevice(kGpuId);
-    std::string wts_name = "";
-    std::string engine_name = "";
-    std::string img_dir;
-    std::string sub_type = "";
-    std::string cuda_post_process = "";
-    int model_bboxes;
-    int is_p = 0;
-    float gd = 0.0f, gw = 0.0f;
-    int max_channels = 0;
+static void print_usage() {
+    std::cerr << "Arguments not right!" << std::endl;
+    std::cerr << "./yolov8 -s [.wts] [.engine] [n/s/m/l/x/n2/s2/m2/l2/x2/n6/s6/m6/l6/x6]  // serialize model to "
+                 "plan file"
+              << std::endl;
+    std::cerr << "./yolov8 -d [.engine] ../samples  [c/g]// deserialize plan file and run inference" << std::endl;
+    std::cerr << "./yolov8 -serve [.engine] [socket] [deadline ms]  // batch requests from a unix socket" << std::endl;
+    std::cerr << "./yolov8 -shm [.engine] [ring name] [slots]  // consume frames from shared memory" << std::endl;
+    std::cerr << "./yolov8 -track [.engine] [video] [detect every k frames]  // track objects in a video" << std::endl;
+    std::cerr << "optional: --config=[file] --precision=fp16 --batch_size=4 --input_h=640 --input_w=640 "
+                 "--num_class=80 --conf_thresh=0.5 --nms_thresh=0.45 --max_num_output_bbox=1000 --gpu_id=0 "
+                 "--dynamic=1 --uint8_input=1 --decode_reduce=1 --verbose=0|1 --trace=trace.json "
+                 "--buffers=device|mapped|managed "
+                 "--cache_mb=64 --cache_key=encoded|pixels --cache_file=results.cache"
+              << std::endl;
+    std::cerr << "optional with -d: --profile=[output prefix] --profile_iters=10  // per-layer timings as csv/json"
+              << std::endl;
+    std::cerr << "optional with -d and -track: --motion_gate [--motion_thresh=8 --motion_area=0.0005 "
+                 "--max_stale=30 --motion_block=16 --motion_step=2]  // reuse detections on static frames"
+              << std::endl;
+    std::cerr << "optional with -d, -serve and -track: --tile [--tile_size=640x640 --tile_overlap=0.2 "
+                 "--tile_full=1 --tile_merge=fusion|nms --tile_merge_thresh=0.5]  // sliced inference on large "
+                 "frames"
+              << std::endl;
+    std::cerr << "optional with -d, -serve and -track: --fine_engine=[.engine] [--c2f_max_rois=4 "
+                 "--c2f_low_conf=0.1 --c2f_small=32 --c2f_zoom=1 --c2f_merge=fusion|nms]  // re-detect small and "
+                 "uncertain objects at high resolution"
+              << std::endl;
+    std::cerr << "optional with -d: --cls_engine=[yolov8_cls .engine] [--cascade_classes=2,5,7 --cascade_topk=3 "
+                 "--cascade_wait_ms=20 --cascade_context=0.1]  // classify the detected boxes in batches"
+              << std::endl;
+    std::cerr << "./yolov8 -d [.engine] [c/g] --bench [--bench_iters=200 --bench_warmup=20 --bench_json=file]  "
+                 "// stage latency on synthetic frames"
+              << std::endl;
+    std::cerr << "./yolov8 --bench_mock  // CPU postprocess stages on synthetic engine output, no GPU" << std::endl;
+}
 
-    if (!parse_args(argc, argv, wts_name, engine_name, is_p, img_dir, sub_type, cuda_post_process, gd, gw,
-                    max_channels)) {
-        std::cerr << "Arguments not right!" << std::endl;
-        std::cerr << "./yolov8 -s [.wts] [.engine] [n/s/m/l/x/n2/s2/m2/l2/x2/n6/s6/m6/l6/x6]  // serialize model to "
-                     "plan file"
-                  << std::endl;
-        std::cerr << "./yolov8 -d [.engine] ../samples  [c/g]// deserialize plan file and run inference" << std::endl;
+// -s: creates a model using the API directly and serializes it to a file.
+static int run_serialize(DetArgs& args, const RuntimeConfig& cfg) {
+    RuntimeConfig defaults;
+    if (args.is_p != 0 && (cfg.precision != defaults.precision || cfg.input_h != defaults.input_h ||
+                           cfg.input_w != defaults.input_w || cfg.batch_size != defaults.batch_size ||
+                           cfg.num_class != defaults.num_class ||
+                           cfg.max_num_output_bbox != defaults.max_num_output_bbox || cfg.dynamic ||
+                           cfg.uint8_input)) {
+        std::cerr << "runtime config is only supported by the default det model, edit config.h for p2/p6" << std::endl;
         return -1;
     }
+    serialize_engine(args.wts_name, args.engine_name, args.is_p, args.sub_type, args.gd, args.gw, args.max_channels,
+                     cfg);
+    return 0;
+}
 
-    // Create a model using the API directly and serialize it to a file
-    if (!wts_name.empty()) {
-        serialize_engine(wts_name, engine_name, is_p, sub_type, gd, gw, max_channels);
-        return 0;
+// The input modes that cannot be combined. --tile and --fine_engine (roi input) cut parts out of one upload of the
+// full frame on the GPU and merge the boxes on the CPU. cfg.uint8_input is taken from the engine, so this runs once
+// the engine is loaded.
+static bool check_input_modes(const DetArgs& args, const RuntimeConfig& cfg) {
+    bool roi_input = args.tiles.enabled || args.c2f.enabled;
+    if (args.tiles.enabled && args.c2f.enabled) {
+        std::cerr << "--tile and --fine_engine cannot be combined" << std::endl;
+        return false;
+    }
+    if (roi_input && args.cuda_post_process != "c") {
+        std::cerr << "--tile and --fine_engine merge detections on the CPU, use c post-processing" << std::endl;
+        return false;
     }
+    if (roi_input && cfg.decode_reduce) {
+        std::cerr << "--tile and --fine_engine look for objects at full resolution, drop --decode_reduce" << std::endl;
+        return false;
+    }
+    if (roi_input && cfg.uint8_input) {
+        std::cerr << "--tile and --fine_engine letterbox parts of the frame on the GPU, use an engine built without "
+                     "uint8_input"
+                  << std::endl;
+        return false;
+    }
+    if (cfg.buffers == BufferStrategy::kHost) {
+        std::cerr << "--buffers=host is CPU memory the engine cannot use, it is for yolov8_buffer_bench" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Everything that changes the detections of an image besides its bytes: the engine and thresholds, and tiling, the
+// second pass and decode_reduce.
+static uint64_t cache_config_id(const DetArgs& args, const RuntimeConfig& cfg) {
+    uint64_t config_id = result_cache_config_id(args.engine_name, cfg.conf_thresh, cfg.nms_thresh,
+                                                cfg.max_num_output_bbox, cfg.cache_key);
+    const TileOptions& tiles = args.tiles;
+    if (tiles.enabled) {
+        float settings[] = {(float)tiles.tile_w, (float)tiles.tile_h, tiles.overlap, (float)tiles.full_frame,
+                            (float)tiles.merge, tiles.merge_thresh};
+        config_id = xxh64(settings, sizeof(settings), config_id);
+    }
+    const CoarseToFineOptions& c2f = args.c2f;
+    if (c2f.enabled) {
+        float settings[] = {c2f.low_conf, c2f.small_side, (float)c2f.max_rois, c2f.roi_zoom, (float)c2f.merge,
+                            c2f.merge_thresh};
+        config_id ^= result_cache_config_id(c2f.fine_engine, cfg.conf_thresh, cfg.nms_thresh,
+                                            cfg.max_num_output_bbox, cfg.cache_key);
+        config_id = xxh64(settings, sizeof(settings), config_id);
+    }
+    // boxes found on a reduced decode are close to, not the same as, those of the full image
+    if (cfg.decode_reduce) {
+        const char tag[] = "decode_reduce";
+        config_id = xxh64(tag, sizeof(tag), config_id);
+    }
+    return config_id;
+}
 
-    // Deserialize the engine from file
+// The engines of a run and their buffers: the detector, with --fine_engine the fine pass of coarse-to-fine (the
+// detector is then the coarse pass), with --cls_engine the classifier of the cascade, and the result cache.
+struct DetPipeline {
+    RuntimeConfig& cfg;
+    std::string cuda_post_process;
+    TileOptions tiles;
+    // --tile or --fine_engine: tiles and regions are cut from one upload of the whole frame, which may be much larger
+    // than the images -d expects
+    bool roi_input = false;
     IRuntime* runtime = nullptr;
     ICudaEngine* engine = nullptr;
     IExecutionContext* context = nullptr;
-    deserialize_engine(engine_name, &runtime, &engine, &context);
-    cudaStream_t stream;
-    CUDA_CHECK(cudaStreamCreate(&stream));
-    cuda_preprocess_init(kMaxInputImageSize);
-    auto out_dims = engine->getBindingDimensions(1);
-    model_bboxes = out_dims.d[0];
-    // Prepare cpu and gpu buffers
-    float* device_buffers[2];
+    cudaStream_t stream = nullptr;
+    bool preprocess_init = false;
+    int model_bboxes = 0;
+    BufferSet buffers;
+    float* device_buffers[2] = {nullptr, nullptr};
     float* output_buffer_host = nullptr;
     float* decode_ptr_host = nullptr;
     float* decode_ptr_device = nullptr;
+    std::unique_ptr<ResultCache> cache;
+
+    IRuntime* fine_runtime = nullptr;
+    ICudaEngine* fine_engine = nullptr;
+    IExecutionContext* fine_context = nullptr;
+    BufferSet fine_buffers;
+    float* fine_device_buffers[2] = {nullptr, nullptr};
+    float* fine_output_host = nullptr;
+    std::unique_ptr<EngineRoiDetector> coarse_detector, fine_detector;
+    std::unique_ptr<CoarseToFine> c2f;
+
+    IRuntime* cls_runtime = nullptr;
+    ICudaEngine* cls_engine = nullptr;
+    IExecutionContext* cls_context = nullptr;
+    BufferSet cls_buffers;
+    std::unique_ptr<EngineCropClassifier> classifier;
+    std::unique_ptr<CropBatcher> batcher;
+
+    explicit DetPipeline(RuntimeConfig& config)
+        : cfg(config), buffers(config.buffers), fine_buffers(config.buffers), cls_buffers(config.buffers) {}
+    DetPipeline(const DetPipeline&) = delete;
+    DetPipeline& operator=(const DetPipeline&) = delete;
 
+    // Deserializes the engines, takes the batch and input sizes of cfg from the detector and allocates the buffers.
+    bool load(const DetArgs& args) {
+        cuda_post_process = args.cuda_post_process;
+        tiles = args.tiles;
+        roi_input = args.tiles.enabled || args.c2f.enabled;
+        deserialize_engine(args.engine_name, &runtime, &engine, &context);
+        CUDA_CHECK(cudaStreamCreate(&stream));
+        cuda_preprocess_init(roi_input ? std::max(kMaxInputImageSize, kMaxTiledImageSize) : kMaxInputImageSize);
+        preprocess_init = true;
+        model_bboxes = configure_from_engine(engine, cfg);
+        if (!check_input_modes(args, cfg)) {
+            return false;
+        }
+        prepare_buffer(engine, buffers, &device_buffers[0], &device_buffers[1], &output_buffer_host, &decode_ptr_host,
+                       &decode_ptr_device, cuda_post_process, cfg);
+        if (cfg.cache_mb > 0) {
+            cache.reset(new ResultCache((size_t)cfg.cache_mb << 20, cache_config_id(args, cfg), cfg.cache_key));
+            if (!cfg.cache_file.empty() && cache->load(cfg.cache_file)) {
+                std::cout << "loaded " << cache->stats().entries << " cached results from " << cfg.cache_file
+                          << std::endl;
+            }
+        }
+        if (args.c2f.enabled && !load_fine_engine(args.c2f)) {
+            return false;
+        }
+        if (args.cascade.enabled) {
+            // the boxes of each image are cropped into batches of the classifier
+            deserialize_engine(args.cascade.cls_engine, &cls_runtime, &cls_engine, &cls_context);
+            classifier.reset(new EngineCropClassifier(*cls_context, stream, cls_buffers));
+            batcher.reset(new CropBatcher(*classifier, args.cascade));
+        }
+        return true;
+    }
+
+    // The detector runs as the coarse pass, with the lower threshold of the candidates.
+    bool load_fine_engine(CoarseToFineOptions opts) {
+        RuntimeConfig fine_cfg = cfg;
+        deserialize_engine(opts.fine_engine, &fine_runtime, &fine_engine, &fine_context);
+        int fine_model_bboxes = configure_from_engine(fine_engine, fine_cfg);
+        if (fine_cfg.uint8_input) {
+            std::cerr << "--fine_engine must be built without uint8_input" << std::endl;
+            return false;
+        }
+        prepare_buffer(fine_engine, fine_buffers, &fine_device_buffers[0], &fine_device_buffers[1], &fine_output_host,
+                       nullptr, nullptr, "c", fine_cfg);
+        RuntimeConfig coarse_cfg = cfg;
+        coarse_cfg.conf_thresh = opts.low_conf;
+        coarse_detector.reset(
+                new EngineRoiDetector(*context, stream, device_buffers, &output_buffer_host, model_bboxes, coarse_cfg));
+        fine_detector.reset(new EngineRoiDetector(*fine_context, stream, fine_device_buffers, &fine_output_host,
+                                                  fine_model_bboxes, fine_cfg));
+        opts.conf_thresh = cfg.conf_thresh;
+        c2f.reset(new CoarseToFine(opts));
+        return true;
+    }
+
+    // Runs a batch and returns its boxes in image pixels
+    void detect(std::vector<cv::Mat>& img_batch, std::vector<std::vector<Detection>>& res_batch) {
+        if (c2f) {
+            res_batch.resize(img_batch.size());
+            for (size_t j = 0; j < img_batch.size(); j++) {
+                TRACE_SCOPE("coarse_to_fine");
+                c2f->detect(img_batch[j], *coarse_detector, *fine_detector, res_batch[j]);
+                corners_to_rects(res_batch[j]);
+            }
+            return;
+        }
+        if (tiles.enabled) {
+            res_batch.resize(img_batch.size());
+            for (size_t j = 0; j < img_batch.size(); j++) {
+                detect_tiled(*context, stream, device_buffers, output_buffer_host, model_bboxes, tiles, img_batch[j],
+                             res_batch[j], cfg);
+            }
+            return;
+        }
+        cv::Size input_size = detect_batch(*context, stream, device_buffers, output_buffer_host, decode_ptr_host,
+                                           decode_ptr_device, model_bboxes, cuda_post_process, img_batch, res_batch,
+                                           cfg);
+        boxes_to_image(img_batch, res_batch, input_size);
+    }
+
+    DetectFn detect_fn() {
+        return [this](std::vector<cv::Mat>& img_batch, std::vector<std::vector<Detection>>& res_batch) {
+            detect(img_batch, res_batch);
+        };
+    }
+
+    ~DetPipeline() {
+        // Release stream and buffers
+        if (stream != nullptr) {
+            cudaStreamDestroy(stream);
+        }
+        buffers.release();
+        fine_buffers.release();
+        cls_buffers.release();
+        if (preprocess_init) {
+            cuda_preprocess_destroy();
+        }
+        // Destroy the engines
+        delete context;
+        delete engine;
+        delete runtime;
+        delete fine_context;
+        delete fine_engine;
+        delete fine_runtime;
+        delete cls_context;
+        delete cls_engine;
+        delete cls_runtime;
+    }
+};
+
+// -serve: requests are coalesced into batches of up to the engine's max batch, one batch on the GPU at a time.
+static int run_server(DetPipeline& pipeline, const DetArgs& args) {
+    const RuntimeConfig& cfg = pipeline.cfg;
+    BatchSchedulerOptions opts;
+    opts.max_batch = cfg.batch_size;
+    // the current device is per thread, the batches run on the scheduler's
+    opts.thread_init = [&cfg]() { cudaSetDevice(cfg.gpu_id); };
+    BatchScheduler scheduler(opts, [&](std::vector<std::shared_ptr<InferJob>>& jobs) {
+        std::vector<cv::Mat> img_batch;
+        for (auto& job : jobs) {
+            img_batch.push_back(job->img);
+        }
+        std::vector<std::vector<Detection>> res_batch;
+        pipeline.detect(img_batch, res_batch);
+        for (size_t j = 0; j < jobs.size(); j++) {
+            jobs[j]->result = res_batch[j];
+        }
+    });
+    if (pipeline.cache && !cfg.cache_file.empty()) {
+        // the server runs until it is killed, so the cache is saved as it grows
+        pipeline.cache->set_persistence(cfg.cache_file, 1000);
+    }
+    return run_inference_server(args.socket_path, scheduler, args.deadline_ms, pipeline.cache.get(),
+                                cfg.decode_reduce ? cv::Size(cfg.input_w, cfg.input_h) : cv::Size());
+}
+
+// -d: detects the images of a directory in batches and writes them with their boxes to _<name>.
+static int run_images(DetPipeline& pipeline, const DetArgs& args) {
+    const RuntimeConfig& cfg = pipeline.cfg;
+    IExecutionContext& context = *pipeline.context;
+    ResultCache* cache = pipeline.cache.get();
+    CropBatcher* batcher = pipeline.batcher.get();
     // Read images from directory
     std::vector<std::string> file_names;
-    if (read_files_in_dir(img_dir.c_str(), file_names) < 0) {
+    if (read_files_in_dir(args.img_dir.c_str(), file_names) < 0) {
         std::cerr << "read_files_in_dir failed." << std::endl;
         return -1;
     }
+    if (args.motion.enabled) {
+        // the gate compares consecutive frames, so the images are taken in name order (frame_0001.jpg, ...)
+        std::sort(file_names.begin(), file_names.end());
+    }
 
-    prepare_buffer(engine, &device_buffers[0], &device_buffers[1], &output_buffer_host, &decode_ptr_host,
-                   &decode_ptr_device, cuda_post_process);
+    LayerProfiler profiler;
+    if (!args.profile_prefix.empty()) {
+        context.setProfiler(&profiler);
+    }
+    MotionGate gate(args.motion);
+    std::vector<Detection> last_dets;
+    int reused_frames = 0;
+    DetectFn detect = pipeline.detect_fn();
 
     // batch predict
-    for (size_t i = 0; i < file_names.size(); i += kBatchSize) {
+    for (size_t i = 0; i < file_names.size(); i += cfg.batch_size) {
         // Get a batch of images
         std::vector<cv::Mat> img_batch;
         std::vector<std::string> img_name_batch;
-        for (size_t j = i; j < i + kBatchSize && j < file_names.size(); j++) {
-            cv::Mat img = cv::imread(img_dir + "/" + file_names[j]);
-            img_batch.push_back(img);
+        std::vector<uint64_t> keys;
+        std::vector<DecodedImage> decoded_batch;
+        for (size_t j = i; j < i + cfg.batch_size && j < file_names.size(); j++) {
+            TRACE_SCOPE("imread");
+            uint64_t key = 0;
+            decoded_batch.push_back(read_image(args.img_dir + "/" + file_names[j], cache, key, cfg));
+            img_batch.push_back(decoded_batch.back().img);
             img_name_batch.push_back(file_names[j]);
+            keys.push_back(key);
         }
-        // Preprocess
-        cuda_batch_preprocess(img_batch, device_buffers[0], kInputW, kInputH, stream);
-        // Run inference
-        infer(*context, stream, (void**)device_buffers, output_buffer_host, kBatchSize, decode_ptr_host,
-              decode_ptr_device, model_bboxes, cuda_post_process);
         std::vector<std::vector<Detection>> res_batch;
-        if (cuda_post_process == "c") {
-            // NMS
-            batch_nms(res_batch, output_buffer_host, img_batch.size(), kOutputSize, kConfThresh, kNmsThresh);
-        } else if (cuda_post_process == "g") {
-            //Process gpu decode and nms results
-            batch_process(res_batch, decode_ptr_host, img_batch.size(), bbox_element, img_batch);
+        if (cache || args.motion.enabled || pipeline.roi_input || batcher) {
+            // duplicates and frames without motion skip preprocessing, inference and NMS, boxes come back in image
+            // pixels
+            reused_frames += detect_batch_gated(args.motion.enabled ? &gate : nullptr, cache, keys, img_batch,
+                                                res_batch, last_dets, detect);
+            for (size_t j = 0; j < img_batch.size(); j++) {
+                // after detection, the gate and the cache compare the decoded images
+                restore_original_size(decoded_batch[j], img_batch[j], &res_batch[j]);
+            }
+            if (batcher) {
+                // the images are written once the crops of their boxes have been classified, in a later batch
+                for (size_t j = 0; j < img_batch.size(); j++) {
+                    TRACE_SCOPE("crop_batcher");
+                    batcher->add(i + j, img_batch[j], res_batch[j], steady_ms());
+                }
+                write_cascade_frames(*batcher, file_names);
+                continue;
+            }
+            for (size_t j = 0; j < img_batch.size(); j++) {
+                TRACE_SCOPE("draw_bbox");
+                draw_image_boxes(img_batch[j], res_batch[j]);
+                cv::imwrite("_" + img_name_batch[j], img_batch[j]);
+            }
+            continue;
+        }
+        cv::Size input_size = detect_batch(context, pipeline.stream, pipeline.device_buffers,
+                                           pipeline.output_buffer_host, pipeline.decode_ptr_host,
+                                           pipeline.decode_ptr_device, pipeline.model_bboxes,
+                                           pipeline.cuda_post_process, img_batch, res_batch, cfg);
+        // Rerun the preprocessed batch so every layer has profile_iters samples per batch
+        for (int k = 1; !args.profile_prefix.empty() && k < args.profile_iters; k++) {
+            infer(context, pipeline.stream, (void**)pipeline.device_buffers, pipeline.output_buffer_host,
+                  img_batch.size(), pipeline.decode_ptr_host, pipeline.decode_ptr_device, pipeline.model_bboxes,
+                  pipeline.cuda_post_process, cfg);
         }
         // Draw bounding boxes
-        draw_bbox(img_batch, res_batch);
+        {
+            TRACE_SCOPE("draw_bbox");
+            for (size_t j = 0; j < img_batch.size(); j++) {
+                // get_rect undoes the letterbox against the size of the image it draws on
+                restore_original_size(decoded_batch[j], img_batch[j], nullptr);
+            }
+            draw_bbox(img_batch, res_batch, input_size.width, input_size.height);
+        }
         // Save images
         for (size_t j = 0; j < img_batch.size(); j++) {
+            TRACE_SCOPE("imwrite");
             cv::imwrite("_" + img_name_batch[j], img_batch[j]);
         }
     }
 
-    // Release stream and buffers
-    cudaStreamDestroy(stream);
-    CUDA_CHECK(cudaFree(device_buffers[0]));
-    CUDA_CHECK(cudaFree(device_buffers[1]));
-    CUDA_CHECK(cudaFree(decode_ptr_device));
-    delete[] decode_ptr_host;
-    delete[] output_buffer_host;
-    cuda_preprocess_destroy();
-    // Destroy the engine
-    delete context;
-    delete engine;
-    delete runtime;
-
-    // Print histogram of the output distribution
-    //std::cout << "\nOutput:\n\n";
-    //for (unsigned int i = 0; i < kOutputSize; i++)
-    //{
-    //    std::cout << prob[i] << ", ";
-    //    if (i % 10 == 0) std::cout << std::endl;
-    //}
-    //std::cout << std::endl;
-
+    if (batcher) {
+        batcher->flush();
+        write_cascade_frames(*batcher, file_names);
+        const CascadeStats& s = batcher->stats();
+        std::cout << "cascade: " << s.crops << " crops of " << s.frames << " frames in " << s.batches
+                  << " classifier batches, " << s.deadline_batches << " run at the wait limit" << std::endl;
+    }
+    if (!args.profile_prefix.empty()) {
+        profiler.table.report(args.profile_prefix);
+    }
+    if (pipeline.c2f) {
+        const CoarseToFineStats& s = pipeline.c2f->stats();
+        std::cout << "coarse-to-fine: " << s.rois << " regions over " << s.frames << " frames, " << s.uncovered
+                  << " of " << s.candidates << " candidates beyond the region budget" << std::endl;
+    }
+    if (args.motion.enabled) {
+        std::cout << "motion gate: " << reused_frames << " of " << file_names.size()
+                  << " frames reused the previous detections" << std::endl;
+    }
+    if (cache) {
+        ResultCacheStats s = cache->stats();
+        std::cout << "result cache: " << s.hits << " hits, " << s.misses << " misses, " << s.entries << " entries"
+                  << std::endl;
+        if (!cfg.cache_file.empty()) {
+            cache->save(cfg.cache_file);
+        }
+    }
     return 0;
 }
+
+int main(int argc, char** argv) {
+    RuntimeConfig cfg;
+    DetArgs args;
+    if (!parse_option_args(argc, argv, args, cfg)) {
+        return -1;
+    }
+    if (!cfg.trace.empty()) {
+#if !defined(ENABLE_TRACE)
+        std::cerr << "built without -DYOLOV8_TRACE=ON, the trace will be empty" << std::endl;
+#endif
+        trace_set_thread_name("main");
+        trace_enable(true);
+    }
+    if (args.bench.mock) {
+        int ret = run_mock_bench(args.bench, cfg);
+        write_trace(cfg);
+        return ret;
+    }
+    cudaSetDevice(cfg.gpu_id);
+    if (!parse_args(argc, argv, args)) {
+        print_usage();
+        return -1;
+    }
+    if (cfg.verbose < 0) {
+        // a line per batch floods the log of a server under load
+        cfg.verbose = args.socket_path.empty() && args.ring_name.empty() && !args.bench.enabled;
+    }
+    if (!args.wts_name.empty()) {
+        return run_serialize(args, cfg);
+    }
+
+    DetPipeline pipeline(cfg);
+    if (!pipeline.load(args)) {
+        return -1;
+    }
+    int ret = 0;
+    if (!args.socket_path.empty()) {
+        ret = run_server(pipeline, args);
+    } else if (!args.ring_name.empty()) {
+        ret = run_shm_consumer(args.ring_name, args.ring_slots, *pipeline.context, pipeline.stream,
+                               pipeline.device_buffers, pipeline.output_buffer_host, pipeline.model_bboxes, cfg);
+    } else if (!args.video_path.empty()) {
+        MotionGate gate(args.motion);
+        ret = run_tracker(args.video_path, args.track_interval, args.motion.enabled ? &gate : nullptr,
+                          pipeline.detect_fn());
+    } else if (args.bench.enabled) {
+        ret = run_detect_bench(args.bench, *pipeline.context, pipeline.stream, pipeline.device_buffers,
+                               pipeline.output_buffer_host, pipeline.decode_ptr_host, pipeline.decode_ptr_device,
+                               pipeline.model_bboxes, pipeline.cuda_post_process, cfg);
+    } else {
+        ret = run_images(pipeline, args);
+    }
+    write_trace(cfg);
+    return ret;
+}
@@ -0,0 +1,260 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bn_fold.h"
+
+// Host-side cost report of the BatchNorm folding done by convBnSiLU, yolov8_tests checks the folded values.
+//   ./yolov8_fold_bench [model.wts]
+// Reports, for the convolutions of model.wts, or of yolov8x built from the topology of buildEngineYolov8Det if none is
+// given, the layers the builder no longer gets and the host memory and time of the BatchNorm handling:
+//   - addBatchNorm2d: an IScaleLayer per BatchNorm, with scale, shift and power arrays that were never freed, and
+//     the weight map copied for every layer, since the block builders took it by value;
+//   - fold into copies: the first version of foldBatchNorm2d, which wrote folded copies of the conv weights;
+//   - fold in place: foldBatchNorm2d now, which scales the conv weights in place and only adds the bias.
+// TensorRT build time needs a GPU host and is not measured here.
+
+// A conv of the weight file, with or without a BatchNorm2d after it
+struct Conv {
+    std::string name;
+    int64_t weight_count;
+    int channels;  // output channels of a conv with BatchNorm, 0 without
+};
+
+static int get_width(int x, float gw, int max_channels) {
+    int channel = int(ceil((x * gw) / 8)) * 8;
+    return channel >= max_channels ? max_channels : channel;
+}
+
+static int get_depth(int x, float gd) {
+    if (x == 1)
+        return 1;
+    int r = round(x * gd);
+    if (x * gd - int(x * gd) == 0.5 && (int(x * gd) % 2) == 0)
+        --r;
+    return std::max<int>(r, 1);
+}
+
+// The convolutions buildEngineYolov8Det creates for gd, gw and max_channels
+static std::vector<Conv> yolov8_det_convs(float gd, float gw, int max_channels, int num_class) {
+    std::vector<Conv> convs;
+    auto conv = [&](const std::string& name, int c_in, int c_out, int k) {
+        convs.push_back(Conv{name, (int64_t)c_out * c_in * k * k, c_out});
+    };
+    auto c2f = [&](const std::string& name, int c1, int c2, int n) {
+        int c = c2 / 2;
+        conv(name + ".cv1", c1, 2 * c, 1);
+        for (int i = 0; i < n; i++) {
+            conv(name + ".m." + std::to_string(i) + ".cv1", c, c, 3);
+            conv(name + ".m." + std::to_string(i) + ".cv2", c, c, 3);
+        }
+        conv(name + ".cv2", (2 + n) * c, c2, 1);
+    };
+    auto w = [&](int x) { return get_width(x, gw, max_channels); };
+    conv("model.0", 3, w(64), 3);
+    conv("model.1", w(64), w(128), 3);
+    c2f("model.2", w(128), w(128), get_depth(3, gd));
+    conv("model.3", w(128), w(256), 3);
+    c2f("model.4", w(256), w(256), get_depth(6, gd));
+    conv("model.5", w(256), w(512), 3);
+    c2f("model.6", w(512), w(512), get_depth(6, gd));
+    conv("model.7", w(512), w(1024), 3);
+    c2f("model.8", w(1024), w(1024), get_depth(3, gd));
+    conv("model.9.cv1", w(1024), w(1024) / 2, 1);
+    conv("model.9.cv2", w(1024) / 2 * 4, w(1024), 1);
+    c2f("model.12", w(1024) + w(512), w(512), get_depth(3, gd));
+    c2f("model.15", w(512) + w(256), w(256), get_depth(3, gd));
+    conv("model.16", w(256), w(256), 3);
+    c2f("model.18", w(256) + w(512), w(512), get_depth(3, gd));
+    conv("model.19", w(512), w(512), 3);
+    c2f("model.21", w(512) + w(1024), w(1024), get_depth(3, gd));
+    int base_in = gw == 1.25f ? 80 : 64;
+    int base_out = gw == 0.25f ? std::max(64, std::min(num_class, 100)) : w(256);
+    const int levels[] = {w(256), w(512), w(1024)};
+    for (int i = 0; i < 3; i++) {
+        std::string head = "model.22.cv2." + std::to_string(i);
+        conv(head + ".0", levels[i], base_in, 3);
+        conv(head + ".1", base_in, base_in, 3);
+        convs.push_back(Conv{head + ".2", (int64_t)64 * base_in + 64, 0});
+        head = "model.22.cv3." + std::to_string(i);
+        conv(head + ".0", levels[i], base_out, 3);
+        conv(head + ".1", base_out, base_out, 3);
+        convs.push_back(Conv{head + ".2", (int64_t)num_class * base_out + num_class, 0});
+    }
+    convs.push_back(Conv{"model.22.dfl", 16, 0});
+    return convs;
+}
+
+// The convolutions of a .wts file, from the names and sizes of its entries
+static bool wts_convs(const std::string& path, std::vector<Conv>& convs) {
+    std::ifstream input(path);
+    int count = 0;
+    if (!(input >> count)) {
+        return false;
+    }
+    std::map<std::string, int64_t> sizes;
+    std::string line;
+    std::getline(input, line);
+    while (count-- > 0 && std::getline(input, line)) {
+        std::istringstream iss(line);
+        std::string name, type;
+        int64_t size = 0;
+        iss >> name >> type;
+        if (type == "shape") {
+            iss >> type >> type;  // skip the dims of the shape tag
+        }
+        if (type == "fp16" || type == "int8") {
+            iss >> size;
+        } else {
+            size = atoll(type.c_str());
+        }
+        sizes[name] = size;
+    }
+    for (const auto& entry : sizes) {
+        const std::string& name = entry.first;
+        const std::string suffix = ".conv.weight";
+        if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            std::string lname = name.substr(0, name.size() - suffix.size());
+            auto var = sizes.find(lname + ".bn.running_var");
+            convs.push_back(Conv{lname, entry.second, var == sizes.end() ? 0 : (int)var->second});
+        }
+    }
+    return !convs.empty();
+}
+
+// nvinfer1::Weights without TensorRT
+struct Weights {
+    int type;
+    const void* values;
+    int64_t count;
+};
+
+// addBatchNorm2d as the block builders called it, with the weight map taken by value
+static void add_batchnorm_by_value(std::map<std::string, Weights> weightMap, const std::string& lname, float eps,
+                                   int64_t& leaked) {
+    const float* gamma = (const float*)weightMap[lname + ".weight"].values;
+    const float* beta = (const float*)weightMap[lname + ".bias"].values;
+    const float* mean = (const float*)weightMap[lname + ".running_mean"].values;
+    const float* var = (const float*)weightMap[lname + ".running_var"].values;
+    int len = weightMap[lname + ".running_var"].count;
+    float* scval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
+    float* shval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
+    float* pval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
+    for (int i = 0; i < len; i++) {
+        scval[i] = gamma[i] / sqrt(var[i] + eps);
+        shval[i] = beta[i] - mean[i] * gamma[i] / sqrt(var[i] + eps);
+        pval[i] = 1.0;
+    }
+    weightMap[lname + ".scale"] = Weights{0, scval, len};
+    weightMap[lname + ".shift"] = Weights{0, shval, len};
+    weightMap[lname + ".power"] = Weights{0, pval, len};
+    leaked += 3 * sizeof(float) * len;
+    // the arrays went out of scope with the copy of the map; freed here only to keep the benchmark repeatable
+    free(scval);
+    free(shval);
+    free(pval);
+}
+
+static void report(const std::vector<Conv>& convs, const char* model) {
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> uniform(0.5f, 1.5f);
+    std::map<std::string, std::vector<float>> storage;
+    std::map<std::string, Weights> weightMap;
+    auto add = [&](const std::string& name, int64_t count) {
+        std::vector<float>& v = storage[name];
+        v.resize(count);
+        for (auto& x : v) x = uniform(rng);
+        weightMap[name] = Weights{0, v.data(), count};
+    };
+    int64_t weights = 0, bn_convs = 0, bn_channels = 0, folded_weights = 0;
+    for (const auto& c : convs) {
+        weights += c.weight_count;
+        if (c.channels == 0) {
+            add(c.name + ".weight", c.weight_count);
+            continue;
+        }
+        add(c.name + ".conv.weight", c.weight_count);
+        for (const char* p : {".bn.weight", ".bn.bias", ".bn.running_mean", ".bn.running_var"}) {
+            add(c.name + p, c.channels);
+        }
+        weights += 4 * c.channels;
+        bn_convs++;
+        bn_channels += c.channels;
+        folded_weights += c.weight_count;
+    }
+
+    auto time_ms = [](const std::chrono::steady_clock::time_point& t0) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    };
+    int64_t leaked = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (const auto& c : convs) {
+        if (c.channels) {
+            add_batchnorm_by_value(weightMap, c.name + ".bn", 1e-3f, leaked);
+        }
+    }
+    double by_value_ms = time_ms(t0);
+
+    std::vector<float> copies(folded_weights), bias(bn_channels);
+    t0 = std::chrono::steady_clock::now();
+    int64_t offset = 0, bias_offset = 0;
+    for (const auto& c : convs) {
+        if (c.channels) {
+            std::copy(storage[c.name + ".conv.weight"].begin(), storage[c.name + ".conv.weight"].end(),
+                      copies.begin() + offset);
+            fold_batchnorm(copies.data() + offset, c.weight_count, storage[c.name + ".bn.weight"].data(),
+                           storage[c.name + ".bn.bias"].data(), storage[c.name + ".bn.running_mean"].data(),
+                           storage[c.name + ".bn.running_var"].data(), c.channels, 1e-3f, bias.data() + bias_offset);
+            offset += c.weight_count;
+            bias_offset += c.channels;
+        }
+    }
+    double copies_ms = time_ms(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    bias_offset = 0;
+    for (const auto& c : convs) {
+        if (c.channels) {
+            std::vector<float>& weight = storage[c.name + ".conv.weight"];
+            fold_batchnorm(weight.data(), c.weight_count, storage[c.name + ".bn.weight"].data(),
+                           storage[c.name + ".bn.bias"].data(), storage[c.name + ".bn.running_mean"].data(),
+                           storage[c.name + ".bn.running_var"].data(), c.channels, 1e-3f, bias.data() + bias_offset);
+            bias_offset += c.channels;
+        }
+    }
+    double in_place_ms = time_ms(t0);
+
+    printf("%s: %.2fM weights, %lld convolutions, %lld of them with a BatchNorm2d\n", model, weights / 1e6,
+           (long long)convs.size(), (long long)bn_convs);
+    printf("  %-16s %20s %28s %10s\n", "", "conv + scale layers", "host memory beyond weights", "host time");
+    printf("  %-16s %20lld %25.2f MB %7.1f ms  (map copied %lld times, %lld entries each)\n", "addBatchNorm2d",
+           (long long)(convs.size() + bn_convs), leaked / 1e6, by_value_ms, (long long)bn_convs,
+           (long long)weightMap.size());
+    printf("  %-16s %20lld %25.2f MB %7.1f ms\n", "fold into copies", (long long)convs.size(),
+           (folded_weights + bn_channels) * sizeof(float) / 1e6, copies_ms);
+    printf("  %-16s %20lld %25.2f MB %7.1f ms\n", "fold in place", (long long)convs.size(),
+           bn_channels * sizeof(float) / 1e6, in_place_ms);
+}
+
+int main(int argc, char** argv) {
+    std::vector<Conv> convs;
+    if (argc > 1) {
+        if (!wts_convs(argv[1], convs)) {
+            std::cerr << "no convolutions in " << argv[1] << std::endl;
+            return 1;
+        }
+        report(convs, argv[1]);
+    } else {
+        report(yolov8_det_convs(1.0, 1.25, 640, 80), "yolov8x");
+    }
+    return 0;
+}
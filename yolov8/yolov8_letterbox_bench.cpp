@@ -0,0 +1,38 @@
+#include <math.h>
+#include <cstdio>
+#include <cstdlib>
+#include "letterbox.h"
+
+// Padding cost model of the rect letterbox of dynamic-shape engines, yolov8_tests checks the shapes.
+//   ./yolov8_letterbox_bench [max_w] [max_h]
+// Reports, for the aspect ratios of our cameras, phones and datasets, the padding of the fixed max_w x max_h input
+// against the rect shape, and the share of input pixels, roughly of the backbone's compute, that the rect shape saves.
+// 640x640 by default.
+
+int main(int argc, char** argv) {
+    int max_w = argc > 1 ? atoi(argv[1]) : 640;
+    int max_h = argc > 2 ? atoi(argv[2]) : 640;
+    struct Source {
+        const char* name;
+        int w;
+        int h;
+    };
+    const Source sources[] = {{"720p camera", 1280, 720},      {"1080p camera", 1920, 1080},
+                              {"4K camera", 3840, 2160},       {"VGA", 640, 480},
+                              {"phone 4:3", 4032, 3024},       {"phone portrait", 1080, 1920},
+                              {"COCO typical", 640, 427},      {"ultrawide 21:9", 2560, 1080},
+                              {"square", 1024, 1024}};
+    printf("\n%-16s %-10s %-15s %-10s %-15s %s\n", "source", "image", "fixed padding%", "rect", "rect padding%",
+           "pixels saved%");
+    for (const Source& s : sources) {
+        LetterboxShape rect = rect_letterbox_shape(s.w, s.h, max_w, max_h);
+        float saved = 1.f - (float)rect.w * rect.h / ((float)max_w * max_h);
+        char image[16], shape[16];
+        snprintf(image, sizeof(image), "%dx%d", s.w, s.h);
+        snprintf(shape, sizeof(shape), "%dx%d", rect.w, rect.h);
+        printf("%-16s %-10s %-15.2f %-10s %-15.2f %.2f\n", s.name, image,
+               100.f * letterbox_padding_ratio(s.w, s.h, max_w, max_h), shape,
+               100.f * letterbox_padding_ratio(s.w, s.h, rect.w, rect.h), 100.f * saved);
+    }
+    return 0;
+}
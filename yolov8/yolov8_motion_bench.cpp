@@ -0,0 +1,30 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "motion_gate.h"
+#include "tests/motion_fixture.h"
+
+// Benchmark of the motion gate on a synthetic fixed-camera frame, yolov8_tests checks when it runs the detector.
+//   ./yolov8_motion_bench [width] [height]
+// Prints the gate cost per frame for each sample step.
+
+int main(int argc, char** argv) {
+    int width = argc > 1 ? atoi(argv[1]) : 1920;
+    int height = argc > 2 ? atoi(argv[2]) : 1080;
+    Sequence seq(width, height);
+    const cv::Mat& frame = seq.render(6, 0, 0, 0);
+    for (int step : {1, 2, 4}) {
+        MotionGateOptions opts;
+        opts.sample_step = step;
+        MotionGate gate(opts);
+        gate.check(frame);
+        const int iters = 200;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iters; i++) {
+            gate.check(frame);
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iters;
+        printf("%dx%d, sample step %d: %.1f us per frame\n", width, height, step, us);
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+#include "nv12_preprocess.h"
+#include "tests/preprocess_fixture.h"
+#include "uint8_input.h"
+#include "utils.h"
+
+// Benchmark of the NV12 letterbox, yolov8_tests checks it against the reference and cvtColor + warpaffine_kernel.
+//   ./yolov8_nv12_bench [width] [height] [iterations]
+// Times the CPU ways from an NV12 frame to the float engine input: cvtColor + preprocess_img + HWC to CHW / 255, the
+// scalar reference, and nv12_letterbox.
+
+int main(int argc, char** argv) {
+    // the cvtColor path takes even sizes only
+    int width = (argc > 1 ? atoi(argv[1]) : 1920) & ~1;
+    int height = (argc > 2 ? atoi(argv[2]) : 1080) & ~1;
+    int iterations = argc > 3 ? atoi(argv[3]) : 50;
+    const int w = 640, h = 640;
+    std::mt19937 rng(8);
+    cv::Mat nv12 = make_nv12(width, height, width, rng);
+    const uint8_t* y_plane = nv12.ptr<uint8_t>(0);
+    const uint8_t* uv_plane = nv12.ptr<uint8_t>(height);
+    std::vector<float> input(3 * w * h);
+    auto time = [&](const char* name, const std::function<void()>& fn) {
+        fn();
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            fn();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        printf("%dx%d NV12 -> %dx%d %-36s %.2f ms per frame\n", width, height, w, h, name,
+               std::chrono::duration<double, std::milli>(t1 - t0).count() / iterations);
+    };
+    cv::Mat bgr;
+    time("cvtColor + preprocess_img + CHW:", [&]() {
+        cv::cvtColor(nv12, bgr, cv::COLOR_YUV2BGR_NV12);
+        to_chw(preprocess_img(bgr, w, h), input.data());
+    });
+    time("nv12_letterbox_reference:",
+         [&]() { nv12_letterbox_reference(y_plane, uv_plane, width, height, width, input.data(), w, h); });
+    time("nv12_letterbox:", [&]() { nv12_letterbox(y_plane, uv_plane, width, height, width, input.data(), w, h); });
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include "preprocess_cache.h"
+#include "tests/prep_fixture.h"
+
+// Benchmark of preprocessing shared by several models on one frame, yolov8_tests checks the shared tensors.
+//   ./yolov8_prep_bench [width] [height] [iterations]
+// Times yolop, a yolov8 detector and a classifier on the same frame, each preprocessing on its own against sharing one
+// cache, and the same with a second yolov8 model (pose) of the detector's input.
+
+// ms per frame to preprocess specs, with one cache for all models or one per model
+static double time_models(const std::vector<InputSpec>& specs, bool shared, const cv::Mat& frame, int iterations) {
+    std::vector<std::unique_ptr<PreprocessCache>> caches(shared ? 1 : specs.size());
+    std::vector<int> models;
+    for (size_t m = 0; m < specs.size(); m++) {
+        auto& cache = caches[shared ? 0 : m];
+        if (!cache) {
+            cache.reset(new PreprocessCache());
+        }
+        models.push_back(cache->add_model(specs[m]));
+    }
+    double ms = 0;
+    for (int it = -1; it < iterations; it++) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (auto& cache : caches) {
+            cache->set_frame(frame);
+        }
+        for (size_t m = 0; m < specs.size(); m++) {
+            caches[shared ? 0 : m]->input(models[m]);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        ms += it < 0 ? 0 : std::chrono::duration<double, std::milli>(t1 - t0).count();
+    }
+    return ms / iterations;
+}
+
+int main(int argc, char** argv) {
+    int w = argc > 1 ? atoi(argv[1]) : 1920;
+    int h = argc > 2 ? atoi(argv[2]) : 1080;
+    int iterations = argc > 3 ? atoi(argv[3]) : 20;
+    cv::Mat frame(h, w, CV_8UC3);
+    make_pattern_frame(frame, 0);
+    std::vector<InputSpec> three = {yolop_spec(), yolov8_spec(), cls_spec()};
+    std::vector<InputSpec> four = {yolop_spec(), yolov8_spec(), yolov8_spec(), cls_spec()};
+    for (const auto* specs : {&three, &four}) {
+        double separate = time_models(*specs, false, frame, iterations);
+        double shared = time_models(*specs, true, frame, iterations);
+        printf("%dx%d, %zu models (yolop, yolov8%s, cls): separate %.2f ms, shared %.2f ms per frame, %.0f%% saved\n",
+               w, h, specs->size(), specs->size() == 4 ? " det and pose" : "", separate, shared,
+               100 * (1 - shared / separate));
+    }
+    return 0;
+}
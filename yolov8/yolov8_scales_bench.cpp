@@ -0,0 +1,35 @@
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include "int8_scales.h"
+
+// Benchmark of the int8 scales file read by the builders in place of calibration, yolov8_tests checks the parser.
+//   ./yolov8_scales_bench [entries]
+// Times reading a calibration table of that many entries.
+
+static std::string write_file(const std::string& text) {
+    std::string path = "/tmp/yolov8_scales_bench_" + std::to_string(getpid()) + ".txt";
+    std::ofstream(path) << text;
+    return path;
+}
+
+int main(int argc, char** argv) {
+    int entries = argc > 1 ? atoi(argv[1]) : 1000;
+    std::string text = "TRT-8401-EntropyCalibration2\n";
+    for (int i = 0; i < entries; i++) {
+        text += "(Unnamed Layer* " + std::to_string(i) + ") [Convolution]_output: 3c010a14\n";
+    }
+    std::string path = write_file(text);
+    std::map<std::string, float> scales;
+    std::string error;
+    auto t0 = std::chrono::steady_clock::now();
+    readInt8Scales(path, scales, error);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    unlink(path.c_str());
+    printf("read a calibration table of %zu entries in %.2f ms\n", scales.size(), ms);
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include <unistd.h>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include "batch_scheduler.h"
+#include "inference_server.h"
+#include "latency_stats.h"
+
+// Load generator for the yolov8_det inference server.
+//   -m: in-process, the scheduler drives a mock engine on the CPU whose batch costs base_ms + n * per_image_ms.
+//       Requests arrive open-loop (Poisson) at rate per second, so the coalescing can be checked without a GPU.
+//   -c: closed-loop, clients each send requests one after another to a running "yolov8_det -serve" socket.
+// yolov8_tests checks the request limits of the server.
+
+static void print_report(std::vector<double>& latencies_ms, double seconds) {
+    std::cout << "requests: " << latencies_ms.size() << ", throughput: " << latencies_ms.size() / seconds << " img/s"
+              << std::endl;
+    std::cout << "latency p50: " << latency_percentile(latencies_ms, 50) << "ms, p99: "
+              << latency_percentile(latencies_ms, 99) << "ms, max: " << latency_percentile(latencies_ms, 100) << "ms"
+              << std::endl;
+}
+
+static int run_mock(double rate, double seconds, int max_batch, double base_ms, double per_image_ms,
+                    int deadline_ms) {
+    BatchSchedulerOptions opts;
+    opts.max_batch = max_batch;
+    BatchScheduler scheduler(opts, [&](std::vector<std::shared_ptr<InferJob>>& batch) {
+        std::this_thread::sleep_for(
+                std::chrono::microseconds((int64_t)((base_ms + per_image_ms * batch.size()) * 1000)));
+    });
+
+    std::mt19937 rng(0);
+    std::exponential_distribution<double> interarrival(rate);
+    std::vector<std::shared_ptr<InferJob>> jobs;
+    std::vector<std::future<void>> futures;
+    auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    auto end = start + std::chrono::microseconds((int64_t)(seconds * 1e6));
+    while (next < end) {
+        std::this_thread::sleep_until(next);
+        auto job = std::make_shared<InferJob>();
+        job->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(deadline_ms);
+        futures.push_back(scheduler.submit(job));
+        jobs.push_back(job);
+        next += std::chrono::microseconds((int64_t)(interarrival(rng) * 1e6));
+    }
+    for (auto& future : futures) {
+        future.wait();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    scheduler.stop();
+
+    std::vector<double> latencies_ms;
+    for (auto& job : jobs) {
+        latencies_ms.push_back(std::chrono::duration<double, std::milli>(job->finish - job->arrival).count());
+    }
+    BatchSchedulerStats stats = scheduler.stats();
+    print_report(latencies_ms, elapsed);
+    double mean_batch = (double)stats.jobs / std::max<uint64_t>(1, stats.batches);
+    std::cout << "batches: " << stats.batches << ", mean batch: " << mean_batch << ", deadline misses: "
+              << stats.deadline_misses << ", final window: " << stats.window_us << "us" << std::endl;
+    return 0;
+}
+
+static int run_client(const std::string& socket_path, const std::string& image_path, int clients, int requests,
+                      int deadline_ms) {
+    std::ifstream file(image_path, std::ios::binary);
+    if (!file.good()) {
+        std::cerr << "read " << image_path << " error!" << std::endl;
+        return -1;
+    }
+    std::vector<uint8_t> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<std::vector<double>> latencies(clients);
+    std::atomic<int> failures(0);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < clients; c++) {
+        threads.emplace_back([&, c] {
+            int fd = connect_inference_server(socket_path);
+            if (fd < 0) {
+                failures++;
+                return;
+            }
+            std::vector<ServerDetection> dets;
+            for (int i = 0; i < requests; i++) {
+                auto t0 = std::chrono::steady_clock::now();
+                if (!send_inference_request(fd, image, deadline_ms) || !read_inference_response(fd, dets)) {
+                    failures++;
+                    break;
+                }
+                auto t1 = std::chrono::steady_clock::now();
+                latencies[c].push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+            }
+            close(fd);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for (auto& l : latencies) {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    print_report(all, elapsed);
+    if (failures > 0) {
+        std::cerr << failures << " clients failed" << std::endl;
+    }
+    return failures > 0 ? -1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 7 && std::string(argv[1]) == "-m") {
+        int deadline_ms = argc >= 8 ? atoi(argv[7]) : 100;
+        return run_mock(atof(argv[2]), atof(argv[3]), atoi(argv[4]), atof(argv[5]), atof(argv[6]), deadline_ms);
+    } else if (argc >= 6 && std::string(argv[1]) == "-c") {
+        int deadline_ms = argc >= 7 ? atoi(argv[6]) : 0;
+        return run_client(argv[2], argv[3], atoi(argv[4]), atoi(argv[5]), deadline_ms);
+    }
+    std::cerr << "./yolov8_server_bench -m [rate/s] [seconds] [max batch] [base ms] [per image ms] [deadline ms]"
+                 "  // mock engine on the cpu"
+              << std::endl;
+    std::cerr << "./yolov8_server_bench -c [socket] [image] [clients] [requests per client] [deadline ms]"
+                 "  // against yolov8_det -serve"
+              << std::endl;
+    return -1;
+}
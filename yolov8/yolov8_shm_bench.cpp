@@ -0,0 +1,126 @@
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "frame_ring.h"
+#include "latency_stats.h"
+
+// CPU benchmark of the shared-memory frame transport: forked producer processes write BGR frames into the ring,
+// this process consumes them in place (reading every cache line, as preprocessing would) and reports throughput and
+// capture-to-consume latency. yolov8_tests checks the frame layout and check_frame_info.
+
+static uint64_t monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void run_producer(const std::string& name, int id, int frames, int width, int height, int fps) {
+    FrameRing ring;
+    if (!ring.open(name)) {
+        _exit(1);
+    }
+    uint64_t interval_ns = fps > 0 ? 1000000000ull / fps : 0;
+    uint64_t next = monotonic_ns();
+    for (int i = 0; i < frames; i++) {
+        if (interval_ns > 0) {
+            while (monotonic_ns() < next) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            next += interval_ns;
+        }
+        FrameSlot* slot = ring.begin_write();
+        if (slot == nullptr) {
+            continue;  // ring full, the frame is dropped like a live camera would
+        }
+        // stands in for the decoder writing straight into the slot
+        memset(slot->data(), (id * 31 + i) & 0xff, (size_t)width * height * 3);
+        slot->info.format = FrameFormat::kBGR;
+        slot->info.width = width;
+        slot->info.height = height;
+        slot->info.stride = width * 3;
+        slot->info.source_id = id;
+        slot->info.frame_id = i;
+        slot->info.size = (size_t)width * height * 3;
+        slot->info.timestamp_ns = monotonic_ns();
+        ring.end_write(slot);
+    }
+    _exit(0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 6) {
+        std::cerr << "./yolov8_shm_bench [producers] [frames per producer] [width] [height] [slots] [fps, 0 = max]"
+                  << std::endl;
+        return -1;
+    }
+    int producers = atoi(argv[1]);
+    int frames = atoi(argv[2]);
+    int width = atoi(argv[3]);
+    int height = atoi(argv[4]);
+    int slots = atoi(argv[5]);
+    int fps = argc >= 7 ? atoi(argv[6]) : 0;
+
+    std::string name = "yolov8_shm_bench_" + std::to_string(getpid());
+    FrameRing ring;
+    if (!ring.create(name, slots, (size_t)width * height * 3)) {
+        return -1;
+    }
+    std::vector<pid_t> children;
+    for (int p = 0; p < producers; p++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            run_producer(name, p, frames, width, height, fps);
+        }
+        children.push_back(pid);
+    }
+
+    std::vector<double> latencies_ms;
+    uint64_t bytes = 0;
+    uint64_t checksum = 0;
+    uint64_t corrupted = 0;
+    uint64_t start = monotonic_ns();
+    uint64_t last = start;
+    int running = producers;
+    while (true) {
+        FrameSlot* slot = ring.acquire(100);
+        if (slot == nullptr) {
+            while (running > 0 && waitpid(-1, nullptr, WNOHANG) > 0) {
+                running--;
+            }
+            if (running == 0) {
+                break;
+            }
+            continue;
+        }
+        std::string error;
+        if (!check_frame_info(slot->info, ring.slot_bytes(), (uint64_t)width * height, error) || slot->info.size == 0) {
+            corrupted++;
+            ring.release(slot);
+            continue;
+        }
+        const uint8_t* data = slot->data();
+        for (uint64_t i = 0; i < slot->info.size; i += 64) {
+            checksum += data[i];
+        }
+        uint8_t expected = (slot->info.source_id * 31 + slot->info.frame_id) & 0xff;
+        corrupted += data[0] != expected || data[slot->info.size - 1] != expected;
+        bytes += slot->info.size;
+        last = monotonic_ns();
+        latencies_ms.push_back((last - slot->info.timestamp_ns) / 1e6);
+        ring.release(slot);
+    }
+    double seconds = (last - start) / 1e9;
+
+    std::cout << "frames: " << latencies_ms.size() << ", dropped: " << ring.dropped() << ", corrupted: " << corrupted
+              << ", " << latencies_ms.size() / seconds << " fps, " << bytes / seconds / 1e9 << " GB/s (checksum "
+              << checksum << ")" << std::endl;
+    std::cout << "latency p50: " << latency_percentile(latencies_ms, 50) << "ms, p99: "
+              << latency_percentile(latencies_ms, 99) << "ms" << std::endl;
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "sparsity.h"
+#include "wts.h"
+
+// Applies 2:4 structured sparsity to the convolution weights of a yolov8 .wts file:
+// in every group of 4 consecutive input channels (per output channel and kernel position)
+// the 2 smallest magnitudes are zeroed, which is the pattern TensorRT's sparse kernels expect.
+// Only the fp32 ".conv.weight" tensors of convBnSiLU blocks are pruned, all other entries are copied unchanged.
+// The kernel size comes from the shape tag gen_wts.py writes; layers of .wts files without it whose layout is
+// ambiguous are skipped unless given on the command line.
+
+struct WtsEntry {
+    std::string name;
+    std::string line;  // original text, written back as is when the entry is not pruned
+    std::string type;  // fp32, fp16 or int8 as stored
+    std::vector<float> values;
+    std::vector<int> shape;
+};
+
+static bool read_wts(const std::string& file, std::vector<WtsEntry>& entries) {
+    std::ifstream input(file);
+    if (!input.is_open())
+        return false;
+    std::string line;
+    int count = 0;
+    if (!(input >> count) || !std::getline(input, line))
+        return false;
+    while (count > 0 && std::getline(input, line)) {
+        WtsEntry e;
+        e.line = line;
+        std::istringstream iss(line);
+        float* values = nullptr;
+        uint32_t size = 0;
+        if (!readWtsEntry(iss, e.name, e.type, values, size, &e.shape)) {
+            std::cerr << file << ": malformed entry " << line.substr(0, line.find(' '))
+                      << std::endl;
+            return false;
+        }
+        e.values.assign(values, values + size);
+        free(values);
+        entries.push_back(e);
+        count--;
+    }
+    return count == 0;
+}
+
+static uint32_t to_bits(float f) {
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "./yolov8_sparsify [input.wts] [output.wts] [layer=k ...]  // prune conv weights to 2:4 sparsity"
+                  << std::endl;
+        std::cerr << "kernel sizes come from the shape tags of gen_wts.py, pass layer=k for older .wts files, "
+                     "e.g. model.9.cv1=1"
+                  << std::endl;
+        return -1;
+    }
+    std::map<std::string, int> kernel_override;
+    for (int i = 3; i < argc; i++) {
+        std::string arg(argv[i]);
+        size_t pos = arg.find('=');
+        if (pos == std::string::npos) {
+            std::cerr << "bad override: " << arg << std::endl;
+            return -1;
+        }
+        kernel_override[arg.substr(0, pos)] = std::stoi(arg.substr(pos + 1));
+    }
+
+    std::vector<WtsEntry> entries;
+    if (!read_wts(argv[1], entries)) {
+        std::cerr << "read " << argv[1] << " error!" << std::endl;
+        return -1;
+    }
+    std::map<std::string, size_t> index;
+    for (size_t i = 0; i < entries.size(); i++) {
+        index[entries[i].name] = i;
+    }
+
+    const std::string suffix = ".conv.weight";
+    std::cout << std::left << std::setw(32) << "layer" << std::setw(20) << "shape" << std::setw(12) << "sparsity"
+              << std::setw(12) << "rel_error"
+              << "2:4" << std::endl;
+    int pruned_layers = 0;
+    bool all_valid = true;
+    for (auto& e : entries) {
+        if (e.name.size() <= suffix.size() || e.name.compare(e.name.size() - suffix.size(), suffix.size(), suffix) != 0)
+            continue;
+        std::string lname = e.name.substr(0, e.name.size() - suffix.size());
+        auto bn = index.find(lname + ".bn.running_var");
+        if (bn == index.end())
+            continue;
+        if (e.type != "fp32") {
+            std::cout << std::setw(32) << lname << "skipped, stored as " << e.type << std::endl;
+            continue;
+        }
+        int out = entries[bn->second].values.size();
+        int count = e.values.size();
+        int k = conv_kernel_size(e.shape, count, out);
+        if (kernel_override.count(lname))
+            k = kernel_override[lname];
+        if (k <= 0) {
+            std::cout << std::setw(32) << lname
+                      << "skipped, kernel size unknown, regenerate the .wts with gen_wts.py or pass " << lname << "=k"
+                      << std::endl;
+            continue;
+        }
+        int in = count / out / (k * k);
+        if (in * k * k * out != count || in % 4 != 0) {
+            std::cout << std::setw(32) << lname << "skipped, input channels not a multiple of 4" << std::endl;
+            continue;
+        }
+
+        PruneStats stats = prune_conv_2to4(e.values, out, in, k * k);
+        all_valid &= stats.valid;
+        std::ostringstream shape;
+        shape << out << "x" << in << "x" << k << "x" << k;
+        std::ostringstream line;
+        line << e.name << " shape " << shape.str() << " " << std::dec << e.values.size();
+        for (float v : e.values) {
+            line << " " << std::hex << std::setw(8) << std::setfill('0') << to_bits(v);
+        }
+        e.line = line.str();
+        pruned_layers++;
+
+        std::cout << std::setw(32) << lname << std::setw(20) << shape.str() << std::setw(12) << std::fixed
+                  << std::setprecision(3) << stats.sparsity << std::setw(12) << stats.rel_error
+                  << (stats.valid ? "ok" : "FAIL") << std::endl;
+    }
+
+    std::ofstream output(argv[2]);
+    if (!output) {
+        std::cerr << "could not open " << argv[2] << std::endl;
+        return -1;
+    }
+    output << entries.size() << "\n";
+    for (auto& e : entries) {
+        output << e.line << "\n";
+    }
+    std::cout << "pruned " << pruned_layers << " layers, written to " << argv[2] << std::endl;
+    return all_valid ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+#include <math.h>
+#include <stdlib.h>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "sparsity.h"
+#include "wts.h"
+
+// Benchmark of the 2:4 pruning of yolov8_sparsify, yolov8_tests checks the pattern it leaves.
+//   ./yolov8_sparsity_bench [out] [in] [k]
+// Times pruning one conv of that shape, 512x512x3x3 by default.
+
+static std::vector<float> random_weights(size_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> dist(0.f, 0.05f);
+    std::vector<float> w(n);
+    for (auto& v : w) {
+        v = dist(rng);
+    }
+    return w;
+}
+
+int main(int argc, char** argv) {
+    int out = argc > 1 ? atoi(argv[1]) : 512;
+    int in = argc > 2 ? atoi(argv[2]) : 512;
+    int k = argc > 3 ? atoi(argv[3]) : 3;
+    std::vector<float> w = random_weights((size_t)out * in * k * k, 4);
+    auto t0 = std::chrono::steady_clock::now();
+    PruneStats stats = prune_conv_2to4(w, out, in, k * k);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    printf("pruned %dx%dx%dx%d in %.2f ms, sparsity %.3f, rel_error %.3f, 2:4 %s\n", out, in, k, k, ms, stats.sparsity,
+           stats.rel_error, stats.valid ? "ok" : "FAIL");
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "tests/tile_fixture.h"
+#include "tiling.h"
+
+// Benchmark of sliced inference, yolov8_tests checks the tile plan, the box mapping and the merge.
+//   ./yolov8_tile_bench [candidates] [iterations]
+// Times planning, mapping and merging for a frame of 64 tiles with the given number of candidates.
+
+int main(int argc, char** argv) {
+    int candidates = argc > 1 ? atoi(argv[1]) : 5000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 100;
+
+    // 8 x 8 tiles of 640 with 20% overlap
+    const int frame = 640 + 7 * 512;
+    TileOptions opts;
+    opts.full_frame = false;
+    std::mt19937 rng(2);
+    std::vector<Tile> tiles = plan_tiles(frame, frame, 640, 640, opts);
+    std::vector<Detection> objects = make_objects(candidates / 2, frame, frame, rng);
+    std::vector<std::vector<Detection>> outputs = tile_outputs(tiles, objects, 0.2f, rng);
+    // trim to the requested number of candidates
+    size_t total = 0;
+    for (auto& out : outputs) {
+        out.resize(std::min(out.size(), (size_t)std::max(0, candidates - (int)total)));
+        total += out.size();
+    }
+    for (TileMerge merge : {TileMerge::kNms, TileMerge::kFusion}) {
+        double plan_us = 0, map_us = 0, merge_us = 0;
+        size_t kept = 0;
+        for (int it = 0; it < iterations; it++) {
+            auto t0 = std::chrono::steady_clock::now();
+            std::vector<Tile> plan = plan_tiles(frame, frame, 640, 640, opts);
+            auto t1 = std::chrono::steady_clock::now();
+            std::vector<Detection> dets;
+            dets.reserve(total);
+            for (size_t t = 0; t < plan.size(); t++) {
+                std::vector<Detection> out = outputs[t];
+                tile_to_frame(plan[t], out);
+                dets.insert(dets.end(), out.begin(), out.end());
+            }
+            auto t2 = std::chrono::steady_clock::now();
+            merge_tile_detections(dets, merge, 0.5f);
+            auto t3 = std::chrono::steady_clock::now();
+            plan_us += std::chrono::duration<double, std::micro>(t1 - t0).count();
+            map_us += std::chrono::duration<double, std::micro>(t2 - t1).count();
+            merge_us += std::chrono::duration<double, std::micro>(t3 - t2).count();
+            kept = dets.size();
+        }
+        printf("%dx%d, %zu tiles, %zu candidates, %-6s: plan %.1f us, map %.1f us, merge %.1f us, %zu boxes kept\n",
+               frame, frame, tiles.size(), total, merge == TileMerge::kNms ? "nms" : "fusion", plan_us / iterations,
+               map_us / iterations, merge_us / iterations, kept);
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include <cstdlib>
+#include <iostream>
+#include "trace.h"
+
+// Overhead of TRACE_SCOPE, yolov8_tests checks a round trip through the Chrome trace exporter.
+//   ./yolov8_trace_bench [spans]
+// Prints ns per span with tracing compiled out of the loop, disabled at runtime and enabled.
+
+// Opaque to the optimizer, so the loops are not folded away.
+static volatile int g_sink = 0;
+
+static double ns_per_iteration(int64_t start_ns, int64_t end_ns, int n) {
+    return (double)(end_ns - start_ns) / n;
+}
+
+static double time_loop(int n, bool traced) {
+    int64_t start = trace_now_ns();
+    for (int i = 0; i < n; i++) {
+        if (traced) {
+            TraceScope scope("span");
+            g_sink = i;
+        } else {
+            g_sink = i;
+        }
+    }
+    return ns_per_iteration(start, trace_now_ns(), n);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 10000000;
+
+    trace_set_thread_name("main");
+    double baseline = time_loop(n, false);
+    trace_enable(false);
+    double disabled = time_loop(n, true);
+    trace_enable(true);
+    double enabled = time_loop(n, true);
+    std::cout << "per span: untraced loop " << baseline << "ns, disabled " << disabled << "ns, enabled " << enabled
+              << "ns, overhead " << enabled - baseline << "ns" << std::endl;
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "tests/tracker_fixture.h"
+#include "tracker.h"
+
+// Benchmark of the tracker, yolov8_tests checks ID switches, allocations and the Hungarian matcher.
+//   ./yolov8_tracker_bench [objects] [frames]
+// Times update() and predict() on a 4K scene of 500 objects by default, greedy and Hungarian.
+
+int main(int argc, char** argv) {
+    int num_objects = argc > 1 ? atoi(argv[1]) : 500;
+    int frames = argc > 2 ? atoi(argv[2]) : 300;
+
+    Scene crowd = make_scene(num_objects, std::max(frames, 51), 3840, 2160, 2);
+    for (bool hungarian : {false, true}) {
+        TrackerOptions opts;
+        opts.hungarian = hungarian;
+        ByteTracker tracker(opts);
+        for (int f = 0; f < 50; f++) {
+            tracker.update(crowd.detections[f]);
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (size_t f = 50; f < crowd.detections.size(); f++) {
+            tracker.update(crowd.detections[f]);
+        }
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto pstart = std::chrono::steady_clock::now();
+        for (int f = 0; f < 250; f++) {
+            tracker.predict();
+        }
+        double ps = std::chrono::duration<double>(std::chrono::steady_clock::now() - pstart).count();
+        printf("%d objects, %-9s: %zu tracks, update %.1f us, predict %.1f us\n", num_objects,
+               hungarian ? "hungarian" : "greedy", tracker.tracks().size(), s * 1e6 / (crowd.detections.size() - 50),
+               ps * 1e6 / 250);
+    }
+    return 0;
+}
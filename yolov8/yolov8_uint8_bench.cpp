@@ -0,0 +1,34 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "tests/preprocess_fixture.h"
+#include "uint8_input.h"
+
+// Benchmark of the uint8 input mode, yolov8_tests checks it against warpaffine_kernel.
+//   ./yolov8_uint8_bench [width] [height] [iterations]
+// Times letterbox_uint8 and compares the bytes each mode copies to the GPU per frame.
+
+int main(int argc, char** argv) {
+    int w = argc > 1 ? atoi(argv[1]) : 1920;
+    int h = argc > 2 ? atoi(argv[2]) : 1080;
+    int iterations = argc > 3 ? atoi(argv[3]) : 50;
+    const int input_w = 640, input_h = 640;
+    std::mt19937 rng(4);
+    cv::Mat img(h, w, CV_8UC3);
+    make_gradient_frame(img, rng);
+    std::vector<uint8_t> bytes(3 * input_w * input_h);
+    letterbox_uint8(img, bytes.data(), input_w, input_h);
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        letterbox_uint8(img, bytes.data(), input_w, input_h);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    printf("%dx%d -> %dx%d letterbox_uint8: %.2f ms per frame\n", w, h, input_w, input_h,
+           std::chrono::duration<double, std::milli>(t1 - t0).count() / iterations);
+    printf("bytes copied to the GPU per frame: frame for warpaffine_kernel %.2f MB, float CHW input %.2f MB, "
+           "uint8 input %.2f MB\n",
+           w * h * 3 / 1e6, input_w * input_h * 3 * sizeof(float) / 1e6, input_w * input_h * 3 / 1e6);
+    return 0;
+}
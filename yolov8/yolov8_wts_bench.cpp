@@ -0,0 +1,49 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "tests/wts_fixture.h"
+#include "wts.h"
+
+// Load benchmark of the fp32, fp16 and int8 entries of .wts files, yolov8_tests checks their values.
+//   ./yolov8_wts_bench [million values]
+// Compares the size and load time of a model of that many conv weights in each format.
+
+int main(int argc, char** argv) {
+    double millions = argc > 1 ? atof(argv[1]) : 3.2;  // about yolov8n
+    std::mt19937 rng(10);
+    std::normal_distribution<float> normal(0.f, 0.05f);
+    const int out = 128, per_channel = 128 * 9;
+    std::vector<float> w(out * per_channel);
+    for (auto& x : w) x = normal(rng);
+    int tensors = std::max(1, (int)(millions * 1e6 / w.size()));
+    for (const char* precision : {"fp32", "fp16", "int8"}) {
+        std::ostringstream file;
+        file << tensors << "\n";
+        for (int t = 0; t < tensors; t++) {
+            write_entry(file, "model." + std::to_string(t) + ".conv.weight", w, out, precision);
+        }
+        std::string text = file.str();
+        auto t0 = std::chrono::steady_clock::now();
+        std::istringstream input(text);
+        int count = 0;
+        input >> count;
+        std::string name, type;
+        float* values = nullptr;
+        uint32_t size = 0;
+        while (count-- > 0 && readWtsEntry(input, name, type, values, size)) {
+            free(values);
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        printf("%s: %.2fM values, %7.2f MB, loaded in %7.1f ms, %6.1f M values/s\n", precision,
+               tensors * w.size() / 1e6, text.size() / 1e6, ms, tensors * w.size() / 1e3 / ms);
+    }
+    return 0;
+}
@@ -75,70 +75,66 @@ int get_depth(int x, float gd) {
     }
     return std::max<int>(r, 1);
 }
-static nvinfer1::IScaleLayer* addBatchNorm2d(nvinfer1::INetworkDefinition* network,
-                                             std::map<std::string, nvinfer1::Weights> weightMap,
-                                             nvinfer1::ITensor& input, std::string lname, float eps) {
-    float* gamma = (float*)weightMap[lname + ".weight"].values;
-    float* beta = (float*)weightMap[lname + ".bias"].values;
-    float* mean = (float*)weightMap[lname + ".running_mean"].values;
-    float* var = (float*)weightMap[lname + ".running_var"].values;
-    int len = weightMap[lname + ".running_var"].count;
-
-    float* scval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-    for (int i = 0; i < len; i++) {
-        scval[i] = gamma[i] / sqrt(var[i] + eps);
-    }
-    nvinfer1::Weights scale{nvinfer1::DataType::kFLOAT, scval, len};
-
-    float* shval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-    for (int i = 0; i < len; i++) {
-        shval[i] = beta[i] - mean[i] * gamma[i] / sqrt(var[i] + eps);
-    }
-    nvinfer1::Weights shift{nvinfer1::DataType::kFLOAT, shval, len};
 
-    float* pval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
-    for (int i = 0; i < len; i++) {
-        pval[i] = 1.0;
+// convBnSiLU and convBnNoAct build one conv with the .bn statistics folded in: its weights scaled in place and a bias
+// stored in weightMap, next to the loaded weights that the build functions free.
+static void foldBatchNorm2d(std::map<std::string, nvinfer1::Weights>& weightMap, std::string conv_name,
+                            std::string bn_name, float eps, nvinfer1::Weights& weight, nvinfer1::Weights& bias) {
+    std::string bias_name = conv_name + ".fused_bias";
+    nvinfer1::Weights& w = weightMap[conv_name + ".weight"];
+    if (weightMap.count(bias_name) == 0) {
+        const float* gamma = (const float*)weightMap[bn_name + ".weight"].values;
+        const float* beta = (const float*)weightMap[bn_name + ".bias"].values;
+        const float* mean = (const float*)weightMap[bn_name + ".running_mean"].values;
+        const float* var = (const float*)weightMap[bn_name + ".running_var"].values;
+        int len = weightMap[bn_name + ".running_var"].count;
+        assert(len > 0 && w.count % len == 0);
+        int per_channel = w.count / len;
+
+        float* wval = (float*)w.values;
+        float* bval = reinterpret_cast<float*>(malloc(sizeof(float) * len));
+        for (int c = 0; c < len; c++) {
+            float scale = gamma[c] / sqrt(var[c] + eps);
+            float* row = wval + c * per_channel;
+            for (int i = 0; i < per_channel; i++) {
+                row[i] *= scale;
+            }
+            bval[c] = beta[c] - mean[c] * scale;
+        }
+        weightMap[bias_name] = nvinfer1::Weights{nvinfer1::DataType::kFLOAT, bval, len};
     }
-    nvinfer1::Weights power{nvinfer1::DataType::kFLOAT, pval, len};
-    weightMap[lname + ".scale"] = scale;
-    weightMap[lname + ".shift"] = shift;
-    weightMap[lname + ".power"] = power;
-    nvinfer1::IScaleLayer* output = network->addScale(input, nvinfer1::ScaleMode::kCHANNEL, shift, scale, power);
-    assert(output);
-    return output;
+    weight = w;
+    bias = weightMap[bias_name];
 }
 nvinfer1::ILayer* convBnSiLU(nvinfer1::INetworkDefinition* network, std::map<std::string, nvinfer1::Weights>& weightMap,
                              nvinfer1::ITensor& input, int ch, int k, int s, int p, std::string lname, int g) {
-    nvinfer1::Weights bias_empty{nvinfer1::DataType::kFLOAT, nullptr, 0};
-    nvinfer1::IConvolutionLayer* conv =
-            network->addConvolutionNd(input, ch, nvinfer1::DimsHW{k, k}, weightMap[lname + ".conv.weight"], bias_empty);
+    nvinfer1::Weights weight, bias;
+    foldBatchNorm2d(weightMap, lname + ".conv", lname + ".bn", 1e-3, weight, bias);
+    nvinfer1::IConvolutionLayer* conv = network->addConvolutionNd(input, ch, nvinfer1::DimsHW{k, k}, weight, bias);
     assert(conv);
     conv->setStrideNd(nvinfer1::DimsHW{s, s});
     conv->setPaddingNd(nvinfer1::DimsHW{p, p});
     conv->setNbGroups(g);
 
-    nvinfer1::IScaleLayer* bn = addBatchNorm2d(network, weightMap, *conv->getOutput(0), lname + ".bn", 1e-3);
-
-    nvinfer1::IActivationLayer* sigmoid = network->addActivation(*bn->getOutput(0), nvinfer1::ActivationType::kSIGMOID);
+    nvinfer1::IActivationLayer* sigmoid =
+            network->addActivation(*conv->getOutput(0), nvinfer1::ActivationType::kSIGMOID);
     assert(sigmoid);
-    auto ew = network->addElementWise(*bn->getOutput(0), *sigmoid->getOutput(0), nvinfer1::ElementWiseOperation::kPROD);
+    auto ew =
+            network->addElementWise(*conv->getOutput(0), *sigmoid->getOutput(0), nvinfer1::ElementWiseOperation::kPROD);
     assert(ew);
     return ew;
 }
 nvinfer1::ILayer* convBnNoAct(nvinfer1::INetworkDefinition* network,
                               std::map<std::string, nvinfer1::Weights>& weightMap, nvinfer1::ITensor& input, int ch,
                               int k, int s, int p, std::string lname, int g) {
-    nvinfer1::Weights bias_empty{nvinfer1::DataType::kFLOAT, nullptr, 0};
-    nvinfer1::IConvolutionLayer* conv =
-            network->addConvolutionNd(input, ch, nvinfer1::DimsHW{k, k}, weightMap[lname + ".conv.weight"], bias_empty);
+    nvinfer1::Weights weight, bias;
+    foldBatchNorm2d(weightMap, lname + ".conv", lname + ".bn", 1e-3, weight, bias);
+    nvinfer1::IConvolutionLayer* conv = network->addConvolutionNd(input, ch, nvinfer1::DimsHW{k, k}, weight, bias);
     assert(conv);
     conv->setStrideNd(nvinfer1::DimsHW{s, s});
     conv->setPaddingNd(nvinfer1::DimsHW{p, p});
     conv->setNbGroups(g);
-
-    nvinfer1::IScaleLayer* bn = addBatchNorm2d(network, weightMap, *conv->getOutput(0), lname + ".bn", 1e-3);
-    return bn;
+    return conv;
 }
 
 std::vector<std::vector<float>> getAnchors(std::map<std::string, Weights>& weightMap, std::string lname) {